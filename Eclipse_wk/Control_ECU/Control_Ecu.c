@@ -1,348 +1,1055 @@
-/*******************************************************************************
- * Control_ECU.c
- *
- *	File Name: Control_Ecu.c
- *
- *	Description: the source file for Control_ECU application
- *
- * Author: Omar Elsherif
- *
- *******************************************************************************/
-
-
-
-
-/*******************************************************************************
- *                      	Header Files	                                   *
- *******************************************************************************/
-
-#include<avr/io.h> 				/* For I-bit*/
-#include"std_types.h"			/* For uint8*/
-#include"util/delay.h"			/* For delay function */
-#include"uart.h"				/* For UART protocol  */
-#include"string.h"				/* For strcmp() function */
-#include "external_eeprom.h"	/* For External EEPROM   */
-#include"twi.h"					/* For I2C Protocol */
-#include"dc_motor.h"			/* For DC Motor */
-#include"timer1.h"				/* For Timer 1  */
-#include"buzzer.h"				/* For Buzzer   */
-
-
-
-/*******************************************************************************
- * 																			   *
- *                      Global Variables              						   *
- *                      									                   *
- *******************************************************************************/
-
-/*	Flag to determine if pass 2 passwords are matched */
-static volatile uint8 g_passCorrectFlag=0;
-/*	Flag to count number of seconds	*/
-static volatile uint8 g_secondsCount=0;
-/*	Flag to determine if user entered old pass correctly,
- * and wanted to change the password
- */
-static volatile uint8 g_changePassFlag=0;
-/*	Flag to determine if user entered the password wrong,
- * in 3 consective times
- */
-static volatile uint8 g_consecWrongPass=0;
-
-
-
-/*******************************************************************************
- *                      	  Defines                                          *
- *******************************************************************************/
-
-#define PASSWORD_SIZE 5
-#define ECU_READY 0xFF
-#define MATCHED_PASSWORD 0xFE
-#define UNMATCHED_PASSWORD 0xFD
-#define SEND_PASSWORD 0x01
-#define CONFIRM_SEND_PASSWORD 0x02
-#define OPEN_DOOR 0x03
-#define CHANGE_PASS 0x04
-
-
-
-/*******************************************************************************
- * 																			   *
- *                     Function Prototypes                                	   *
- *                     													       *
- *******************************************************************************/
-
-/* Function to receive the password from HMI_ECU*/
-void receivePassword(uint8* password);
-/*	This function is called every 1 second passed in timer1*/
-void timer1ControlCallBack();
-/* Function to check if two passwords are matched or not*/
-void checkPassword(uint8*password,uint8*reEnteredPassword);
-/* Function to check if entered password is matched or not matched
- * in the saved password in EEPROM.
- */
-void checkPasswordInEEPROM(uint8*password);
-
-
-
-
-/*******************************************************************************
- *                         main() Function                                     *
- *******************************************************************************/
-
-int main(void)
-{
-	// Enable I-bit
-	SREG |=(1<<7);
-
-	/*	Initialize UART with :
-	 * Asynchronous with double speed
-	 * 8- bit Mode
-	 * Parity is disabled
-	 * 1-stop bit
-	 * baud rate =9600
-	 *
-	 */
-	UART_ConfigType UART_Config={Asynchronous_Double_Speed_Mode,MODE_8_BITS,PARITY_DISABLED,ONE_STOP_BIT,9600};
-	UART_init(&UART_Config);
-
-	/*	Initialize I2C with :
-	 * 400 kbit/sec
-	 * Master address = 0x01
-	 */
-	TWI_ConfigType TWI_Config={400000,0x01};
-	TWI_init(&TWI_Config);
-
-	/*	initialize Motor	*/
-	DcMotor_Init();
-	/* Initialize the buzzer */
-	Buzzer_init();
-
-
-	/*	Timer1 configurations to calculate 1 sec*/
-	Timer1_ConfigType TIMER1_Config = {0,CTC_MODE, F_CPU_256, 31250};
-	Timer1_init(&TIMER1_Config);
-	/*	Set the callback function of timer1*/
-	Timer1_setCallBack(timer1ControlCallBack);
-
-
-
-
-	/* looping until HMI send ECU_READY signal */
-	while (UART_recieveByte() != ECU_READY);
-	/* sending to HMI_ECU ECU_READY signal */
-	UART_sendByte(ECU_READY);
-
-	/* 5-digit Password + null +'#' when we send using UART */
-	uint8 password[PASSWORD_SIZE+2];
-	uint8 reEnteredPassword[PASSWORD_SIZE+2];
-
-	while(1)
-	{
-		/* receive the password from HMI_ECU */
-		receivePassword(password);
-		/* receive the re entered password from HMI_ECU */
-		receivePassword(reEnteredPassword);
-		/* Check the two passwords */
-		checkPassword(password,reEnteredPassword);
-
-		/* if password matched we are in inner menu
-		 *  '+' : Open Door
-		 * '-' : change Pass
-		 */
-		if(g_passCorrectFlag==1)
-		{
-
-			while(1)
-			{
-				/* receive the password from HMI_ECU */
-				receivePassword(reEnteredPassword);
-				/* check that received password with the one saved in EEPROM */
-				checkPasswordInEEPROM(reEnteredPassword);
-				/* if user wants to change password and entered the old one correctly*/
-				if(g_changePassFlag==1)
-				{
-					/* Clear the change password flag	*/
-					g_changePassFlag=0;
-					/* Break to outer while(1) which has outer menu	*/
-					break;
-				}
-				/*	if user entered the password wrong 3 consecutive times	*/
-				if(g_consecWrongPass==3)
-				{
-					/* Clear the consecutive password counter	*/
-					g_consecWrongPass=0;
-					/* Clear the seconds counter to start count from beginning	*/
-					g_secondsCount=0;
-					/*	Activate Buzzer */
-					Buzzer_on();
-					/* Wait until 60 seconds are passed*/
-					while(g_secondsCount<60);
-					/*	De-activate the buzzer */
-					Buzzer_off();
-				}
-
-			}/* End of inner while(1) */
-
-
-		}/* End of if(g_passCorrectFlag==1) */
-
-
-	}/* End of while(1)	*/
-
-
-
-	return 1;
-
-}	/* End of main() function*/
-
-
-
-
-
-/*******************************************************************************
- * 																			   *
- *                     Function Definitions									   *
- *                     					                                       *
- *******************************************************************************/
-
-
-/* Function to receive the password from HMI_ECU*/
-void receivePassword(uint8* password)
-{
-	/* Loop untill the HMI_ECU is ready to send the password*/
-	while (UART_recieveByte() != SEND_PASSWORD);
-	UART_sendByte(CONFIRM_SEND_PASSWORD);
-	/* Receive the password from HMI_ECU	*/
-	UART_receiveString(password);
-}
-
-/*	This function is called every 1 second passed in timer1*/
-void timer1ControlCallBack()
-{
-	/* Increment the seconds counter */
-	g_secondsCount++;
-}
-
-/* Function to check if two passwords are matched or not*/
-void checkPassword(uint8*password,uint8*reEnteredPassword)
-{
-	/*if two passwords are matched , strcmp() = 0*/
-	if(!strcmp(password,reEnteredPassword))
-	{
-		/* Set the Passwords correct flag*/
-		g_passCorrectFlag=1;
-
-		/* Write Password in the external EEPROM */
-		uint8 i=0;
-		for(i=0;i<=PASSWORD_SIZE;i++)
-		{
-			/*	Since EEPROM each location inside it has 1 byte,
-			 * so next location we increment address by 1 */
-			EEPROM_writeByte(0x0311+i, password[i]);
-			/*	Must make 10 ms delay between each write/read operation in EEPROM*/
-			_delay_ms(10);
-		}
-		/*	Send to HMI_ECU that Control_ECU is ready to send	*/
-		UART_sendByte(SEND_PASSWORD);
-		while ( UART_recieveByte() != CONFIRM_SEND_PASSWORD);
-		/*	Send to HMI_ECU that password is matched */
-		UART_sendByte(MATCHED_PASSWORD);
-	}
-	/*if two passwords are NOT Matched */
-	else
-	{
-		/* Clear the Passwords correct flag*/
-		g_passCorrectFlag=0;
-		/*	Send to HMI_ECU that Control_ECU is ready to send	*/
-		UART_sendByte(SEND_PASSWORD);
-		while ( UART_recieveByte() != CONFIRM_SEND_PASSWORD);
-		/*	Send to HMI_ECU that password is NOT Matched */
-		UART_sendByte(UNMATCHED_PASSWORD);
-	}
-
-}
-
-/* Function to check if entered password is matched or not matched
- * in the saved password in EEPROM.
- */
-void checkPasswordInEEPROM(uint8*password)
-{
-	uint8 i=0;
-	/* Make array of unsigned character to store inside it
-	 * the password saved in EEPROM.
-	 */
-	uint8 savedPassword[PASSWORD_SIZE+2];
-	/*	Read saved password from EEPROM*/
-	for(i=0;i<=PASSWORD_SIZE;i++)
-	{
-		/*	Since EEPROM each location inside it has 1 byte,
-		 * so next location we increment address by 1*/
-		EEPROM_readByte(0x0311+i, &savedPassword[i]);
-		/*	Must make 10 ms delay between each write/read operation in EEPROM*/
-		_delay_ms(10);
-	}
-
-	/*If password in EEPROM is Matched with password entered by user*/
-	if(!strcmp(password,savedPassword))
-	{
-		/*	Send to HMI_ECU that Control_ECU is ready to send	*/
-		UART_sendByte(SEND_PASSWORD);
-		while ( UART_recieveByte() != CONFIRM_SEND_PASSWORD);
-		/*	Send to HMI_ECU that password is matched */
-		UART_sendByte(MATCHED_PASSWORD);
-
-		/*	Variable to determine if HMI_ECU wants to open door or change the password*/
-		uint8 HMIStatus;
-		HMIStatus=UART_recieveByte();
-
-		/* If HMI_ECU wants to Open Door */
-		if(HMIStatus==OPEN_DOOR)
-		{
-			/* Clear the seconds counter to start counting from beginning*/
-			g_secondsCount=0;
-			/*	Rotate Motor Clockwise at 50 %	*/
-			DcMotor_Rotate(Clockwise,50);
-			/*	wait till 15 seconds are passed	*/
-			while(g_secondsCount<15);
-			/* Stop the motor */
-			DcMotor_Rotate(Stop,0);
-			/*	wait till another 3 seconds are passed	*/
-			while(g_secondsCount<18);
-			/*	Rotate Motor Anti Clockwise at 50 %	*/
-			DcMotor_Rotate(Anti_Clockwise,50);
-			/*	wait till another 15 seconds are passed	*/
-			while(g_secondsCount<33);
-			/* Stop the motor */
-			DcMotor_Rotate(Stop,0);
-		}
-
-		/* If HMI_ECU wants to Change Password */
-		if(HMIStatus==CHANGE_PASS)
-		{
-			/*	Set the change password flag */
-			g_changePassFlag=1;
-		}
-		/* Since the two passwords are matched then we
-		 * clear consecutive wrong password counter */
-		g_consecWrongPass=0;
-
-	}/* End of if(!strcmp(password,savedPassword)) */
-
-	/*If password in EEPROM is NOT Matched with password entered by user*/
-	else
-	{
-		/* increment the consecutive wrong password counter */
-		g_consecWrongPass++;
-		/* clear the correct password flag,since two passwords are NOT matched*/
-		g_passCorrectFlag=0;
-		/*	Send to HMI_ECU that Control_ECU is ready to send	*/
-		UART_sendByte(SEND_PASSWORD);
-		while ( UART_recieveByte() != CONFIRM_SEND_PASSWORD);
-		/*	Send to HMI_ECU that password is matched */
-		UART_sendByte(UNMATCHED_PASSWORD);
-	}
-
-}
-
-
-
+/*******************************************************************************
+ * Control_ECU.c
+ *
+ *	File Name: Control_Ecu.c
+ *
+ *	Description: the source file for Control_ECU application
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+
+
+
+/*******************************************************************************
+ *                      	Header Files	                                   *
+ *******************************************************************************/
+
+#include"mcu_hal.h"				/* For I-bit*/
+#include"std_types.h"			/* For uint8*/
+#include"util/delay.h"			/* For delay function */
+#include"uart.h"				/* For UART protocol  */
+#include "external_eeprom.h"	/* For External EEPROM   */
+#include"twi.h"					/* For I2C Protocol */
+#include"dc_motor.h"			/* For DC Motor */
+#include"speed_control.h"		/* For the motor speed telemetry */
+#include"timer1.h"				/* For Timer 1  */
+#include"buzzer.h"				/* For Buzzer   */
+#include"limit_switch.h"		/* For Door Limit Switches */
+#include"profiler.h"			/* For the hot path profiler */
+#include"trace.h"				/* For the event trace */
+#include"stats.h"				/* For the runtime statistics */
+#include"histogram.h"			/* For the latency histograms */
+#include"stack_monitor.h"		/* For the stack high-water mark */
+#include"idle.h"				/* For the idle sleep */
+#include"multidrop.h"			/* For the HMI panels on the link */
+#include"link.h"				/* For the acknowledged transport */
+
+
+
+/*******************************************************************************
+ * 																			   *
+ *                      Global Variables              						   *
+ *                      									                   *
+ *******************************************************************************/
+
+/*	Flag to determine if pass 2 passwords are matched */
+static volatile uint8 g_passCorrectFlag=0;
+/*	Flag to count number of seconds	*/
+static volatile uint8 g_secondsCount=0;
+/*	Flag to determine if user entered old pass correctly,
+ * and wanted to change the password
+ */
+static volatile uint8 g_changePassFlag=0;
+/*	Seconds left of the wrong password lockout, 0 when not locked out	*/
+static volatile uint8 g_lockoutSeconds=0;
+/*	Count of the wrong passwords in consecutive times, of all the panels	*/
+static uint8 g_consecWrongPass=0;
+/*	Flag to determine if the door hit one of its limit switches	*/
+static volatile uint8 g_doorLimitFlag=0;
+/*	Seconds passed since power on, never cleared	*/
+static volatile uint16 g_uptimeSeconds=0;
+/*	Learned door travel time of each direction in 1/10 second */
+static uint16 g_unlockTravelTime;
+static uint16 g_lockTravelTime;
+/*	Time the last password was received in ms, for the response latency	*/
+static uint32 g_passwordTime=0;
+/*	Panel served now, the index of its session	*/
+static uint8 g_panel=0;
+/*	Motor speed in RPM and duty cycle in % measured during the last travel
+ *	at the door speed, for the telemetry
+ */
+static uint16 g_motorRpm=0;
+static uint8 g_motorDutyCycle=0;
+
+
+
+/*******************************************************************************
+ *                      	  Defines                                          *
+ *******************************************************************************/
+
+#define PASSWORD_SIZE 5
+#define ECU_READY 0xFF
+#define MATCHED_PASSWORD 0xFE
+#define UNMATCHED_PASSWORD 0xFD
+/*	Answer to a password received during the lockout, it is not checked	*/
+#define LOCKED_OUT 0xFC
+#define SEND_PASSWORD 0x01
+#define CONFIRM_SEND_PASSWORD 0x02
+#define OPEN_DOOR 0x03
+#define CHANGE_PASS 0x04
+#define DOOR_UNLOCKED 0x05
+#define DOOR_LOCKING 0x06
+#define DOOR_LOCKED 0x07
+
+/* Link baud rate negotiation : HMI_ECU sends BAUD_REQUEST with the index of its
+ * highest rate in g_linkBaudRates, Control_ECU answers BAUD_REQUEST with the
+ * index both of them support, then both switch to it. The handshake with
+ * ECU_READY is done again at the new rate.
+ */
+#define BAUD_REQUEST 0x16
+/* Highest link baud rate of the build, make BAUD=n gives -DLINK_MAX_BAUD=n */
+#ifndef LINK_MAX_BAUD
+#define LINK_MAX_BAUD (F_CPU/2)
+#endif
+#ifdef MULTIDROP_ENABLE
+/* The panels share the link at 9600 */
+#undef LINK_MAX_BAUD
+#define LINK_MAX_BAUD 9600
+#endif
+#define LINK_NUM_BAUD_RATES (sizeof(g_linkBaudRates)/sizeof(g_linkBaudRates[0]))
+/* The acknowledged transport (-DLINK_ENABLE, make LINK=1) starts at the highest
+ * rate of the build and does not switch : a frame lost at the switch could not
+ * be sent again
+ */
+#ifdef LINK_ENABLE
+#define LINK_START_BAUD_INDEX getMaxBaudIndex()
+#else
+#define LINK_START_BAUD_INDEX 0
+#endif
+
+/* Synchronous link with -DUART_SYNC_ENABLE (make SYNC=1) : XCK on PB0 of both
+ * ECUs, Control_ECU is the master that clocks both directions
+ */
+#ifdef UART_SYNC_ENABLE
+#if defined(MULTIDROP_ENABLE) || defined(RS485_ENABLE)
+#error "The synchronous link is point-to-point, without RS-485 transceivers"
+#endif
+#define LINK_UART_MODE Synchronous_Mode
+#else
+#define LINK_UART_MODE Asynchronous_Double_Speed_Mode
+#endif
+#define LINK_XCK_ROLE UART_XCK_MASTER
+
+/* Time the door is kept opened in seconds */
+#define DOOR_HOLD_TIME 3
+#define DOOR_MOTOR_SPEED 50
+/* Time the alarm is played after 3 consecutive wrong passwords in seconds */
+#define LOCKOUT_TIME 60
+
+/* Door travel timing in 1/10 second.
+ * Each direction learns its travel time from the limit switch/stall events,
+ * the next travel times out after the learned time + 25% + margin.
+ * DOOR_MAX_TRAVEL_TIME is used till the first travel is learned, and again
+ * after any travel timed out.
+ * The motor slows down DOOR_RAMP_TIME before the learned end of travel.
+ */
+#define DOOR_MAX_TRAVEL_TIME 150
+#define DOOR_TRAVEL_TIME_MARGIN 10
+#define DOOR_RAMP_TIME 10
+#define DOOR_APPROACH_SPEED 25
+#define DOOR_TRAVEL_TIMED_OUT 0xFFFF
+/* Timer1 counts 31250 ticks per second */
+#define TIMER1_TICKS_PER_TENTH_SECOND 3125
+
+/* Learned travel times are saved in the external EEPROM after the password */
+#define DOOR_UNLOCK_TIME_ADDRESS 0x0320
+#define DOOR_LOCK_TIME_ADDRESS 0x0322
+
+
+
+/*******************************************************************************
+ * 																			   *
+ *                      Link Baud Rates              						   *
+ *                      									                   *
+ *******************************************************************************/
+
+/*	Link baud rates of both ECUs by their index, the first one is the rate at
+ * reset. 57600 and 115200 are not there, their error is above 2 % at 8 MHz.
+ * The synchronous slave needs XCK below F_CPU/4, F_CPU/6 is the fastest rate
+ * between two ECUs at the same clock.
+ */
+static const UART_BaudRate g_linkBaudRates[]={
+		UART_BAUD(LINK_UART_MODE,9600),
+		UART_BAUD(LINK_UART_MODE,19200),
+		UART_BAUD(LINK_UART_MODE,38400),
+		UART_BAUD(LINK_UART_MODE,76800),
+		UART_BAUD(LINK_UART_MODE,250000),
+		UART_BAUD(LINK_UART_MODE,500000),
+		UART_BAUD(LINK_UART_MODE,1000000)
+#ifdef UART_SYNC_ENABLE
+		,UART_BAUD(LINK_UART_MODE,F_CPU/6)
+#endif
+};
+
+
+
+/*******************************************************************************
+ *                      	  Types                                            *
+ *******************************************************************************/
+
+/*	Step of the HMI_ECU flow, what its next password is for	*/
+typedef enum{
+	SESSION_NEW_PASSWORD,		/* first password of a new pair */
+	SESSION_CONFIRM_PASSWORD,	/* the same password re-entered */
+	SESSION_MENU				/* password to open the door or change it */
+}Session_State;
+
+/*	Each HMI panel on the link has its own session,
+ * there is only one on the point-to-point link
+ */
+typedef struct{
+	Session_State state;
+	/*	First password of the pair, till it is re-entered, + null	*/
+	uint8 password[PASSWORD_SIZE+1];
+	/*	FALSE if the first password was not PASSWORD_SIZE bytes, the pair is then not matched	*/
+	uint8 valid;
+}Session;
+
+
+
+/*******************************************************************************
+ * 																			   *
+ *                      Sessions              								   *
+ *                      									                   *
+ *******************************************************************************/
+
+static Session g_sessions[MULTIDROP_NUM_PANELS];
+
+
+
+/*******************************************************************************
+ * 																			   *
+ *                     Function Prototypes                                	   *
+ *                     													       *
+ *******************************************************************************/
+
+/* Function to receive the password from HMI_ECU and the panel that sent it,
+ * it returns FALSE if the password is not PASSWORD_SIZE bytes
+ */
+uint8 receivePassword(UART_Frame* password,uint8* panel);
+/*	This function is called every 1 second passed in timer1*/
+void timer1ControlCallBack();
+/*	This function is called when the door hits one of its limit switches */
+void limitSwitchControlCallBack(LimitSwitch_DoorPosition position);
+/* Function to check if two passwords are matched or not*/
+void checkPassword(uint8*password,const UART_Frame*reEnteredPassword);
+/* Function to check if entered password is matched or not matched
+ * in the saved password in EEPROM.
+ */
+void checkPasswordInEEPROM(const UART_Frame*password);
+/* Function to answer a password received during the lockout without checking it,
+ * the lockout is for all the panels
+ */
+void refusePassword(void);
+/* Function to answer a pair of passwords that are not matched */
+void rejectPassword(void);
+/* Function to count a wrong password and answer it */
+void countWrongPassword(void);
+/* Function to rotate the door motor until it hits a limit switch or stalls
+ * at the end of travel, or until the timeout of the learned travel time.
+ * It returns the measured travel time, DOOR_TRAVEL_TIMED_OUT or 0 if
+ * the door was already there.
+ */
+uint16 moveDoor(DcMotor_State direction,uint16 travelTime);
+/* Function to update the learned travel time with the measured one
+ * and save it in EEPROM if it is changed.
+ */
+void learnDoorTravelTime(uint16*travelTime,uint16 measuredTime,uint16 address);
+/* Function to play a short buzzer pattern unless the lockout alarm is playing */
+void playFeedback(Buzzer_Pattern pattern);
+/* Function to send the motor speed measured during the last travel as one text line :
+ * MOTOR RPM <rpm> DUTY <duty cycle %> TARGET <rpm>
+ */
+void sendMotorTelemetry(void);
+/* Function to send a number in decimal */
+void sendNumber(uint16 number);
+/* Function to read the learned travel time from EEPROM */
+void loadDoorTravelTime(uint16*travelTime,uint16 address);
+/* Function to return the time passed since power on in 1/10 second */
+uint16 getTimeStamp(void);
+/* Function to return the time passed since power on in ms */
+uint32 getTimeMs(void);
+/* Function to return the Timer1 ticks passed since the start count, less than 1 second */
+uint16 getTicksSince(uint16 start);
+/* Functions to access the external EEPROM, counting their errors and latencies */
+uint8 readEepromByte(uint16 address,uint8*data);
+uint8 writeEepromByte(uint16 address,uint8 data);
+/* Function to return the index of the highest link baud rate of this build */
+uint8 getMaxBaudIndex(void);
+/* Function to answer the BAUD_REQUEST of HMI_ECU and switch to the agreed rate */
+void negotiateBaudRate(void);
+
+
+
+
+/*******************************************************************************
+ *                         main() Function                                     *
+ *******************************************************************************/
+
+int main(void)
+{
+	// Enable I-bit
+	HAL_SET_BITS(SREG, (1<<7));
+	/*	Sleep in the Idle mode while waiting for an interrupt	*/
+	Idle_init();
+
+	/*	Initialize UART with :
+	 * Asynchronous with double speed
+	 * 8- bit Mode, 9-bit on the multi-drop link
+	 * Parity is disabled
+	 * 1-stop bit
+	 * baud rate =9600, till HMI_ECU asks for a higher one
+	 * (the highest one from the start under the transport)
+	 *
+	 */
+	UART_ConfigType UART_Config={LINK_UART_MODE,MULTIDROP_UART_BITS,PARITY_DISABLED,ONE_STOP_BIT,g_linkBaudRates[LINK_START_BAUD_INDEX],LINK_XCK_ROLE};
+	UART_init(&UART_Config);
+
+	/*	Initialize I2C with :
+	 * 400 kbit/sec
+	 * Master address = 0x01
+	 */
+	TWI_ConfigType TWI_Config={400000,0x01};
+	TWI_init(&TWI_Config);
+
+	/*	initialize Motor	*/
+	DcMotor_Init();
+	/* Initialize the buzzer */
+	Buzzer_init();
+	/*	Initialize the door limit switches, and stop the motor once a limit is hit */
+	LimitSwitch_init();
+	LimitSwitch_setCallBack(limitSwitchControlCallBack);
+
+
+	/*	Timer1 configurations to calculate 1 sec*/
+	Timer1_ConfigType TIMER1_Config = {0,CTC_MODE, F_CPU_256, 31250};
+	Timer1_init(&TIMER1_Config);
+	/*	Set the callback function of timer1*/
+	Timer1_setCallBack(timer1ControlCallBack);
+	/*	Time the hot paths with Timer1, only with PROFILER_ENABLE	*/
+	PROFILER_INIT();
+	/*	Record the events with their time, only with TRACE_ENABLE	*/
+	TRACE_INIT();
+	/*	Poll the HMI panels with the Timer1 alarm, only with MULTIDROP_ENABLE	*/
+	MULTIDROP_INIT();
+	/*	Frames acknowledged and sent again on the link, only with LINK_ENABLE	*/
+	LINK_INIT();
+	/*	Throttle the peer with XON/XOFF or RTS/CTS, only with UART_FLOW_XONXOFF/RTSCTS	*/
+	UART_FLOW_INIT();
+
+	/*	Read the statistics saved before, and count the UART errors	*/
+	Stats_init();
+	UART_setErrorCallBack(Stats_uartErrorCallBack);
+
+	/*	Read the door travel times learned in the previous cycles	*/
+	loadDoorTravelTime(&g_unlockTravelTime,DOOR_UNLOCK_TIME_ADDRESS);
+	loadDoorTravelTime(&g_lockTravelTime,DOOR_LOCK_TIME_ADDRESS);
+
+
+
+
+	/* 5-digit Password, read where the UART received it till it is released */
+	UART_Frame password;
+	/* Session of the panel that sent the password */
+	Session * session;
+	/* FALSE if the password is too long or too short, it is not checked */
+	uint8 validPassword;
+
+	while(1)
+	{
+		/* receive the password from HMI_ECU, on the multi-drop
+		 * link from any panel that has one
+		 */
+		validPassword=receivePassword(&password,&g_panel);
+		session=&g_sessions[g_panel];
+
+		switch(session->state)
+		{
+		case SESSION_NEW_PASSWORD:
+			/* Keep it till it is re-entered, a bad one is answered with the pair */
+			session->valid=validPassword;
+			if(validPassword)
+			{
+				UART_copyFrame(&password,session->password,sizeof(session->password));
+			}
+			session->state=SESSION_CONFIRM_PASSWORD;
+			break;
+
+		case SESSION_CONFIRM_PASSWORD:
+			/* A new password is not saved during the lockout either */
+			if(g_lockoutSeconds>0)
+			{
+				refusePassword();
+				session->state=SESSION_NEW_PASSWORD;
+				break;
+			}
+			/* Check the two passwords, nothing is saved if one of them is bad */
+			if(validPassword && session->valid)
+			{
+				checkPassword(session->password,&password);
+			}
+			else
+			{
+				rejectPassword();
+			}
+			/* if password matched we are in inner menu
+			 *  '+' : Open Door
+			 * '-' : change Pass
+			 */
+			session->state=(g_passCorrectFlag==1) ? SESSION_MENU : SESSION_NEW_PASSWORD;
+			break;
+
+		case SESSION_MENU:
+			/* No password is checked till the end of the lockout */
+			if(g_lockoutSeconds>0)
+			{
+				refusePassword();
+				break;
+			}
+			/* check that received password with the one saved in EEPROM,
+			 * a bad one is a wrong password without reading it
+			 */
+			if(validPassword)
+			{
+				checkPasswordInEEPROM(&password);
+			}
+			else
+			{
+				countWrongPassword();
+			}
+			/* if user wants to change password and entered the old one correctly*/
+			if(g_changePassFlag==1)
+			{
+				/* Clear the change password flag	*/
+				g_changePassFlag=0;
+				/* Back to the outer menu of this panel */
+				session->state=SESSION_NEW_PASSWORD;
+			}
+			/*	if user entered the password wrong 3 consecutive times	*/
+			if(g_consecWrongPass==3)
+			{
+				/* Clear the consecutive password counter	*/
+				g_consecWrongPass=0;
+				/*	Start the lockout, the alarm is played in the background
+				 * and stopped by timer1ControlCallBack after 60 seconds,
+				 * so the UART is still served meanwhile.
+				 */
+				g_lockoutSeconds=LOCKOUT_TIME;
+				Buzzer_play(BUZZER_ALARM);
+				TRACE(TRACE_EVENT_LOCKOUT, 1);
+				Stats_increment(STATS_LOCKOUTS);
+			}
+			break;
+		}
+		/* The UART can take the next password in its place */
+		UART_releaseFrame();
+
+	}/* End of while(1)	*/
+
+
+
+	return 1;
+
+}	/* End of main() function*/
+
+
+
+
+
+/*******************************************************************************
+ * 																			   *
+ *                     Function Definitions									   *
+ *                     					                                       *
+ *******************************************************************************/
+
+
+/* Function to receive the password from HMI_ECU and the panel that sent it,
+ * it returns FALSE if the password is not PASSWORD_SIZE bytes
+ */
+uint8 receivePassword(UART_Frame* password,uint8* panel)
+{
+	uint8 command;
+	uint8 fits;
+
+	/*	Save the statistics while the HMI_ECU is idle, if it is time to,
+	 *	with the deepest stack so far
+	 */
+	Stats_recordStackUsage(StackMonitor_getMaxUsage());
+	Stats_update();
+
+	/* Loop untill the HMI_ECU is ready to send the password,
+	 * it may query the statistics or request a dump meanwhile
+	 */
+	while ((command = MULTIDROP_RECEIVE_COMMAND(panel)) != SEND_PASSWORD)
+	{
+		/* The HMI_ECU starts again : new password first */
+		if(command == ECU_READY)
+		{
+			g_sessions[*panel].state=SESSION_NEW_PASSWORD;
+			/* The wrong passwords are still counted, a reset does not end the lockout */
+			/* sending to HMI_ECU ECU_READY signal */
+			UART_sendByte(ECU_READY);
+		}
+		else if(command == STATS_REQUEST)
+		{
+			Stats_send();
+		}
+		/* The dumps go on the channels of the transport behind the commands */
+		else if(command == PROFILER_DUMP_REQUEST)
+		{
+			LINK_SET_TX_CHANNEL(LINK_CHANNEL_TRACE);
+			PROFILER_DUMP();
+			LINK_SET_TX_CHANNEL(LINK_CHANNEL_CONTROL);
+		}
+		else if(command == TRACE_DUMP_REQUEST)
+		{
+			LINK_SET_TX_CHANNEL(LINK_CHANNEL_TRACE);
+			TRACE_DUMP();
+			LINK_SET_TX_CHANNEL(LINK_CHANNEL_CONTROL);
+		}
+		else if(command == HISTOGRAM_REQUEST)
+		{
+			LINK_SET_TX_CHANNEL(LINK_CHANNEL_TELEMETRY);
+			Histogram_send();
+			sendMotorTelemetry();
+			Idle_send();
+			LINK_SEND();
+			UART_FLOW_SEND();
+			LINK_SET_TX_CHANNEL(LINK_CHANNEL_CONTROL);
+		}
+		else if(command == HISTOGRAM_RESET)
+		{
+			Histogram_reset();
+		}
+		else if(command == BAUD_REQUEST)
+		{
+			negotiateBaudRate();
+		}
+	}
+	UART_sendByte(CONFIRM_SEND_PASSWORD);
+	/* Receive the password from HMI_ECU, not kept in the trace	*/
+	TRACE_MASK(TRUE);
+	fits=UART_receiveFrame(password,'#',PASSWORD_SIZE);
+	TRACE_MASK(FALSE);
+	g_passwordTime=getTimeMs();
+	/*	Click to acknowledge the received password	*/
+	playFeedback(BUZZER_KEY_CLICK);
+	/*	A longer frame is empty, a shorter one is not a password either	*/
+	return (fits && (UART_frameLength(password)==PASSWORD_SIZE));
+}
+
+/* Function to return the index of the highest link baud rate of this build */
+uint8 getMaxBaudIndex(void)
+{
+	uint8 index=0;
+	while(((index+1) < LINK_NUM_BAUD_RATES) && (g_linkBaudRates[index+1] <= LINK_MAX_BAUD))
+	{
+		index++;
+	}
+	return index;
+}
+
+/* Function to answer the BAUD_REQUEST of HMI_ECU and switch to the agreed rate */
+void negotiateBaudRate(void)
+{
+	uint8 index=UART_recieveByte();
+	uint8 maxIndex=getMaxBaudIndex();
+
+	if(index > maxIndex)
+	{
+		index=maxIndex;
+	}
+	UART_sendByte(BAUD_REQUEST);
+	UART_sendByte(index);
+	/*	Switches once the answer is on the bus, HMI_ECU sends ECU_READY
+	 *	at the new rate to start again
+	 */
+	UART_setBaudRate(g_linkBaudRates[index]);
+}
+
+/*	This function is called every 1 second passed in timer1*/
+void timer1ControlCallBack()
+{
+	/* Increment the seconds counter */
+	g_secondsCount++;
+	/* Increment the time since power on */
+	g_uptimeSeconds++;
+	/* Count the second of the trace timestamps */
+	TRACE_TICK();
+	/* Count the seconds till the next statistics checkpoint */
+	Stats_tick();
+	/* Accept the limit switch edges left pending */
+	LimitSwitch_tick();
+	/*	Stop the alarm at the end of the lockout	*/
+	if(g_lockoutSeconds>0)
+	{
+		g_lockoutSeconds--;
+		if(g_lockoutSeconds==0)
+		{
+			Buzzer_stop();
+			TRACE(TRACE_EVENT_LOCKOUT, 0);
+		}
+	}
+}
+
+/*	This function is called when the door hits one of its limit switches */
+void limitSwitchControlCallBack(LimitSwitch_DoorPosition position)
+{
+	/* Stop the motor at once, no need to wait for the end of the loop */
+	DcMotor_Rotate(Stop,0);
+	/* Set the door limit flag */
+	g_doorLimitFlag=1;
+}
+
+/* Function to check if two passwords are matched or not*/
+void checkPassword(uint8*password,const UART_Frame*reEnteredPassword)
+{
+	/*if two passwords are matched	*/
+	if(UART_frameEquals(reEnteredPassword,password,PASSWORD_SIZE))
+	{
+		/* Set the Passwords correct flag*/
+		g_passCorrectFlag=1;
+
+		/* Write Password in the external EEPROM */
+		uint8 i=0;
+		for(i=0;i<=PASSWORD_SIZE;i++)
+		{
+			/*	Since EEPROM each location inside it has 1 byte,
+			 * so next location we increment address by 1 */
+			writeEepromByte(0x0311+i, password[i]);
+			/*	Must make 10 ms delay between each write/read operation in EEPROM*/
+			_delay_ms(10);
+		}
+		playFeedback(BUZZER_SUCCESS);
+		TRACE(TRACE_EVENT_PASSWORD_CHECK, MATCHED_PASSWORD);
+		Stats_recordLatency((uint16)(getTimeMs()-g_passwordTime));
+		Histogram_record(HISTOGRAM_PASSWORD_VERIFY,(uint16)(getTimeMs()-g_passwordTime));
+		/*	Send to HMI_ECU that Control_ECU is ready to send	*/
+		UART_sendByte(SEND_PASSWORD);
+		while ( UART_recieveByte() != CONFIRM_SEND_PASSWORD);
+		/*	Send to HMI_ECU that password is matched */
+		UART_sendByte(MATCHED_PASSWORD);
+	}
+	/*if two passwords are NOT Matched */
+	else
+	{
+		rejectPassword();
+	}
+
+}
+
+/* Function to answer a pair of passwords that are not matched */
+void rejectPassword(void)
+{
+	/* Clear the Passwords correct flag*/
+	g_passCorrectFlag=0;
+	playFeedback(BUZZER_FAILURE);
+	TRACE(TRACE_EVENT_PASSWORD_CHECK, UNMATCHED_PASSWORD);
+	Stats_recordLatency((uint16)(getTimeMs()-g_passwordTime));
+	Histogram_record(HISTOGRAM_PASSWORD_VERIFY,(uint16)(getTimeMs()-g_passwordTime));
+	/*	Send to HMI_ECU that Control_ECU is ready to send	*/
+	UART_sendByte(SEND_PASSWORD);
+	while ( UART_recieveByte() != CONFIRM_SEND_PASSWORD);
+	/*	Send to HMI_ECU that password is NOT Matched */
+	UART_sendByte(UNMATCHED_PASSWORD);
+}
+
+/* Function to check if entered password is matched or not matched
+ * in the saved password in EEPROM.
+ */
+void checkPasswordInEEPROM(const UART_Frame*password)
+{
+	uint8 i=0;
+	/* Make array of unsigned character to store inside it
+	 * the password saved in EEPROM.
+	 */
+	uint8 savedPassword[PASSWORD_SIZE+2];
+	/*	Ended even if the EEPROM holds no password	*/
+	savedPassword[PASSWORD_SIZE+1]='\0';
+	/*	Read saved password from EEPROM*/
+	for(i=0;i<=PASSWORD_SIZE;i++)
+	{
+		/*	Since EEPROM each location inside it has 1 byte,
+		 * so next location we increment address by 1*/
+		readEepromByte(0x0311+i, &savedPassword[i]);
+		/*	Must make 10 ms delay between each write/read operation in EEPROM*/
+		_delay_ms(10);
+	}
+
+	/*If password in EEPROM is Matched with password entered by user*/
+	if(UART_frameEquals(password,savedPassword,PASSWORD_SIZE))
+	{
+		playFeedback(BUZZER_SUCCESS);
+		TRACE(TRACE_EVENT_PASSWORD_CHECK, MATCHED_PASSWORD);
+		Stats_recordLatency((uint16)(getTimeMs()-g_passwordTime));
+		Histogram_record(HISTOGRAM_PASSWORD_VERIFY,(uint16)(getTimeMs()-g_passwordTime));
+		/*	Send to HMI_ECU that Control_ECU is ready to send	*/
+		UART_sendByte(SEND_PASSWORD);
+		while ( UART_recieveByte() != CONFIRM_SEND_PASSWORD);
+		/*	Send to HMI_ECU that password is matched */
+		UART_sendByte(MATCHED_PASSWORD);
+
+		/*	Variable to determine if HMI_ECU wants to open door or change the password*/
+		uint8 HMIStatus;
+		HMIStatus=UART_recieveByte();
+
+		/* If HMI_ECU wants to Open Door */
+		if(HMIStatus==OPEN_DOOR)
+		{
+			/*	Variable to hold the measured travel time	*/
+			uint16 travelTime;
+			/*	Start of the door cycle in 1/10 second	*/
+			uint16 cycleStart=getTimeStamp();
+
+			/*	Send to HMI_ECU the expected unlocking time in seconds	*/
+			UART_sendByte((g_unlockTravelTime+9)/10);
+			/*	Rotate Motor Clockwise till the door is unlocked	*/
+			TRACE(TRACE_EVENT_DOOR, OPEN_DOOR);
+			travelTime=moveDoor(Clockwise,g_unlockTravelTime);
+			learnDoorTravelTime(&g_unlockTravelTime,travelTime,DOOR_UNLOCK_TIME_ADDRESS);
+			/*	Send to HMI_ECU that the door is opened, and its real position	*/
+			TRACE(TRACE_EVENT_DOOR, DOOR_UNLOCKED);
+			Stats_increment(STATS_UNLOCKS);
+			UART_sendByte(DOOR_UNLOCKED);
+			UART_sendByte(LimitSwitch_getDoorPosition());
+			/* Clear the seconds counter to start counting from beginning*/
+			g_secondsCount=0;
+			/*	Keep the door opened for 3 seconds	*/
+			/*	Nothing to do till the Timer1 interrupt	*/
+			IDLE_WAIT_UNTIL(g_secondsCount>=DOOR_HOLD_TIME);
+			/*	Send to HMI_ECU that the door is locking	*/
+			TRACE(TRACE_EVENT_DOOR, DOOR_LOCKING);
+			UART_sendByte(DOOR_LOCKING);
+			/*	Send to HMI_ECU the expected locking time in seconds	*/
+			UART_sendByte((g_lockTravelTime+9)/10);
+			/*	Rotate Motor Anti Clockwise till the door is locked	*/
+			travelTime=moveDoor(Anti_Clockwise,g_lockTravelTime);
+			learnDoorTravelTime(&g_lockTravelTime,travelTime,DOOR_LOCK_TIME_ADDRESS);
+			/*	Send to HMI_ECU that the door is locked, and its real position	*/
+			TRACE(TRACE_EVENT_DOOR, DOOR_LOCKED);
+			Histogram_record(HISTOGRAM_DOOR_CYCLE,getTimeStamp()-cycleStart);
+			UART_sendByte(DOOR_LOCKED);
+			UART_sendByte(LimitSwitch_getDoorPosition());
+		}
+
+		/* If HMI_ECU wants to Change Password */
+		if(HMIStatus==CHANGE_PASS)
+		{
+			/*	Set the change password flag */
+			g_changePassFlag=1;
+		}
+		/* Since the two passwords are matched then we
+		 * clear consecutive wrong password counter */
+		g_consecWrongPass=0;
+
+	}/* End of if(UART_frameEquals(password,savedPassword,...)) */
+
+	/*If password in EEPROM is NOT Matched with password entered by user*/
+	else
+	{
+		countWrongPassword();
+	}
+
+}
+
+/* Function to count a wrong password and answer it */
+void countWrongPassword(void)
+{
+	/* increment the consecutive wrong password counter */
+	g_consecWrongPass++;
+	Stats_increment(STATS_WRONG_ATTEMPTS);
+	/*	The third one starts the alarm instead	*/
+	if(g_consecWrongPass<3)
+	{
+		playFeedback(BUZZER_FAILURE);
+	}
+	/* clear the correct password flag,since two passwords are NOT matched*/
+	g_passCorrectFlag=0;
+	TRACE(TRACE_EVENT_PASSWORD_CHECK, UNMATCHED_PASSWORD);
+	Stats_recordLatency((uint16)(getTimeMs()-g_passwordTime));
+	Histogram_record(HISTOGRAM_PASSWORD_VERIFY,(uint16)(getTimeMs()-g_passwordTime));
+	/*	Send to HMI_ECU that Control_ECU is ready to send	*/
+	UART_sendByte(SEND_PASSWORD);
+	while ( UART_recieveByte() != CONFIRM_SEND_PASSWORD);
+	/*	Send to HMI_ECU that password is NOT matched */
+	UART_sendByte(UNMATCHED_PASSWORD);
+}
+
+/* Function to answer a password received during the lockout without checking it,
+ * the lockout is for all the panels
+ */
+void refusePassword(void)
+{
+	TRACE(TRACE_EVENT_PASSWORD_CHECK, LOCKED_OUT);
+	/*	Send to HMI_ECU that Control_ECU is ready to send	*/
+	UART_sendByte(SEND_PASSWORD);
+	while ( UART_recieveByte() != CONFIRM_SEND_PASSWORD);
+	/*	Send to HMI_ECU that the password was not checked */
+	UART_sendByte(LOCKED_OUT);
+}
+
+/* Function to rotate the door motor until it hits a limit switch or stalls
+ * at the end of travel, or until the timeout of the learned travel time.
+ * It returns the measured travel time, DOOR_TRAVEL_TIMED_OUT or 0 if
+ * the door was already there.
+ */
+uint16 moveDoor(DcMotor_State direction,uint16 travelTime)
+{
+	/*	The door position this rotation direction moves to	*/
+	LimitSwitch_DoorPosition target =
+			(direction==Clockwise) ? DOOR_POSITION_OPENED : DOOR_POSITION_CLOSED;
+	uint16 timeout;
+	uint16 startTime;
+	uint16 elapsedTime=0;
+	uint8 speed=DOOR_MOTOR_SPEED;
+	uint8 endReached;
+	uint8 sreg;
+
+	/*	Nothing to do if the door is already there	*/
+	if(LimitSwitch_getDoorPosition()==target)
+	{
+		return 0;
+	}
+
+	/*	Allow 25% + margin over the learned travel time	*/
+	timeout = travelTime + (travelTime>>2) + DOOR_TRAVEL_TIME_MARGIN;
+	if(timeout > DOOR_MAX_TRAVEL_TIME)
+	{
+		timeout = DOOR_MAX_TRAVEL_TIME;
+	}
+
+	/* Clear the door limit flag */
+	g_doorLimitFlag=0;
+	startTime=getTimeStamp();
+	/*	Rotate Motor at the door speed	*/
+	DcMotor_Rotate(direction,speed);
+	/*	wait till the motor is stopped by a limit switch, stall detection, or the timeout	*/
+	while((elapsedTime<timeout) && (!g_doorLimitFlag) && (!DcMotor_isStalled()))
+	{
+		elapsedTime=getTimeStamp()-startTime;
+
+		/*	Accept the debounced limit switches, it calls limitSwitchControlCallBack	*/
+		LimitSwitch_update();
+
+		/*	Keep the last speed measured at the door speed, 0 till the first pulses	*/
+		if((speed==DOOR_MOTOR_SPEED) && (SpeedControl_getRpm()!=0))
+		{
+			g_motorRpm=SpeedControl_getRpm();
+			g_motorDutyCycle=SpeedControl_getDutyCycle();
+		}
+
+		/*	Slow down just before the learned end of travel, not before it is learned	*/
+		if((speed==DOOR_MOTOR_SPEED) && (travelTime<DOOR_MAX_TRAVEL_TIME) && (elapsedTime+DOOR_RAMP_TIME>=travelTime))
+		{
+			speed=DOOR_APPROACH_SPEED;
+			/*	Only the duty cycle is changed, a motor stopped by the ISRs stays stopped	*/
+			DcMotor_setSpeed(speed);
+		}
+		/*	The stall flag changes in the ADC ISR, every 0.2 ms while the motor runs :
+		 *	checked again with the interrupts disabled, so its wake up is not lost
+		 */
+		sreg=HAL_READ_REG(SREG);
+		cli();
+		if((!g_doorLimitFlag) && (!DcMotor_isStalled()))
+		{
+			Idle_sleep();
+		}
+		HAL_WRITE_REG(SREG, sreg);
+	}
+	elapsedTime=getTimeStamp()-startTime;
+	endReached=(g_doorLimitFlag || DcMotor_isStalled());
+	TRACE(TRACE_EVENT_MOTOR, g_motorDutyCycle);
+	/* Stop the motor */
+	DcMotor_Rotate(Stop,0);
+
+	if(!endReached)
+	{
+		return DOOR_TRAVEL_TIMED_OUT;
+	}
+	/*	0 is kept for a door that did not move	*/
+	return (elapsedTime==0) ? 1 : elapsedTime;
+}
+
+/* Function to update the learned travel time with the measured one
+ * and save it in EEPROM if it is changed.
+ */
+void learnDoorTravelTime(uint16*travelTime,uint16 measuredTime,uint16 address)
+{
+	uint16 newTravelTime;
+
+	/*	The door did not move, nothing learned	*/
+	if(measuredTime==0)
+	{
+		return;
+	}
+	/*	The end of travel was not detected, start learning again from the maximum	*/
+	else if(measuredTime==DOOR_TRAVEL_TIMED_OUT)
+	{
+		newTravelTime=DOOR_MAX_TRAVEL_TIME;
+	}
+	/*	First travel after the maximum, take it as it is	*/
+	else if(*travelTime>=DOOR_MAX_TRAVEL_TIME)
+	{
+		newTravelTime=measuredTime;
+	}
+	/*	Running average : 3/4 old + 1/4 measured	*/
+	else
+	{
+		newTravelTime=((3*(*travelTime))+measuredTime+2)/4;
+	}
+
+	/*	Write EEPROM only when needed	*/
+	if(newTravelTime!=*travelTime)
+	{
+		*travelTime=newTravelTime;
+		writeEepromByte(address, (uint8)newTravelTime);
+		/*	Must make 10 ms delay between each write/read operation in EEPROM*/
+		_delay_ms(10);
+		writeEepromByte(address+1, (uint8)(newTravelTime>>8));
+		_delay_ms(10);
+	}
+}
+
+/* Function to play a short buzzer pattern unless the lockout alarm is playing */
+void playFeedback(Buzzer_Pattern pattern)
+{
+	if(g_lockoutSeconds==0)
+	{
+		/*	Returns at once, the pattern is played by the Timer2 interrupt	*/
+		Buzzer_play(pattern);
+	}
+}
+
+/* Function to send the motor speed measured during the last travel as one text line :
+ * MOTOR RPM <rpm> DUTY <duty cycle %> TARGET <rpm>
+ */
+void sendMotorTelemetry(void)
+{
+	UART_sendString((const uint8 *)"MOTOR RPM ");
+	sendNumber(g_motorRpm);
+	UART_sendString((const uint8 *)" DUTY ");
+	sendNumber(g_motorDutyCycle);
+	UART_sendString((const uint8 *)" TARGET ");
+	sendNumber((uint16)(((uint32)DOOR_MOTOR_SPEED*SPEED_CONTROL_MAX_RPM)/100));
+	UART_sendString((const uint8 *)"\r\n");
+}
+
+/* Function to send a number in decimal */
+void sendNumber(uint16 number)
+{
+	uint8 digits[5];
+	uint8 i=0;
+
+	do
+	{
+		digits[i++]='0'+(number%10);
+		number/=10;
+	}while(number!=0);
+
+	while(i>0)
+	{
+		UART_sendByte(digits[--i]);
+	}
+}
+
+/* Function to read the learned travel time from EEPROM */
+void loadDoorTravelTime(uint16*travelTime,uint16 address)
+{
+	uint8 lowByte=0;
+	uint8 highByte=0;
+
+	readEepromByte(address, &lowByte);
+	/*	Must make 10 ms delay between each write/read operation in EEPROM*/
+	_delay_ms(10);
+	readEepromByte(address+1, &highByte);
+	_delay_ms(10);
+
+	*travelTime=((uint16)highByte<<8) | lowByte;
+	/*	Erased EEPROM (0xFFFF) or invalid value, not learned yet	*/
+	if((*travelTime==0) || (*travelTime>DOOR_MAX_TRAVEL_TIME))
+	{
+		*travelTime=DOOR_MAX_TRAVEL_TIME;
+	}
+}
+
+/* Function to return the time passed since power on in 1/10 second */
+uint16 getTimeStamp(void)
+{
+	return (uint16)(getTimeMs()/100);
+}
+
+/* Function to return the time passed since power on in ms */
+uint32 getTimeMs(void)
+{
+	uint16 seconds;
+	uint16 ticks;
+
+	/*	Read again if the second is incremented while reading the counter	*/
+	do
+	{
+		seconds=g_uptimeSeconds;
+		ticks=Timer1_getCount();
+	}while(seconds!=g_uptimeSeconds);
+
+	/*	TCNT1 still reads the compare value for one timer tick after
+	 *	the compare interrupt has counted the new second
+	 */
+	if(ticks>=(10*TIMER1_TICKS_PER_TENTH_SECOND))
+	{
+		ticks=0;
+	}
+
+	return ((uint32)seconds*1000) + (((uint32)ticks*100)/TIMER1_TICKS_PER_TENTH_SECOND);
+}
+
+/* Function to return the Timer1 ticks passed since the start count, less than 1 second */
+uint16 getTicksSince(uint16 start)
+{
+	uint16 ticks=Timer1_getCount();
+
+	/*	TCNT1 reads the compare value for one tick after the new second	*/
+	if(ticks>=(10*TIMER1_TICKS_PER_TENTH_SECOND))
+	{
+		ticks=0;
+	}
+	if(start>=(10*TIMER1_TICKS_PER_TENTH_SECOND))
+	{
+		start=0;
+	}
+	/*	The counter restarted from 0 at the new second	*/
+	if(ticks<start)
+	{
+		ticks+=10*TIMER1_TICKS_PER_TENTH_SECOND;
+	}
+	return ticks-start;
+}
+
+/* Function to read a byte from the external EEPROM, counting its error and latency */
+uint8 readEepromByte(uint16 address,uint8*data)
+{
+	uint16 start=Timer1_getCount();
+	uint8 status=EEPROM_readByte(address, data);
+
+	Histogram_record(HISTOGRAM_EEPROM_READ,getTicksSince(start));
+	if(status == ERROR)
+	{
+		Stats_increment(STATS_EEPROM_ERRORS);
+	}
+	return status;
+}
+
+/* Function to write a byte in the external EEPROM, counting its error and latency */
+uint8 writeEepromByte(uint16 address,uint8 data)
+{
+	uint16 start=Timer1_getCount();
+	uint8 status=EEPROM_writeByte(address, data);
+
+	Histogram_record(HISTOGRAM_EEPROM_WRITE,getTicksSince(start));
+	if(status == ERROR)
+	{
+		Stats_increment(STATS_EEPROM_ERRORS);
+	}
+	return status;
+}
@@ -5,34 +5,73 @@
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
 ../Control_Ecu.c \
-../PWM_Timer0.c \
+../adc.c \
 ../buzzer.c \
 ../dc_motor.c \
 ../external_eeprom.c \
+../external_interrupt.c \
 ../gpio.c \
+../histogram.c \
+../idle.c \
+../limit_switch.c \
+../link.c \
+../multidrop.c \
+../profiler.c \
+../pwm.c \
+../queue.c \
+../speed_control.c \
+../stack_monitor.c \
+../stats.c \
 ../timer1.c \
+../trace.c \
 ../twi.c \
 ../uart.c 
 
 OBJS += \
 ./Control_Ecu.o \
-./PWM_Timer0.o \
+./adc.o \
 ./buzzer.o \
 ./dc_motor.o \
 ./external_eeprom.o \
+./external_interrupt.o \
 ./gpio.o \
+./histogram.o \
+./idle.o \
+./limit_switch.o \
+./link.o \
+./multidrop.o \
+./profiler.o \
+./pwm.o \
+./queue.o \
+./speed_control.o \
+./stack_monitor.o \
+./stats.o \
 ./timer1.o \
+./trace.o \
 ./twi.o \
 ./uart.o 
 
 C_DEPS += \
 ./Control_Ecu.d \
-./PWM_Timer0.d \
+./adc.d \
 ./buzzer.d \
 ./dc_motor.d \
 ./external_eeprom.d \
+./external_interrupt.d \
 ./gpio.d \
+./histogram.d \
+./idle.d \
+./limit_switch.d \
+./link.d \
+./multidrop.d \
+./profiler.d \
+./pwm.d \
+./queue.d \
+./speed_control.d \
+./stack_monitor.d \
+./stats.d \
 ./timer1.d \
+./trace.d \
 ./twi.d \
 ./uart.d 
 
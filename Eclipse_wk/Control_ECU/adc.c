@@ -0,0 +1,115 @@
+ /******************************************************************************
+ *
+ * Module: ADC
+ *
+ * File Name: adc.c
+ *
+ * Description: Source file for the ATmega32 ADC driver
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include <avr/interrupt.h> /* For ADC ISR */
+#include "mcu_hal.h"	/* For Register access */
+#include "adc.h"
+#include "idle.h"		/* For the wake reason */
+
+/*******************************************************************************
+ *                      Global Variables                                  *
+ *******************************************************************************/
+
+static void (*volatile g_callBackPtr)(uint16) = NULL_PTR;
+
+/* Running average scaled by 2^ADC_FILTER_SHIFT to keep the fraction bits */
+static volatile uint16 g_filterAccumulator = 0;
+
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Function to initialize the ADC driver in free running mode:
+ * 1. Select the reference voltage and the input channel.
+ * 2. Enable the ADC conversion complete interrupt.
+ * 3. Start the first conversion, every next conversion starts automatically.
+ */
+void ADC_init(const ADC_ConfigType * Config_Ptr)
+{
+	/* REFS1:0 = reference voltage , ADLAR = 0 right adjusted , MUX4:0 = channel */
+	HAL_WRITE_REG(ADMUX, (((Config_Ptr->ref_volt)<<6) & 0xC0) | ((Config_Ptr->channel) & 0x07));
+
+	/* ADTS2:0 = 000 Free Running mode */
+	HAL_WRITE_REG(SFIOR, HAL_READ_REG(SFIOR) & 0x1F);
+
+	/* Start from zero so the average rises with the first samples */
+	g_filterAccumulator = 0;
+
+	/************************** ADCSRA Description **************************
+	 * ADEN    = 1 Enable ADC
+	 * ADSC    = 1 Start the first conversion
+	 * ADATE   = 1 Auto trigger, next conversions are started by the free running trigger
+	 * ADIE    = 1 Enable ADC conversion complete interrupt
+	 * ADPS2:0 = prescaler, ADC clock must be between 50 and 200 KHz
+	 ***********************************************************************/
+	HAL_WRITE_REG(ADCSRA, (1<<ADEN) | (1<<ADSC) | (1<<ADATE) | (1<<ADIE) | ((Config_Ptr->prescaler) & 0x07));
+}
+
+/*
+ * Description :
+ * Function to stop the conversions and disable the ADC.
+ */
+void ADC_deInit(void)
+{
+	HAL_WRITE_REG(ADCSRA, 0);
+	HAL_WRITE_REG(ADMUX, 0);
+}
+
+/*
+ * Description :
+ * Function to return the last filtered conversion value (0 --> 1023).
+ */
+uint16 ADC_getFilteredValue(void)
+{
+	uint16 filtered;
+
+	/* 16-bit variable shared with the ISR, read it with interrupts disabled */
+	uint8 sreg = HAL_READ_REG(SREG);
+	cli();
+	filtered = g_filterAccumulator >> ADC_FILTER_SHIFT;
+	HAL_WRITE_REG(SREG, sreg);
+
+	return filtered;
+}
+
+/*
+ * Description :
+ * Function to set the Call Back function address.
+ * It is called from the ADC ISR with the new filtered value after every conversion.
+ */
+void ADC_setCallBack(void(*a_ptr)(uint16))
+{
+	/* Save the address of the Call back function in a global variable */
+	g_callBackPtr = a_ptr;
+}
+
+
+/*******************************************************************************
+ *                      		ISRs 		                                   *
+ *******************************************************************************/
+
+ISR(ADC_vect)
+{
+	Idle_noteWake(IDLE_WAKE_ADC);
+
+	/* Filter in place : acc = acc - acc/2^N + sample */
+	g_filterAccumulator = g_filterAccumulator - (g_filterAccumulator >> ADC_FILTER_SHIFT) + HAL_READ_REG16(ADC);
+
+	if(g_callBackPtr != NULL_PTR)
+	{
+		/* Call the Call Back function in the application with the filtered value */
+		(*g_callBackPtr)(g_filterAccumulator >> ADC_FILTER_SHIFT);
+	}
+}
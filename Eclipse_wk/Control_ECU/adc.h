@@ -0,0 +1,83 @@
+ /******************************************************************************
+ *
+ * Module: ADC
+ *
+ * File Name: adc.h
+ *
+ * Description: Header file for the ATmega32 ADC driver
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef ADC_H_
+#define ADC_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define ADC_MAXIMUM_VALUE    1023
+
+/*
+ * Each new sample is merged in the running average as:
+ * filtered = filtered + (sample - filtered) / 2^ADC_FILTER_SHIFT
+ * Keep it <= 6 so the accumulator fits in 16-bit.
+ */
+#define ADC_FILTER_SHIFT     3
+
+/*******************************************************************************
+ *                      Configuration                                          *
+ *******************************************************************************/
+
+typedef enum{
+	AREF,AVCC,INTERNAL_2_56V=0x03
+}ADC_ReferenceVoltage;
+
+typedef enum{
+	ADC_F_CPU_2=1,ADC_F_CPU_4,ADC_F_CPU_8,ADC_F_CPU_16,ADC_F_CPU_32,ADC_F_CPU_64,ADC_F_CPU_128
+}ADC_Prescaler;
+
+typedef struct{
+	ADC_ReferenceVoltage ref_volt;
+	ADC_Prescaler prescaler;
+	uint8 channel;	/* ADC0 --> ADC7 */
+}ADC_ConfigType;
+
+
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Function to initialize the ADC driver in free running mode:
+ * 1. Select the reference voltage and the input channel.
+ * 2. Enable the ADC conversion complete interrupt.
+ * 3. Start the first conversion, every next conversion starts automatically.
+ */
+void ADC_init(const ADC_ConfigType * Config_Ptr);
+
+/*
+ * Description :
+ * Function to stop the conversions and disable the ADC.
+ */
+void ADC_deInit(void);
+
+/*
+ * Description :
+ * Function to return the last filtered conversion value (0 --> 1023).
+ */
+uint16 ADC_getFilteredValue(void);
+
+/*
+ * Description :
+ * Function to set the Call Back function address.
+ * It is called from the ADC ISR with the new filtered value after every conversion.
+ */
+void ADC_setCallBack(void(*a_ptr)(uint16));
+
+#endif /* ADC_H_ */
@@ -1,50 +1,165 @@
-/*
- * buzzer.c
- *
- *  Created on: Oct 26, 2022
- *      Author: Omar Elsherif
- */
-
-
-#include"buzzer.h"
-#include"gpio.h"
-#include"std_types.h"
-
-/*******************************************************************************
- *                      Functions Definitions                                  *
- *******************************************************************************/
-
-
-/*
- * Description :
- * 1. Setup the direction for the buzzer pin as output pin through the GPIO driver.
- * 2. Turn off the buzzer through the GPIO.
- */
-void Buzzer_init(void)
-{
-	/*	Setup Pin of buzzer as Output*/
-	GPIO_setupPinDirection(BUZZER_PORT_ID, BUZZER_PIN_ID, PIN_OUTPUT);
-
-	/*	Initially Turn Off the Buzzer */
-	GPIO_writePin(BUZZER_PORT_ID, BUZZER_PIN_ID, LOGIC_LOW);
-}
-
-/*
- * Description :
- * Function to enable the Buzzer through the GPIO
- */
-void Buzzer_on(void)
-{
-	/*	Turn On the Buzzer */
-	GPIO_writePin(BUZZER_PORT_ID, BUZZER_PIN_ID, LOGIC_HIGH);
-}
-
-/*
- * Description :
- * Function to disable the Buzzer through the GPIO
- */
-void Buzzer_off(void)
-{
-	/*	Turn Off the Buzzer */
-	GPIO_writePin(BUZZER_PORT_ID, BUZZER_PIN_ID, LOGIC_LOW);
-}
+/*
+ * buzzer.c
+ *
+ *  Created on: Oct 26, 2022
+ *      Author: Omar Elsherif
+ */
+
+
+#include <avr/pgmspace.h>	/* For patterns in flash */
+#include"buzzer.h"
+#include"pwm.h"
+#include"std_types.h"
+
+/*******************************************************************************
+ *                      Patterns in Flash                                      *
+ *******************************************************************************/
+
+static const Buzzer_Segment g_alarmPattern[] PROGMEM = {
+		{BUZZER_TONE_HIGH, 250}, {BUZZER_TONE_MID, 250}, {0, 0}
+};
+static const Buzzer_Segment g_keyClickPattern[] PROGMEM = {
+		{BUZZER_TONE_HIGH, 15}, {0, 0}
+};
+static const Buzzer_Segment g_successPattern[] PROGMEM = {
+		{BUZZER_TONE_MID, 80}, {BUZZER_SILENCE, 40}, {BUZZER_TONE_HIGH, 120}, {0, 0}
+};
+static const Buzzer_Segment g_failurePattern[] PROGMEM = {
+		{BUZZER_TONE_LOW, 150}, {BUZZER_SILENCE, 60}, {BUZZER_TONE_LOW, 300}, {0, 0}
+};
+
+/* Indexed by Buzzer_Pattern */
+static const Buzzer_Segment * const g_patterns[] = {
+		g_alarmPattern, g_keyClickPattern, g_successPattern, g_failurePattern
+};
+
+/*******************************************************************************
+ *                      Global Variables                                  *
+ *******************************************************************************/
+
+/* Pattern being played, NULL_PTR when the buzzer is off */
+static const Buzzer_Segment * volatile g_pattern = NULL_PTR;
+static volatile uint8 g_segmentIndex = 0;
+static volatile uint8 g_repeat = FALSE;
+/* PWM periods left in the current segment */
+static volatile uint16 g_periodsLeft = 0;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Start the segment g_segmentIndex of the pattern, return FALSE at the pattern end.
+ */
+static uint8 Buzzer_startSegment(void);
+
+/*
+ * Called from the Timer2 overflow ISR at the start of every PWM period
+ */
+static void Buzzer_periodCallBack(void);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+
+/*
+ * Description :
+ * Turn off the buzzer, Timer2 runs only while a pattern is played.
+ */
+void Buzzer_init(void)
+{
+	/*	Setup Pin of buzzer as Output and initially Turn Off the Buzzer */
+	PWM_ConfigType PWM_Config = {BUZZER_PWM_CHANNEL, BUZZER_TONE_HIGH};
+	PWM_init(&PWM_Config);
+	PWM_stop(BUZZER_PWM_CHANNEL);
+}
+
+/*
+ * Description :
+ * Start playing the pattern from flash in the background and return immediately.
+ * The Timer2 PWM period interrupt moves from one segment to the next,
+ * any pattern already playing is replaced.
+ */
+void Buzzer_play(Buzzer_Pattern pattern)
+{
+	Buzzer_stop();
+
+	g_pattern = g_patterns[pattern];
+	g_segmentIndex = 0;
+	g_repeat = (pattern == BUZZER_ALARM);
+
+	if(Buzzer_startSegment())
+	{
+		PWM_setCallBack(BUZZER_PWM_CHANNEL, Buzzer_periodCallBack);
+	}
+}
+
+/*
+ * Description :
+ * Stop the pattern and turn off the buzzer.
+ */
+void Buzzer_stop(void)
+{
+	PWM_setCallBack(BUZZER_PWM_CHANNEL, NULL_PTR);
+	PWM_stop(BUZZER_PWM_CHANNEL);
+	g_pattern = NULL_PTR;
+}
+
+/*
+ * Description :
+ * Return TRUE while a pattern is playing.
+ */
+uint8 Buzzer_isPlaying(void)
+{
+	return (g_pattern != NULL_PTR);
+}
+
+
+static uint8 Buzzer_startSegment(void)
+{
+	uint16 frequency = pgm_read_word(&g_pattern[g_segmentIndex].frequency);
+	uint16 duration = pgm_read_word(&g_pattern[g_segmentIndex].duration_ms);
+
+	if(duration == 0)
+	{
+		return FALSE;
+	}
+
+	if(frequency != BUZZER_SILENCE)
+	{
+		/* New tone : restart Timer2 with the prescaler of the tone, 50% duty cycle */
+		PWM_ConfigType PWM_Config = {BUZZER_PWM_CHANNEL, frequency};
+		PWM_init(&PWM_Config);
+		PWM_setDutyCycle(BUZZER_PWM_CHANNEL, 50);
+	}
+	else
+	{
+		/* Silence : keep Timer2 running to count the time, OC2 off */
+		PWM_setDutyCycle(BUZZER_PWM_CHANNEL, 0);
+	}
+
+	/* Segment time counted in PWM periods of the current frequency */
+	g_periodsLeft = (uint16)(((uint32)duration * PWM_getFrequency(BUZZER_PWM_CHANNEL)) / 1000);
+	return TRUE;
+}
+
+static void Buzzer_periodCallBack(void)
+{
+	if(g_periodsLeft > 0)
+	{
+		g_periodsLeft--;
+		return;
+	}
+
+	/* Move to the next segment, from the start again for a repeated pattern */
+	g_segmentIndex++;
+	if(!Buzzer_startSegment())
+	{
+		g_segmentIndex = 0;
+		if((!g_repeat) || (!Buzzer_startSegment()))
+		{
+			Buzzer_stop();
+		}
+	}
+}
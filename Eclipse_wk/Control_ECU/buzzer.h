@@ -1,45 +1,77 @@
-/*
- * buzzer.h
- *
- *  Created on: Oct 26, 2022
- *      Author: Omar Elsherif
- */
-
-#ifndef BUZZER_H_
-#define BUZZER_H_
-
-
-/*******************************************************************************
- *                                Definitions                                  *
- *******************************************************************************/
-
-#define BUZZER_PORT_ID		PORTD_ID
-#define BUZZER_PIN_ID		PIN2_ID
-
-
-/*******************************************************************************
- *                      Functions Prototypes                                   *
- *******************************************************************************/
-
-
-/*
- * Description :
- * 1. Setup the direction for the buzzer pin as output pin through the GPIO driver.
- * 2. Turn off the buzzer through the GPIO.
- */
-void Buzzer_init(void);
-
-/*
- * Description :
- * Function to enable the Buzzer through the GPIO
- */
-void Buzzer_on(void);
-
-/*
- * Description :
- * Function to disable the Buzzer through the GPIO
- */
-void Buzzer_off(void);
-
-
-#endif /* BUZZER_H_ */
+/*
+ * buzzer.h
+ *
+ *  Created on: Oct 26, 2022
+ *      Author: Omar Elsherif
+ */
+
+#ifndef BUZZER_H_
+#define BUZZER_H_
+
+#include "std_types.h"
+#include "pwm.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* The buzzer is driven by Timer2 PWM on OC2 (PD7),
+ * PD2/PD3 are used by INT0/INT1 of the door limit switches */
+#define BUZZER_PWM_CHANNEL		PWM_CHANNEL_OC2
+
+/* Tones, Timer2 fast PWM can only give F_CPU/(256*N) */
+#define BUZZER_TONE_HIGH		3906
+#define BUZZER_TONE_MID			977
+#define BUZZER_TONE_LOW			488
+#define BUZZER_SILENCE			0
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef enum{
+	BUZZER_ALARM,		/* repeated till Buzzer_stop() is called */
+	BUZZER_KEY_CLICK,
+	BUZZER_SUCCESS,
+	BUZZER_FAILURE
+}Buzzer_Pattern;
+
+/* One tone or silence of a pattern, a zero duration ends the pattern */
+typedef struct{
+	uint16 frequency;
+	uint16 duration_ms;
+}Buzzer_Segment;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+
+/*
+ * Description :
+ * Turn off the buzzer, Timer2 runs only while a pattern is played.
+ */
+void Buzzer_init(void);
+
+/*
+ * Description :
+ * Start playing the pattern from flash in the background and return immediately.
+ * The Timer2 PWM period interrupt moves from one segment to the next,
+ * any pattern already playing is replaced.
+ */
+void Buzzer_play(Buzzer_Pattern pattern);
+
+/*
+ * Description :
+ * Stop the pattern and turn off the buzzer.
+ */
+void Buzzer_stop(void);
+
+/*
+ * Description :
+ * Return TRUE while a pattern is playing.
+ */
+uint8 Buzzer_isPlaying(void);
+
+
+#endif /* BUZZER_H_ */
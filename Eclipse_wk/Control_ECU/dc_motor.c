@@ -1,33 +1,142 @@
-/*
- * dc_motor.c
- *
- *  Created on: 4 Oct 2022
- *      Author: Omar Elsheriif
- */
-
-#include "dc_motor.h"
-
-
-void DcMotor_Init(void)
-{
-	/* Setting up motor1 o/p pins*/
-	GPIO_setupPinDirection(Motor1_PORT_ID, Motor1_INPUT_PIN1, PIN_OUTPUT);
-	GPIO_setupPinDirection(Motor1_PORT_ID, Motor1_INPUT_PIN2, PIN_OUTPUT);
-
-	/* Initially Motor is Stopped*/
-	GPIO_writePin(Motor1_PORT_ID,Motor1_INPUT_PIN1,Stop);
-	GPIO_writePin(Motor1_PORT_ID,Motor1_INPUT_PIN2,Stop);
-
-}
-
-
-void DcMotor_Rotate(DcMotor_State state,uint8 speed)
-{
-	/* change the state of the motor according to input state given */
-	GPIO_writePin(Motor1_PORT_ID,Motor1_INPUT_PIN1,(state&0x01));
-	GPIO_writePin(Motor1_PORT_ID,Motor1_INPUT_PIN2,((state&0x02)>>1));
-
-	/* generate duty cycle of speed value (0-->100) to get required motor speed */
-	PWM_Timer0_Start(speed);
-
-}
+/*
+ * dc_motor.c
+ *
+ *  Created on: 4 Oct 2022
+ *      Author: Omar Elsheriif
+ */
+
+#include "dc_motor.h"
+#include "adc.h"
+#include "speed_control.h"
+
+/*******************************************************************************
+ *                      Global Variables                                  *
+ *******************************************************************************/
+
+/* Current state of the motor, to ignore current samples while it is stopped */
+static volatile DcMotor_State g_motorState = Stop;
+/* Set by the ADC ISR when the motor is stopped due to stall */
+static volatile uint8 g_motorStalled = FALSE;
+/* Number of samples still to be ignored since the motor started */
+static volatile uint16 g_blankingSamples = 0;
+/* Number of consecutive samples above the stall threshold */
+static volatile uint8 g_stallSamples = 0;
+
+/*	Sample the shunt voltage in free running mode :
+ * AVCC reference
+ * ADC clock = F_CPU/128 = 62.5 KHz
+ */
+static const ADC_ConfigType g_shuntAdcConfig = {AVCC, ADC_F_CPU_128, Motor1_SHUNT_ADC_CHANNEL};
+
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Function called from the ADC ISR with every new filtered current sample
+ */
+static void DcMotor_currentCallBack(uint16 current);
+
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+void DcMotor_Init(void)
+{
+	/* Setting up motor1 o/p pins*/
+	GPIO_setupPinDirection(Motor1_PORT_ID, Motor1_INPUT_PIN1, PIN_OUTPUT);
+	GPIO_setupPinDirection(Motor1_PORT_ID, Motor1_INPUT_PIN2, PIN_OUTPUT);
+
+	/* Initially Motor is Stopped*/
+	GPIO_writePin(Motor1_PORT_ID,Motor1_INPUT_PIN1,Stop);
+	GPIO_writePin(Motor1_PORT_ID,Motor1_INPUT_PIN2,Stop);
+
+	/*	Start the PWM timer with 0% duty cycle, F_PWM = 488 Hz	*/
+	PWM_ConfigType PWM_Config = {Motor1_PWM_CHANNEL, Motor1_PWM_FREQUENCY};
+	PWM_init(&PWM_Config);
+
+	/*	Keep the speed constant from the encoder feedback	*/
+	SpeedControl_init();
+
+	/*	The shunt is sampled only while the motor is driven	*/
+	ADC_setCallBack(DcMotor_currentCallBack);
+}
+
+
+void DcMotor_Rotate(DcMotor_State state,uint8 speed)
+{
+	/* restart the stall detection for the new rotation,
+	 * the ISR ignores the samples until the new state is set */
+	g_motorState = Stop;
+	g_motorStalled = FALSE;
+	g_stallSamples = 0;
+	g_blankingSamples = MOTOR_INRUSH_BLANKING_SAMPLES;
+	g_motorState = state;
+
+	/* change the state of the motor according to input state given */
+	GPIO_writePin(Motor1_PORT_ID,Motor1_INPUT_PIN1,(state&0x01));
+	GPIO_writePin(Motor1_PORT_ID,Motor1_INPUT_PIN2,((state&0x02)>>1));
+
+	/* generate duty cycle of speed value (0-->100), then the speed controller
+	 * corrects it to keep the required motor speed */
+	SpeedControl_setSpeed((state==Stop) ? 0 : speed);
+
+	/* No current to sense while the motor is stopped, the 4800 ADC
+	 * interrupts per second are only needed while it rotates */
+	if(state==Stop)
+	{
+		ADC_deInit();
+	}
+	else
+	{
+		ADC_init(&g_shuntAdcConfig);
+	}
+
+}
+
+
+void DcMotor_setSpeed(uint8 speed)
+{
+	/* the timer keeps running, only the required speed is changed */
+	SpeedControl_setSpeed(speed);
+}
+
+
+uint8 DcMotor_isStalled(void)
+{
+	return g_motorStalled;
+}
+
+
+static void DcMotor_currentCallBack(uint16 current)
+{
+	/* Nothing to detect while the motor is stopped */
+	if(g_motorState == Stop)
+	{
+		return;
+	}
+
+	/* Ignore the inrush current at motor start */
+	if(g_blankingSamples > 0)
+	{
+		g_blankingSamples--;
+		return;
+	}
+
+	if(current >= MOTOR_STALL_CURRENT_THRESHOLD)
+	{
+		g_stallSamples++;
+		/* The door reached its end of travel, stop the motor immediately */
+		if(g_stallSamples >= MOTOR_STALL_CONFIRM_SAMPLES)
+		{
+			DcMotor_Rotate(Stop,0);
+			g_motorStalled = TRUE;
+		}
+	}
+	else
+	{
+		g_stallSamples = 0;
+	}
+}
@@ -1,52 +1,100 @@
-/*
- * dc_motor.h
- *
- *  Created on: 4 Oct 2022
- *      Author: Omar Elsherif
- */
-
-#ifndef DC_MOTOR_H_
-#define DC_MOTOR_H_
-
-#include "gpio.h"
-#include "PWM_Timer0.h"
-/*******************************************************************************
- *                      DC Motor Configurations                                *
- *******************************************************************************/
-typedef enum{
-	Stop,Clockwise,Anti_Clockwise
-}DcMotor_State;
-
-
-/*******************************************************************************
- *                                Definitions                                  *
- *******************************************************************************/
-#define Motor1_PORT_ID		PORTB_ID
-#define Motor1_INPUT_PIN1	PIN0_ID
-#define Motor1_INPUT_PIN2   PIN1_ID
-
-
-
-
-/*******************************************************************************
- *                      Functions Prototypes                                   *
- *******************************************************************************/
-
-/*
- * Description :
- * The Function responsible for setup the direction for the two motor pins through the GPIO driver.
- * Stop at the DC-Motor at the beginning through the GPIO driver.
- */
-void DcMotor_Init(void);
-
-/*
- * Description :
- * The function responsible for rotate the DC Motor CW/ or A-CW or stop the motor based on the state input state value.
- * Send the required duty cycle to the PWM driver based on the required speed value.
-
- */
-void DcMotor_Rotate(DcMotor_State state,uint8 speed);
-
-
-
-#endif /* DC_MOTOR_H_ */
+/*
+ * dc_motor.h
+ *
+ *  Created on: 4 Oct 2022
+ *      Author: Omar Elsherif
+ */
+
+#ifndef DC_MOTOR_H_
+#define DC_MOTOR_H_
+
+#include "gpio.h"
+#include "pwm.h"
+/*******************************************************************************
+ *                      DC Motor Configurations                                *
+ *******************************************************************************/
+typedef enum{
+	Stop,Clockwise,Anti_Clockwise
+}DcMotor_State;
+
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define Motor1_PORT_ID		PORTB_ID
+#ifdef UART_SYNC_ENABLE
+/* PB0 is XCK of the synchronous link, IN1 is wired to PB2 */
+#define Motor1_INPUT_PIN1	PIN2_ID
+#else
+#define Motor1_INPUT_PIN1	PIN0_ID
+#endif
+#define Motor1_INPUT_PIN2   PIN1_ID
+
+/* Motor speed is the duty cycle of Timer0 PWM on OC0 (PB3),
+ * corrected by the speed controller from the encoder on ICP1 (PD6) */
+#define Motor1_PWM_CHANNEL		PWM_CHANNEL_OC0
+#define Motor1_PWM_FREQUENCY	500
+
+/* Motor current is sensed as the voltage across a shunt resistor on ADC0 (PA0) */
+#define Motor1_SHUNT_ADC_CHANNEL	0
+
+/*
+ * Filtered ADC value (AVCC = 5V reference) above which the motor is stalled.
+ * The running door takes ~0.3A, stalled at the ~35% duty cycle of the approach
+ * speed the motor still takes ~0.9A.
+ * 0.5 ohm shunt : 0.6A --> 0.3V --> 0.3*1023/5 = 61
+ */
+#define MOTOR_STALL_CURRENT_THRESHOLD	61
+
+/*
+ * Free running ADC with F_CPU/128 gives 8MHz/128/13 = ~4800 samples per second.
+ * Inrush current at motor start must not be taken as a stall, so ignore
+ * the samples of the first 250 ms, then the current must stay above the
+ * threshold for 20 ms to confirm the stall.
+ */
+#define MOTOR_INRUSH_BLANKING_SAMPLES	1200
+#define MOTOR_STALL_CONFIRM_SAMPLES		96
+
+
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * The Function responsible for setup the direction for the two motor pins through the GPIO driver.
+ * Stop at the DC-Motor at the beginning through the GPIO driver.
+ * The motor current is sampled through the ADC driver only while the motor rotates.
+ */
+void DcMotor_Init(void);
+
+/*
+ * Description :
+ * The function responsible for rotate the DC Motor CW/ or A-CW or stop the motor based on the state input state value.
+ * Send the required speed to the speed controller, that keeps the motor RPM
+ * at the speed percentage of the maximum RPM by changing the PWM duty cycle.
+ * Every new rotation clears the stall flag and starts the inrush blanking time.
+ * The ADC is started with the rotation and stopped with the motor.
+
+ */
+void DcMotor_Rotate(DcMotor_State state,uint8 speed);
+
+/*
+ * Description :
+ * Return TRUE if the motor was stopped by the driver because its current
+ * stayed above the stall threshold (end of travel), FALSE otherwise.
+ */
+uint8 DcMotor_isStalled(void);
+
+/*
+ * Description :
+ * Change the speed of the rotating motor without changing its direction
+ * or restarting its stall detection. The speed controller applies the new
+ * duty cycle at the start of the next PWM period.
+ */
+void DcMotor_setSpeed(uint8 speed);
+
+
+
+#endif /* DC_MOTOR_H_ */
@@ -0,0 +1,118 @@
+ /******************************************************************************
+ *
+ * Module: External Interrupts
+ *
+ * File Name: external_interrupt.c
+ *
+ * Description: Source file for the ATmega32 INT0/INT1 external interrupts driver
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include <avr/interrupt.h> /* For INT0/INT1 ISRs */
+#include "mcu_hal.h"	/* For Register access */
+#include "external_interrupt.h"
+#include "common_macros.h" /* To use the macros like SET_BIT */
+#include "idle.h"		/* For the wake reason */
+
+/*******************************************************************************
+ *                      Global Variables                                  *
+ *******************************************************************************/
+
+static void (*volatile g_int0CallBackPtr)(void) = NULL_PTR;
+static void (*volatile g_int1CallBackPtr)(void) = NULL_PTR;
+
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Function to initialize the external interrupt:
+ * 1. Setup the interrupt pin as input pin.
+ * 2. Select the interrupt sense control.
+ * 3. Enable the external interrupt request.
+ */
+void EXTI_init(const EXTI_ConfigType * Config_Ptr)
+{
+	if(Config_Ptr->id == EXTI_INT0)
+	{
+		/* INT0 pin PD2 is input */
+		HAL_CLEAR_BIT(DDRD,PD2);
+		/* ISC01:0 = sense control */
+		HAL_WRITE_REG(MCUCR, (HAL_READ_REG(MCUCR) & 0xFC) | ((Config_Ptr->sense) & 0x03));
+		/* Clear any old flag, then enable the INT0 request */
+		HAL_WRITE_REG(GIFR, (1<<INTF0));
+		HAL_SET_BIT(GICR,INT0);
+	}
+	else if(Config_Ptr->id == EXTI_INT1)
+	{
+		/* INT1 pin PD3 is input */
+		HAL_CLEAR_BIT(DDRD,PD3);
+		/* ISC11:0 = sense control */
+		HAL_WRITE_REG(MCUCR, (HAL_READ_REG(MCUCR) & 0xF3) | (((Config_Ptr->sense) & 0x03)<<2));
+		/* Clear any old flag, then enable the INT1 request */
+		HAL_WRITE_REG(GIFR, (1<<INTF1));
+		HAL_SET_BIT(GICR,INT1);
+	}
+}
+
+/*
+ * Description :
+ * Function to disable the external interrupt request.
+ */
+void EXTI_deInit(EXTI_Id id)
+{
+	if(id == EXTI_INT0)
+	{
+		HAL_CLEAR_BIT(GICR,INT0);
+	}
+	else if(id == EXTI_INT1)
+	{
+		HAL_CLEAR_BIT(GICR,INT1);
+	}
+}
+
+/*
+ * Description :
+ * Function to set the Call Back function address of the required interrupt.
+ */
+void EXTI_setCallBack(EXTI_Id id,void(*a_ptr)(void))
+{
+	/* Save the address of the Call back function in a global variable */
+	if(id == EXTI_INT0)
+	{
+		g_int0CallBackPtr = a_ptr;
+	}
+	else if(id == EXTI_INT1)
+	{
+		g_int1CallBackPtr = a_ptr;
+	}
+}
+
+
+/*******************************************************************************
+ *                      		ISRs 		                                   *
+ *******************************************************************************/
+
+ISR(INT0_vect)
+{
+	Idle_noteWake(IDLE_WAKE_EXTERNAL);
+	if(g_int0CallBackPtr != NULL_PTR)
+	{
+		/* Call the Call Back function in the application after the edge is detected */
+		(*g_int0CallBackPtr)();
+	}
+}
+
+ISR(INT1_vect)
+{
+	Idle_noteWake(IDLE_WAKE_EXTERNAL);
+	if(g_int1CallBackPtr != NULL_PTR)
+	{
+		/* Call the Call Back function in the application after the edge is detected */
+		(*g_int1CallBackPtr)();
+	}
+}
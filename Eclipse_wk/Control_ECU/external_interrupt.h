@@ -0,0 +1,62 @@
+ /******************************************************************************
+ *
+ * Module: External Interrupts
+ *
+ * File Name: external_interrupt.h
+ *
+ * Description: Header file for the ATmega32 INT0/INT1 external interrupts driver
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef EXTERNAL_INTERRUPT_H_
+#define EXTERNAL_INTERRUPT_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                      Configuration                                          *
+ *******************************************************************************/
+
+typedef enum{
+	EXTI_INT0,EXTI_INT1		/* INT0 --> PD2 , INT1 --> PD3 */
+}EXTI_Id;
+
+typedef enum{
+	LOW_LEVEL,ANY_LOGICAL_CHANGE,FALLING_EDGE,RISING_EDGE
+}EXTI_SenseControl;
+
+typedef struct{
+	EXTI_Id id;
+	EXTI_SenseControl sense;
+}EXTI_ConfigType;
+
+
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Function to initialize the external interrupt:
+ * 1. Setup the interrupt pin as input pin.
+ * 2. Select the interrupt sense control.
+ * 3. Enable the external interrupt request.
+ */
+void EXTI_init(const EXTI_ConfigType * Config_Ptr);
+
+/*
+ * Description :
+ * Function to disable the external interrupt request.
+ */
+void EXTI_deInit(EXTI_Id id);
+
+/*
+ * Description :
+ * Function to set the Call Back function address of the required interrupt.
+ */
+void EXTI_setCallBack(EXTI_Id id,void(*a_ptr)(void));
+
+#endif /* EXTERNAL_INTERRUPT_H_ */
@@ -0,0 +1,151 @@
+ /******************************************************************************
+ *
+ * Module: Histogram
+ *
+ * File Name: histogram.c
+ *
+ * Description: Source file for the log2 latency histograms of the Control ECU
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include "histogram.h"
+#include <avr/pgmspace.h>	/* For the names in flash */
+#include "uart.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define HISTOGRAM_NAME_SIZE			24
+
+/*******************************************************************************
+ *                      Names in Flash                                         *
+ *******************************************************************************/
+
+/* Indexed by Histogram_Id : name and unit */
+static const char g_names[HISTOGRAM_NUM_HISTOGRAMS][HISTOGRAM_NAME_SIZE] PROGMEM = {
+		"PASSWORD_VERIFY ms", "EEPROM_READ tick32us", "EEPROM_WRITE tick32us", "DOOR_CYCLE ds"
+};
+
+/*******************************************************************************
+ *                      Global Variables                                  *
+ *******************************************************************************/
+
+static uint16 g_counts[HISTOGRAM_NUM_HISTOGRAMS][HISTOGRAM_NUM_BUCKETS];
+
+/* Does not compile if the counts do not fit in HISTOGRAM_SRAM_BUDGET */
+typedef uint8 Histogram_BudgetCheck[(sizeof(g_counts) <= HISTOGRAM_SRAM_BUDGET) ? 1 : -1];
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Send the number in decimal
+ */
+static void Histogram_sendNumber(uint16 number);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Add the latency to its bucket.
+ */
+void Histogram_record(Histogram_Id id,uint16 latency)
+{
+	uint8 bucket = 0;
+
+	/* Number of bits of the latency */
+	while((latency != 0) && (bucket < (HISTOGRAM_NUM_BUCKETS - 1)))
+	{
+		latency >>= 1;
+		bucket++;
+	}
+
+	if(g_counts[id][bucket] != 0xFFFF)
+	{
+		g_counts[id][bucket]++;
+	}
+}
+
+/*
+ * Description :
+ * Clear all the histograms.
+ */
+void Histogram_reset(void)
+{
+	uint8 id;
+	uint8 bucket;
+
+	for(id=0;id<HISTOGRAM_NUM_HISTOGRAMS;id++)
+	{
+		for(bucket=0;bucket<HISTOGRAM_NUM_BUCKETS;bucket++)
+		{
+			g_counts[id][bucket] = 0;
+		}
+	}
+}
+
+/*
+ * Description :
+ * Return the count of the bucket.
+ */
+uint16 Histogram_getCount(Histogram_Id id,uint8 bucket)
+{
+	return g_counts[id][bucket];
+}
+
+/*
+ * Description :
+ * Send the histograms over the UART, one line each :
+ * HIST <name> <unit> <count of bucket 0> ... <count of the last bucket>
+ */
+void Histogram_send(void)
+{
+	const char * name;
+	char c;
+	uint8 id;
+	uint8 bucket;
+
+	for(id=0;id<HISTOGRAM_NUM_HISTOGRAMS;id++)
+	{
+		UART_sendString((const uint8 *)"HIST ");
+		name = g_names[id];
+		while((c = pgm_read_byte(name++)) != '\0')
+		{
+			UART_sendByte(c);
+		}
+		for(bucket=0;bucket<HISTOGRAM_NUM_BUCKETS;bucket++)
+		{
+			UART_sendByte(' ');
+			Histogram_sendNumber(g_counts[id][bucket]);
+		}
+		UART_sendString((const uint8 *)"\r\n");
+	}
+}
+
+
+/*******************************************************************************
+ *                      Private Functions                                      *
+ *******************************************************************************/
+
+static void Histogram_sendNumber(uint16 number)
+{
+	uint8 digits[5];
+	uint8 i = 0;
+
+	do
+	{
+		digits[i++] = '0' + (number % 10);
+		number /= 10;
+	}while(number != 0);
+
+	while(i > 0)
+	{
+		UART_sendByte(digits[--i]);
+	}
+}
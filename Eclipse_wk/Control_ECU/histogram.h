@@ -0,0 +1,80 @@
+ /******************************************************************************
+ *
+ * Module: Histogram
+ *
+ * File Name: histogram.h
+ *
+ * Description: Header file for the log2 latency histograms of the Control ECU
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef HISTOGRAM_H_
+#define HISTOGRAM_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Bucket 0 counts the latencies of 0, bucket k the latencies from 2^(k-1)
+ * to 2^k - 1 and the last bucket all the longer ones.
+ * The counts are 16 bits and stop at 0xFFFF.
+ */
+#define HISTOGRAM_NUM_BUCKETS			16
+
+/* SRAM allowed for the counts, checked at build time */
+#define HISTOGRAM_SRAM_BUDGET			160
+
+/*
+ * Bytes sent by the HMI_ECU while the password is awaited : the first one
+ * is answered with one text line per histogram, the second clears them.
+ */
+#define HISTOGRAM_REQUEST				0x13
+#define HISTOGRAM_RESET					0x14
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef enum{
+	HISTOGRAM_PASSWORD_VERIFY,		/* ms from the password received to its answer */
+	HISTOGRAM_EEPROM_READ,			/* Timer1 ticks (32 us) of EEPROM_readByte() */
+	HISTOGRAM_EEPROM_WRITE,			/* Timer1 ticks (32 us) of EEPROM_writeByte() */
+	HISTOGRAM_DOOR_CYCLE,			/* 1/10 s from the unlocking start to locked */
+	HISTOGRAM_NUM_HISTOGRAMS
+}Histogram_Id;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Add the latency to its bucket.
+ */
+void Histogram_record(Histogram_Id id,uint16 latency);
+
+/*
+ * Description :
+ * Clear all the histograms.
+ */
+void Histogram_reset(void);
+
+/*
+ * Description :
+ * Return the count of the bucket.
+ */
+uint16 Histogram_getCount(Histogram_Id id,uint8 bucket);
+
+/*
+ * Description :
+ * Send the histograms over the UART, one line each :
+ * HIST <name> <unit> <count of bucket 0> ... <count of the last bucket>
+ */
+void Histogram_send(void);
+
+#endif /* HISTOGRAM_H_ */
@@ -0,0 +1,250 @@
+ /******************************************************************************
+ *
+ * Module: Limit Switch
+ *
+ * File Name: limit_switch.c
+ *
+ * Description: Source file for the door open/closed limit switches driver
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include <avr/interrupt.h> /* For cli() */
+#include "mcu_hal.h"	/* For Register access */
+#include "limit_switch.h"
+#include "external_interrupt.h"
+#include "gpio.h"
+#include "timer1.h"		/* For the edge time */
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define LIMIT_SWITCH_OPENED				0
+#define LIMIT_SWITCH_CLOSED				1
+#define LIMIT_SWITCH_NUM				2
+
+/*******************************************************************************
+ *                      Global Variables                                  *
+ *******************************************************************************/
+
+static void (*volatile g_callBackPtr)(LimitSwitch_DoorPosition) = NULL_PTR;
+
+static const uint8 g_pins[LIMIT_SWITCH_NUM] = {LIMIT_SWITCH_OPENED_PIN_ID, LIMIT_SWITCH_CLOSED_PIN_ID};
+static const LimitSwitch_DoorPosition g_positions[LIMIT_SWITCH_NUM] = {DOOR_POSITION_OPENED, DOOR_POSITION_CLOSED};
+
+/* Last debounced level of each switch */
+static volatile uint8 g_levels[LIMIT_SWITCH_NUM] = {!LIMIT_SWITCH_PRESSED, !LIMIT_SWITCH_PRESSED};
+
+/* Last edge of each switch not accepted yet : its Timer1 count and the cycles since */
+static volatile uint8 g_edgePending[LIMIT_SWITCH_NUM] = {FALSE, FALSE};
+static volatile uint16 g_edgeCount[LIMIT_SWITCH_NUM];
+static volatile uint8 g_edgeCycles[LIMIT_SWITCH_NUM];
+
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Return the Timer1 count, 0 while it still reads the compare value of the
+ * cycle just ended.
+ */
+static uint16 LimitSwitch_readCount(void);
+
+/*
+ * Return TRUE if the pending edge of the switch is LIMIT_SWITCH_DEBOUNCE_TICKS
+ * old at the Timer1 count now.
+ */
+static uint8 LimitSwitch_isSettled(uint8 index,uint16 now);
+
+/*
+ * Called from INT0/INT1 ISRs on any change of the opened/closed switch
+ */
+static void LimitSwitch_openedCallBack(void);
+static void LimitSwitch_closedCallBack(void);
+static void LimitSwitch_stampEdge(uint8 index);
+
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * 1. Setup the two switch pins as input pins with internal pull-up.
+ * 2. Read the initial door position.
+ * 3. Enable INT0/INT1 on any logical change of the switches.
+ */
+void LimitSwitch_init(void)
+{
+	GPIO_setupPinDirection(LIMIT_SWITCH_PORT_ID, LIMIT_SWITCH_OPENED_PIN_ID, PIN_INPUT);
+	GPIO_setupPinDirection(LIMIT_SWITCH_PORT_ID, LIMIT_SWITCH_CLOSED_PIN_ID, PIN_INPUT);
+
+	/* Enable the internal pull-up resistors */
+	GPIO_writePin(LIMIT_SWITCH_PORT_ID, LIMIT_SWITCH_OPENED_PIN_ID, LOGIC_HIGH);
+	GPIO_writePin(LIMIT_SWITCH_PORT_ID, LIMIT_SWITCH_CLOSED_PIN_ID, LOGIC_HIGH);
+
+	g_levels[LIMIT_SWITCH_OPENED] = GPIO_readPin(LIMIT_SWITCH_PORT_ID, LIMIT_SWITCH_OPENED_PIN_ID);
+	g_levels[LIMIT_SWITCH_CLOSED] = GPIO_readPin(LIMIT_SWITCH_PORT_ID, LIMIT_SWITCH_CLOSED_PIN_ID);
+	g_edgePending[LIMIT_SWITCH_OPENED] = FALSE;
+	g_edgePending[LIMIT_SWITCH_CLOSED] = FALSE;
+
+	EXTI_setCallBack(EXTI_INT0, LimitSwitch_openedCallBack);
+	EXTI_setCallBack(EXTI_INT1, LimitSwitch_closedCallBack);
+
+	EXTI_ConfigType EXTI_Config = {EXTI_INT0, ANY_LOGICAL_CHANGE};
+	EXTI_init(&EXTI_Config);
+	EXTI_Config.id = EXTI_INT1;
+	EXTI_init(&EXTI_Config);
+}
+
+/*
+ * Description :
+ * Return the door position from the last debounced switch levels.
+ * DOOR_POSITION_UNKNOWN means the door is between the two limits.
+ */
+LimitSwitch_DoorPosition LimitSwitch_getDoorPosition(void)
+{
+	/* Take the edges settled since the last call */
+	LimitSwitch_update();
+
+	if(g_levels[LIMIT_SWITCH_OPENED] == LIMIT_SWITCH_PRESSED)
+	{
+		return DOOR_POSITION_OPENED;
+	}
+	else if(g_levels[LIMIT_SWITCH_CLOSED] == LIMIT_SWITCH_PRESSED)
+	{
+		return DOOR_POSITION_CLOSED;
+	}
+	else
+	{
+		return DOOR_POSITION_UNKNOWN;
+	}
+}
+
+/*
+ * Description :
+ * Function to set the Call Back function address. It is called from
+ * LimitSwitch_update() with the new position when a limit switch is pressed.
+ */
+void LimitSwitch_setCallBack(void(*a_ptr)(LimitSwitch_DoorPosition))
+{
+	/* Save the address of the Call back function in a global variable */
+	g_callBackPtr = a_ptr;
+}
+
+
+/*
+ * Description :
+ * Accept the level of each switch that has not changed for the debounce time
+ * and call the Call Back function for a switch just pressed. The stop of the
+ * door is late by the time between two calls.
+ */
+void LimitSwitch_update(void)
+{
+	uint8 i;
+	uint8 level;
+	LimitSwitch_DoorPosition pressed = DOOR_POSITION_UNKNOWN;
+	/* The edge state is shared with the ISRs, take it with interrupts disabled */
+	uint8 sreg = HAL_READ_REG(SREG);
+	cli();
+
+	for(i=0;i<LIMIT_SWITCH_NUM;i++)
+	{
+		if(g_edgePending[i] && LimitSwitch_isSettled(i, LimitSwitch_readCount()))
+		{
+			g_edgePending[i] = FALSE;
+			level = GPIO_readPin(LIMIT_SWITCH_PORT_ID, g_pins[i]);
+			if(level != g_levels[i])
+			{
+				g_levels[i] = level;
+				if(level == LIMIT_SWITCH_PRESSED)
+				{
+					pressed = g_positions[i];
+				}
+			}
+		}
+	}
+
+	HAL_WRITE_REG(SREG, sreg);
+
+	if((pressed != DOOR_POSITION_UNKNOWN) && (g_callBackPtr != NULL_PTR))
+	{
+		(*g_callBackPtr)(pressed);
+	}
+}
+
+/*
+ * Description :
+ * Called from the Timer1 compare ISR at each new 1 second cycle, it counts the
+ * cycles since the last edge and accepts the levels left pending.
+ */
+void LimitSwitch_tick(void)
+{
+	uint8 i;
+	uint16 now = LimitSwitch_readCount();
+
+	for(i=0;i<LIMIT_SWITCH_NUM;i++)
+	{
+		/* An edge stamped after the new cycle started is not one cycle old */
+		if(g_edgePending[i] && (g_edgeCycles[i] < 2) && ((g_edgeCycles[i] != 0) || (g_edgeCount[i] > now)))
+		{
+			g_edgeCycles[i]++;
+		}
+	}
+	LimitSwitch_update();
+}
+
+
+static uint16 LimitSwitch_readCount(void)
+{
+	uint16 count = Timer1_getCount();
+
+	/* TCNT1 reads the compare value for one tick after the new cycle */
+	return (count >= LIMIT_SWITCH_TIMER1_CYCLE) ? 0 : count;
+}
+
+static uint8 LimitSwitch_isSettled(uint8 index,uint16 now)
+{
+	uint16 ticks;
+
+	if(g_edgeCycles[index] >= 2)
+	{
+		return TRUE;
+	}
+	else if(now < g_edgeCount[index])
+	{
+		/* The count restarted once since the edge, the tick may still be pending */
+		ticks = now + LIMIT_SWITCH_TIMER1_CYCLE - g_edgeCount[index];
+	}
+	else if(g_edgeCycles[index] != 0)
+	{
+		/* A whole cycle and more */
+		return TRUE;
+	}
+	else
+	{
+		ticks = now - g_edgeCount[index];
+	}
+	return (ticks >= LIMIT_SWITCH_DEBOUNCE_TICKS);
+}
+
+static void LimitSwitch_openedCallBack(void)
+{
+	LimitSwitch_stampEdge(LIMIT_SWITCH_OPENED);
+}
+
+static void LimitSwitch_closedCallBack(void)
+{
+	LimitSwitch_stampEdge(LIMIT_SWITCH_CLOSED);
+}
+
+static void LimitSwitch_stampEdge(uint8 index)
+{
+	/* Each bounce starts the debounce time again */
+	g_edgeCount[index] = LimitSwitch_readCount();
+	g_edgeCycles[index] = 0;
+	g_edgePending[index] = TRUE;
+}
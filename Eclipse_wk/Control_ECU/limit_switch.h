@@ -0,0 +1,90 @@
+ /******************************************************************************
+ *
+ * Module: Limit Switch
+ *
+ * File Name: limit_switch.h
+ *
+ * Description: Header file for the door open/closed limit switches driver
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef LIMIT_SWITCH_H_
+#define LIMIT_SWITCH_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Door opened switch on INT0 (PD2) , door closed switch on INT1 (PD3) */
+#define LIMIT_SWITCH_PORT_ID			PORTD_ID
+#define LIMIT_SWITCH_OPENED_PIN_ID		PIN2_ID
+#define LIMIT_SWITCH_CLOSED_PIN_ID		PIN3_ID
+
+/* Switches connect the pin to ground, internal pull-up is used */
+#define LIMIT_SWITCH_PRESSED			LOGIC_LOW
+
+/*
+ * The INT0/INT1 ISRs only stamp each edge with the Timer1 count, the new level
+ * of a switch is accepted once it has not changed for LIMIT_SWITCH_DEBOUNCE_TICKS
+ * Timer1 ticks of 32 us. LimitSwitch_update() checks it, from the main loop
+ * while the door moves and from LimitSwitch_tick() every Timer1 cycle.
+ */
+#define LIMIT_SWITCH_DEBOUNCE_TICKS		25		/* 800 us */
+
+/* Timer1 ticks in its 1 second CTC cycle, the count restarts from 0 after it */
+#define LIMIT_SWITCH_TIMER1_CYCLE		31250
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef enum{
+	DOOR_POSITION_UNKNOWN,DOOR_POSITION_OPENED,DOOR_POSITION_CLOSED
+}LimitSwitch_DoorPosition;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * 1. Setup the two switch pins as input pins with internal pull-up.
+ * 2. Read the initial door position.
+ * 3. Enable INT0/INT1 on any logical change of the switches.
+ */
+void LimitSwitch_init(void);
+
+/*
+ * Description :
+ * Return the door position from the last debounced switch levels.
+ * DOOR_POSITION_UNKNOWN means the door is between the two limits.
+ */
+LimitSwitch_DoorPosition LimitSwitch_getDoorPosition(void);
+
+/*
+ * Description :
+ * Function to set the Call Back function address. It is called from
+ * LimitSwitch_update() with the new position when a limit switch is pressed.
+ */
+void LimitSwitch_setCallBack(void(*a_ptr)(LimitSwitch_DoorPosition));
+
+/*
+ * Description :
+ * Accept the level of each switch that has not changed for the debounce time
+ * and call the Call Back function for a switch just pressed. The stop of the
+ * door is late by the time between two calls.
+ */
+void LimitSwitch_update(void);
+
+/*
+ * Description :
+ * Called from the Timer1 compare ISR at each new 1 second cycle, it counts the
+ * cycles since the last edge and accepts the levels left pending.
+ */
+void LimitSwitch_tick(void);
+
+#endif /* LIMIT_SWITCH_H_ */
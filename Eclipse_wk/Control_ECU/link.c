@@ -0,0 +1,670 @@
+ /******************************************************************************
+ *
+ * Module: Link
+ *
+ * File Name: link.c
+ *
+ * Description: Source file for the acknowledged transport over the UART link
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifdef LINK_ENABLE
+
+#include "link.h"
+#include <avr/pgmspace.h>	/* For the names in flash */
+#include "uart.h"			/* For the frames on the link */
+#include "timer1.h"			/* For the retransmit timeout */
+#include "mcu_hal.h"		/* For the critical sections */
+#include "idle.h"			/* For the sleep till the window has room or a byte */
+#include "queue.h"			/* For the bytes of the control channel */
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define LINK_SEQUENCE_MASK			0x0F
+#define LINK_LENGTH_MASK			0x0F
+#define LINK_CHANNEL_SHIFT			4
+/* SOF, control and length before the payload, the CRC after it */
+#define LINK_FRAME_OVERHEAD			4
+#define LINK_MAX_FRAME_SIZE			(LINK_MAX_PAYLOAD + LINK_FRAME_OVERHEAD)
+
+#if !QUEUE_IS_CAPACITY(LINK_RX_BUFFER_SIZE)
+#error "LINK_RX_BUFFER_SIZE must be a power of 2 up to 128"
+#endif
+
+#define LINK_ECU_NAME				"CONTROL"
+#define LINK_NAME_SIZE				14
+
+/* The frames are put one at a time in the transmit ring, when it is empty */
+#if LINK_MAX_FRAME_SIZE >= UART_TX_BUFFER_SIZE
+#error "The transmit ring of the UART must hold a frame of the transport"
+#endif
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+/* Field of the frame the receiver waits for */
+typedef enum{
+	LINK_RX_SOF, LINK_RX_CONTROL, LINK_RX_LENGTH, LINK_RX_PAYLOAD, LINK_RX_CRC
+}Link_RxState;
+
+typedef struct{
+	uint8 length;
+	uint8 payload[LINK_MAX_PAYLOAD];
+}Link_Frame;
+
+/*******************************************************************************
+ *                      Names in Flash                                         *
+ *******************************************************************************/
+
+/* Indexed by Link_Stat */
+static const char g_names[LINK_NUM_STATS][LINK_NAME_SIZE] PROGMEM = {
+		"SENT", "RETRANSMITTED", "TIMEOUTS", "BAD", "DROPPED"
+};
+
+/*******************************************************************************
+ *                      Global Variables                                       *
+ *******************************************************************************/
+
+/* Frames of the windows by sequence number, kept till they are acknowledged */
+static Link_Frame g_txFrames[LINK_NUM_CHANNELS][LINK_WINDOW_SIZE];
+/* Oldest frame of the channel not acknowledged */
+static volatile uint8 g_txBase[LINK_NUM_CHANNELS];
+/* Next frame put in the transmit ring, back to the base on a timeout */
+static volatile uint8 g_txSent[LINK_NUM_CHANNELS];
+/* Sequence number of the next frame, its bytes are gathered in its slot */
+static volatile uint8 g_txNext[LINK_NUM_CHANNELS];
+static volatile uint8 g_txOpenLength[LINK_NUM_CHANNELS];
+/* Channel of Link_sendByte() */
+static volatile Link_Channel g_txChannel = LINK_CHANNEL_CONTROL;
+/* A frame is in the transmit ring, the next one waits till it is empty */
+static volatile uint8 g_txBusy = FALSE;
+
+/* Sequence number of the next frame expected from the peer on each channel */
+static volatile uint8 g_rxExpected[LINK_NUM_CHANNELS];
+/* Bit of each channel with frames received and not acknowledged yet */
+static volatile uint8 g_ackPending = 0;
+/* Bytes of the control channel received in order, put by the RX Complete ISR */
+static uint8 g_rxBuffer[QUEUE_BUFFER_SIZE(1, LINK_RX_BUFFER_SIZE)];
+static Queue g_rxQueue;
+/* Bytes of the ring read and held since Link_holdBytes(), dropped on release */
+static uint8 g_rxRead = 0;
+static uint8 g_rxHeld = FALSE;
+/* Called with the bytes of the other channels, from the RX Complete ISR */
+static void (*volatile g_rxCallBackPtrs[LINK_NUM_CHANNELS])(uint8);
+
+/* Frame being received, only used by the RX Complete ISR */
+static Link_RxState g_rxState = LINK_RX_SOF;
+static uint8 g_rxControl;
+static uint8 g_rxChannel;
+static uint8 g_rxLength;
+static uint8 g_rxCount;
+static uint8 g_rxCrc;
+static uint8 g_rxPayload[LINK_MAX_PAYLOAD];
+
+static volatile uint16 g_stats[LINK_NUM_STATS];
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Return the frames of the channel gathered and not acknowledged yet
+ */
+static uint8 Link_framesQueued(uint8 channel);
+
+/*
+ * Return the frames of the channel in the transmit ring or sent, and not
+ * acknowledged yet
+ */
+static uint8 Link_framesInFlight(uint8 channel);
+
+/*
+ * Return TRUE if a frame of a channel waits for its acknowledge
+ */
+static uint8 Link_anyInFlight(void);
+
+/*
+ * Return TRUE if a byte can be added to the next frame of the channel.
+ * Called with the interrupts disabled.
+ */
+static uint8 Link_hasRoom(uint8 channel);
+
+/*
+ * Close the next frame of the channel if it has bytes, it waits for its turn
+ * in the transmit ring. Called with the interrupts disabled.
+ */
+static void Link_closeFrame(uint8 channel);
+
+/*
+ * Put the next frame in the transmit ring if it is empty : the first frame
+ * waiting of the channel with the lowest number, else an acknowledge.
+ * Called with the interrupts disabled.
+ */
+static void Link_schedule(void);
+
+/*
+ * Put the frame in the transmit ring with the acknowledge number of the
+ * channel, length 0 for an acknowledge. Called with the interrupts disabled.
+ */
+static void Link_putFrame(uint8 channel,uint8 sequence,uint8 length);
+
+/*
+ * Return the CRC-8 (polynomial 0x07) updated with the byte
+ */
+static uint8 Link_crc8(uint8 crc,uint8 data);
+
+/*
+ * Called by the UDRE ISR once the transmit ring is empty
+ */
+static void Link_txEmptyCallBack(void);
+
+/*
+ * Called by the RX Complete ISR with each byte of the frames
+ */
+static void Link_receiveCallBack(uint8 data,uint8 errors);
+
+/*
+ * A frame is received with a good CRC, from the RX Complete ISR
+ */
+static void Link_frameReceived(void);
+
+/*
+ * Called by the Timer1 alarm, the oldest frames were not acknowledged in time
+ */
+static void Link_alarmCallBack(void);
+
+/*
+ * Send the number in decimal
+ */
+static void Link_sendNumber(uint16 number);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Start with the sequence numbers at 0 and take the bytes received by the UART.
+ */
+void Link_init(void)
+{
+	uint8 sreg = HAL_READ_REG(SREG);
+	uint8 i;
+
+	cli();
+	for(i=0;i<LINK_NUM_CHANNELS;i++)
+	{
+		g_txBase[i] = 0;
+		g_txSent[i] = 0;
+		g_txNext[i] = 0;
+		g_txOpenLength[i] = 0;
+		g_rxExpected[i] = 0;
+		g_rxCallBackPtrs[i] = NULL_PTR;
+	}
+	g_txChannel = LINK_CHANNEL_CONTROL;
+	g_txBusy = FALSE;
+	g_ackPending = 0;
+	Queue_init(&g_rxQueue, g_rxBuffer, 1, LINK_RX_BUFFER_SIZE);
+	g_rxRead = 0;
+	g_rxHeld = FALSE;
+	g_rxState = LINK_RX_SOF;
+	for(i=0;i<LINK_NUM_STATS;i++)
+	{
+		g_stats[i] = 0;
+	}
+	Timer1_setAlarmCallBack(Link_alarmCallBack);
+	UART_setTxEmptyCallBack(Link_txEmptyCallBack);
+	UART_setReceiveCallBack(Link_receiveCallBack);
+	HAL_WRITE_REG(SREG, sreg);
+}
+
+/*
+ * Description :
+ * Add the byte to the next frame of the transmit channel, sleeping while the
+ * window of the channel is full.
+ */
+void Link_sendByte(uint8 data)
+{
+	uint8 channel = g_txChannel;
+	uint8 sreg;
+
+	/* The acknowledges make room in the window */
+	IDLE_WAIT_UNTIL(Link_hasRoom(channel));
+
+	sreg = HAL_READ_REG(SREG);
+	cli();
+	g_txFrames[channel][g_txNext[channel] % LINK_WINDOW_SIZE].payload[g_txOpenLength[channel]] = data;
+	g_txOpenLength[channel]++;
+	/* Sent right away if nothing waits for an acknowledge, else with it */
+	if((g_txOpenLength[channel] == LINK_MAX_PAYLOAD) || (Link_framesQueued(channel) == 0))
+	{
+		Link_closeFrame(channel);
+	}
+	HAL_WRITE_REG(SREG, sreg);
+}
+
+/*
+ * Description :
+ * Set the channel of the bytes given to Link_sendByte(), the control channel
+ * after Link_init(). The bytes gathered for the previous one are still sent.
+ */
+void Link_setTxChannel(Link_Channel channel)
+{
+	g_txChannel = channel;
+}
+
+/*
+ * Description :
+ * Set the function called from the RX Complete ISR with each byte received in
+ * order on the channel, not the control channel read by Link_receiveByte().
+ */
+void Link_setReceiveCallBack(Link_Channel channel,void(*a_ptr)(uint8))
+{
+	g_rxCallBackPtrs[channel] = a_ptr;
+}
+
+/*
+ * Description :
+ * Send the bytes gathered so far on the control channel, then sleep till a byte
+ * of the control channel is received in order.
+ */
+uint8 Link_receiveByte(void)
+{
+	uint8 sreg = HAL_READ_REG(SREG);
+	uint8 data;
+
+	/* The peer may be waiting for them to answer */
+	cli();
+	Link_closeFrame(LINK_CHANNEL_CONTROL);
+	HAL_WRITE_REG(SREG, sreg);
+	/* The RX Complete interrupt wakes the CPU up */
+	IDLE_WAIT_UNTIL(Queue_at(&g_rxQueue, g_rxRead) != NULL_PTR);
+
+	data = *(const uint8 *)Queue_at(&g_rxQueue, g_rxRead);
+	if(g_rxHeld)
+	{
+		g_rxRead++;
+	}
+	else
+	{
+		Queue_drop(&g_rxQueue);
+	}
+	return data;
+}
+
+/*
+ * Description :
+ * Keep the bytes read by Link_receiveByte() in the receive ring from now on,
+ * they stay at the front of Link_getReceiveQueue() till Link_releaseBytes().
+ */
+void Link_holdBytes(void)
+{
+	Link_releaseBytes();
+	g_rxHeld = TRUE;
+}
+
+/*
+ * Description :
+ * Drop the bytes read since Link_holdBytes() from the receive ring, the next
+ * ones are dropped as they are read.
+ */
+void Link_releaseBytes(void)
+{
+	Queue_dropCount(&g_rxQueue, g_rxRead);
+	g_rxRead = 0;
+	g_rxHeld = FALSE;
+}
+
+/*
+ * Description :
+ * Return the ring of the control channel, the bytes held by Link_holdBytes()
+ * are at its front. Only to read them in place.
+ */
+const Queue * Link_getReceiveQueue(void)
+{
+	return &g_rxQueue;
+}
+
+/*
+ * Description :
+ * Return the counter of the transport since Link_init().
+ */
+uint16 Link_getStat(Link_Stat stat)
+{
+	uint8 sreg = HAL_READ_REG(SREG);
+	uint16 value;
+
+	cli();
+	value = g_stats[stat];
+	HAL_WRITE_REG(SREG, sreg);
+	return value;
+}
+
+/*
+ * Description :
+ * Send the counters over the UART as one text line :
+ * LINK <ECU> <counter> <value> ... <counter> <value>
+ */
+void Link_send(void)
+{
+	const char * name;
+	char c;
+	uint8 i;
+
+	UART_sendString((const uint8 *)"LINK " LINK_ECU_NAME);
+	for(i=0;i<LINK_NUM_STATS;i++)
+	{
+		UART_sendByte(' ');
+		name = g_names[i];
+		while((c = pgm_read_byte(name++)) != '\0')
+		{
+			UART_sendByte(c);
+		}
+		UART_sendByte(' ');
+		Link_sendNumber(Link_getStat(i));
+	}
+	UART_sendString((const uint8 *)"\r\n");
+}
+
+/*******************************************************************************
+ *                      Private Functions                                      *
+ *******************************************************************************/
+
+static uint8 Link_framesQueued(uint8 channel)
+{
+	return (g_txNext[channel] - g_txBase[channel]) & LINK_SEQUENCE_MASK;
+}
+
+static uint8 Link_framesInFlight(uint8 channel)
+{
+	return (g_txSent[channel] - g_txBase[channel]) & LINK_SEQUENCE_MASK;
+}
+
+static uint8 Link_anyInFlight(void)
+{
+	uint8 channel;
+
+	for(channel=0;channel<LINK_NUM_CHANNELS;channel++)
+	{
+		if(Link_framesInFlight(channel) != 0)
+		{
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+static uint8 Link_hasRoom(uint8 channel)
+{
+	/* The slot of the next frame is free once the frame before it is acknowledged */
+	return (g_txOpenLength[channel] < LINK_MAX_PAYLOAD) && (Link_framesQueued(channel) < LINK_WINDOW_SIZE);
+}
+
+static void Link_closeFrame(uint8 channel)
+{
+	if(g_txOpenLength[channel] == 0)
+	{
+		return;
+	}
+
+	/* Bytes are only added while the window has room for their frame */
+	g_txFrames[channel][g_txNext[channel] % LINK_WINDOW_SIZE].length = g_txOpenLength[channel];
+	g_txNext[channel] = (g_txNext[channel] + 1) & LINK_SEQUENCE_MASK;
+	g_txOpenLength[channel] = 0;
+	g_stats[LINK_STAT_FRAMES_SENT]++;
+	Link_schedule();
+}
+
+static void Link_schedule(void)
+{
+	uint8 channel;
+	uint8 sequence;
+
+	/* A command waits for the frame being sent at most */
+	if(g_txBusy)
+	{
+		return;
+	}
+
+	for(channel=0;channel<LINK_NUM_CHANNELS;channel++)
+	{
+		sequence = g_txSent[channel];
+		if(sequence != g_txNext[channel])
+		{
+			/* The timeout runs for the oldest frame, nothing waited before it */
+			if(!Link_anyInFlight())
+			{
+				Timer1_startAlarm(LINK_RETRANSMIT_TIMEOUT);
+			}
+			/* It carries the acknowledge too */
+			Link_putFrame(channel, sequence, g_txFrames[channel][sequence % LINK_WINDOW_SIZE].length);
+			g_txSent[channel] = (sequence + 1) & LINK_SEQUENCE_MASK;
+			return;
+		}
+		if(g_ackPending & (1 << channel))
+		{
+			Link_putFrame(channel, sequence, 0);
+			return;
+		}
+	}
+}
+
+static void Link_putFrame(uint8 channel,uint8 sequence,uint8 length)
+{
+	const uint8 * payload = g_txFrames[channel][sequence % LINK_WINDOW_SIZE].payload;
+	uint8 frame[LINK_MAX_FRAME_SIZE];
+	uint8 crc;
+	uint8 i;
+
+	frame[0] = LINK_SOF;
+	frame[1] = (uint8)((sequence << 4) | g_rxExpected[channel]);
+	frame[2] = (uint8)((channel << LINK_CHANNEL_SHIFT) | length);
+	crc = Link_crc8(Link_crc8(0, frame[1]), frame[2]);
+	for(i=0;i<length;i++)
+	{
+		frame[3 + i] = payload[i];
+		crc = Link_crc8(crc, payload[i]);
+	}
+	frame[3 + length] = crc;
+
+	/* The ring is empty, the UDRE interrupt tells when it is again */
+	UART_putBytes(frame, length + LINK_FRAME_OVERHEAD);
+	g_txBusy = TRUE;
+	/* It carries the acknowledge of all the frames received on the channel */
+	g_ackPending &= (uint8)~(1 << channel);
+}
+
+static uint8 Link_crc8(uint8 crc,uint8 data)
+{
+	uint8 bit;
+
+	crc ^= data;
+	for(bit=0;bit<8;bit++)
+	{
+		crc = (crc & 0x80) ? (uint8)((crc << 1) ^ 0x07) : (uint8)(crc << 1);
+	}
+	return crc;
+}
+
+static void Link_txEmptyCallBack(void)
+{
+	g_txBusy = FALSE;
+	Link_schedule();
+}
+
+static void Link_receiveCallBack(uint8 data,uint8 errors)
+{
+	if(errors != 0)
+	{
+		/* The frame is lost, the sender sends it again */
+		if(g_rxState != LINK_RX_SOF)
+		{
+			g_stats[LINK_STAT_BAD_FRAMES]++;
+			g_rxState = LINK_RX_SOF;
+		}
+		return;
+	}
+
+	switch(g_rxState)
+	{
+	case LINK_RX_SOF:
+		if(data == LINK_SOF)
+		{
+			g_rxCrc = 0;
+			g_rxState = LINK_RX_CONTROL;
+		}
+		break;
+	case LINK_RX_CONTROL:
+		g_rxControl = data;
+		g_rxCrc = Link_crc8(g_rxCrc, data);
+		g_rxState = LINK_RX_LENGTH;
+		break;
+	case LINK_RX_LENGTH:
+		g_rxChannel = data >> LINK_CHANNEL_SHIFT;
+		g_rxLength = data & LINK_LENGTH_MASK;
+		if((g_rxLength > LINK_MAX_PAYLOAD) || (g_rxChannel >= LINK_NUM_CHANNELS))
+		{
+			g_stats[LINK_STAT_BAD_FRAMES]++;
+			g_rxState = LINK_RX_SOF;
+			break;
+		}
+		g_rxCount = 0;
+		g_rxCrc = Link_crc8(g_rxCrc, data);
+		g_rxState = (g_rxLength == 0) ? LINK_RX_CRC : LINK_RX_PAYLOAD;
+		break;
+	case LINK_RX_PAYLOAD:
+		g_rxPayload[g_rxCount] = data;
+		g_rxCount++;
+		g_rxCrc = Link_crc8(g_rxCrc, data);
+		if(g_rxCount == g_rxLength)
+		{
+			g_rxState = LINK_RX_CRC;
+		}
+		break;
+	default:
+		g_rxState = LINK_RX_SOF;
+		if(data != g_rxCrc)
+		{
+			g_stats[LINK_STAT_BAD_FRAMES]++;
+			break;
+		}
+		Link_frameReceived();
+		break;
+	}
+}
+
+static void Link_frameReceived(void)
+{
+	uint8 channel = g_rxChannel;
+	uint8 acknowledge = g_rxControl & LINK_SEQUENCE_MASK;
+	uint8 sequence = g_rxControl >> 4;
+	uint8 acknowledged = (acknowledge - g_txBase[channel]) & LINK_SEQUENCE_MASK;
+	uint8 i;
+
+	/* Cumulative acknowledge, an old one is out of the window */
+	if((acknowledged != 0) && (acknowledged <= Link_framesQueued(channel)))
+	{
+		/* Frames sent before a timeout may be acknowledged after it */
+		if(Link_framesInFlight(channel) < acknowledged)
+		{
+			g_txSent[channel] = acknowledge;
+		}
+		g_txBase[channel] = acknowledge;
+		if(Link_anyInFlight())
+		{
+			/* The timeout runs for the oldest frame left */
+			Timer1_startAlarm(LINK_RETRANSMIT_TIMEOUT);
+		}
+		else
+		{
+			Timer1_stopAlarm();
+		}
+		/* The bytes gathered waited for this acknowledge */
+		Link_closeFrame(channel);
+	}
+
+	if(g_rxLength > 0)
+	{
+		/* In order, else the sender sends it again */
+		if(sequence != g_rxExpected[channel])
+		{
+			g_stats[LINK_STAT_DROPPED_FRAMES]++;
+		}
+		else if(channel != LINK_CHANNEL_CONTROL)
+		{
+			if(g_rxCallBackPtrs[channel] != NULL_PTR)
+			{
+				for(i=0;i<g_rxLength;i++)
+				{
+					(*g_rxCallBackPtrs[channel])(g_rxPayload[i]);
+				}
+			}
+			g_rxExpected[channel] = (sequence + 1) & LINK_SEQUENCE_MASK;
+		}
+		else if(Queue_room(&g_rxQueue) < g_rxLength)
+		{
+			/* Not read yet, the sender sends it again after the timeout */
+			g_stats[LINK_STAT_DROPPED_FRAMES]++;
+		}
+		else
+		{
+			for(i=0;i<g_rxLength;i++)
+			{
+				Queue_put(&g_rxQueue, &g_rxPayload[i]);
+			}
+			g_rxExpected[channel] = (sequence + 1) & LINK_SEQUENCE_MASK;
+		}
+		/* A duplicate is acknowledged too, the first acknowledge may be lost */
+		g_ackPending |= (uint8)(1 << channel);
+		Link_schedule();
+	}
+}
+
+static void Link_alarmCallBack(void)
+{
+	uint8 channel;
+	uint8 frames;
+	uint8 timeout = FALSE;
+
+	/* Go-back-N : the frames of each channel from the oldest one, in their turn */
+	for(channel=0;channel<LINK_NUM_CHANNELS;channel++)
+	{
+		frames = Link_framesInFlight(channel);
+		if(frames != 0)
+		{
+			g_stats[LINK_STAT_RETRANSMISSIONS] += frames;
+			g_txSent[channel] = g_txBase[channel];
+			timeout = TRUE;
+		}
+	}
+	if(timeout)
+	{
+		g_stats[LINK_STAT_TIMEOUTS]++;
+		/* The first frame sent starts the timeout again */
+		Link_schedule();
+	}
+}
+
+static void Link_sendNumber(uint16 number)
+{
+	uint8 digits[5];
+	uint8 i = 0;
+
+	do
+	{
+		digits[i++] = '0' + (number % 10);
+		number /= 10;
+	}while(number != 0);
+
+	while(i > 0)
+	{
+		UART_sendByte(digits[--i]);
+	}
+}
+
+#endif /* LINK_ENABLE */
@@ -0,0 +1,91 @@
+ /******************************************************************************
+ *
+ * Module: MCU HAL
+ *
+ * File Name: mcu_hal.h
+ *
+ * Description: Register access layer of the ATmega32 drivers.
+ *              On the target the macros are plain register accesses, in the
+ *              host build (HOST_BUILD defined) they go to the simulated
+ *              peripherals of Eclipse_wk/Host_Sim.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef MCU_HAL_H_
+#define MCU_HAL_H_
+
+#include <avr/io.h>	/* For Register names, the host build has its own <avr/io.h> */
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#ifndef HOST_BUILD
+
+#define HAL_READ_REG(REG)				(REG)
+#define HAL_WRITE_REG(REG,VALUE)		((REG) = (VALUE))
+
+/* 16-bit registers (TCNT1, OCR1A, OCR1B, ICR1, ADC) */
+#define HAL_READ_REG16(REG)				(REG)
+#define HAL_WRITE_REG16(REG,VALUE)		((REG) = (VALUE))
+
+/*
+ * Enable the interrupts and sleep till the next one, then disable them again.
+ * The instruction after sei runs before any interrupt, the one that ends
+ * the wait can not be served between the check of its flag and the sleep.
+ * SE of MCUCR must be set, sleep does nothing without it.
+ */
+#define HAL_SLEEP()						__asm__ __volatile__ ("sei\n\tsleep\n\tcli" ::: "memory")
+
+#else
+
+#define HAL_READ_REG(REG)				Sim_readRegister(REG)
+#define HAL_WRITE_REG(REG,VALUE)		Sim_writeRegister(REG,VALUE)
+
+#define HAL_READ_REG16(REG)				Sim_readRegister16(REG)
+#define HAL_WRITE_REG16(REG,VALUE)		Sim_writeRegister16(REG,VALUE)
+
+/* The simulator moves to the next interrupt instead of spinning */
+#define HAL_SLEEP()						Sim_sleep()
+
+#endif
+
+/*
+ * The compiler keeps the memory accesses on each side of it in order, for the
+ * data shared with an ISR without disabling the interrupts
+ */
+#define HAL_MEMORY_BARRIER()			__asm__ __volatile__ ("" ::: "memory")
+
+/*
+ * 8-bit counter shared with an ISR : the memory accesses after the load stay
+ * after it, the ones before the store stay before it. The AVR has one core,
+ * the compiler barrier is enough; the host test runs the two sides on two
+ * threads and needs the atomic accesses.
+ */
+#ifndef HOST_BUILD
+#define HAL_LOAD_ACQUIRE(VAR)			__extension__ ({ uint8 value_ = (VAR); HAL_MEMORY_BARRIER(); value_; })
+#define HAL_STORE_RELEASE(VAR,VALUE)	do{ HAL_MEMORY_BARRIER(); (VAR) = (VALUE); }while(0)
+#else
+#define HAL_LOAD_ACQUIRE(VAR)			__atomic_load_n(&(VAR), __ATOMIC_ACQUIRE)
+#define HAL_STORE_RELEASE(VAR,VALUE)	__atomic_store_n(&(VAR), (VALUE), __ATOMIC_RELEASE)
+#endif
+
+/* Set a certain bit in a register */
+#define HAL_SET_BIT(REG,BIT)		HAL_WRITE_REG(REG, HAL_READ_REG(REG) | (1<<(BIT)))
+
+/* Clear a certain bit in a register */
+#define HAL_CLEAR_BIT(REG,BIT)		HAL_WRITE_REG(REG, HAL_READ_REG(REG) & (~(1<<(BIT))))
+
+/* Set/Clear the bits of the mask in a register */
+#define HAL_SET_BITS(REG,MASK)		HAL_WRITE_REG(REG, HAL_READ_REG(REG) | (MASK))
+#define HAL_CLEAR_BITS(REG,MASK)	HAL_WRITE_REG(REG, HAL_READ_REG(REG) & (~(MASK)))
+
+/* Check if a specific bit is set in a register and return true if yes */
+#define HAL_BIT_IS_SET(REG,BIT)		(HAL_READ_REG(REG) & (1<<(BIT)))
+
+/* Check if a specific bit is cleared in a register and return true if yes */
+#define HAL_BIT_IS_CLEAR(REG,BIT)	(!(HAL_READ_REG(REG) & (1<<(BIT))))
+
+#endif /* MCU_HAL_H_ */
@@ -0,0 +1,207 @@
+ /******************************************************************************
+ *
+ * Module: Multi-drop
+ *
+ * File Name: multidrop.c
+ *
+ * Description: Source file for the polling of the HMI panels on the multi-drop link
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifdef MULTIDROP_ENABLE
+
+#include "multidrop.h"
+#include "timer1.h"			/* For the reply timeouts */
+#include "idle.h"			/* For the sleep till a byte or the alarm */
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* No panel has the turn */
+#define MULTIDROP_NO_PANEL			0xFF
+
+/*******************************************************************************
+ *                      Global Variables                                       *
+ *******************************************************************************/
+
+/* Set by the Timer1 alarm */
+static volatile uint8 g_alarmFlag = FALSE;
+/* Bit n is set while the panel n answers its polls */
+static uint8 g_presentPanels = 0;
+/* Panel that has the turn, MULTIDROP_NO_PANEL if none */
+static uint8 g_turnPanel = MULTIDROP_NO_PANEL;
+/* Next panel to poll, the one after the last served so they all get their turn */
+static uint8 g_nextPanel = 0;
+/* Rounds since the absent panels were polled */
+static uint8 g_discoveryRounds = 0;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Poll the panels once, return TRUE with the first byte of a request
+ */
+static uint8 Multidrop_pollRound(uint8 * panel,uint8 * command);
+
+/*
+ * Wait for a byte at most ticks of Timer1, return TRUE with it
+ */
+static uint8 Multidrop_waitByte(uint16 ticks,uint8 * data);
+
+/*
+ * Drop the late answers of the previous polls
+ */
+static void Multidrop_flush(void);
+
+/*
+ * Sleep ticks of Timer1
+ */
+static void Multidrop_sleep(uint16 ticks);
+
+/*
+ * Called by the Timer1 alarm
+ */
+static void Multidrop_alarmCallBack(void);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Start with all the panels absent, the first round looks for all of them.
+ */
+void Multidrop_init(void)
+{
+	g_presentPanels = 0;
+	g_turnPanel = MULTIDROP_NO_PANEL;
+	g_nextPanel = 0;
+	g_discoveryRounds = MULTIDROP_DISCOVERY_ROUNDS;
+	Timer1_setAlarmCallBack(Multidrop_alarmCallBack);
+}
+
+/*
+ * Description :
+ * Return the next byte sent by a panel outside of an exchange, and the panel
+ * 0 --> MULTIDROP_MAX_PANELS-1 that sent it. The panel that has the turn goes
+ * on first, then the panels are polled in turn, sleeping between the rounds.
+ */
+uint8 Multidrop_receiveCommand(uint8 * panel)
+{
+	uint8 command;
+
+	/* The panel that has the turn may send the rest of its request */
+	if(g_turnPanel != MULTIDROP_NO_PANEL)
+	{
+		if(Multidrop_waitByte(MULTIDROP_TURN_TIMEOUT, &command))
+		{
+			*panel = g_turnPanel;
+			return command;
+		}
+		g_turnPanel = MULTIDROP_NO_PANEL;
+	}
+
+	while(!Multidrop_pollRound(panel, &command))
+	{
+		/* Nobody has a request */
+		Multidrop_sleep(MULTIDROP_POLL_PERIOD);
+	}
+
+	g_turnPanel = *panel;
+	return command;
+}
+
+
+/*******************************************************************************
+ *                      Private Functions                                      *
+ *******************************************************************************/
+
+static uint8 Multidrop_pollRound(uint8 * panel,uint8 * command)
+{
+	uint8 discovery = (g_discoveryRounds >= MULTIDROP_DISCOVERY_ROUNDS);
+	uint8 polled;
+	uint8 current;
+
+	for(polled=0;polled<MULTIDROP_MAX_PANELS;polled++)
+	{
+		current = g_nextPanel;
+		g_nextPanel = (g_nextPanel + 1) % MULTIDROP_MAX_PANELS;
+
+		if((!discovery) && (!(g_presentPanels & (1<<current))))
+		{
+			continue;
+		}
+
+		/* Panels are addressed from 1, 0 is nobody */
+		Multidrop_flush();
+		UART_sendAddress(current + 1);
+		if(!Multidrop_waitByte(MULTIDROP_REPLY_TIMEOUT, command))
+		{
+			g_presentPanels &= ~(1<<current);
+			continue;
+		}
+		g_presentPanels |= (1<<current);
+
+		if(*command != MULTIDROP_NO_REQUEST)
+		{
+			*panel = current;
+			return TRUE;
+		}
+	}
+
+	g_discoveryRounds = discovery ? 0 : (g_discoveryRounds + 1);
+	return FALSE;
+}
+
+static uint8 Multidrop_waitByte(uint16 ticks,uint8 * data)
+{
+	uint8 received;
+	uint8 sreg;
+
+	g_alarmFlag = FALSE;
+	Timer1_startAlarm(ticks);
+	IDLE_WAIT_UNTIL(UART_isByteReceived() || g_alarmFlag);
+	Timer1_stopAlarm();
+
+	/* The byte wins over the alarm, it stays in UDR till it is read */
+	sreg = HAL_READ_REG(SREG);
+	cli();
+	received = UART_isByteReceived();
+	HAL_WRITE_REG(SREG, sreg);
+	if(!received)
+	{
+		return FALSE;
+	}
+	*data = UART_recieveByte();
+	return TRUE;
+}
+
+static void Multidrop_flush(void)
+{
+	uint8 sreg = HAL_READ_REG(SREG);
+
+	cli();
+	while(UART_isByteReceived())
+	{
+		UART_recieveByte();
+	}
+	HAL_WRITE_REG(SREG, sreg);
+}
+
+static void Multidrop_sleep(uint16 ticks)
+{
+	g_alarmFlag = FALSE;
+	Timer1_startAlarm(ticks);
+	IDLE_WAIT_UNTIL(g_alarmFlag);
+}
+
+static void Multidrop_alarmCallBack(void)
+{
+	g_alarmFlag = TRUE;
+}
+
+#endif /* MULTIDROP_ENABLE */
@@ -0,0 +1,89 @@
+ /******************************************************************************
+ *
+ * Module: Multi-drop
+ *
+ * File Name: multidrop.h
+ *
+ * Description: Header file for the polling of the HMI panels on the multi-drop link
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef MULTIDROP_H_
+#define MULTIDROP_H_
+
+#include "std_types.h"
+#include "uart.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * The multi-drop link is only built with MULTIDROP_ENABLE defined
+ * (-DMULTIDROP_ENABLE), without it the link is point-to-point with one
+ * HMI_ECU and the macros below read the UART directly.
+ *
+ * The TX of the Control_ECU goes to the RX of all the panels, the TX of the
+ * panels are wired together to its RX. The frames have 9 bits : an address
+ * frame (ninth bit set) selects the panel 1 --> MULTIDROP_MAX_PANELS, the
+ * others stay in the multi-processor mode and do not see the data frames.
+ *
+ * The Control_ECU polls the panels in turn with their address. A panel with
+ * nothing to send answers MULTIDROP_NO_REQUEST, a panel with a request sends
+ * its first byte instead and keeps the turn till it is silent for
+ * MULTIDROP_TURN_TIMEOUT. A panel that does not answer within
+ * MULTIDROP_REPLY_TIMEOUT is taken as absent, it is only polled again every
+ * MULTIDROP_DISCOVERY_ROUNDS rounds. After a round without requests the
+ * Control_ECU sleeps MULTIDROP_POLL_PERIOD.
+ * Timer1 must be initialized (1 second CTC cycle) before MULTIDROP_INIT().
+ */
+
+#define MULTIDROP_MAX_PANELS			8
+
+/* Answer of a polled panel with nothing to send */
+#define MULTIDROP_NO_REQUEST			0x15
+
+/* Times in Timer1 ticks of 32 us, a 9 bits frame is 1.15 ms at 9600 baud */
+#define MULTIDROP_REPLY_TIMEOUT			125		/* 4 ms */
+#define MULTIDROP_TURN_TIMEOUT			313		/* 10 ms */
+#define MULTIDROP_POLL_PERIOD			1563	/* 50 ms */
+
+#define MULTIDROP_DISCOVERY_ROUNDS		20
+
+#ifdef MULTIDROP_ENABLE
+
+#define MULTIDROP_NUM_PANELS				MULTIDROP_MAX_PANELS
+#define MULTIDROP_UART_BITS					MODE_9_BITS
+#define MULTIDROP_INIT()					Multidrop_init()
+#define MULTIDROP_RECEIVE_COMMAND(PANEL)	Multidrop_receiveCommand(PANEL)
+
+#else
+
+#define MULTIDROP_NUM_PANELS				1
+#define MULTIDROP_UART_BITS					MODE_8_BITS
+#define MULTIDROP_INIT()
+#define MULTIDROP_RECEIVE_COMMAND(PANEL)	((*(PANEL) = 0), UART_recieveByte())
+
+#endif
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Start with all the panels absent, the first round looks for all of them.
+ */
+void Multidrop_init(void);
+
+/*
+ * Description :
+ * Return the next byte sent by a panel outside of an exchange, and the panel
+ * 0 --> MULTIDROP_MAX_PANELS-1 that sent it. The panel that has the turn goes
+ * on first, then the panels are polled in turn, sleeping between the rounds.
+ */
+uint8 Multidrop_receiveCommand(uint8 * panel);
+
+#endif /* MULTIDROP_H_ */
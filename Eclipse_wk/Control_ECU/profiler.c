@@ -0,0 +1,254 @@
+ /******************************************************************************
+ *
+ * Module: Profiler
+ *
+ * File Name: profiler.c
+ *
+ * Description: Source file for the Timer1 based profiler of the code regions
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include "profiler.h"
+
+#ifdef PROFILER_ENABLE
+
+#include <avr/interrupt.h>	/* For cli() */
+#include <avr/pgmspace.h>	/* For the region names in flash */
+#include "mcu_hal.h"		/* For Register access */
+#include "uart.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define PROFILER_EXIT_FLAG			0x80
+#define PROFILER_NAME_SIZE			24
+
+/*******************************************************************************
+ *                      Region Names in Flash                                  *
+ *******************************************************************************/
+
+/* Indexed by Profiler_RegionId */
+static const char g_regionNames[PROFILER_NUM_REGIONS][PROFILER_NAME_SIZE] PROGMEM = {
+		"UART_receiveFrame", "EEPROM_readByte", "EEPROM_writeByte"
+};
+
+/*******************************************************************************
+ *                      Global Variables                                  *
+ *******************************************************************************/
+
+static Profiler_RegionStats g_regions[PROFILER_NUM_REGIONS];
+static uint16 g_enterTimestamp[PROFILER_NUM_REGIONS];
+
+static Profiler_Record g_records[PROFILER_RING_SIZE];
+/* Next record written, and records kept (up to PROFILER_RING_SIZE) */
+static uint8 g_recordIndex = 0;
+static uint8 g_recordCount = 0;
+
+/* TCNT1 counts from 0 to g_timerTop, OCR1A in CTC mode */
+static uint16 g_timerTop = 0xFFFF;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Add a record to the ring and return the timestamp, called with interrupts disabled.
+ */
+static uint16 Profiler_record(uint8 region);
+
+/*
+ * Send the region name from flash
+ */
+static void Profiler_sendName(uint8 region);
+
+/*
+ * Send the number in decimal
+ */
+static void Profiler_sendNumber(uint32 number);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Clear the regions and the records, and read the Timer1 cycle length.
+ */
+void Profiler_init(void)
+{
+	uint8 i;
+
+	for(i=0;i<PROFILER_NUM_REGIONS;i++)
+	{
+		g_regions[i].count = 0;
+		g_regions[i].totalTicks = 0;
+		g_regions[i].maxTicks = 0;
+	}
+	g_recordIndex = 0;
+	g_recordCount = 0;
+
+	/* WGM12 = 1 : CTC mode, the counter is cleared after OCR1A */
+	g_timerTop = HAL_BIT_IS_SET(TCCR1B, WGM12) ? HAL_READ_REG16(OCR1A) : 0xFFFF;
+}
+
+/*
+ * Description :
+ * Record the entry of the region with the current TCNT1.
+ */
+void Profiler_enter(Profiler_RegionId region)
+{
+	uint8 sreg = HAL_READ_REG(SREG);
+	cli();
+
+	g_enterTimestamp[region] = Profiler_record(region);
+
+	HAL_WRITE_REG(SREG, sreg);
+}
+
+/*
+ * Description :
+ * Record the exit of the region and add its time to the region statistics.
+ */
+void Profiler_exit(Profiler_RegionId region)
+{
+	Profiler_RegionStats * stats = &g_regions[region];
+	uint16 ticks;
+	uint8 sreg = HAL_READ_REG(SREG);
+	cli();
+
+	ticks = Profiler_record(region | PROFILER_EXIT_FLAG);
+	/* The counter may have restarted from 0 once in the region */
+	if(ticks >= g_enterTimestamp[region])
+	{
+		ticks -= g_enterTimestamp[region];
+	}
+	else
+	{
+		ticks = (uint16)(ticks + (g_timerTop - g_enterTimestamp[region]) + 1);
+	}
+
+	stats->count++;
+	stats->totalTicks += ticks;
+	if(ticks > stats->maxTicks)
+	{
+		stats->maxTicks = ticks;
+	}
+
+	HAL_WRITE_REG(SREG, sreg);
+}
+
+/*
+ * Description :
+ * Copy the statistics of the region.
+ */
+void Profiler_getRegion(Profiler_RegionId region,Profiler_RegionStats * stats)
+{
+	uint8 sreg = HAL_READ_REG(SREG);
+	cli();
+
+	*stats = g_regions[region];
+
+	HAL_WRITE_REG(SREG, sreg);
+}
+
+/*
+ * Description :
+ * Send the statistics of the regions then the records, oldest first,
+ * as text lines over the UART :
+ * PROFILE <cycles per tick>
+ * <region> <count> <total ticks> <max ticks>
+ * E|X <region> <TCNT1>
+ */
+void Profiler_dump(void)
+{
+	/* CS12:0 --> Timer1 prescaler, the external clock has no known tick */
+	static const uint16 prescalers[8] = {0, 1, 8, 64, 256, 1024, 0, 0};
+	Profiler_RegionStats stats;
+	Profiler_Record record;
+	uint8 i;
+
+	UART_sendString((const uint8 *)"PROFILE ");
+	Profiler_sendNumber(prescalers[HAL_READ_REG(TCCR1B) & 0x07]);
+	UART_sendString((const uint8 *)"\r\n");
+
+	for(i=0;i<PROFILER_NUM_REGIONS;i++)
+	{
+		Profiler_getRegion(i, &stats);
+		Profiler_sendName(i);
+		UART_sendByte(' ');
+		Profiler_sendNumber(stats.count);
+		UART_sendByte(' ');
+		Profiler_sendNumber(stats.totalTicks);
+		UART_sendByte(' ');
+		Profiler_sendNumber(stats.maxTicks);
+		UART_sendString((const uint8 *)"\r\n");
+	}
+
+	for(i=0;i<g_recordCount;i++)
+	{
+		/* The oldest record is the next one written once the ring is full */
+		uint8 sreg = HAL_READ_REG(SREG);
+		cli();
+		record = g_records[(g_recordIndex + PROFILER_RING_SIZE - g_recordCount + i) % PROFILER_RING_SIZE];
+		HAL_WRITE_REG(SREG, sreg);
+
+		UART_sendByte((record.region & PROFILER_EXIT_FLAG) ? 'X' : 'E');
+		UART_sendByte(' ');
+		Profiler_sendName(record.region & (~PROFILER_EXIT_FLAG));
+		UART_sendByte(' ');
+		Profiler_sendNumber(record.timestamp);
+		UART_sendString((const uint8 *)"\r\n");
+	}
+}
+
+
+/*******************************************************************************
+ *                      Private Functions                                      *
+ *******************************************************************************/
+
+static uint16 Profiler_record(uint8 region)
+{
+	uint16 timestamp = HAL_READ_REG16(TCNT1);
+
+	g_records[g_recordIndex].region = region;
+	g_records[g_recordIndex].timestamp = timestamp;
+	g_recordIndex = (g_recordIndex + 1) % PROFILER_RING_SIZE;
+	if(g_recordCount < PROFILER_RING_SIZE)
+	{
+		g_recordCount++;
+	}
+	return timestamp;
+}
+
+static void Profiler_sendName(uint8 region)
+{
+	const char * name = g_regionNames[region];
+	char c;
+
+	while((c = pgm_read_byte(name++)) != '\0')
+	{
+		UART_sendByte(c);
+	}
+}
+
+static void Profiler_sendNumber(uint32 number)
+{
+	uint8 digits[10];
+	uint8 i = 0;
+
+	do
+	{
+		digits[i++] = '0' + (number % 10);
+		number /= 10;
+	}while(number != 0);
+
+	while(i > 0)
+	{
+		UART_sendByte(digits[--i]);
+	}
+}
+
+#endif /* PROFILER_ENABLE */
@@ -0,0 +1,377 @@
+ /******************************************************************************
+ *
+ * Module: PWM
+ *
+ * File Name: pwm.c
+ *
+ * Description: Source file for the ATmega32 Timer0/Timer2 fast PWM driver
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include <avr/interrupt.h> /* For Timer0/Timer2 overflow ISRs */
+#include "mcu_hal.h"	/* For Register access */
+#include "pwm.h"
+#include "common_macros.h" /* To use the macros like SET_BIT */
+#include "idle.h"		/* For the wake reason */
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define PWM_NUM_OF_CHANNELS		2
+
+/* Fast PWM mode, non-inverting : clear OCx on compare match, set OCx at BOTTOM */
+#define TIMER0_FAST_PWM			((1<<WGM00) | (1<<WGM01))
+#define TIMER0_NON_INVERTING	(1<<COM01)
+#define TIMER2_FAST_PWM			((1<<WGM20) | (1<<WGM21))
+#define TIMER2_NON_INVERTING	(1<<COM21)
+
+/*******************************************************************************
+ *                      Global Variables                                  *
+ *******************************************************************************/
+
+/* Prescaler tables, the index + 1 is the CSx2:0 value of the timer */
+static const uint16 g_timer0Prescalers[] = {1, 8, 64, 256, 1024};
+static const uint16 g_timer2Prescalers[] = {1, 8, 32, 64, 128, 256, 1024};
+
+static void (*volatile g_callBackPtr[PWM_NUM_OF_CHANNELS])(void) = {NULL_PTR, NULL_PTR};
+
+/* Duty cycle buffers, applied by the overflow ISR at the start of the next period */
+static volatile uint8 g_compareBuffer[PWM_NUM_OF_CHANNELS] = {0, 0};
+static volatile uint8 g_dutyZeroBuffer[PWM_NUM_OF_CHANNELS] = {TRUE, TRUE};
+static volatile uint8 g_updatePending[PWM_NUM_OF_CHANNELS] = {FALSE, FALSE};
+/*
+ * OCRx written by the overflow ISR is only latched at the end of that period,
+ * the OCx connection follows at the next overflow to switch with it
+ */
+static volatile uint8 g_outputZero[PWM_NUM_OF_CHANNELS] = {TRUE, TRUE};
+static volatile uint8 g_outputPending[PWM_NUM_OF_CHANNELS] = {FALSE, FALSE};
+
+/* Real frequency of each channel */
+static PWM_Frequency g_frequency[PWM_NUM_OF_CHANNELS] = {0, 0};
+
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Select from the prescaler table the prescaler that gives the nearest
+ * frequency to the required one, return its CSx2:0 value.
+ */
+static uint8 PWM_selectPrescaler(const uint16 * prescalers,uint8 size,PWM_Frequency frequency,PWM_Frequency * real_frequency);
+
+/*
+ * Apply the buffered duty cycle of the channel, called at the start of the period.
+ */
+static void PWM_applyDutyCycle(PWM_Channel channel);
+
+/*
+ * Connect or disconnect OCx for the duty cycle written one period before,
+ * called at the start of the period that OCRx takes it.
+ */
+static void PWM_applyOutput(PWM_Channel channel);
+
+/*
+ * Keep the overflow interrupt enabled only while it has something to do.
+ */
+static void PWM_updateOverflowInterrupt(PWM_Channel channel);
+
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Function to start the timer of the channel in fast PWM mode:
+ * 1. Setup the OCx pin as output pin.
+ * 2. Select the prescaler nearest to the required frequency.
+ * 3. Start with duty cycle 0% (OCx pin is disconnected and low).
+ */
+void PWM_init(const PWM_ConfigType * Config_Ptr)
+{
+	uint8 clock;
+	PWM_Channel channel = Config_Ptr->channel;
+
+	g_compareBuffer[channel] = 0;
+	g_dutyZeroBuffer[channel] = TRUE;
+	g_updatePending[channel] = FALSE;
+	g_outputZero[channel] = TRUE;
+	g_outputPending[channel] = FALSE;
+
+	if(channel == PWM_CHANNEL_OC0)
+	{
+		clock = PWM_selectPrescaler(g_timer0Prescalers, sizeof(g_timer0Prescalers)/sizeof(uint16),
+				Config_Ptr->frequency, &g_frequency[channel]);
+
+		/* PB3/OC0 is output, it stays low while OC0 is disconnected */
+		HAL_SET_BIT(DDRB,PB3);
+		HAL_CLEAR_BIT(PORTB,PB3);
+
+		HAL_WRITE_REG(TCNT0, 0);
+		HAL_WRITE_REG(OCR0, 0);
+		/* Fast PWM, OC0 disconnected for 0% duty cycle, CS02:0 = prescaler */
+		HAL_WRITE_REG(TCCR0, TIMER0_FAST_PWM | clock);
+	}
+	else if(channel == PWM_CHANNEL_OC2)
+	{
+		clock = PWM_selectPrescaler(g_timer2Prescalers, sizeof(g_timer2Prescalers)/sizeof(uint16),
+				Config_Ptr->frequency, &g_frequency[channel]);
+
+		/* PD7/OC2 is output, it stays low while OC2 is disconnected */
+		HAL_SET_BIT(DDRD,PD7);
+		HAL_CLEAR_BIT(PORTD,PD7);
+
+		HAL_WRITE_REG(TCNT2, 0);
+		HAL_WRITE_REG(OCR2, 0);
+		/* Fast PWM, OC2 disconnected for 0% duty cycle, CS22:0 = prescaler */
+		HAL_WRITE_REG(TCCR2, TIMER2_FAST_PWM | clock);
+	}
+
+	PWM_updateOverflowInterrupt(channel);
+}
+
+/*
+ * Description :
+ * Function to change the duty cycle (0 --> 100) of the channel without
+ * restarting its timer. The new value is written at the start of the next
+ * PWM period and takes effect, OCRx and the OCx connection together, when the
+ * timer latches it at the end of that period, so no period is ever truncated.
+ */
+void PWM_setDutyCycle(PWM_Channel channel,uint8 duty_cycle)
+{
+	if(duty_cycle > MAX_DUTY_CYCLE_PERCENTAGE)
+	{
+		duty_cycle = MAX_DUTY_CYCLE_PERCENTAGE;
+	}
+
+	/* The ISR takes the buffers only when the pending flag is set */
+	g_updatePending[channel] = FALSE;
+	g_compareBuffer[channel] = (uint8)(((uint16)duty_cycle * MAX_TIMER_VALUE) / MAX_DUTY_CYCLE_PERCENTAGE);
+	g_dutyZeroBuffer[channel] = (duty_cycle == 0);
+	g_updatePending[channel] = TRUE;
+
+	PWM_updateOverflowInterrupt(channel);
+}
+
+/*
+ * Description :
+ * Function to stop the timer of the channel and force its OCx pin low.
+ */
+void PWM_stop(PWM_Channel channel)
+{
+	/* TIMSK is shared with the ISRs, modify it with interrupts disabled */
+	uint8 sreg = HAL_READ_REG(SREG);
+	cli();
+
+	g_updatePending[channel] = FALSE;
+	g_compareBuffer[channel] = 0;
+	g_dutyZeroBuffer[channel] = TRUE;
+	g_outputZero[channel] = TRUE;
+	g_outputPending[channel] = FALSE;
+
+	if(channel == PWM_CHANNEL_OC0)
+	{
+		HAL_CLEAR_BIT(TIMSK,TOIE0);
+		HAL_WRITE_REG(TCCR0, 0);
+		HAL_WRITE_REG(OCR0, 0);
+		HAL_CLEAR_BIT(PORTB,PB3);
+	}
+	else if(channel == PWM_CHANNEL_OC2)
+	{
+		HAL_CLEAR_BIT(TIMSK,TOIE2);
+		HAL_WRITE_REG(TCCR2, 0);
+		HAL_WRITE_REG(OCR2, 0);
+		HAL_CLEAR_BIT(PORTD,PD7);
+	}
+
+	HAL_WRITE_REG(SREG, sreg);
+}
+
+/*
+ * Description :
+ * Function to return the real frequency selected for the channel in Hz.
+ */
+PWM_Frequency PWM_getFrequency(PWM_Channel channel)
+{
+	return g_frequency[channel];
+}
+
+/*
+ * Description :
+ * Function to set the Call Back function address of the channel.
+ * It is called from the timer overflow ISR at the start of every PWM period.
+ */
+void PWM_setCallBack(PWM_Channel channel,void(*a_ptr)(void))
+{
+	/* Save the address of the Call back function in a global variable */
+	g_callBackPtr[channel] = a_ptr;
+
+	PWM_updateOverflowInterrupt(channel);
+}
+
+
+static uint8 PWM_selectPrescaler(const uint16 * prescalers,uint8 size,PWM_Frequency frequency,PWM_Frequency * real_frequency)
+{
+	uint8 i;
+	uint8 best = 0;
+	uint32 error;
+	uint32 best_error = 0xFFFFFFFF;
+	uint32 candidate;
+
+	for(i=0;i<size;i++)
+	{
+		candidate = F_CPU / ((uint32)(MAX_TIMER_VALUE+1) * prescalers[i]);
+		error = (candidate > frequency) ? (candidate - frequency) : (frequency - candidate);
+		if(error < best_error)
+		{
+			best_error = error;
+			best = i;
+			*real_frequency = (PWM_Frequency)candidate;
+		}
+	}
+
+	/* CSx2:0 = table index + 1 */
+	return best + 1;
+}
+
+static void PWM_applyDutyCycle(PWM_Channel channel)
+{
+	/* OCRx is double buffered by the timer, it is latched at the end of this period */
+	if(channel == PWM_CHANNEL_OC0)
+	{
+		HAL_WRITE_REG(OCR0, g_compareBuffer[channel]);
+	}
+	else if(channel == PWM_CHANNEL_OC2)
+	{
+		HAL_WRITE_REG(OCR2, g_compareBuffer[channel]);
+	}
+
+	/* Changing COMx now would cut the period still running on the old OCRx */
+	g_outputZero[channel] = g_dutyZeroBuffer[channel];
+	g_outputPending[channel] = TRUE;
+	g_updatePending[channel] = FALSE;
+}
+
+static void PWM_applyOutput(PWM_Channel channel)
+{
+	if(channel == PWM_CHANNEL_OC0)
+	{
+		/* 0% needs OC0 disconnected, otherwise fast PWM still gives a one tick pulse */
+		if(g_outputZero[channel])
+		{
+			HAL_CLEAR_BITS(TCCR0, (1<<COM01) | (1<<COM00));
+		}
+		else
+		{
+			HAL_SET_BITS(TCCR0, TIMER0_NON_INVERTING);
+		}
+	}
+	else if(channel == PWM_CHANNEL_OC2)
+	{
+		/* 0% needs OC2 disconnected, otherwise fast PWM still gives a one tick pulse */
+		if(g_outputZero[channel])
+		{
+			HAL_CLEAR_BITS(TCCR2, (1<<COM21) | (1<<COM20));
+		}
+		else
+		{
+			HAL_SET_BITS(TCCR2, TIMER2_NON_INVERTING);
+		}
+	}
+
+	g_outputPending[channel] = FALSE;
+}
+
+static void PWM_updateOverflowInterrupt(PWM_Channel channel)
+{
+	uint8 needed = g_updatePending[channel] || g_outputPending[channel] || (g_callBackPtr[channel] != NULL_PTR);
+	/* TIMSK is shared with the ISRs, modify it with interrupts disabled */
+	uint8 sreg = HAL_READ_REG(SREG);
+	cli();
+
+	if(channel == PWM_CHANNEL_OC0)
+	{
+		if(needed)
+		{
+			HAL_SET_BIT(TIMSK,TOIE0);
+		}
+		else
+		{
+			HAL_CLEAR_BIT(TIMSK,TOIE0);
+		}
+	}
+	else if(channel == PWM_CHANNEL_OC2)
+	{
+		if(needed)
+		{
+			HAL_SET_BIT(TIMSK,TOIE2);
+		}
+		else
+		{
+			HAL_CLEAR_BIT(TIMSK,TOIE2);
+		}
+	}
+
+	HAL_WRITE_REG(SREG, sreg);
+}
+
+
+/*******************************************************************************
+ *                      		ISRs 		                                   *
+ *******************************************************************************/
+
+ISR(TIMER0_OVF_vect)
+{
+	Idle_noteWake(IDLE_WAKE_TIMER0);
+
+	/* A new period has just started, on the OCR0 written at the last overflow */
+	if(g_outputPending[PWM_CHANNEL_OC0])
+	{
+		PWM_applyOutput(PWM_CHANNEL_OC0);
+	}
+	if(g_updatePending[PWM_CHANNEL_OC0])
+	{
+		PWM_applyDutyCycle(PWM_CHANNEL_OC0);
+	}
+
+	if(g_callBackPtr[PWM_CHANNEL_OC0] != NULL_PTR)
+	{
+		/* Call the Call Back function in the application at the start of the period */
+		(*g_callBackPtr[PWM_CHANNEL_OC0])();
+	}
+	else if(!g_updatePending[PWM_CHANNEL_OC0] && !g_outputPending[PWM_CHANNEL_OC0])
+	{
+		/* Nothing more to do till the next duty cycle change */
+		HAL_CLEAR_BIT(TIMSK,TOIE0);
+	}
+}
+
+ISR(TIMER2_OVF_vect)
+{
+	Idle_noteWake(IDLE_WAKE_TIMER2);
+
+	/* A new period has just started, on the OCR2 written at the last overflow */
+	if(g_outputPending[PWM_CHANNEL_OC2])
+	{
+		PWM_applyOutput(PWM_CHANNEL_OC2);
+	}
+	if(g_updatePending[PWM_CHANNEL_OC2])
+	{
+		PWM_applyDutyCycle(PWM_CHANNEL_OC2);
+	}
+
+	if(g_callBackPtr[PWM_CHANNEL_OC2] != NULL_PTR)
+	{
+		/* Call the Call Back function in the application at the start of the period */
+		(*g_callBackPtr[PWM_CHANNEL_OC2])();
+	}
+	else if(!g_updatePending[PWM_CHANNEL_OC2] && !g_outputPending[PWM_CHANNEL_OC2])
+	{
+		/* Nothing more to do till the next duty cycle change */
+		HAL_CLEAR_BIT(TIMSK,TOIE2);
+	}
+}
@@ -0,0 +1,89 @@
+ /******************************************************************************
+ *
+ * Module: PWM
+ *
+ * File Name: pwm.h
+ *
+ * Description: Header file for the ATmega32 Timer0/Timer2 fast PWM driver
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef PWM_H_
+#define PWM_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define MAX_DUTY_CYCLE_PERCENTAGE 100
+#define MAX_TIMER_VALUE     255
+
+/*******************************************************************************
+ *                      Configuration                                          *
+ *******************************************************************************/
+
+typedef enum{
+	PWM_CHANNEL_OC0,	/* Timer0 --> PB3 */
+	PWM_CHANNEL_OC2		/* Timer2 --> PD7 */
+}PWM_Channel;
+
+/*
+ * Fast PWM frequency = F_CPU/(256*N), the driver selects the prescaler N
+ * that gives the nearest frequency to the required one:
+ * Timer0 N = 1, 8, 64, 256, 1024          --> 31250, 3906, 488, 122, 30 Hz
+ * Timer2 N = 1, 8, 32, 64, 128, 256, 1024 --> 31250, 3906, 977, 488, 244, 122, 30 Hz
+ */
+typedef uint16 PWM_Frequency;
+
+typedef struct{
+	PWM_Channel channel;
+	PWM_Frequency frequency;
+}PWM_ConfigType;
+
+
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Function to start the timer of the channel in fast PWM mode:
+ * 1. Setup the OCx pin as output pin.
+ * 2. Select the prescaler nearest to the required frequency.
+ * 3. Start with duty cycle 0% (OCx pin is disconnected and low).
+ */
+void PWM_init(const PWM_ConfigType * Config_Ptr);
+
+/*
+ * Description :
+ * Function to change the duty cycle (0 --> 100) of the channel without
+ * restarting its timer. The new value is written at the start of the next
+ * PWM period and takes effect, OCRx and the OCx connection together, when the
+ * timer latches it at the end of that period, so no period is ever truncated.
+ */
+void PWM_setDutyCycle(PWM_Channel channel,uint8 duty_cycle);
+
+/*
+ * Description :
+ * Function to stop the timer of the channel and force its OCx pin low.
+ */
+void PWM_stop(PWM_Channel channel);
+
+/*
+ * Description :
+ * Function to return the real frequency selected for the channel in Hz.
+ */
+PWM_Frequency PWM_getFrequency(PWM_Channel channel);
+
+/*
+ * Description :
+ * Function to set the Call Back function address of the channel.
+ * It is called from the timer overflow ISR at the start of every PWM period.
+ */
+void PWM_setCallBack(PWM_Channel channel,void(*a_ptr)(void));
+
+#endif /* PWM_H_ */
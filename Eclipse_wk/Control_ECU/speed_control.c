@@ -0,0 +1,217 @@
+ /******************************************************************************
+ *
+ * Module: Speed Control
+ *
+ * File Name: speed_control.c
+ *
+ * Description: Source file for the DC motor closed loop speed controller
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include <avr/interrupt.h> /* For cli() */
+#include "mcu_hal.h"	/* For Register access */
+#include "speed_control.h"
+#include "dc_motor.h"
+#include "timer1.h"
+#include "pwm.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Integral is limited to what gives 100% duty cycle alone (anti wind-up) */
+#define SPEED_CONTROL_INTEGRAL_LIMIT \
+	((sint16)((MAX_DUTY_CYCLE_PERCENTAGE * SPEED_CONTROL_GAIN_DIVISOR) / SPEED_CONTROL_KI))
+
+/*******************************************************************************
+ *                      Global Variables                                  *
+ *******************************************************************************/
+
+/* Encoder periods summed by the capture ISR since the last controller step */
+static volatile uint32 g_periodTicksSum = 0;
+static volatile uint8 g_periodCount = 0;
+/* The first capture after a stop measures the stop time, not a pulse period */
+static volatile uint8 g_skipNextPeriod = TRUE;
+
+/* Controller state, only used from the PWM ISR once the speed is set */
+static volatile uint8 g_speed = 0;
+static volatile uint16 g_targetRpm = 0;
+static volatile sint16 g_integral = 0;
+static volatile uint8 g_stepPeriods = 0;
+static volatile uint8 g_stepsWithoutPulse = 0;
+
+/* Telemetry */
+static volatile uint16 g_measuredRpm = 0;
+static volatile uint8 g_dutyCycle = 0;
+
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Called from the Timer1 capture ISR with the period of the last encoder pulse
+ */
+static void SpeedControl_captureCallBack(uint16 period);
+
+/*
+ * Called from the motor PWM overflow ISR at the start of every PWM period
+ */
+static void SpeedControl_periodCallBack(void);
+
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * 1. Start capturing the encoder pulses through the Timer1 input capture.
+ * 2. Run the PI controller from the PWM period Call Back of the motor channel,
+ *    it is set with a speed and removed once the motor is at rest.
+ * Timer1 must be running for the encoder time stamps.
+ */
+void SpeedControl_init(void)
+{
+	Timer1_setCaptureCallBack(SpeedControl_captureCallBack);
+	Timer1_enableInputCapture(CAPTURE_RISING_EDGE);
+}
+
+/*
+ * Description :
+ * Set the required motor speed in percentage of SPEED_CONTROL_MAX_RPM (0 --> 100).
+ * The duty cycle starts from the same percentage, then the PI controller corrects it.
+ * 0 stops the controller and the motor PWM.
+ */
+void SpeedControl_setSpeed(uint8 speed)
+{
+	if(speed > MAX_DUTY_CYCLE_PERCENTAGE)
+	{
+		speed = MAX_DUTY_CYCLE_PERCENTAGE;
+	}
+
+	/* Stop the controller while its state is changed */
+	g_speed = 0;
+	g_targetRpm = (uint16)(((uint32)speed * SPEED_CONTROL_MAX_RPM) / MAX_DUTY_CYCLE_PERCENTAGE);
+	if(speed == 0)
+	{
+		g_integral = 0;
+		g_skipNextPeriod = TRUE;
+	}
+	g_dutyCycle = speed;
+	PWM_setDutyCycle(Motor1_PWM_CHANNEL, speed);
+	g_speed = speed;
+
+	if(speed != 0)
+	{
+		PWM_setCallBack(Motor1_PWM_CHANNEL, SpeedControl_periodCallBack);
+	}
+}
+
+/*
+ * Description :
+ * Return the last measured motor speed in RPM (telemetry).
+ */
+uint16 SpeedControl_getRpm(void)
+{
+	uint16 rpm;
+
+	/* 16-bit variable shared with the ISR, read it with interrupts disabled */
+	uint8 sreg = HAL_READ_REG(SREG);
+	cli();
+	rpm = g_measuredRpm;
+	HAL_WRITE_REG(SREG, sreg);
+
+	return rpm;
+}
+
+/*
+ * Description :
+ * Return the duty cycle applied by the controller in percentage (telemetry).
+ */
+uint8 SpeedControl_getDutyCycle(void)
+{
+	return g_dutyCycle;
+}
+
+
+static void SpeedControl_captureCallBack(uint16 period)
+{
+	if(g_skipNextPeriod)
+	{
+		g_skipNextPeriod = FALSE;
+		return;
+	}
+	/* A bounce of the encoder within one timer tick is not a pulse, and would divide by 0 */
+	if(period == 0)
+	{
+		return;
+	}
+	g_periodTicksSum += period;
+	g_periodCount++;
+}
+
+static void SpeedControl_periodCallBack(void)
+{
+	sint16 error;
+	sint16 duty;
+
+	if(++g_stepPeriods < SPEED_CONTROL_STEP_PERIODS)
+	{
+		return;
+	}
+	g_stepPeriods = 0;
+
+	/* Measure : RPM = 60 * ticks per second / (average period * pulses per revolution) */
+	if(g_periodCount > 0)
+	{
+		g_measuredRpm = (uint16)((60UL * SPEED_CONTROL_TIMER_TICKS_PER_SECOND * g_periodCount)
+				/ (g_periodTicksSum * SPEED_CONTROL_ENCODER_PULSES_PER_REV));
+		g_periodTicksSum = 0;
+		g_periodCount = 0;
+		g_stepsWithoutPulse = 0;
+	}
+	else if(g_stepsWithoutPulse < SPEED_CONTROL_STOP_STEPS)
+	{
+		g_stepsWithoutPulse++;
+	}
+	else
+	{
+		g_measuredRpm = 0;
+		g_skipNextPeriod = TRUE;
+	}
+
+	/* Nothing to control while the motor is stopped */
+	if(g_speed == 0)
+	{
+		/* No PWM period interrupts once the motor is at rest, till the next speed is set */
+		if(g_measuredRpm == 0)
+		{
+			PWM_setCallBack(Motor1_PWM_CHANNEL, NULL_PTR);
+		}
+		return;
+	}
+
+	/* PI : duty = feed forward + KP*error + KI*integral */
+	error = (sint16)g_targetRpm - (sint16)g_measuredRpm;
+	duty = (sint16)g_speed + (((sint32)SPEED_CONTROL_KP * error) + ((sint32)SPEED_CONTROL_KI * g_integral)) / SPEED_CONTROL_GAIN_DIVISOR;
+
+	if(duty > MAX_DUTY_CYCLE_PERCENTAGE)
+	{
+		duty = MAX_DUTY_CYCLE_PERCENTAGE;
+	}
+	else if(duty < 0)
+	{
+		duty = 0;
+	}
+	/* Integrate only while the output is not saturated (anti wind-up) */
+	else if((g_integral + error < SPEED_CONTROL_INTEGRAL_LIMIT) && (g_integral + error > -SPEED_CONTROL_INTEGRAL_LIMIT))
+	{
+		g_integral += error;
+	}
+
+	g_dutyCycle = (uint8)duty;
+	PWM_setDutyCycle(Motor1_PWM_CHANNEL, g_dutyCycle);
+}
@@ -0,0 +1,84 @@
+ /******************************************************************************
+ *
+ * Module: Speed Control
+ *
+ * File Name: speed_control.h
+ *
+ * Description: Header file for the DC motor closed loop speed controller
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef SPEED_CONTROL_H_
+#define SPEED_CONTROL_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Encoder output on ICP1 (PD6), captured on rising edges by Timer1 */
+#define SPEED_CONTROL_ENCODER_PULSES_PER_REV	20
+
+/* Timer1 runs at F_CPU/256 for the 1 second tick */
+#define SPEED_CONTROL_TIMER_TICKS_PER_SECOND	31250UL
+
+/* Motor speed at 100% duty cycle, used to map the speed percentage to RPM */
+#define SPEED_CONTROL_MAX_RPM					300
+
+/*
+ * The PI controller runs every SPEED_CONTROL_STEP_PERIODS motor PWM periods:
+ * 488 Hz / 16 = ~30 steps per second.
+ */
+#define SPEED_CONTROL_STEP_PERIODS				16
+
+/*
+ * No encoder pulse for SPEED_CONTROL_STOP_STEPS steps means the motor is stopped
+ * (~130 ms, below 23 RPM with 20 pulses per revolution).
+ */
+#define SPEED_CONTROL_STOP_STEPS				4
+
+/*
+ * PI gains in duty cycle % per RPM, as fractions of SPEED_CONTROL_GAIN_DIVISOR:
+ * duty = feed forward + (KP*error + KI*sum of errors) / SPEED_CONTROL_GAIN_DIVISOR
+ */
+#define SPEED_CONTROL_KP						4
+#define SPEED_CONTROL_KI						1
+#define SPEED_CONTROL_GAIN_DIVISOR				32
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * 1. Start capturing the encoder pulses through the Timer1 input capture.
+ * 2. Run the PI controller from the PWM period Call Back of the motor channel,
+ *    it is set with a speed and removed once the motor is at rest.
+ * Timer1 must be running for the encoder time stamps.
+ */
+void SpeedControl_init(void);
+
+/*
+ * Description :
+ * Set the required motor speed in percentage of SPEED_CONTROL_MAX_RPM (0 --> 100).
+ * The duty cycle starts from the same percentage, then the PI controller corrects it.
+ * 0 stops the controller and the motor PWM.
+ */
+void SpeedControl_setSpeed(uint8 speed);
+
+/*
+ * Description :
+ * Return the last measured motor speed in RPM (telemetry).
+ */
+uint16 SpeedControl_getRpm(void);
+
+/*
+ * Description :
+ * Return the duty cycle applied by the controller in percentage (telemetry).
+ */
+uint8 SpeedControl_getDutyCycle(void);
+
+#endif /* SPEED_CONTROL_H_ */
@@ -0,0 +1,264 @@
+ /******************************************************************************
+ *
+ * Module: Statistics
+ *
+ * File Name: stats.c
+ *
+ * Description: Source file for the runtime statistics of the Control ECU
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include "stats.h"
+#include <avr/interrupt.h>		/* For cli() */
+#include <util/delay.h>			/* For delay function */
+#include "mcu_hal.h"			/* For Register access */
+#include "external_eeprom.h"
+#include "uart.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define STATS_SIZE					(2 * STATS_NUM_VALUES)
+
+/*******************************************************************************
+ *                      Global Variables                                  *
+ *******************************************************************************/
+
+/* Changed from the main loop only, the UART error callback included */
+static uint16 g_values[STATS_NUM_VALUES];
+/* The values saved in the EEPROM, all the bytes are written if it is not valid */
+static uint16 g_savedValues[STATS_NUM_VALUES];
+static uint8 g_savedValid = FALSE;
+/* Counted by Stats_tick() in the Timer1 interrupt */
+static volatile uint16 g_secondsSinceSave = 0;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Byte i of the values, low byte first
+ */
+static uint8 Stats_byte(const uint16 * values,uint8 i);
+
+/*
+ * Checksum of the saved values, an erased EEPROM does not match it
+ */
+static uint8 Stats_checksum(const uint16 * values);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Read the statistics saved in the EEPROM, they start from 0 if the
+ * EEPROM is erased or the checksum is wrong.
+ */
+void Stats_init(void)
+{
+	uint8 data[STATS_SIZE + 1];
+	uint8 i;
+
+	for(i=0;i<(STATS_SIZE + 1);i++)
+	{
+		data[i] = 0xFF;
+		EEPROM_readByte(STATS_EEPROM_ADDRESS + i, &data[i]);
+		/*	Must make 10 ms delay between each write/read operation in EEPROM*/
+		_delay_ms(10);
+	}
+	for(i=0;i<STATS_NUM_VALUES;i++)
+	{
+		g_savedValues[i] = ((uint16)data[(2 * i) + 1] << 8) | data[2 * i];
+	}
+
+	g_savedValid = (Stats_checksum(g_savedValues) == data[STATS_SIZE]);
+	for(i=0;i<STATS_NUM_VALUES;i++)
+	{
+		if(!g_savedValid)
+		{
+			g_savedValues[i] = 0;
+		}
+		g_values[i] = g_savedValues[i];
+	}
+	/* Save the first change at once */
+	g_secondsSinceSave = STATS_CHECKPOINT_PERIOD;
+}
+
+/*
+ * Description :
+ * Count one second, called from the Timer1 callback.
+ */
+void Stats_tick(void)
+{
+	if(g_secondsSinceSave < STATS_CHECKPOINT_PERIOD)
+	{
+		g_secondsSinceSave++;
+	}
+}
+
+/*
+ * Description :
+ * Add one to the counter, it stops at 0xFFFF.
+ */
+void Stats_increment(Stats_ValueId id)
+{
+	if(g_values[id] != 0xFFFF)
+	{
+		g_values[id]++;
+	}
+}
+
+/*
+ * Description :
+ * Keep the maximum of the latency in ms.
+ */
+void Stats_recordLatency(uint16 latency)
+{
+	if(latency > g_values[STATS_MAX_LATENCY])
+	{
+		g_values[STATS_MAX_LATENCY] = latency;
+	}
+}
+
+/*
+ * Description :
+ * Keep the maximum of the stack usage in bytes, from StackMonitor_getMaxUsage().
+ */
+void Stats_recordStackUsage(uint16 usage)
+{
+	if(usage > g_values[STATS_MAX_STACK])
+	{
+		g_values[STATS_MAX_STACK] = usage;
+	}
+}
+
+/*
+ * Description :
+ * Count the FE/DOR bits of a byte received with errors,
+ * to be set with UART_setErrorCallBack().
+ */
+void Stats_uartErrorCallBack(uint8 errors)
+{
+	if(errors & (1<<FE))
+	{
+		Stats_increment(STATS_UART_FRAME_ERRORS);
+	}
+	if(errors & (1<<DOR))
+	{
+		Stats_increment(STATS_UART_OVERRUNS);
+	}
+}
+
+/*
+ * Description :
+ * Return the value.
+ */
+uint16 Stats_get(Stats_ValueId id)
+{
+	return g_values[id];
+}
+
+/*
+ * Description :
+ * Save the statistics in the EEPROM if they changed and the checkpoint
+ * period passed, only the changed bytes are written.
+ */
+void Stats_update(void)
+{
+	uint16 values[STATS_NUM_VALUES];
+	uint16 seconds;
+	uint8 changed = FALSE;
+	uint8 i;
+	uint8 sreg = HAL_READ_REG(SREG);
+
+	cli();
+	seconds = g_secondsSinceSave;
+	HAL_WRITE_REG(SREG, sreg);
+	if(seconds < STATS_CHECKPOINT_PERIOD)
+	{
+		return;
+	}
+	for(i=0;i<STATS_NUM_VALUES;i++)
+	{
+		values[i] = Stats_get(i);
+		if(values[i] != g_savedValues[i])
+		{
+			changed = TRUE;
+		}
+	}
+	if(!changed)
+	{
+		return;
+	}
+
+	for(i=0;i<STATS_SIZE;i++)
+	{
+		if((!g_savedValid) || (Stats_byte(values, i) != Stats_byte(g_savedValues, i)))
+		{
+			if(EEPROM_writeByte(STATS_EEPROM_ADDRESS + i, Stats_byte(values, i)) == ERROR)
+			{
+				Stats_increment(STATS_EEPROM_ERRORS);
+			}
+			/*	Must make 10 ms delay between each write/read operation in EEPROM*/
+			_delay_ms(10);
+		}
+	}
+	if(EEPROM_writeByte(STATS_EEPROM_ADDRESS + STATS_SIZE, Stats_checksum(values)) == ERROR)
+	{
+		Stats_increment(STATS_EEPROM_ERRORS);
+	}
+	_delay_ms(10);
+
+	for(i=0;i<STATS_NUM_VALUES;i++)
+	{
+		g_savedValues[i] = values[i];
+	}
+	g_savedValid = TRUE;
+	cli();
+	g_secondsSinceSave = 0;
+	HAL_WRITE_REG(SREG, sreg);
+}
+
+/*
+ * Description :
+ * Send the answer to STATS_REQUEST over the UART.
+ */
+void Stats_send(void)
+{
+	uint16 value;
+	uint8 i;
+
+	UART_sendByte(STATS_REQUEST);
+	for(i=0;i<STATS_NUM_VALUES;i++)
+	{
+		value = Stats_get(i);
+		UART_sendByte((uint8)value);
+		UART_sendByte((uint8)(value >> 8));
+	}
+}
+
+
+/*******************************************************************************
+ *                      Private Functions                                      *
+ *******************************************************************************/
+
+static uint8 Stats_byte(const uint16 * values,uint8 i)
+{
+	return (i & 0x01) ? (uint8)(values[i / 2] >> 8) : (uint8)values[i / 2];
+}
+
+static uint8 Stats_checksum(const uint16 * values)
+{
+	uint8 sum = 0;
+	uint8 i;
+
+	for(i=0;i<STATS_SIZE;i++)
+	{
+		sum += Stats_byte(values, i);
+	}
+	return (uint8)(~sum);
+}
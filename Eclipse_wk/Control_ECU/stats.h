@@ -0,0 +1,118 @@
+ /******************************************************************************
+ *
+ * Module: Statistics
+ *
+ * File Name: stats.h
+ *
+ * Description: Header file for the runtime statistics of the Control ECU
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef STATS_H_
+#define STATS_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * The statistics are kept in RAM and saved in the external EEPROM by
+ * Stats_update(), when they changed and STATS_CHECKPOINT_PERIOD seconds
+ * passed since the previous save. A reset loses at most the changes of
+ * the last period.
+ */
+
+/* Saved after the learned door travel times : 16 bytes + checksum */
+#define STATS_EEPROM_ADDRESS		0x0330
+
+#define STATS_CHECKPOINT_PERIOD		300
+
+/*
+ * Byte sent by the HMI_ECU to query the statistics, while the password is awaited.
+ * The answer is STATS_REQUEST then the STATS_NUM_VALUES values, 2 bytes each,
+ * low byte first, in the order of Stats_ValueId.
+ */
+#define STATS_REQUEST				0x12
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef enum{
+	STATS_UNLOCKS,
+	STATS_WRONG_ATTEMPTS,
+	STATS_LOCKOUTS,
+	STATS_EEPROM_ERRORS,
+	STATS_UART_FRAME_ERRORS,
+	STATS_UART_OVERRUNS,
+	STATS_MAX_LATENCY,			/* in ms, not a counter */
+	STATS_MAX_STACK,			/* in bytes, not a counter */
+	STATS_NUM_VALUES
+}Stats_ValueId;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Read the statistics saved in the EEPROM, they start from 0 if the
+ * EEPROM is erased or the checksum is wrong.
+ */
+void Stats_init(void);
+
+/*
+ * Description :
+ * Count one second, called from the Timer1 callback.
+ */
+void Stats_tick(void);
+
+/*
+ * Description :
+ * Add one to the counter, it stops at 0xFFFF.
+ */
+void Stats_increment(Stats_ValueId id);
+
+/*
+ * Description :
+ * Keep the maximum of the latency in ms.
+ */
+void Stats_recordLatency(uint16 latency);
+
+/*
+ * Description :
+ * Keep the maximum of the stack usage in bytes, from StackMonitor_getMaxUsage().
+ */
+void Stats_recordStackUsage(uint16 usage);
+
+/*
+ * Description :
+ * Count the FE/DOR bits of a byte received with errors,
+ * to be set with UART_setErrorCallBack().
+ */
+void Stats_uartErrorCallBack(uint8 errors);
+
+/*
+ * Description :
+ * Return the value.
+ */
+uint16 Stats_get(Stats_ValueId id);
+
+/*
+ * Description :
+ * Save the statistics in the EEPROM if they changed and the checkpoint
+ * period passed, only the changed bytes are written.
+ */
+void Stats_update(void);
+
+/*
+ * Description :
+ * Send the answer to STATS_REQUEST over the UART.
+ */
+void Stats_send(void);
+
+#endif /* STATS_H_ */
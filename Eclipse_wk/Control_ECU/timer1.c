@@ -1,106 +1,250 @@
-/*
- * timer.c
- *
- *  Created on: Oct 27, 2022
- *      Author: Omar Elsherif
- */
-
-#include <avr/interrupt.h> /* For Timer ISR */
-#include <avr/io.h>	/* For Register names */
-#include "timer1.h"
-
-/*******************************************************************************
- *                      Global Variables                                  *
- *******************************************************************************/
-
-static volatile void (*g_callBackPtr)(void) = NULL_PTR;
-
-
-/*******************************************************************************
- *                      Functions Definitions                                  *
- *******************************************************************************/
-
-
-/*
- * Description :
- * Function to initialize the Timer driver.
- */
-void Timer1_init(const Timer1_ConfigType * TIMER1_Config)
-{
-
-	/* FOC1A,FOC1B  : are only active when specifying non-pwm mode */
-	TCCR1A = (1<<FOC1A) | (1<<FOC1B);
-	/* Select the modes WGM11,WGM10 , {Normal Mode or Compare Mode} */
-	TCCR1A = (TCCR1A & 0xFC) | ((TIMER1_Config->mode)&0x03);
-	/* configure WGM13, WGM12 */
-	TCCR1B = (TCCR1B & 0xE7) | (((TIMER1_Config->mode) & 0x0C)<<1);
-
-	/* Configure prescaler , CS12, CS11, CS10*/
-	TCCR1B = (TCCR1B & 0xF8) | ((TIMER1_Config->prescaler)&0x07);
-
-	/* Value of Timer initially */
-	TCNT1 = TIMER1_Config->initial_value;
-
-	if(TIMER1_Config->mode == CTC_MODE)
-	{
-		/* Compare value is put in OCR1A register*/
-		OCR1A = TIMER1_Config->compare_value;
-
-		/* Enable the Output Compare A Match Interrupt Enable */
-		TIMSK = (1<<OCIE1A);
-	}
-	else if (TIMER1_Config->mode == NORMAL_MODE)
-	{
-		/* Enable the Output Compare A Match Interrupt Enable */
-		TIMSK = (1<<TOIE1);
-	}
-}
-
-/*
- * Description :
- * Function to disable the Timer1
- */
-void Timer1_deInit(void)
-{
-	/* deInit the Whole Timer1*/
-	TCCR1A = 0;
-	TCNT1 = 0;
-	OCR1A = 0;
-	TIMSK = 0;
-}
-
-
-/*
- * Description :
- * Function to set the Call Back function address.
- */
-void Timer1_setCallBack(void(*a_ptr)(void))
-{
-	/* Save the address of the Call back function in a global variable */
-	g_callBackPtr = a_ptr;
-}
-
-
-/*******************************************************************************
- *                      		ISRs 		                                   *
- *******************************************************************************/
-
-ISR(TIMER1_OVF_vect)
-{
-	if(g_callBackPtr != NULL_PTR)
-	{
-		/* Call the Call Back function in the application after the edge is detected */
-		(*g_callBackPtr)(); /* another method to call the function using pointer to function g_callBackPtr(); */
-	}
-}
-
-ISR(TIMER1_COMPA_vect)
-{
-	if(g_callBackPtr != NULL_PTR)
-	{
-		/* Call the Call Back function in the application after the edge is detected */
-		(*g_callBackPtr)(); /* another method to call the function using pointer to function g_callBackPtr(); */
-	}
-
-}
-
+/*
+ * timer.c
+ *
+ *  Created on: Oct 27, 2022
+ *      Author: Omar Elsherif
+ */
+
+#include <avr/interrupt.h> /* For Timer ISR */
+#include "mcu_hal.h"	/* For Register access */
+#include "timer1.h"
+#include "idle.h"		/* For the wake reason */
+
+/*******************************************************************************
+ *                      Global Variables                                  *
+ *******************************************************************************/
+
+static volatile void (*g_callBackPtr)(void) = NULL_PTR;
+static void (*volatile g_captureCallBackPtr)(uint16) = NULL_PTR;
+static void (*volatile g_alarmCallBackPtr)(void) = NULL_PTR;
+
+/* Timer value at the previous input capture */
+static volatile uint16 g_lastCapture = 0;
+
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+
+/*
+ * Description :
+ * Function to initialize the Timer driver.
+ */
+void Timer1_init(const Timer1_ConfigType * TIMER1_Config)
+{
+
+	/* FOC1A,FOC1B  : are only active when specifying non-pwm mode */
+	HAL_WRITE_REG(TCCR1A, (1<<FOC1A) | (1<<FOC1B));
+	/* Select the modes WGM11,WGM10 , {Normal Mode or Compare Mode} */
+	HAL_WRITE_REG(TCCR1A, (HAL_READ_REG(TCCR1A) & 0xFC) | ((TIMER1_Config->mode)&0x03));
+	/* configure WGM13, WGM12 */
+	HAL_WRITE_REG(TCCR1B, (HAL_READ_REG(TCCR1B) & 0xE7) | (((TIMER1_Config->mode) & 0x0C)<<1));
+
+	/* Configure prescaler , CS12, CS11, CS10*/
+	HAL_WRITE_REG(TCCR1B, (HAL_READ_REG(TCCR1B) & 0xF8) | ((TIMER1_Config->prescaler)&0x07));
+
+	/* Value of Timer initially */
+	HAL_WRITE_REG16(TCNT1, TIMER1_Config->initial_value);
+
+	if(TIMER1_Config->mode == CTC_MODE)
+	{
+		/* Compare value is put in OCR1A register*/
+		HAL_WRITE_REG16(OCR1A, TIMER1_Config->compare_value);
+
+		/* Enable the Output Compare A Match Interrupt Enable,
+		 * TIMSK is shared with Timer0/Timer2 and the input capture, keep their bits */
+		HAL_WRITE_REG(TIMSK, (HAL_READ_REG(TIMSK) & 0xE3) | (1<<OCIE1A));
+	}
+	else if (TIMER1_Config->mode == NORMAL_MODE)
+	{
+		/* Enable the Overflow Interrupt Enable,
+		 * TIMSK is shared with Timer0/Timer2 and the input capture, keep their bits */
+		HAL_WRITE_REG(TIMSK, (HAL_READ_REG(TIMSK) & 0xE3) | (1<<TOIE1));
+	}
+}
+
+/*
+ * Description :
+ * Function to disable the Timer1
+ */
+void Timer1_deInit(void)
+{
+	/* deInit the Whole Timer1*/
+	HAL_WRITE_REG(TCCR1A, 0);
+	HAL_WRITE_REG16(TCNT1, 0);
+	HAL_WRITE_REG16(OCR1A, 0);
+	/* Disable Timer1 interrupts only */
+	HAL_WRITE_REG(TIMSK, HAL_READ_REG(TIMSK) & 0xC3);
+}
+
+
+/*
+ * Description :
+ * Function to set the Call Back function address.
+ */
+void Timer1_setCallBack(void(*a_ptr)(void))
+{
+	/* Save the address of the Call back function in a global variable */
+	g_callBackPtr = a_ptr;
+}
+
+
+/*
+ * Description :
+ * Function to return the current value of the timer counter.
+ */
+uint16 Timer1_getCount(void)
+{
+	return HAL_READ_REG16(TCNT1);
+}
+
+/*
+ * Description :
+ * Function to start capturing the timer on the required edge of ICP1 (PD6).
+ * The capture works in CTC mode too, so the timer can keep its compare interrupt.
+ */
+void Timer1_enableInputCapture(Timer1_CaptureEdge edge)
+{
+	/* ICP1 pin PD6 is input */
+	HAL_CLEAR_BITS(DDRD, 1<<PD6);
+
+	/* ICNC1 = 1 noise canceler (4 samples) , ICES1 = capture edge */
+	HAL_WRITE_REG(TCCR1B, (HAL_READ_REG(TCCR1B) & 0x3F) | (1<<ICNC1) | ((edge & 0x01)<<ICES1));
+
+	/* Clear any old capture flag, then enable the input capture interrupt */
+	HAL_WRITE_REG(TIFR, (1<<ICF1));
+	g_lastCapture = HAL_READ_REG16(ICR1);
+	HAL_SET_BITS(TIMSK, (1<<TICIE1));
+}
+
+/*
+ * Description :
+ * Function to stop the input capture.
+ */
+void Timer1_disableInputCapture(void)
+{
+	HAL_CLEAR_BITS(TIMSK, 1<<TICIE1);
+}
+
+/*
+ * Description :
+ * Function to set the Call Back function address of the input capture.
+ * It is called from the ISR with the timer ticks passed since the previous capture,
+ * the period is only valid if it is less than one timer cycle.
+ */
+void Timer1_setCaptureCallBack(void(*a_ptr)(uint16))
+{
+	/* Save the address of the Call back function in a global variable */
+	g_captureCallBackPtr = a_ptr;
+}
+
+/*
+ * Description :
+ * Function to start a one shot alarm on the compare B match, the ticks from now
+ * must be less than one timer cycle. It works in CTC mode too, next to the
+ * compare A interrupt, starting it again moves the alarm.
+ */
+void Timer1_startAlarm(uint16 ticks)
+{
+	uint32 cycle = 0x10000UL;
+	uint32 compare;
+	uint8 sreg = HAL_READ_REG(SREG);
+
+	cli();
+	/* In CTC mode the timer wraps at OCR1A instead of 0xFFFF */
+	if(HAL_READ_REG(TCCR1B) & (1<<WGM12))
+	{
+		cycle = (uint32)HAL_READ_REG16(OCR1A) + 1;
+	}
+	compare = ((uint32)HAL_READ_REG16(TCNT1) + ticks) % cycle;
+	HAL_WRITE_REG16(OCR1B, (uint16)compare);
+
+	/* Clear any old compare B flag, then enable the compare B interrupt */
+	HAL_WRITE_REG(TIFR, (1<<OCF1B));
+	HAL_SET_BITS(TIMSK, (1<<OCIE1B));
+	HAL_WRITE_REG(SREG, sreg);
+}
+
+/*
+ * Description :
+ * Function to cancel the alarm if it did not ring yet.
+ */
+void Timer1_stopAlarm(void)
+{
+	uint8 sreg = HAL_READ_REG(SREG);
+
+	cli();
+	HAL_CLEAR_BITS(TIMSK, 1<<OCIE1B);
+	HAL_WRITE_REG(SREG, sreg);
+}
+
+/*
+ * Description :
+ * Function to set the Call Back function address of the alarm.
+ * It is called from the ISR, once for each Timer1_startAlarm().
+ */
+void Timer1_setAlarmCallBack(void(*a_ptr)(void))
+{
+	/* Save the address of the Call back function in a global variable */
+	g_alarmCallBackPtr = a_ptr;
+}
+
+
+/*******************************************************************************
+ *                      		ISRs 		                                   *
+ *******************************************************************************/
+
+ISR(TIMER1_OVF_vect)
+{
+	Idle_noteWake(IDLE_WAKE_TIMER1);
+	if(g_callBackPtr != NULL_PTR)
+	{
+		/* Call the Call Back function in the application after the edge is detected */
+		(*g_callBackPtr)(); /* another method to call the function using pointer to function g_callBackPtr(); */
+	}
+}
+
+ISR(TIMER1_CAPT_vect)
+{
+	uint16 capture = HAL_READ_REG16(ICR1);
+	uint16 period = capture - g_lastCapture;
+
+	Idle_noteWake(IDLE_WAKE_TIMER1);
+
+	/* In CTC mode the timer wraps at OCR1A instead of 0xFFFF */
+	if((HAL_READ_REG(TCCR1B) & (1<<WGM12)) && (capture < g_lastCapture))
+	{
+		period += HAL_READ_REG16(OCR1A) + 1;
+	}
+	g_lastCapture = capture;
+
+	if(g_captureCallBackPtr != NULL_PTR)
+	{
+		/* Call the Call Back function in the application with the captured period */
+		(*g_captureCallBackPtr)(period);
+	}
+}
+
+ISR(TIMER1_COMPB_vect)
+{
+	Idle_noteWake(IDLE_WAKE_TIMER1);
+	/* One shot : disabled till the next Timer1_startAlarm() */
+	HAL_CLEAR_BITS(TIMSK, 1<<OCIE1B);
+	if(g_alarmCallBackPtr != NULL_PTR)
+	{
+		(*g_alarmCallBackPtr)();
+	}
+}
+
+ISR(TIMER1_COMPA_vect)
+{
+	Idle_noteWake(IDLE_WAKE_TIMER1);
+	if(g_callBackPtr != NULL_PTR)
+	{
+		/* Call the Call Back function in the application after the edge is detected */
+		(*g_callBackPtr)(); /* another method to call the function using pointer to function g_callBackPtr(); */
+	}
+
+}
+
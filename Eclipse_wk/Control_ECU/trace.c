@@ -0,0 +1,216 @@
+ /******************************************************************************
+ *
+ * Module: Trace
+ *
+ * File Name: trace.c
+ *
+ * Description: Source file for the binary event trace of the ECU
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include "trace.h"
+
+#ifdef TRACE_ENABLE
+
+#include <avr/interrupt.h>	/* For cli() */
+#include "mcu_hal.h"		/* For Register access */
+#include "uart.h"
+
+/*******************************************************************************
+ *                      Global Variables                                  *
+ *******************************************************************************/
+
+static Trace_Record g_records[TRACE_RING_SIZE];
+/* Next record written, and records kept (up to TRACE_RING_SIZE) */
+static uint8 g_recordIndex = 0;
+static uint8 g_recordCount = 0;
+
+static volatile uint8 g_seconds = 0;
+/* TCNT1 counts from 0 to g_timerTop, OCR1A in CTC mode */
+static uint16 g_timerTop = 0xFFFF;
+
+static uint8 g_masked = 0;
+/* The dump is sent with UART_sendByte(), its bytes are not recorded */
+static volatile uint8 g_dumping = 0;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Send the byte as two hex digits
+ */
+static void Trace_sendHex(uint8 data);
+
+/*
+ * Send the number in decimal
+ */
+static void Trace_sendNumber(uint32 number);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Clear the ring, read the Timer1 cycle length and record TRACE_EVENT_INIT.
+ */
+void Trace_init(void)
+{
+	g_recordIndex = 0;
+	g_recordCount = 0;
+	g_seconds = 0;
+
+	/* WGM12 = 1 : CTC mode, the counter is cleared after OCR1A */
+	g_timerTop = HAL_BIT_IS_SET(TCCR1B, WGM12) ? HAL_READ_REG16(OCR1A) : 0xFFFF;
+
+	Trace_record(TRACE_EVENT_INIT, 0);
+}
+
+/*
+ * Description :
+ * Count one second, called from the Timer1 callback.
+ */
+void Trace_tick(void)
+{
+	g_seconds++;
+}
+
+/*
+ * Description :
+ * Add the event to the ring with the current time.
+ */
+void Trace_record(Trace_EventId event,uint8 argument)
+{
+	Trace_Record * record;
+	uint8 sreg;
+
+	if(g_dumping)
+	{
+		return;
+	}
+	if(g_masked && ((event == TRACE_EVENT_UART_TX) || (event == TRACE_EVENT_UART_RX)))
+	{
+		event = (event == TRACE_EVENT_UART_TX) ? TRACE_EVENT_UART_TX_MASKED : TRACE_EVENT_UART_RX_MASKED;
+		argument = 0;
+	}
+
+	sreg = HAL_READ_REG(SREG);
+	cli();
+
+	record = &g_records[g_recordIndex];
+	record->event = event;
+	record->argument = argument;
+	record->ticks = HAL_READ_REG16(TCNT1);
+	record->seconds = g_seconds;
+	/*
+	 * The compare match is at TCNT1 = g_timerTop, this last tick already
+	 * belongs to the next second, counted by the compare interrupt
+	 */
+	if(record->ticks >= g_timerTop)
+	{
+		record->ticks = 0;
+	}
+	/*
+	 * The compare interrupt waits for the interrupts to be enabled again,
+	 * the second is not counted yet
+	 */
+	if(HAL_BIT_IS_SET(TIFR, OCF1A) && (record->ticks < (g_timerTop / 2)))
+	{
+		record->seconds++;
+	}
+
+	g_recordIndex = (g_recordIndex + 1) % TRACE_RING_SIZE;
+	if(g_recordCount < TRACE_RING_SIZE)
+	{
+		g_recordCount++;
+	}
+
+	HAL_WRITE_REG(SREG, sreg);
+}
+
+/*
+ * Description :
+ * While masked, the UART bytes are recorded with their masked events,
+ * so the password is not kept in the trace.
+ */
+void Trace_mask(uint8 masked)
+{
+	g_masked = masked;
+}
+
+/*
+ * Description :
+ * Send the records, oldest first, over the UART :
+ * TRACE <ECU> <ticks per second> <records>
+ * one line of 10 hex digits per record : event, argument, seconds, ticks
+ * END
+ */
+void Trace_dump(void)
+{
+	Trace_Record record;
+	uint8 count;
+	uint8 i;
+	uint8 sreg = HAL_READ_REG(SREG);
+
+	/* Stop the recording till the dump is sent */
+	cli();
+	g_dumping = 1;
+	count = g_recordCount;
+	HAL_WRITE_REG(SREG, sreg);
+
+	UART_sendString((const uint8 *)"TRACE " TRACE_ECU_NAME " ");
+	Trace_sendNumber((uint32)g_timerTop + 1);
+	UART_sendByte(' ');
+	Trace_sendNumber(count);
+	UART_sendString((const uint8 *)"\r\n");
+
+	for(i=0;i<count;i++)
+	{
+		/* The oldest record is the next one written once the ring is full */
+		record = g_records[(g_recordIndex + TRACE_RING_SIZE - count + i) % TRACE_RING_SIZE];
+		Trace_sendHex(record.event);
+		Trace_sendHex(record.argument);
+		Trace_sendHex(record.seconds);
+		Trace_sendHex((uint8)(record.ticks >> 8));
+		Trace_sendHex((uint8)record.ticks);
+		UART_sendString((const uint8 *)"\r\n");
+	}
+	UART_sendString((const uint8 *)"END\r\n");
+
+	g_dumping = 0;
+}
+
+
+/*******************************************************************************
+ *                      Private Functions                                      *
+ *******************************************************************************/
+
+static void Trace_sendHex(uint8 data)
+{
+	static const uint8 digits[16] = "0123456789ABCDEF";
+
+	UART_sendByte(digits[data >> 4]);
+	UART_sendByte(digits[data & 0x0F]);
+}
+
+static void Trace_sendNumber(uint32 number)
+{
+	uint8 digits[10];
+	uint8 i = 0;
+
+	do
+	{
+		digits[i++] = '0' + (number % 10);
+		number /= 10;
+	}while(number != 0);
+
+	while(i > 0)
+	{
+		UART_sendByte(digits[--i]);
+	}
+}
+
+#endif /* TRACE_ENABLE */
@@ -0,0 +1,126 @@
+ /******************************************************************************
+ *
+ * Module: Trace
+ *
+ * File Name: trace.h
+ *
+ * Description: Header file for the binary event trace of the ECU
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * The trace is only built with TRACE_ENABLE defined (-DTRACE_ENABLE),
+ * without it the macros below are empty.
+ *
+ * Each event is a 5 bytes record in a RAM ring, the oldest one is overwritten.
+ * It is stamped with the seconds counted by TRACE_TICK() in the Timer1
+ * callback and TCNT1, Timer1 must be initialized before TRACE_INIT().
+ * The dump is text so it can not be mistaken for a command on the link,
+ * Eclipse_wk/Tools/trace_decode.py merges the dumps of the two ECUs.
+ */
+
+#define TRACE_ECU_NAME				"CONTROL"
+
+#define TRACE_RING_SIZE				64
+
+/* Byte sent by the HMI_ECU to request the dump, while the password is awaited */
+#define TRACE_DUMP_REQUEST			0x11
+
+#ifdef TRACE_ENABLE
+
+#define TRACE_INIT()				Trace_init()
+#define TRACE_TICK()				Trace_tick()
+#define TRACE(EVENT,ARGUMENT)		Trace_record(EVENT,ARGUMENT)
+#define TRACE_MASK(MASKED)			Trace_mask(MASKED)
+#define TRACE_DUMP()				Trace_dump()
+
+#else
+
+#define TRACE_INIT()
+#define TRACE_TICK()
+#define TRACE(EVENT,ARGUMENT)
+#define TRACE_MASK(MASKED)
+#define TRACE_DUMP()
+
+#endif
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+/* Same events on the two ECUs, the decoder knows them by their value */
+typedef enum{
+	TRACE_EVENT_INIT=0x00,				/* argument : 0 */
+	TRACE_EVENT_UART_TX=0x01,			/* argument : the byte */
+	TRACE_EVENT_UART_RX=0x02,			/* argument : the byte */
+	TRACE_EVENT_UART_TX_MASKED=0x03,	/* a password byte, argument : 0 */
+	TRACE_EVENT_UART_RX_MASKED=0x04,	/* a password byte, argument : 0 */
+	TRACE_EVENT_KEY=0x10,				/* argument : the password digits entered */
+	TRACE_EVENT_MENU=0x11,				/* argument : the key */
+	TRACE_EVENT_PASSWORD_CHECK=0x20,	/* argument : MATCHED/UNMATCHED_PASSWORD, LOCKED_OUT */
+	TRACE_EVENT_DOOR=0x21,				/* argument : OPEN_DOOR, DOOR_UNLOCKED/LOCKING/LOCKED */
+	TRACE_EVENT_LOCKOUT=0x22,			/* argument : 1 at the start, 0 at the end */
+	TRACE_EVENT_MOTOR=0x23				/* argument : the duty cycle % at the door speed, once per travel */
+}Trace_EventId;
+
+typedef struct{
+	uint8 event;
+	uint8 argument;
+	uint8 seconds;
+	uint16 ticks;
+}Trace_Record;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+#ifdef TRACE_ENABLE
+
+/*
+ * Description :
+ * Clear the ring, read the Timer1 cycle length and record TRACE_EVENT_INIT.
+ */
+void Trace_init(void);
+
+/*
+ * Description :
+ * Count one second, called from the Timer1 callback.
+ */
+void Trace_tick(void);
+
+/*
+ * Description :
+ * Add the event to the ring with the current time.
+ */
+void Trace_record(Trace_EventId event,uint8 argument);
+
+/*
+ * Description :
+ * While masked, the UART bytes are recorded with their masked events,
+ * so the password is not kept in the trace.
+ */
+void Trace_mask(uint8 masked);
+
+/*
+ * Description :
+ * Send the records, oldest first, over the UART :
+ * TRACE <ECU> <ticks per second> <records>
+ * one line of 10 hex digits per record : event, argument, seconds, ticks
+ * END
+ */
+void Trace_dump(void);
+
+#endif /* TRACE_ENABLE */
+
+#endif /* TRACE_H_ */
@@ -1,185 +1,1262 @@
-/******************************************************************************
- *
- * Module: UART
- *
- * File Name: uart.c
- *
- * Description: Source file for the UART AVR driver
- *
- *******************************************************************************/
-
-#include "uart.h"
-#include "avr/io.h" /* To use the UART Registers */
-#include "common_macros.h" /* To use the macros like SET_BIT */
-
-/*******************************************************************************
- *                      Functions Definitions                                  *
- *******************************************************************************/
-
-/*
- * Description :
- * Functional responsible for Initialize the UART device by:
- * 1. Setup the Frame format like number of data bits, parity bit type and number of stop bits.
- * 2. Enable the UART.
- * 3. Setup the UART baud rate.
- */
-void UART_init(const UART_ConfigType * Config_Ptr)
-{
-	uint16 ubrr_value = 0;
-
-	/************************** UCSRB Description **************************
-	 * RXCIE = 0 Disable USART RX Complete Interrupt Enable
-	 * TXCIE = 0 Disable USART Tx Complete Interrupt Enable
-	 * UDRIE = 0 Disable USART Data Register Empty Interrupt Enable
-	 * RXEN  = 1 Receiver Enable
-	 * RXEN  = 1 Transmitter Enable
-	 * UCSZ2 = 0 For 5,6,7,8-bit data mode
-	 * RXB8 & TXB8 not used for 5,6,7,8-bit data mode
-	 ***********************************************************************/
-	UCSRB = (1<<RXEN) | (1<<TXEN);
-
-
-	/************************** UCSRC Description **************************
-	 * URSEL   = 1 The URSEL must be one when writing the UCSRC
-	 * UMSEL   = 0 Asynchronous Operation
-	 * UPM1:0  = parity bit
-	 * USBS    = 0 One stop bit
-	 * UCSZ1:0 = For 5,6,7,8-bit data mode
-	 * UCPOL   = 0 Used with the Synchronous operation only
-	 ***********************************************************************/
-	UCSRC = (1<<URSEL) | ( ((Config_Ptr->bit_data)<<1) & 0x06 )  ;
-	/* Set Parity and Number of Stop Bits*/
-	UCSRC |= (((Config_Ptr->parity)<<4) & 0x30 ) | (((Config_Ptr->stop_bit)<<3) & 0x08 );
-
-
-	/* Asynchronous Double Speed Mode */
-	if(Config_Ptr->Mode == Asynchronous_Double_Speed_Mode)
-	{
-		/* U2X = 1 for double transmission speed */
-		UCSRA = (1<<U2X);
-
-
-		UCSRC &= ~(1<<UMSEL);		/* Asynchronous Operation, UMSEL =	0 */
-
-
-		/* Calculate the UBRR register value */
-		ubrr_value = (uint16)(((F_CPU / ((Config_Ptr->baud_rate) * 8UL))) - 1);
-	}
-
-	/* Synchronous Mode */
-	else if((Config_Ptr->Mode == Synchronous_Mode))
-	{
-		UCSRC |= (1<<UMSEL);		/* Synchronous Operation	*/
-
-		/* UCPOL : Bit 0
-		 * UCPOL = 0 -> TX Rising XCK edge ,RX Falling XCK edge
-		 * UCPOL = 1 -> TX Falling XCK edge ,RX Rising XCK edge
-		 * */
-		UCSRC |= SYNC_TX_XCK_EGGE;
-
-		/* Calculate the UBRR register value */
-		ubrr_value = (uint16)(((F_CPU / ((Config_Ptr->baud_rate) * 2UL))) - 1);
-
-	}
-
-	/*	Asynchronous Normal Mode */
-	else
-	{
-		UCSRC &= ~(1<<UMSEL);		/* Asynchronous Operation, UMSEL =	0 */
-
-		/* Calculate the UBRR register value */
-		ubrr_value = (uint16)(((F_CPU / ((Config_Ptr->baud_rate) * 16UL))) - 1);
-	}
-
-
-
-	/* First 8 bits from the BAUD_PRESCALE inside UBRRL and last 4 bits in UBRRH*/
-	UBRRH = ubrr_value>>8;
-	UBRRL = ubrr_value;
-}
-
-/*
- * Description :
- * Functional responsible for send byte to another UART device.
- */
-void UART_sendByte(const uint8 data)
-{
-	/*
-	 * UDRE flag is set when the Tx buffer (UDR) is empty and ready for
-	 * transmitting a new byte so wait until this flag is set to one
-	 */
-	while(BIT_IS_CLEAR(UCSRA,UDRE)){}
-
-	/*
-	 * Put the required data in the UDR register and it also clear the UDRE flag as
-	 * the UDR register is not empty now
-	 */
-	UDR = data;
-
-	/************************* Another Method *************************
-	UDR = data;
-	while(BIT_IS_CLEAR(UCSRA,TXC)){} // Wait until the transmission is complete TXC = 1
-	SET_BIT(UCSRA,TXC); // Clear the TXC flag
-	 *******************************************************************/
-}
-
-/*
- * Description :
- * Functional responsible for receive byte from another UART device.
- */
-uint8 UART_recieveByte(void)
-{
-	/* RXC flag is set when the UART receive data so wait until this flag is set to one */
-	while(BIT_IS_CLEAR(UCSRA,RXC)){}
-
-	/*
-	 * Read the received data from the Rx buffer (UDR)
-	 * The RXC flag will be cleared after read the data
-	 */
-	return UDR;
-}
-
-/*
- * Description :
- * Send the required string through UART to the other UART device.
- */
-void UART_sendString(const uint8 *Str)
-{
-	uint8 i = 0;
-
-	/* Send the whole string */
-	while(Str[i] != '\0')
-	{
-		UART_sendByte(Str[i]);
-		i++;
-	}
-	/************************* Another Method *************************
-	while(*Str != '\0')
-	{
-		UART_sendByte(*Str);
-		Str++;
-	}		
-	 *******************************************************************/
-}
-
-/*
- * Description :
- * Receive the required string until the '#' symbol through UART from the other UART device.
- */
-void UART_receiveString(uint8 *Str)
-{
-	uint8 i = 0;
-
-	/* Receive the first byte */
-	Str[i] = UART_recieveByte();
-
-	/* Receive the whole string until the '#' */
-	while(Str[i] != '#')
-	{
-		i++;
-		Str[i] = UART_recieveByte();
-	}
-
-	/* After receiving the whole string plus the '#', replace the '#' with '\0' */
-	Str[i] = '\0';
-}
+/******************************************************************************
+ *
+ * Module: UART
+ *
+ * File Name: uart.c
+ *
+ * Description: Source file for the UART AVR driver
+ *
+ *******************************************************************************/
+
+#include "uart.h"
+#include "mcu_hal.h" /* For Register access */
+#include "common_macros.h" /* To use the macros like SET_BIT */
+#include "profiler.h" /* For the hot path regions */
+#include "trace.h" /* For the link events */
+#include "idle.h" /* For the sleep till a byte is received */
+#include "gpio.h" /* For the XCK pin and the RS-485 driver enable pin */
+#include "queue.h" /* For the transmit ring */
+#ifdef LINK_ENABLE
+#include "link.h" /* For the acknowledged transport */
+#endif
+#ifdef RS485_ENABLE
+#include <util/delay.h> /* For the turnaround guard */
+#endif
+#ifdef UART_FLOW_CONTROL_ENABLE
+#include <avr/pgmspace.h> /* For the names in flash */
+#include "timer1.h" /* For the hold timeout and the CTS polls */
+#endif
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define UART_ECU_NAME				"CONTROL"
+#define UART_NAME_SIZE				10
+
+#if defined(UART_TX_BUFFER_ENABLE) && !QUEUE_IS_CAPACITY(UART_TX_BUFFER_SIZE)
+#error "UART_TX_BUFFER_SIZE must be a power of 2 up to 128"
+#endif
+#if defined(UART_RX_RING_ENABLE) && !QUEUE_IS_CAPACITY(UART_RX_BUFFER_SIZE)
+#error "UART_RX_BUFFER_SIZE must be a power of 2 up to 128"
+#endif
+
+#ifdef UART_FLOW_CONTROL_ENABLE
+/*******************************************************************************
+ *                      Names in Flash                                         *
+ *******************************************************************************/
+
+/* Indexed by UART_FlowStat */
+static const char g_flowNames[UART_NUM_FLOW_STATS][UART_NAME_SIZE] PROGMEM = {
+		"THROTTLES", "HOLDS", "TIMEOUTS", "LOST"
+};
+#endif
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* Mode given to UART_init(), for the baud rate changes */
+static UART_Mode g_mode = Asynchronous_Double_Speed_Mode;
+/* A byte was sent since UART_init(), TXC tells when it is finished */
+static uint8 g_txStarted = FALSE;
+/* Called with the FE/DOR/PE bits of a byte received with errors */
+static void (*g_errorCallBackPtr)(uint8) = NULL_PTR;
+/* Called with the address frames, from the RX Complete ISR */
+static void (*volatile g_addressCallBackPtr)(uint8) = NULL_PTR;
+/* Called with the data bytes and their errors, from the RX Complete ISR */
+static void (*volatile g_receiveCallBackPtr)(uint8,uint8) = NULL_PTR;
+
+#ifdef UART_TX_BUFFER_ENABLE
+/* Bytes waiting for the UDRE interrupt, put by the main loop and sent by the ISR */
+static uint8 g_txBuffer[QUEUE_BUFFER_SIZE(1, UART_TX_BUFFER_SIZE)];
+static Queue g_txQueue;
+/* Called from the UDRE ISR once the ring is empty */
+static void (*volatile g_txEmptyCallBackPtr)(void) = NULL_PTR;
+#endif
+
+#ifdef UART_RX_RING_ENABLE
+/*
+ * Bytes received, put by the RX Complete ISR and taken by the main loop. The
+ * g_rxRead bytes at the tail are read, they are kept while a frame is held.
+ */
+static uint8 g_rxBuffer[QUEUE_BUFFER_SIZE(1, UART_RX_BUFFER_SIZE)];
+static Queue g_rxQueue;
+static uint8 g_rxRead = 0;
+/* A frame of UART_receiveFrame() is in the ring, till UART_releaseFrame() */
+static uint8 g_frameHeld = FALSE;
+#endif
+
+#ifdef UART_FLOW_CONTROL_ENABLE
+/* The peer was asked to stop, till the ring is down to the low water mark */
+static volatile uint8 g_rxThrottled = FALSE;
+/* The peer asked to stop, the UDRE interrupt is disabled till it is released */
+static volatile uint8 g_txHeld = FALSE;
+/* UART_startFlowControl() was called, the Timer1 alarm can be used */
+static volatile uint8 g_flowStarted = FALSE;
+static volatile uint16 g_flowStats[UART_NUM_FLOW_STATS];
+#ifdef UART_FLOW_XONXOFF
+/* XON or XOFF sent before the next byte of the transmit ring, 0 for none */
+static volatile uint8 g_flowPending = 0;
+/* UART_ESCAPE is sent, the byte at the tail of the ring follows */
+static volatile uint8 g_txEscaped = FALSE;
+/* UART_ESCAPE is received, the next byte is xored */
+static uint8 g_rxEscaped = FALSE;
+#else
+/* CTS polls since the hold, the hold timeout ends it */
+static volatile uint8 g_ctsPolls = 0;
+/* The hold timeout ended the hold, CTS is ignored till it is low again */
+static volatile uint8 g_ctsIgnored = FALSE;
+#endif
+#endif
+
+#ifdef RS485_ENABLE
+/* The RS-485 driver is enabled, till the TXC interrupt */
+static volatile uint8 g_txDriving = FALSE;
+/* A byte was received since the driver was enabled, the peer may still drive the bus */
+static volatile uint8 g_rxSinceDrive = FALSE;
+#endif
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Return TRUE if the byte in UDR is an address frame, its ninth bit is set
+ */
+static uint8 UART_isAddressFrame(void);
+
+/*
+ * Read the address frame in UDR and give it to the address call back
+ */
+static void UART_receiveAddress(void);
+
+/*
+ * Clear TXC before a byte is written to UDR, it is set again after its stop bit
+ */
+static void UART_clearTxComplete(void);
+
+#ifdef RS485_ENABLE
+/*
+ * Wait UART_RS485_GUARD_US before the driver is enabled to answer the peer
+ */
+static void UART_waitTurnaround(void);
+
+/*
+ * Enable the RS-485 driver, called with the interrupts disabled
+ */
+static void UART_driveBus(void);
+#endif
+
+/*
+ * Write the frame to UDR, TXC is cleared first so TXC and its interrupt come
+ * after its stop bit. Called with the interrupts disabled on the RS-485 link.
+ */
+static void UART_transmit(uint8 data);
+
+/*
+ * Give in frame the first length bytes of the ring, in place
+ */
+static void UART_viewFrame(const Queue * queue,uint8 length,UART_Frame * frame);
+
+#ifdef UART_RX_RING_ENABLE
+/*
+ * Put the byte received in the receive ring and throttle the peer once it is
+ * high, the XON/XOFF bytes are taken on the way. Called from the RX Complete ISR.
+ */
+static void UART_storeByte(uint8 data);
+
+/*
+ * Give back the ring up to g_rxRead, the peer sends again once the ring is
+ * down to the low water mark
+ */
+static void UART_releaseRing(void);
+#endif
+
+#ifdef UART_FLOW_CONTROL_ENABLE
+/*
+ * Ask the peer to stop sending, or release it. Called with the interrupts disabled.
+ */
+static void UART_throttle(uint8 stop);
+
+/*
+ * Send the flow control byte or the escaped byte, or hold the transmit ring :
+ * return TRUE if the UDRE ISR must not send the byte at its tail.
+ */
+static uint8 UART_transmitFlow(void);
+
+/*
+ * Called by the Timer1 alarm : the hold timeout or the next CTS poll
+ */
+static void UART_alarmCallBack(void);
+
+/*
+ * Send the number in decimal
+ */
+static void UART_sendNumber(uint16 number);
+#endif
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Functional responsible for Initialize the UART device by:
+ * 1. Setup the Frame format like number of data bits, parity bit type and number of stop bits.
+ * 2. Enable the UART.
+ * 3. Setup the UART baud rate.
+ */
+void UART_init(const UART_ConfigType * Config_Ptr)
+{
+	uint16 ubrr_value = 0;
+	uint8 ucsrc;
+#ifdef UART_FLOW_CONTROL_ENABLE
+	uint8 i;
+#endif
+
+	/************************** UCSRB Description **************************
+	 * RXCIE = 0 Disable USART RX Complete Interrupt Enable
+	 * TXCIE = 0 Disable USART Tx Complete Interrupt Enable
+	 * UDRIE = 0 Disable USART Data Register Empty Interrupt Enable
+	 * RXEN  = 1 Receiver Enable
+	 * RXEN  = 1 Transmitter Enable
+	 * UCSZ2 = 0 For 5,6,7,8-bit data mode, 1 for the 9-bit data mode
+	 * RXB8 & TXB8 the ninth bit in the 9-bit data mode, 1 for an address frame
+	 ***********************************************************************/
+	HAL_WRITE_REG(UCSRB, (1<<RXEN) | (1<<TXEN));
+	if(Config_Ptr->bit_data == MODE_9_BITS)
+	{
+		HAL_SET_BIT(UCSRB,UCSZ2);
+	}
+
+
+	/************************** UCSRC Description **************************
+	 * URSEL   = 1 The URSEL must be one when writing the UCSRC
+	 * UMSEL   = 0 Asynchronous Operation
+	 * UPM1:0  = parity bit
+	 * USBS    = 0 One stop bit
+	 * UCSZ1:0 = For 5,6,7,8-bit data mode, 11 for the 9-bit data mode
+	 * UCPOL   = 0 Used with the Synchronous operation only
+	 * UCSRC shares its address with UBRRH and a read gives UBRRH, so it is
+	 * built here and written once with URSEL = 1.
+	 ***********************************************************************/
+	ucsrc = (1<<URSEL) | ( ((Config_Ptr->bit_data)<<1) & 0x06 );
+	/* Set Parity and Number of Stop Bits*/
+	ucsrc |= (((Config_Ptr->parity)<<4) & 0x30 ) | (((Config_Ptr->stop_bit)<<3) & 0x08 );
+
+
+	/* Asynchronous Double Speed Mode */
+	if(Config_Ptr->Mode == Asynchronous_Double_Speed_Mode)
+	{
+		/* U2X = 1 for double transmission speed */
+		HAL_WRITE_REG(UCSRA, (1<<U2X));
+
+		/* Asynchronous Operation, UMSEL =	0 */
+
+		/* Calculate the UBRR register value, rounded to the nearest */
+		ubrr_value = (uint16)UART_UBRR(Asynchronous_Double_Speed_Mode, Config_Ptr->baud_rate);
+	}
+
+	/* Synchronous Mode */
+	else if((Config_Ptr->Mode == Synchronous_Mode))
+	{
+		/* U2X = 0, it must be cleared in the synchronous mode */
+		HAL_WRITE_REG(UCSRA, 0);
+
+		ucsrc |= (1<<UMSEL);		/* Synchronous Operation	*/
+
+		/* UCPOL : Bit 0
+		 * UCPOL = 0 -> TX Rising XCK edge ,RX Falling XCK edge
+		 * UCPOL = 1 -> TX Falling XCK edge ,RX Rising XCK edge
+		 * */
+		ucsrc |= (SYNC_TX_XCK_EDGE<<UCPOL);
+
+		/* XCK is the clock output of the master, the clock input of the slave */
+		GPIO_setupPinDirection(UART_XCK_PORT_ID, UART_XCK_PIN_ID,
+				(Config_Ptr->xck_role == UART_XCK_MASTER) ? PIN_OUTPUT : PIN_INPUT);
+
+		/* Calculate the UBRR register value, rounded to the nearest */
+		ubrr_value = (uint16)UART_UBRR(Synchronous_Mode, Config_Ptr->baud_rate);
+
+	}
+
+	/*	Asynchronous Normal Mode */
+	else
+	{
+		/* Asynchronous Operation, UMSEL =	0 */
+
+		/* Calculate the UBRR register value, rounded to the nearest */
+		ubrr_value = (uint16)UART_UBRR(Asynchronous_Normal_Mode, Config_Ptr->baud_rate);
+	}
+
+	HAL_WRITE_REG(UCSRC, ucsrc);
+
+	/* First 8 bits from the BAUD_PRESCALE inside UBRRL and last 4 bits in UBRRH*/
+	HAL_WRITE_REG(UBRRH, ubrr_value>>8);
+	HAL_WRITE_REG(UBRRL, ubrr_value);
+	g_mode = Config_Ptr->Mode;
+	g_txStarted = FALSE;
+
+#ifdef UART_TX_BUFFER_ENABLE
+	Queue_init(&g_txQueue, g_txBuffer, 1, UART_TX_BUFFER_SIZE);
+#endif
+#ifdef UART_RX_RING_ENABLE
+	Queue_init(&g_rxQueue, g_rxBuffer, 1, UART_RX_BUFFER_SIZE);
+	g_rxRead = 0;
+	g_frameHeld = FALSE;
+#endif
+#ifdef UART_FLOW_CONTROL_ENABLE
+	g_rxThrottled = FALSE;
+	g_txHeld = FALSE;
+	for(i=0;i<UART_NUM_FLOW_STATS;i++)
+	{
+		g_flowStats[i] = 0;
+	}
+#ifdef UART_FLOW_XONXOFF
+	g_flowPending = 0;
+	g_txEscaped = FALSE;
+	g_rxEscaped = FALSE;
+#else
+	g_ctsIgnored = FALSE;
+	/* RTS low : ready to receive, CTS pulled up till the peer drives it */
+	GPIO_setupPinDirection(UART_RTS_PORT_ID, UART_RTS_PIN_ID, PIN_OUTPUT);
+	GPIO_writePin(UART_RTS_PORT_ID, UART_RTS_PIN_ID, LOGIC_LOW);
+	GPIO_setupPinDirection(UART_CTS_PORT_ID, UART_CTS_PIN_ID, PIN_INPUT);
+	GPIO_writePin(UART_CTS_PORT_ID, UART_CTS_PIN_ID, LOGIC_HIGH);
+#endif
+#endif
+#ifdef UART_RX_RING_ENABLE
+	/* RXCIE = 1, the ISR takes each byte to the receive ring */
+	HAL_SET_BIT(UCSRB,RXCIE);
+#endif
+#ifdef RS485_ENABLE
+	/* Listen on the bus till the first byte is sent */
+	g_txDriving = FALSE;
+	g_rxSinceDrive = FALSE;
+	GPIO_setupPinDirection(UART_RS485_DE_PORT_ID, UART_RS485_DE_PIN_ID, PIN_OUTPUT);
+	GPIO_writePin(UART_RS485_DE_PORT_ID, UART_RS485_DE_PIN_ID, LOGIC_LOW);
+#endif
+}
+
+/*
+ * Description :
+ * Functional responsible for send byte to another UART device.
+ */
+void UART_sendByte(const uint8 data)
+{
+#if defined(LINK_ENABLE)
+	/* The transport sends it in a frame and again till it is acknowledged */
+	Link_sendByte(data);
+	TRACE(TRACE_EVENT_UART_TX, data);
+#elif defined(UART_TX_BUFFER_ENABLE)
+	uint8 sreg;
+
+	/* Sleep while the ring is full, the UDRE interrupt makes room */
+	IDLE_WAIT_UNTIL(Queue_room(&g_txQueue) != 0);
+#ifdef RS485_ENABLE
+	UART_waitTurnaround();
+#endif
+
+	sreg = HAL_READ_REG(SREG);
+	cli();
+#ifdef RS485_ENABLE
+	/* The TXC interrupt can not release the driver between the two */
+	UART_driveBus();
+#endif
+	Queue_put(&g_txQueue, &data);
+	/* UDRIE = 1, the UDRE interrupt sends it as soon as UDR is empty */
+	HAL_SET_BIT(UCSRB,UDRIE);
+	HAL_WRITE_REG(SREG, sreg);
+	TRACE(TRACE_EVENT_UART_TX, data);
+#else
+	/*
+	 * UDRE flag is set when the Tx buffer (UDR) is empty and ready for
+	 * transmitting a new byte so wait until this flag is set to one
+	 */
+	while(HAL_BIT_IS_CLEAR(UCSRA,UDRE)){}
+
+	/*
+	 * Put the required data in the UDR register and it also clear the UDRE flag as
+	 * the UDR register is not empty now
+	 */
+	UART_transmit(data);
+	TRACE(TRACE_EVENT_UART_TX, data);
+
+	/************************* Another Method *************************
+	UDR = data;
+	while(BIT_IS_CLEAR(UCSRA,TXC)){} // Wait until the transmission is complete TXC = 1
+	SET_BIT(UCSRA,TXC); // Clear the TXC flag
+	 *******************************************************************/
+#endif
+}
+
+/*
+ * Description :
+ * Change the baud rate, in the mode given to UART_init(). The bytes being sent
+ * are finished first, a byte being received is lost. The synchronous slave
+ * follows the XCK clock of the master.
+ */
+void UART_setBaudRate(UART_BaudRate baud_rate)
+{
+	uint16 ubrr_value = (uint16)UART_UBRR(g_mode, baud_rate);
+
+#ifdef UART_TX_BUFFER_ENABLE
+	UART_flush();
+#else
+	/* TXC is set once the stop bit of the last byte is sent */
+	if(g_txStarted)
+	{
+		while(HAL_BIT_IS_CLEAR(UCSRA,TXC)){}
+	}
+#endif
+
+	/* UBRRH is written first, UBRRL updates the prescaler */
+	HAL_WRITE_REG(UBRRH, ubrr_value>>8);
+	HAL_WRITE_REG(UBRRL, ubrr_value);
+}
+
+#ifdef UART_TX_BUFFER_ENABLE
+/*
+ * Description :
+ * Put all the bytes in the transmit ring and return TRUE, or none of them and
+ * return FALSE if the ring has not room for all (UART_TX_BUFFER_ENABLE only).
+ * It does not wait, it can be called from an ISR.
+ */
+uint8 UART_putBytes(const uint8 * data,uint8 size)
+{
+	uint8 sreg = HAL_READ_REG(SREG);
+	uint8 i;
+
+	cli();
+	if(Queue_room(&g_txQueue) < size)
+	{
+		HAL_WRITE_REG(SREG, sreg);
+		return FALSE;
+	}
+#ifdef RS485_ENABLE
+	UART_driveBus();
+#endif
+	for(i=0;i<size;i++)
+	{
+		Queue_put(&g_txQueue, &data[i]);
+	}
+	/* UDRIE = 1, the UDRE interrupt sends them */
+	HAL_SET_BIT(UCSRB,UDRIE);
+	HAL_WRITE_REG(SREG, sreg);
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Set the function called from the UDRE ISR once the last byte of the transmit
+ * ring is taken, it can put the next bytes (UART_TX_BUFFER_ENABLE only).
+ */
+void UART_setTxEmptyCallBack(void(*a_ptr)(void))
+{
+	g_txEmptyCallBackPtr = a_ptr;
+}
+
+/*
+ * Description :
+ * Sleep till all the bytes of the transmit ring are on the bus and the RS-485
+ * driver is released (UART_TX_BUFFER_ENABLE only).
+ */
+void UART_flush(void)
+{
+#ifdef RS485_ENABLE
+	/* The UDRE and TXC interrupts wake the CPU up */
+	IDLE_WAIT_UNTIL(Queue_isEmpty(&g_txQueue) && (!g_txDriving));
+#else
+	/* The UDRE interrupt wakes the CPU up */
+	IDLE_WAIT_UNTIL(Queue_isEmpty(&g_txQueue));
+	/* TXC is set once the stop bit of the last byte is sent */
+	if(g_txStarted)
+	{
+		while(HAL_BIT_IS_CLEAR(UCSRA,TXC)){}
+	}
+#endif
+}
+#endif
+
+/*
+ * Description :
+ * Functional responsible for receive byte from another UART device.
+ */
+uint8 UART_recieveByte(void)
+{
+#if defined(LINK_ENABLE)
+	/* The RX Complete ISR gives the frames to the transport, in order */
+	uint8 data = Link_receiveByte();
+#else
+	uint8 data;
+
+	/* The RX Complete interrupt wakes the CPU up, its ISR fills the ring */
+	IDLE_WAIT_UNTIL(Queue_at(&g_rxQueue, g_rxRead) != NULL_PTR);
+
+	data = *(const uint8 *)Queue_at(&g_rxQueue, g_rxRead);
+	g_rxRead++;
+	/* The bytes after a held frame are given back with it */
+	if(!g_frameHeld)
+	{
+		UART_releaseRing();
+	}
+#endif
+
+	TRACE(TRACE_EVENT_UART_RX, data);
+	return data;
+}
+
+/*
+ * Description :
+ * Send the required string through UART to the other UART device.
+ */
+void UART_sendString(const uint8 *Str)
+{
+	uint8 i = 0;
+
+	/* Send the whole string */
+	while(Str[i] != '\0')
+	{
+		UART_sendByte(Str[i]);
+		i++;
+	}
+	/************************* Another Method *************************
+	while(*Str != '\0')
+	{
+		UART_sendByte(*Str);
+		Str++;
+	}		
+	 *******************************************************************/
+}
+
+/*
+ * Description :
+ * Receive the required string until the '#' symbol through UART from the other UART device.
+ * At most size - 1 bytes are kept in Str, the '#' is replaced by '\0'. Returns FALSE
+ * if the string was longer, Str is then empty.
+ */
+uint8 UART_receiveString(uint8 *Str,uint8 size)
+{
+	UART_Frame frame;
+	uint8 fits = UART_receiveFrame(&frame, '#', size - 1);
+
+	UART_copyFrame(&frame, Str, size);
+	UART_releaseFrame();
+	return fits;
+}
+
+/*
+ * Description :
+ * Receive the bytes till the terminator and give them in frame, without a copy.
+ * Returns FALSE if there were more than max_length
+ * bytes (at most UART_FRAME_MAX_LENGTH) : they are dropped and frame is empty.
+ * Only one frame is held at a time, UART_releaseFrame() gives it back once it
+ * is processed. UART_recieveByte() can be used in between.
+ */
+uint8 UART_receiveFrame(UART_Frame * frame,uint8 terminator,uint8 max_length)
+{
+	uint8 length = 0;
+	uint8 fits = TRUE;
+	uint8 data;
+
+	PROFILER_ENTER(PROFILER_UART_RECEIVE_FRAME);
+
+	if(max_length > UART_FRAME_MAX_LENGTH)
+	{
+		max_length = UART_FRAME_MAX_LENGTH;
+	}
+
+	/* The bytes stay where the ISR put them, UART_recieveByte() only reads them */
+#ifdef LINK_ENABLE
+	Link_holdBytes();
+#else
+	UART_releaseRing();
+	g_frameHeld = TRUE;
+#endif
+
+	/* Receive the whole frame until the terminator */
+	data = UART_recieveByte();
+	while(data != terminator)
+	{
+		if(length < max_length)
+		{
+			length++;
+		}
+		else if(fits)
+		{
+			/* Too long, the rest is dropped as it comes */
+			fits = FALSE;
+			UART_releaseFrame();
+		}
+		data = UART_recieveByte();
+	}
+
+	if(!fits)
+	{
+		length = 0;
+	}
+
+	/* The frame starts at the tail of the ring, the bytes before were given back */
+#ifdef LINK_ENABLE
+	UART_viewFrame(Link_getReceiveQueue(), length, frame);
+#else
+	UART_viewFrame(&g_rxQueue, length, frame);
+#endif
+
+	PROFILER_EXIT(PROFILER_UART_RECEIVE_FRAME);
+	return fits;
+}
+
+/*
+ * Description :
+ * Give back the room of the frame and the bytes received before the call,
+ * the frame must not be read anymore.
+ */
+void UART_releaseFrame(void)
+{
+#ifdef LINK_ENABLE
+	Link_releaseBytes();
+#else
+	g_frameHeld = FALSE;
+	UART_releaseRing();
+#endif
+}
+
+/*
+ * Description :
+ * Return the number of bytes of the frame.
+ */
+uint8 UART_frameLength(const UART_Frame * frame)
+{
+	return frame->length[0] + frame->length[1];
+}
+
+/*
+ * Description :
+ * Return TRUE if the frame holds the size bytes of data.
+ */
+uint8 UART_frameEquals(const UART_Frame * frame,const uint8 * data,uint8 size)
+{
+	uint8 part;
+	uint8 i;
+
+	if(UART_frameLength(frame) != size)
+	{
+		return FALSE;
+	}
+	for(part=0;part<2;part++)
+	{
+		for(i=0;i<frame->length[part];i++)
+		{
+			if(frame->data[part][i] != *data)
+			{
+				return FALSE;
+			}
+			data++;
+		}
+	}
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Copy the frame in Str as a string of at most size - 1 bytes, ended by '\0'.
+ */
+void UART_copyFrame(const UART_Frame * frame,uint8 * Str,uint8 size)
+{
+	uint8 part;
+	uint8 i;
+	uint8 length = 0;
+
+	for(part=0;part<2;part++)
+	{
+		for(i=0;(i<frame->length[part]) && ((length + 1) < size);i++)
+		{
+			Str[length] = frame->data[part][i];
+			length++;
+		}
+	}
+	Str[length] = '\0';
+}
+
+/*
+ * Description :
+ * Set the function called with the FE/DOR/PE bits of UCSRA
+ * when a byte is received with errors.
+ */
+void UART_setErrorCallBack(void(*a_ptr)(uint8))
+{
+	g_errorCallBackPtr = a_ptr;
+}
+
+/*
+ * Description :
+ * Set the function called from the RX Complete ISR with each data byte received
+ * and its FE/DOR/PE bits, they are not left in UDR for UART_recieveByte().
+ */
+void UART_setReceiveCallBack(void(*a_ptr)(uint8,uint8))
+{
+	uint8 sreg = HAL_READ_REG(SREG);
+
+	cli();
+	g_receiveCallBackPtr = a_ptr;
+	if(a_ptr != NULL_PTR)
+	{
+		/* RXCIE = 1, the ISR takes each byte */
+		HAL_SET_BIT(UCSRB,RXCIE);
+	}
+	HAL_WRITE_REG(SREG, sreg);
+}
+
+/*
+ * Description :
+ * Return TRUE if a data byte is waiting to be read by UART_recieveByte(), the
+ * address frames before it are given to their call back. Else the RX Complete
+ * interrupt is enabled, so a sleep ends with the next byte.
+ * It must be called with the interrupts disabled.
+ */
+uint8 UART_isByteReceived(void)
+{
+#ifdef UART_RX_RING_ENABLE
+	/* The RX Complete interrupt stays enabled, the address frames are taken by its ISR */
+	return (Queue_at(&g_rxQueue, g_rxRead) != NULL_PTR);
+#else
+	while(HAL_BIT_IS_SET(UCSRA,RXC))
+	{
+		if(!UART_isAddressFrame())
+		{
+			return TRUE;
+		}
+		UART_receiveAddress();
+	}
+	/* RXCIE = 1 to be woken up by the next byte */
+	HAL_SET_BIT(UCSRB,RXCIE);
+	return FALSE;
+#endif
+}
+
+/*
+ * Description :
+ * Send an address frame, a 9 bits frame with the ninth bit set (MODE_9_BITS only).
+ * All the receivers get it, even those in the multi-processor mode.
+ */
+void UART_sendAddress(const uint8 address)
+{
+	uint8 sreg;
+
+#ifdef UART_TX_BUFFER_ENABLE
+	/* The ninth bit is not kept in the ring, the bytes before must be sent first */
+	UART_flush();
+#else
+	while(HAL_BIT_IS_CLEAR(UCSRA,UDRE)){}
+#endif
+#ifdef RS485_ENABLE
+	UART_waitTurnaround();
+#endif
+
+	/* TXB8 must be set before UDR is written, the RX Complete ISR also changes UCSRB */
+	sreg = HAL_READ_REG(SREG);
+	cli();
+	HAL_SET_BIT(UCSRB,TXB8);
+#ifdef RS485_ENABLE
+	UART_driveBus();
+#endif
+	UART_transmit(address);
+	HAL_WRITE_REG(SREG, sreg);
+
+	/* Keep it till the frame has left UDR for the shift register */
+	while(HAL_BIT_IS_CLEAR(UCSRA,UDRE)){}
+
+	sreg = HAL_READ_REG(SREG);
+	cli();
+	HAL_CLEAR_BIT(UCSRB,TXB8);
+	HAL_WRITE_REG(SREG, sreg);
+}
+
+/*
+ * Description :
+ * Enable or disable the multi-processor mode (MPCM) : while it is enabled
+ * the receiver ignores the data frames, only the address frames are received.
+ */
+void UART_setMultiProcessorMode(uint8 enable)
+{
+	/* TXC is cleared by writing one to it, it is not written back */
+	uint8 ucsra = HAL_READ_REG(UCSRA) & (1<<U2X);
+
+	if(enable)
+	{
+		ucsra |= (1<<MPCM);
+	}
+	HAL_WRITE_REG(UCSRA, ucsra);
+}
+
+/*
+ * Description :
+ * Set the function called from the RX Complete ISR with each address frame
+ * received (MODE_9_BITS only), the data frames are still read by UART_recieveByte().
+ * Once it is set the RX Complete interrupt stays enabled to watch the address frames.
+ */
+void UART_setAddressCallBack(void(*a_ptr)(uint8))
+{
+	uint8 sreg = HAL_READ_REG(SREG);
+
+	cli();
+	g_addressCallBackPtr = a_ptr;
+	if(a_ptr != NULL_PTR)
+	{
+		HAL_SET_BIT(UCSRB,RXCIE);
+	}
+	HAL_WRITE_REG(SREG, sreg);
+}
+
+#ifdef UART_FLOW_CONTROL_ENABLE
+/*
+ * Description :
+ * Take the Timer1 alarm for the hold timeout and the CTS polls, and obey the
+ * throttles of the peer from now on (UART_FLOW_CONTROL_ENABLE only).
+ */
+void UART_startFlowControl(void)
+{
+	uint8 sreg = HAL_READ_REG(SREG);
+
+	cli();
+	Timer1_setAlarmCallBack(UART_alarmCallBack);
+	g_flowStarted = TRUE;
+	HAL_WRITE_REG(SREG, sreg);
+}
+
+/*
+ * Description :
+ * Return the counter of the flow control since UART_init() (UART_FLOW_CONTROL_ENABLE only).
+ */
+uint16 UART_getFlowStat(UART_FlowStat stat)
+{
+	uint8 sreg = HAL_READ_REG(SREG);
+	uint16 value;
+
+	cli();
+	value = g_flowStats[stat];
+	HAL_WRITE_REG(SREG, sreg);
+	return value;
+}
+
+/*
+ * Description :
+ * Send the counters of the flow control as one text line (UART_FLOW_CONTROL_ENABLE only) :
+ * FLOW <ECU> <counter> <value> ... <counter> <value>
+ */
+void UART_sendFlowStats(void)
+{
+	const char * name;
+	char c;
+	uint8 i;
+
+	UART_sendString((const uint8 *)"FLOW " UART_ECU_NAME);
+	for(i=0;i<UART_NUM_FLOW_STATS;i++)
+	{
+		UART_sendByte(' ');
+		name = g_flowNames[i];
+		while((c = pgm_read_byte(name++)) != '\0')
+		{
+			UART_sendByte(c);
+		}
+		UART_sendByte(' ');
+		UART_sendNumber(UART_getFlowStat(i));
+	}
+	UART_sendString((const uint8 *)"\r\n");
+}
+#endif
+
+/*******************************************************************************
+ *                      Private Functions                                      *
+ *******************************************************************************/
+
+static uint8 UART_isAddressFrame(void)
+{
+	/* RXB8 belongs to the byte in UDR, it must be read before it */
+	return (HAL_BIT_IS_SET(UCSRB,UCSZ2) && HAL_BIT_IS_SET(UCSRB,RXB8)) ? TRUE : FALSE;
+}
+
+static void UART_receiveAddress(void)
+{
+	uint8 address = HAL_READ_REG(UDR);
+
+#ifdef RS485_ENABLE
+	g_rxSinceDrive = TRUE;
+#endif
+
+	if(g_addressCallBackPtr != NULL_PTR)
+	{
+		(*g_addressCallBackPtr)(address);
+	}
+}
+
+static void UART_clearTxComplete(void)
+{
+	/* The RX Complete ISR may change MPCM */
+	uint8 sreg = HAL_READ_REG(SREG);
+
+	cli();
+	/* TXC is cleared by writing one to it, U2X and MPCM are kept */
+	HAL_WRITE_REG(UCSRA, (HAL_READ_REG(UCSRA) & ((1<<U2X) | (1<<MPCM))) | (1<<TXC));
+	HAL_WRITE_REG(SREG, sreg);
+}
+
+#ifdef RS485_ENABLE
+static void UART_waitTurnaround(void)
+{
+	/* Not needed while driving, or when the peer was not the last one on the bus */
+	if((!g_txDriving) && g_rxSinceDrive)
+	{
+		_delay_us(UART_RS485_GUARD_US);
+	}
+}
+
+static void UART_driveBus(void)
+{
+	if(!g_txDriving)
+	{
+		g_txDriving = TRUE;
+		g_rxSinceDrive = FALSE;
+		GPIO_writePin(UART_RS485_DE_PORT_ID, UART_RS485_DE_PIN_ID, LOGIC_HIGH);
+	}
+}
+
+#endif
+
+static void UART_transmit(uint8 data)
+{
+	UART_clearTxComplete();
+	HAL_WRITE_REG(UDR, data);
+	g_txStarted = TRUE;
+#ifdef RS485_ENABLE
+	/* TXCIE = 1 to release the driver after the stop bit */
+	HAL_SET_BIT(UCSRB,TXCIE);
+#endif
+}
+
+static void UART_viewFrame(const Queue * queue,uint8 length,UART_Frame * frame)
+{
+	uint8 contiguous = Queue_contiguous(queue);
+
+	/* The part up to the end of the ring, then the part from its start */
+	frame->length[0] = (length > contiguous) ? contiguous : length;
+	frame->length[1] = length - frame->length[0];
+	frame->data[0] = Queue_at(queue, 0);
+	frame->data[1] = Queue_at(queue, frame->length[0]);
+}
+
+#ifdef UART_RX_RING_ENABLE
+static void UART_storeByte(uint8 data)
+{
+#ifdef UART_FLOW_XONXOFF
+	if(g_rxEscaped)
+	{
+		data ^= UART_ESCAPE_XOR;
+		g_rxEscaped = FALSE;
+	}
+	else if(data == UART_XOFF)
+	{
+		if(g_flowStarted && (!g_txHeld))
+		{
+			g_txHeld = TRUE;
+			g_flowStats[UART_FLOW_STAT_HOLDS]++;
+			Timer1_startAlarm(UART_FLOW_HOLD_TIMEOUT);
+		}
+		return;
+	}
+	else if(data == UART_XON)
+	{
+		if(g_txHeld)
+		{
+			g_txHeld = FALSE;
+			Timer1_stopAlarm();
+			/* UDRIE = 1, the UDRE interrupt sends the ring again */
+			HAL_SET_BIT(UCSRB,UDRIE);
+		}
+		return;
+	}
+	else if(data == UART_ESCAPE)
+	{
+		g_rxEscaped = TRUE;
+		return;
+	}
+#endif
+
+	if(!Queue_put(&g_rxQueue, &data))
+	{
+#ifdef UART_FLOW_CONTROL_ENABLE
+		/* Not read : the peer did not stop or its hold timed out */
+		g_flowStats[UART_FLOW_STAT_LOST]++;
+#endif
+		return;
+	}
+
+#ifdef UART_FLOW_CONTROL_ENABLE
+	if((!g_rxThrottled) && (Queue_count(&g_rxQueue) >= UART_RX_HIGH_WATER))
+	{
+		/* The peer may still send the byte in its shift register and the one in UDR */
+		g_rxThrottled = TRUE;
+		g_flowStats[UART_FLOW_STAT_THROTTLES]++;
+		UART_throttle(TRUE);
+	}
+#endif
+}
+
+/*
+ * Description :
+ * Give back the ring up to g_rxRead, the peer sends again once the ring is
+ * down to the low water mark.
+ */
+static void UART_releaseRing(void)
+{
+#ifdef UART_FLOW_CONTROL_ENABLE
+	uint8 sreg;
+#endif
+
+	Queue_dropCount(&g_rxQueue, g_rxRead);
+	g_rxRead = 0;
+#ifdef UART_FLOW_CONTROL_ENABLE
+	sreg = HAL_READ_REG(SREG);
+	cli();
+	if(g_rxThrottled && (Queue_count(&g_rxQueue) <= UART_RX_LOW_WATER))
+	{
+		g_rxThrottled = FALSE;
+		UART_throttle(FALSE);
+	}
+	HAL_WRITE_REG(SREG, sreg);
+#endif
+}
+#endif
+
+#ifdef UART_FLOW_CONTROL_ENABLE
+static void UART_throttle(uint8 stop)
+{
+#ifdef UART_FLOW_XONXOFF
+	g_flowPending = stop ? UART_XOFF : UART_XON;
+	/* UDRIE = 1, the UDRE interrupt sends it ahead of the ring */
+	HAL_SET_BIT(UCSRB,UDRIE);
+#else
+	GPIO_writePin(UART_RTS_PORT_ID, UART_RTS_PIN_ID, stop ? LOGIC_HIGH : LOGIC_LOW);
+#endif
+}
+
+static uint8 UART_transmitFlow(void)
+{
+#ifdef UART_FLOW_XONXOFF
+	uint8 data;
+
+	if(g_flowPending != 0)
+	{
+		/* Even while the peer holds this side */
+		UART_transmit(g_flowPending);
+		g_flowPending = 0;
+	}
+	else if((!g_txHeld) && Queue_peek(&g_txQueue, &data))
+	{
+		if((data != UART_XON) && (data != UART_XOFF) && (data != UART_ESCAPE))
+		{
+			return FALSE;
+		}
+		if(!g_txEscaped)
+		{
+			UART_transmit(UART_ESCAPE);
+			g_txEscaped = TRUE;
+			return TRUE;
+		}
+		UART_transmit(data ^ UART_ESCAPE_XOR);
+		g_txEscaped = FALSE;
+		Queue_drop(&g_txQueue);
+	}
+
+	if(g_txHeld || Queue_isEmpty(&g_txQueue))
+	{
+		/* UDRIE = 0 till XON or the next byte */
+		HAL_CLEAR_BIT(UCSRB,UDRIE);
+	}
+	return TRUE;
+#else
+	if((!g_flowStarted) || Queue_isEmpty(&g_txQueue))
+	{
+		return FALSE;
+	}
+	if(GPIO_readPin(UART_CTS_PORT_ID, UART_CTS_PIN_ID) == LOGIC_LOW)
+	{
+		g_ctsIgnored = FALSE;
+		return FALSE;
+	}
+	if(g_ctsIgnored)
+	{
+		return FALSE;
+	}
+
+	/* UDRIE = 0, the Timer1 alarm polls CTS */
+	HAL_CLEAR_BIT(UCSRB,UDRIE);
+	if(!g_txHeld)
+	{
+		g_txHeld = TRUE;
+		g_ctsPolls = 0;
+		g_flowStats[UART_FLOW_STAT_HOLDS]++;
+		Timer1_startAlarm(UART_CTS_POLL_TICKS);
+	}
+	return TRUE;
+#endif
+}
+
+static void UART_alarmCallBack(void)
+{
+	if(!g_txHeld)
+	{
+		return;
+	}
+#ifdef UART_FLOW_RTSCTS
+	g_ctsPolls++;
+	if(GPIO_readPin(UART_CTS_PORT_ID, UART_CTS_PIN_ID) == LOGIC_LOW)
+	{
+		g_txHeld = FALSE;
+	}
+	else if(g_ctsPolls < (UART_FLOW_HOLD_TIMEOUT / UART_CTS_POLL_TICKS))
+	{
+		Timer1_startAlarm(UART_CTS_POLL_TICKS);
+		return;
+	}
+	else
+	{
+		g_ctsIgnored = TRUE;
+	}
+#endif
+	if(g_txHeld)
+	{
+		/* The peer does not read, the bytes that do not fit in its ring are lost */
+		g_txHeld = FALSE;
+		g_flowStats[UART_FLOW_STAT_TIMEOUTS]++;
+	}
+	/* UDRIE = 1, the UDRE interrupt sends the ring again */
+	HAL_SET_BIT(UCSRB,UDRIE);
+}
+
+static void UART_sendNumber(uint16 number)
+{
+	uint8 digits[5];
+	uint8 i = 0;
+
+	do
+	{
+		digits[i++] = '0' + (number % 10);
+		number /= 10;
+	}while(number != 0);
+
+	while(i > 0)
+	{
+		UART_sendByte(digits[--i]);
+	}
+}
+#endif
+
+/*******************************************************************************
+ *                      		ISRs 		                                   *
+ *******************************************************************************/
+
+ISR(USART_RXC_vect)
+{
+	uint8 errors;
+	uint8 data;
+
+	Idle_noteWake(IDLE_WAKE_UART_RX);
+
+	if(UART_isAddressFrame())
+	{
+		UART_receiveAddress();
+	}
+	else if(g_receiveCallBackPtr != NULL_PTR)
+	{
+		/* The error flags belong to the byte in UDR, they must be read before it */
+		errors = HAL_READ_REG(UCSRA) & ((1<<FE) | (1<<DOR) | (1<<PE));
+		data = HAL_READ_REG(UDR);
+#ifdef RS485_ENABLE
+		g_rxSinceDrive = TRUE;
+#endif
+		if((errors != 0) && (g_errorCallBackPtr != NULL_PTR))
+		{
+			(*g_errorCallBackPtr)(errors);
+		}
+		(*g_receiveCallBackPtr)(data, errors);
+	}
+#ifdef UART_RX_RING_ENABLE
+	else
+	{
+		/* The error flags belong to the byte in UDR, they must be read before it */
+		errors = HAL_READ_REG(UCSRA) & ((1<<FE) | (1<<DOR) | (1<<PE));
+		data = HAL_READ_REG(UDR);
+#ifdef RS485_ENABLE
+		g_rxSinceDrive = TRUE;
+#endif
+#ifdef UART_FLOW_CONTROL_ENABLE
+		if(errors & (1<<DOR))
+		{
+			g_flowStats[UART_FLOW_STAT_LOST]++;
+		}
+#endif
+		if((errors != 0) && (g_errorCallBackPtr != NULL_PTR))
+		{
+			(*g_errorCallBackPtr)(errors);
+		}
+		UART_storeByte(data);
+	}
+#else
+	else
+	{
+		/* The byte is read by UART_recieveByte(), RXC stays set till then */
+		HAL_CLEAR_BIT(UCSRB,RXCIE);
+	}
+#endif
+}
+
+#ifdef UART_TX_BUFFER_ENABLE
+ISR(USART_UDRE_vect)
+{
+	uint8 data;
+
+	Idle_noteWake(IDLE_WAKE_UART_TX);
+
+#ifdef UART_FLOW_CONTROL_ENABLE
+	if(UART_transmitFlow())
+	{
+		return;
+	}
+#endif
+	if(Queue_get(&g_txQueue, &data))
+	{
+		UART_transmit(data);
+	}
+	if(Queue_isEmpty(&g_txQueue))
+	{
+		/* UDRIE = 0 till the next byte */
+		HAL_CLEAR_BIT(UCSRB,UDRIE);
+		if(g_txEmptyCallBackPtr != NULL_PTR)
+		{
+			(*g_txEmptyCallBackPtr)();
+		}
+	}
+}
+#endif /* UART_TX_BUFFER_ENABLE */
+
+#ifdef RS485_ENABLE
+ISR(USART_TXC_vect)
+{
+	/*
+	 * The shift register and UDR are empty : the stop bit of the last byte is on
+	 * the bus, the driver is released first so the peer can answer right away.
+	 * A byte put in the ring since then is sent by the UDRE interrupt, which comes
+	 * first and clears TXC.
+	 */
+	if(Queue_isEmpty(&g_txQueue))
+	{
+		GPIO_writePin(UART_RS485_DE_PORT_ID, UART_RS485_DE_PIN_ID, LOGIC_LOW);
+		g_txDriving = FALSE;
+		HAL_CLEAR_BIT(UCSRB,TXCIE);
+	}
+	Idle_noteWake(IDLE_WAKE_UART_TX);
+}
+#endif /* RS485_ENABLE */
@@ -1,108 +1,419 @@
- /******************************************************************************
- *
- * Module: UART
- *
- * File Name: uart.h
- *
- * Description: Header file for the UART AVR driver
- *
- * Author: Omar Elsherif
- *
- *******************************************************************************/
-
-#ifndef UART_H_
-#define UART_H_
-
-#include "std_types.h"
-
-
-
-#define TX_RISING_XCK_EDGE   0
-#define TX_FALLING_XCK_EDGE  1
-
-
-
-/*******************************************************************************
- *                      Configuration                                   *
- *******************************************************************************/
-
-
-/* 	Configure Required Synchronous TX XCK edge	*/
-#define SYNC_TX_XCK_EGGE  TX_RISING_XCK_EDGE
-
-
-
-typedef uint16 UART_BaudRate;
-
-typedef enum
-{
-	Asynchronous_Normal_Mode,Asynchronous_Double_Speed_Mode,Synchronous_Mode
-}UART_Mode;
-
-typedef enum
-{
-	MODE_5_BITS, MODE_6_BITS ,MODE_7_BITS ,MODE_8_BITS
-}UART_BitData;
-
-typedef enum
-{
-	PARITY_DISABLED ,EVEN_PARITY=2 ,ODD_PARITY
-}UART_Parity;
-
-typedef enum
-{
-	ONE_STOP_BIT,TWO_STOP_BIT
-}UART_StopBit;
-
-
-
-typedef struct
-{
-	UART_Mode Mode;
-	UART_BitData bit_data;
-	UART_Parity parity;
-	UART_StopBit stop_bit;
-	UART_BaudRate baud_rate;
-
-}UART_ConfigType;
-
-
-
-/*******************************************************************************
- *                      Functions Prototypes                                   *
- *******************************************************************************/
-
-/*
- * Description :
- * Functional responsible for Initialize the UART device by:
- * 1. Setup the Frame format like number of data bits, parity bit type and number of stop bits.
- * 2. Enable the UART.
- * 3. Setup the UART baud rate.
- */
-void UART_init(const UART_ConfigType * Config_Ptr);
-
-/*
- * Description :
- * Functional responsible for send byte to another UART device.
- */
-void UART_sendByte(const uint8 data);
-
-/*
- * Description :
- * Functional responsible for receive byte from another UART device.
- */
-uint8 UART_recieveByte(void);
-
-/*
- * Description :
- * Send the required string through UART to the other UART device.
- */
-void UART_sendString(const uint8 *Str);
-
-/*
- * Description :
- * Receive the required string until the '#' symbol through UART from the other UART device.
- */
-void UART_receiveString(uint8 *Str); // Receive until #
-
-#endif /* UART_H_ */
+ /******************************************************************************
+ *
+ * Module: UART
+ *
+ * File Name: uart.h
+ *
+ * Description: Header file for the UART AVR driver
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef UART_H_
+#define UART_H_
+
+#include "std_types.h"
+
+
+
+#define TX_RISING_XCK_EDGE   0
+#define TX_FALLING_XCK_EDGE  1
+
+
+
+/*******************************************************************************
+ *                      Configuration                                   *
+ *******************************************************************************/
+
+
+/*
+ * Configure Required Synchronous TX XCK edge, the same on both ends of the link :
+ * the master and the slave send on this edge and sample on the other one
+ */
+#define SYNC_TX_XCK_EDGE  TX_RISING_XCK_EDGE
+
+/*
+ * XCK pin of the synchronous mode : an output driven by the baud rate generator
+ * of the master, an input on the slave that sends and receives with it
+ */
+#define UART_XCK_PORT_ID		PORTB_ID
+#define UART_XCK_PIN_ID			PIN0_ID
+
+/*
+ * Receive ring : the RX Complete ISR puts the data bytes in it and
+ * UART_recieveByte() takes them, UART_receiveFrame() gives its frames in place.
+ * Built on every link but the acknowledged transport of link.h, whose frames
+ * go to the ring of its control channel instead.
+ */
+#ifndef LINK_ENABLE
+#define UART_RX_RING_ENABLE
+#endif
+
+/*
+ * Flow control of the point-to-point link, built with UART_FLOW_XONXOFF defined
+ * (-DUART_FLOW_XONXOFF) or UART_FLOW_RTSCTS (-DUART_FLOW_RTSCTS). The peer is
+ * throttled once the receive ring holds UART_RX_HIGH_WATER bytes and released
+ * once UART_recieveByte() takes it down to UART_RX_LOW_WATER :
+ *   XON/XOFF : UART_XOFF and UART_XON are sent ahead of the transmit ring. The
+ *   data bytes UART_XON, UART_XOFF and UART_ESCAPE are sent as UART_ESCAPE then
+ *   the byte xor UART_ESCAPE_XOR, so the binary commands go through.
+ *   RTS/CTS : RTS is driven high to throttle, it is wired to CTS of the peer.
+ *   The UDRE ISR only sends while CTS is low, the Timer1 alarm watches it while
+ *   it is high.
+ * A sender held longer than UART_FLOW_HOLD_TIMEOUT sends again : the text dumps
+ * are not read by the peer, the bytes that do not fit in its ring are lost.
+ * UART_FLOW_INIT() is called once Timer1 is initialized, the Timer1 alarm
+ * belongs to the flow control.
+ */
+#if defined(UART_FLOW_XONXOFF) || defined(UART_FLOW_RTSCTS)
+#define UART_FLOW_CONTROL_ENABLE
+#endif
+
+#ifdef UART_FLOW_CONTROL_ENABLE
+#if defined(UART_FLOW_XONXOFF) && defined(UART_FLOW_RTSCTS)
+#error "Only one flow control, XON/XOFF or RTS/CTS"
+#endif
+/* The Timer1 alarm is also taken by the polls and the transport */
+#if defined(MULTIDROP_ENABLE) || defined(RS485_ENABLE) || defined(LINK_ENABLE)
+#error "The flow control is for the point-to-point link, the transport has its own"
+#endif
+#define UART_FLOW_INIT()		UART_startFlowControl()
+#define UART_FLOW_SEND()		UART_sendFlowStats()
+#else
+#define UART_FLOW_INIT()
+#define UART_FLOW_SEND()
+#endif
+
+/*
+ * Longest frame given by UART_receiveFrame(), not counting its terminator. A
+ * frame held in the receive ring, with its terminator, fits under the low water
+ * mark : the peer is not left throttled while it is processed.
+ */
+#define UART_FRAME_MAX_LENGTH	7
+
+/* Size of the receive ring, a power of 2 up to 128, and its water marks */
+#define UART_RX_BUFFER_SIZE		32
+#define UART_RX_HIGH_WATER		24
+#define UART_RX_LOW_WATER		8
+
+#if (UART_FRAME_MAX_LENGTH + 1) > UART_RX_LOW_WATER
+#error "A frame held in the receive ring must stay below the low water mark"
+#endif
+
+#define UART_XON				0x11
+#define UART_XOFF				0x13
+#define UART_ESCAPE				0x7D
+#define UART_ESCAPE_XOR			0x20
+
+/*
+ * RTS output and CTS input, low : ready to receive. RTS is the DE pin of the
+ * RS-485 link, CTS is MOSI of the ISP header, free once it is unplugged.
+ */
+#define UART_RTS_PORT_ID		PORTB_ID
+#define UART_RTS_PIN_ID			PIN4_ID
+#define UART_CTS_PORT_ID		PORTB_ID
+#define UART_CTS_PIN_ID			PIN5_ID
+
+/* Time in Timer1 ticks of 32 us */
+#define UART_CTS_POLL_TICKS		16		/* 512 us */
+#define UART_FLOW_HOLD_TIMEOUT	3125	/* 100 ms */
+
+/*
+ * Transmit ring emptied by the UDRE interrupt, built with UART_TX_BUFFER_ENABLE
+ * defined (-DUART_TX_BUFFER_ENABLE) and always on the RS-485 link, with the flow
+ * control and under the acknowledged transport of link.h (-DLINK_ENABLE) :
+ * UART_sendByte() returns as soon as the byte is in the ring.
+ */
+#if (defined(RS485_ENABLE) || defined(LINK_ENABLE) || defined(UART_FLOW_CONTROL_ENABLE)) && \
+	!defined(UART_TX_BUFFER_ENABLE)
+#define UART_TX_BUFFER_ENABLE
+#endif
+
+/*
+ * RS-485 half-duplex link, only built with RS485_ENABLE defined (-DRS485_ENABLE).
+ * DE and /RE of the transceiver are tied to the pin below : high to drive the
+ * bus, low to listen. The driver is enabled with the first byte of the transmit
+ * ring and released by the TXC interrupt once the stop bit of the last one is
+ * on the bus.
+ */
+#define UART_RS485_DE_PORT_ID	PORTB_ID
+#define UART_RS485_DE_PIN_ID	PIN4_ID
+
+/*
+ * Wait before answering the peer : its last byte is received in the middle of
+ * the stop bit and it drives the bus till its TXC interrupt, half a bit at
+ * 9600 baud (52 us) and the latency of its TXC interrupt
+ */
+#define UART_RS485_GUARD_US		75
+
+/* Size of the transmit ring, a power of 2, the transport puts one frame at a time */
+#ifdef LINK_ENABLE
+#define UART_TX_BUFFER_SIZE		16
+#else
+#define UART_TX_BUFFER_SIZE		32
+#endif
+
+
+
+typedef uint32 UART_BaudRate;
+
+typedef enum
+{
+	Asynchronous_Normal_Mode,Asynchronous_Double_Speed_Mode,Synchronous_Mode
+}UART_Mode;
+
+typedef enum
+{
+	MODE_5_BITS, MODE_6_BITS ,MODE_7_BITS ,MODE_8_BITS ,MODE_9_BITS=7
+}UART_BitData;
+
+typedef enum
+{
+	PARITY_DISABLED ,EVEN_PARITY=2 ,ODD_PARITY
+}UART_Parity;
+
+typedef enum
+{
+	ONE_STOP_BIT,TWO_STOP_BIT
+}UART_StopBit;
+
+/* Clock of the synchronous mode, not used by the asynchronous modes */
+typedef enum
+{
+	UART_XCK_MASTER,UART_XCK_SLAVE
+}UART_XckRole;
+
+
+
+/*
+ * Baud rates checked at compile time : UART_BAUD(MODE, BAUD) gives BAUD, and the
+ * build fails if the nearest UBRR of the mode gives an error above
+ * UART_MAX_BAUD_ERROR (in 0.1 %) or does not fit in its 12 bits.
+ * MODE and BAUD must be constants, UART_init() uses the same UBRR.
+ */
+#define UART_MAX_BAUD_ERROR		20
+
+/* Clock divisor of the mode */
+#define UART_DIVISOR(MODE)		(((MODE) == Asynchronous_Normal_Mode) ? 16UL : \
+								(((MODE) == Asynchronous_Double_Speed_Mode) ? 8UL : 2UL))
+/* UBRR of the baud rate, rounded to the nearest */
+#define UART_UBRR(MODE,BAUD)	((((F_CPU) + ((UART_DIVISOR(MODE) * (BAUD)) / 2)) / \
+								(UART_DIVISOR(MODE) * (BAUD))) - 1)
+/* Baud rate given by this UBRR */
+#define UART_ACTUAL_BAUD(MODE,BAUD)		((F_CPU) / (UART_DIVISOR(MODE) * (UART_UBRR(MODE,BAUD) + 1)))
+/* Error of the actual baud rate in 0.1 % */
+#define UART_BAUD_ERROR(MODE,BAUD)		\
+	((((UART_ACTUAL_BAUD(MODE,BAUD) > (BAUD)) ? (UART_ACTUAL_BAUD(MODE,BAUD) - (BAUD)) : \
+	((BAUD) - UART_ACTUAL_BAUD(MODE,BAUD))) * 1000UL) / (BAUD))
+
+#define UART_BAUD(MODE,BAUD)	((UART_BaudRate)(BAUD) + (0 * sizeof(char[ \
+	((UART_BAUD_ERROR(MODE,BAUD) <= UART_MAX_BAUD_ERROR) && (UART_UBRR(MODE,BAUD) <= 0x0FFF)) ? 1 : -1])))
+
+typedef struct
+{
+	UART_Mode Mode;
+	UART_BitData bit_data;
+	UART_Parity parity;
+	UART_StopBit stop_bit;
+	UART_BaudRate baud_rate;
+	UART_XckRole xck_role;		/* Synchronous_Mode only, the slave ignores baud_rate */
+
+}UART_ConfigType;
+
+typedef enum{
+	UART_FLOW_STAT_THROTTLES,		/* the peer was asked to stop, the receive ring was high */
+	UART_FLOW_STAT_HOLDS,			/* the peer asked to stop sending */
+	UART_FLOW_STAT_TIMEOUTS,		/* holds ended by UART_FLOW_HOLD_TIMEOUT */
+	UART_FLOW_STAT_LOST,			/* bytes lost, the receive ring was full or an overrun */
+	UART_NUM_FLOW_STATS
+}UART_FlowStat;
+
+/*
+ * Frame given by UART_receiveFrame(), without its terminator. The bytes are read
+ * where the RX Complete ISR put them, in the receive ring or in the control
+ * channel ring of the transport : the frame is in two parts when it wraps
+ * around the end of the ring. The bytes are valid till UART_releaseFrame().
+ */
+typedef struct{
+	const uint8 * data[2];
+	uint8 length[2];
+}UART_Frame;
+
+
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Functional responsible for Initialize the UART device by:
+ * 1. Setup the Frame format like number of data bits, parity bit type and number of stop bits.
+ * 2. Enable the UART.
+ * 3. Setup the UART baud rate.
+ */
+void UART_init(const UART_ConfigType * Config_Ptr);
+
+/*
+ * Description :
+ * Functional responsible for send byte to another UART device.
+ * With UART_TX_BUFFER_ENABLE the byte is put in the transmit ring, the ring
+ * must have room when it is called from an ISR. With LINK_ENABLE it is sent
+ * in a frame of the transport, not from an ISR.
+ */
+void UART_sendByte(const uint8 data);
+
+/*
+ * Description :
+ * Put all the bytes in the transmit ring and return TRUE, or none of them and
+ * return FALSE if the ring has not room for all (UART_TX_BUFFER_ENABLE only).
+ * It does not wait, it can be called from an ISR.
+ */
+uint8 UART_putBytes(const uint8 * data,uint8 size);
+
+/*
+ * Description :
+ * Set the function called from the UDRE ISR once the last byte of the transmit
+ * ring is taken, it can put the next bytes (UART_TX_BUFFER_ENABLE only).
+ */
+void UART_setTxEmptyCallBack(void(*a_ptr)(void));
+
+/*
+ * Description :
+ * Change the baud rate, in the mode given to UART_init(). The bytes being sent
+ * are finished first, a byte being received is lost. The synchronous slave
+ * follows the XCK clock of the master.
+ */
+void UART_setBaudRate(UART_BaudRate baud_rate);
+
+/*
+ * Description :
+ * Sleep till all the bytes of the transmit ring are on the bus and the RS-485
+ * driver is released (UART_TX_BUFFER_ENABLE only).
+ */
+void UART_flush(void);
+
+/*
+ * Description :
+ * Functional responsible for receive byte from another UART device.
+ * With LINK_ENABLE it is the next byte of the frames of the transport, with the
+ * flow control the next byte of the receive ring.
+ */
+uint8 UART_recieveByte(void);
+
+/*
+ * Description :
+ * Send the required string through UART to the other UART device.
+ */
+void UART_sendString(const uint8 *Str);
+
+/*
+ * Description :
+ * Receive the required string until the '#' symbol through UART from the other UART device.
+ * At most size - 1 bytes are kept in Str, the '#' is replaced by '\0'. Returns FALSE
+ * if the string was longer, Str is then empty.
+ */
+uint8 UART_receiveString(uint8 *Str,uint8 size); // Receive until #
+
+/*
+ * Description :
+ * Receive the bytes till the terminator and give them in frame, without a copy.
+ * Returns FALSE if there were more than max_length
+ * bytes (at most UART_FRAME_MAX_LENGTH) : they are dropped and frame is empty.
+ * Only one frame is held at a time, UART_releaseFrame() gives it back once it
+ * is processed. UART_recieveByte() can be used in between.
+ */
+uint8 UART_receiveFrame(UART_Frame * frame,uint8 terminator,uint8 max_length);
+
+/*
+ * Description :
+ * Give back the room of the frame and the bytes received before the call,
+ * the frame must not be read anymore.
+ */
+void UART_releaseFrame(void);
+
+/*
+ * Description :
+ * Return the number of bytes of the frame.
+ */
+uint8 UART_frameLength(const UART_Frame * frame);
+
+/*
+ * Description :
+ * Return TRUE if the frame holds the size bytes of data.
+ */
+uint8 UART_frameEquals(const UART_Frame * frame,const uint8 * data,uint8 size);
+
+/*
+ * Description :
+ * Copy the frame in Str as a string of at most size - 1 bytes, ended by '\0'.
+ */
+void UART_copyFrame(const UART_Frame * frame,uint8 * Str,uint8 size);
+
+/*
+ * Description :
+ * Set the function called with the FE/DOR/PE bits of UCSRA
+ * when a byte is received with errors.
+ */
+void UART_setErrorCallBack(void(*a_ptr)(uint8));
+
+/*
+ * Description :
+ * Set the function called from the RX Complete ISR with each data byte received
+ * and its FE/DOR/PE bits, they are not left in UDR for UART_recieveByte().
+ */
+void UART_setReceiveCallBack(void(*a_ptr)(uint8,uint8));
+
+/*
+ * Description :
+ * Return TRUE if a data byte is waiting to be read by UART_recieveByte(), the
+ * address frames before it are given to their call back. Else the RX Complete
+ * interrupt is enabled, so a sleep ends with the next byte.
+ * It must be called with the interrupts disabled.
+ */
+uint8 UART_isByteReceived(void);
+
+/*
+ * Description :
+ * Send an address frame, a 9 bits frame with the ninth bit set (MODE_9_BITS only).
+ * All the receivers get it, even those in the multi-processor mode.
+ */
+void UART_sendAddress(const uint8 address);
+
+/*
+ * Description :
+ * Enable or disable the multi-processor mode (MPCM) : while it is enabled
+ * the receiver ignores the data frames, only the address frames are received.
+ */
+void UART_setMultiProcessorMode(uint8 enable);
+
+/*
+ * Description :
+ * Set the function called from the RX Complete ISR with each address frame
+ * received (MODE_9_BITS only), the data frames are still read by UART_recieveByte().
+ * Once it is set the RX Complete interrupt stays enabled to watch the address frames.
+ */
+void UART_setAddressCallBack(void(*a_ptr)(uint8));
+
+/*
+ * Description :
+ * Take the Timer1 alarm for the hold timeout and the CTS polls, and obey the
+ * throttles of the peer from now on (UART_FLOW_CONTROL_ENABLE only).
+ */
+void UART_startFlowControl(void);
+
+/*
+ * Description :
+ * Return the counter of the flow control since UART_init() (UART_FLOW_CONTROL_ENABLE only).
+ */
+uint16 UART_getFlowStat(UART_FlowStat stat);
+
+/*
+ * Description :
+ * Send the counters of the flow control as one text line (UART_FLOW_CONTROL_ENABLE only) :
+ * FLOW <ECU> <counter> <value> ... <counter> <value>
+ */
+void UART_sendFlowStats(void);
+
+#endif /* UART_H_ */
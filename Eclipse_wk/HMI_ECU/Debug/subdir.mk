@@ -6,25 +6,46 @@
 C_SRCS += \
 ../Human_Machine_Interface.c \
 ../gpio.c \
+../idle.c \
 ../keypad.c \
 ../lcd.c \
+../link.c \
+../multidrop.c \
+../profiler.c \
+../queue.c \
+../stack_monitor.c \
 ../timer1.c \
+../trace.c \
 ../uart.c 
 
 OBJS += \
 ./Human_Machine_Interface.o \
 ./gpio.o \
+./idle.o \
 ./keypad.o \
 ./lcd.o \
+./link.o \
+./multidrop.o \
+./profiler.o \
+./queue.o \
+./stack_monitor.o \
 ./timer1.o \
+./trace.o \
 ./uart.o 
 
 C_DEPS += \
 ./Human_Machine_Interface.d \
 ./gpio.d \
+./idle.d \
 ./keypad.d \
 ./lcd.d \
+./link.d \
+./multidrop.d \
+./profiler.d \
+./queue.d \
+./stack_monitor.d \
 ./timer1.d \
+./trace.d \
 ./uart.d 
 
 
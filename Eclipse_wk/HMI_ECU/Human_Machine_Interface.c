@@ -1,420 +1,799 @@
-/*******************************************************************************
- * Human_Machne_Interface.c
- *
- *	File Name: Human_Machne_Interface.c
- *
- *	Description: the source file for HMI_ECU application
- *
- * Author: Omar Elsherif
- *
- *******************************************************************************/
-
-
-
-/*******************************************************************************
- *                      	Header Files	                                   *
- *******************************************************************************/
-
-
-#include<avr/io.h> 		/* For I-bit*/
-#include"std_types.h"	/* For uint8*/
-#include"lcd.h"			/* For LCD */
-#include"keypad.h"		/* For Keypad */
-#include"util/delay.h"	/* For delay function */
-#include"uart.h"		/* For UART protocol */
-#include"timer1.h"		/* For Timer 1 */
-
-
-/*******************************************************************************
- * 																			   *
- *                      Global Variables              						   *
- *                      									                   *
- *******************************************************************************/
-
-/*	Flag to count number of seconds	*/
-static volatile uint8 g_secondsCount=0;
-/*	Flag to determine if user entered the password wrong,
- * in 3 consective times
- */
-static volatile uint8 g_consectiveWrongPasswords=0;
-/*	Flag to determine if user entered old pass correctly,
- * and wanted to change the password
- */
-static volatile uint8 g_changepassFlag=0;
-
-
-
-/*******************************************************************************
- *                      	  Defines                                          *
- *******************************************************************************/
-
-#define KEYPAD_ENTER_CHARACTER '='
-#define PASSWORD_SIZE 5
-#define ECU_READY 0xFF
-#define MATCHED_PASSWORD 0xFE
-#define UNMATCHED_PASSWORD 0xFD
-#define SEND_PASSWORD 0x01
-#define CONFIRM_SEND_PASSWORD 0x02
-#define OPEN_DOOR 0x03
-#define CHANGE_PASS 0x04
-
-
-/*******************************************************************************
- * 																			   *
- *                     Function Prototypes                                	   *
- *                     													       *
- *******************************************************************************/
-
-
-
-/*	This function is called every 1 second passed in timer1*/
-void timer1HMICallback(void);
-/*	Function to get password from user and
- * send it to the Contol_ECU*/
-void getAndSendPassword(void);
-/*	Function to Open the Door	*/
-void openDoor(void);
-/*	Function to change the password if user
- *  wanted to change the password and entered
- *  the old password correct.
- */
-void changePassword();
-
-
-
-
-/*******************************************************************************
- *                         main() Function                                     *
- *******************************************************************************/
-
-
-int main(void)
-{
-	// Enable I-bit
-	SREG |=(1<<7);
-	/*	Initialize the LCD*/
-	LCD_init();
-
-	/*	Initialize UART with :
-	 * Asynchronous with double speed
-	 * 8- bit Mode
-	 * Parity is disabled
-	 * 1-stop bit
-	 * baud rate =9600
-	 *
-	 */
-	UART_ConfigType UART_Config={Asynchronous_Double_Speed_Mode,MODE_8_BITS,PARITY_DISABLED,ONE_STOP_BIT,9600};
-	UART_init(&UART_Config);
-
-	/*	Timer1 configurations to calculate 1 second*/
-	Timer1_ConfigType TIMER1_Config = {0,CTC_MODE, F_CPU_256, 31250};
-	Timer1_init(&TIMER1_Config);
-
-	/*	Set the callback function of timer1*/
-	Timer1_setCallBack(timer1HMICallback);
-
-	/* sending to CONTROL_ECU ECU_READY signal */
-	UART_sendByte(ECU_READY);
-	/* looping until CONTROL_ECU send ECU_READY signal */
-	while ( UART_recieveByte() != ECU_READY);
-
-	/* variable to know if password match or not match*/
-	uint8 passStatus;
-
-	while(1)
-	{
-		/*	Clear LCD screen*/
-		LCD_clearScreen();
-		LCD_displayString("Plz Enter Pass:");
-		/*	Move LCD cursor to second line*/
-		LCD_moveCursor(1, 0);
-		/* Get password from user */
-		getAndSendPassword();
-		/*	Clear LCD screen*/
-		LCD_clearScreen();
-		/*	Move LCD cursor to First line*/
-		LCD_moveCursor(0, 0);
-		LCD_displayString("Plz Re-Enter the:");
-		/*	Move LCD cursor to second line*/
-		LCD_moveCursor(1, 0);
-		LCD_displayString("same pass:");
-		/* Get password from user */
-		getAndSendPassword();
-
-
-
-		/* looping until CONTROL_ECU is ready to receive the password */
-		while (UART_recieveByte() != SEND_PASSWORD);
-		/* sending to CONTROL_ECU  signal to let it know that HMI_ECU will send the password*/
-		UART_sendByte(CONFIRM_SEND_PASSWORD);
-
-		/*	Get the password status from CONTROL_ECU to identify if the
-		 * two passwords are matched or not	*/
-		passStatus = UART_recieveByte();
-
-		LCD_clearScreen();
-
-		/* if passwords were matched*/
-		if(passStatus==MATCHED_PASSWORD)
-		{
-
-			while(1)
-			{
-				/* if user entered password wrong 3 consecutive times */
-				if(g_consectiveWrongPasswords==3)
-				{
-					/* clear the counter of consecutive wrong passwords*/
-					g_consectiveWrongPasswords=0;
-					/* clear second count	*/
-					g_secondsCount=0;
-					LCD_clearScreen();
-					LCD_displayString("ERROR !!!");
-					/* loop till there are 60 seconds passed */
-					while(g_secondsCount<60);
-
-				}
-				/* if passwords match and not wrong in 3 consecutive times , display :
-				 * '+' : Open Door
-				 * '-' : change Pass
-				 */
-				LCD_clearScreen();
-				LCD_displayString("+ : Open Door");
-				LCD_moveCursor(1, 0);
-				LCD_displayString("- : Change Pass");
-
-				/* if user wanted to open the door '+' */
-				if(KEYPAD_getPressedKey()=='+')
-				{
-					_delay_ms(200);
-					/* Open the door	*/
-					openDoor();
-				}
-				/* if user wanted to change the pass '-' */
-				else if(KEYPAD_getPressedKey()=='-')
-				{
-					_delay_ms(200);
-					/* Change the password	*/
-					changePassword();
-				}
-
-				/* If user wanted to change the password and entered the old
-				 * password correctly */
-				if(g_changepassFlag==1)
-				{
-					/*	Clear the change pass flag 	*/
-					g_changepassFlag=0;
-					/* break and go to outer menu to get new	*/
-					break;
-				}
-
-
-			} /* End of inner while(1) */
-
-		}/*	End of if(passStatus==MATCHED_PASSWORD) */
-
-
-		/* if the 2 entered passwords were not matched	*/
-		else if(passStatus==UNMATCHED_PASSWORD)
-		{
-			LCD_displayString("NOT MATCHED ");
-			_delay_ms(2000);
-		}
-
-	} /* End Of While(1)*/
-
-
-	return 1;
-} /* End of main() function */
-
-
-
-
-/*******************************************************************************
- * 																			   *
- *                     Function Definitions									   *
- *                     					                                       *
- *******************************************************************************/
-
-
-
-
-
-/*	This function is called every 1 second passed in timer1*/
-void timer1HMICallback(void)
-{
-	/* increments the seconds counter*/
-	g_secondsCount++;
-}
-
-
-
-/*	Function to get password from user and
- * send it to the Contol_ECU*/
-void getAndSendPassword(void)
-{
-	/*	variable to loop over password 	*/
-	uint8 passwordSize=0;
-	/* 5-digit Password + null +'#' when we send using UART */
-	uint8 password[PASSWORD_SIZE+2];
-	/* Loop to get password from user via keypad*/
-	for(passwordSize=0;passwordSize< PASSWORD_SIZE;passwordSize++)
-	{
-		/* Store password	*/
-		password[passwordSize] = KEYPAD_getPressedKey();
-		LCD_displayCharacter('*');
-		//LCD_intgerToString(password[passwordSize]);
-		_delay_ms(500);
-	}
-	/*	Put null after filling the string */
-	//password[++passwordSize]='\0';
-	password[passwordSize]='#';
-	password[++passwordSize]='\0';
-
-
-	/* As long as '=' is not pressed we wait */
-	while(KEYPAD_getPressedKey() != KEYPAD_ENTER_CHARACTER);
-	_delay_ms(100);
-
-	/* Send signal to Control_ECU to let him know that HMI_ECU will send password */
-	UART_sendByte(SEND_PASSWORD);
-	while ( UART_recieveByte() != CONFIRM_SEND_PASSWORD);
-	/*Send Each digit password to Control_ECU*/
-	UART_sendString(password);
-}
-
-/*	Function to Open the Door	*/
-void openDoor(void)
-{
-	/*	Variable to determine status of entered password,
-	 * whether it is matched or not matched
-	 */
-	uint8 passwordStatus;
-
-	LCD_clearScreen();
-	LCD_displayString("Plz Enter Pass:");
-	LCD_moveCursor(1, 0);
-	/* Calling function getAndSendPassword() ,
-	 * that get the pass from user and send it to Control_ECU
-	 */
-	getAndSendPassword();
-
-
-	/*	Wait till the Control_ECU send a signal to let HMI_ECU know that it will
-	 * receive status of password from Control_ECU
-	 */
-	while ( UART_recieveByte() != SEND_PASSWORD);
-	UART_sendByte(CONFIRM_SEND_PASSWORD);
-	/*	Receive the password status, whether entered pass in matched or not*/
-	passwordStatus=UART_recieveByte();
-	/* Send a signal to Control_ECU to let him know that we are in open Door function */
-	UART_sendByte(OPEN_DOOR);
-
-	/*	If the Two password matched */
-	if(passwordStatus==MATCHED_PASSWORD)
-	{
-		/*	Clear the consecutive wrong password counter */
-		g_consectiveWrongPasswords=0;
-		/*	Clear the seconds counter */
-		g_secondsCount=0;
-		LCD_clearScreen();
-		/*	Display Door Unlocking */
-		LCD_displayString("Door Unlocking");
-		/*	Wait till 15 seconds were passed */
-		while(g_secondsCount<15);
-		LCD_clearScreen();
-		/*	Display Door Opened */
-		LCD_displayString("Door Opened");
-		/*	Wait till another 3 seconds were passed */
-		while(g_secondsCount<=18);
-		LCD_clearScreen();
-		/*	Display Door Locking */
-		LCD_displayString("Door Locking");
-		/*	Wait till another 15 seconds were passed */
-		while(g_secondsCount<33);
-	}
-
-	/*	If the Two passwords are NOT matched */
-	else if(passwordStatus==UNMATCHED_PASSWORD)
-	{
-		/*	Increment the consecutive wrong password counter */
-		g_consectiveWrongPasswords++;
-		/* if user entered consecutive wrong pass less than 3 times*/
-		if(g_consectiveWrongPasswords<3)
-		{
-			LCD_clearScreen();
-			/* Display "Wrong Pass:" and display the number of wrong password times*/
-			LCD_displayString("Wrong Pass: ");
-			LCD_intgerToString(g_consectiveWrongPasswords);
-			_delay_ms(2000);
-			/* If two password are not matched get another password from user	*/
-			openDoor();
-		}
-	}
-}
-
-/*	Function to change the password if user
- *  wanted to change the password and entered
- *  the old password correct.
- */
-void changePassword()
-{
-	/*	Variable to determine status of entered password,
-	 * whether it is matched or not matched
-	 */
-	uint8 passwordStatus;
-
-	LCD_clearScreen();
-	LCD_displayString("Plz Enter Pass: ");
-	LCD_moveCursor(1, 0);
-	/* Calling function getAndSendPassword() ,
-	 * that get the pass from user and send it to Control_ECU
-	 */
-	getAndSendPassword();
-
-
-	/*	Wait till the Control_ECU send a signal to let HMI_ECU know that it will
-	 * receive status of password from Control_ECU
-	 */
-	while ( UART_recieveByte() != SEND_PASSWORD);
-	UART_sendByte(CONFIRM_SEND_PASSWORD);
-	/*	Receive the password status, whether entered pass in matched or not*/
-	passwordStatus=UART_recieveByte();
-	/* Send a signal to Control_ECU to let him know that we are in Change pass function */
-	UART_sendByte(CHANGE_PASS);
-
-	/*	If the Two passwords matched */
-	if(passwordStatus==MATCHED_PASSWORD)
-	{
-		/*	Clear the consecutive wrong password counter */
-		g_consectiveWrongPasswords=0;
-		/* Set the change password flag */
-		g_changepassFlag=1;
-		LCD_clearScreen();
-		LCD_displayString("Change Password");
-		LCD_moveCursor(1, 0);
-		LCD_displayString("Confirmed");
-		_delay_ms(2000);
-	}
-	/*	If the Two passwords are NOT matched */
-	else if(passwordStatus==UNMATCHED_PASSWORD)
-	{
-		/* Clear the change password flag */
-		g_changepassFlag=0;
-		/*	Increment the consecutive wrong password counter */
-		g_consectiveWrongPasswords++;
-		/* if user entered consecutive wrong pass less than 3 times*/
-		if(g_consectiveWrongPasswords<3)
-		{
-			LCD_clearScreen();
-			/* Display "Wrong Pass:" and display the number of wrong password times*/
-			LCD_displayString("Wrong Pass: ");
-			LCD_intgerToString(g_consectiveWrongPasswords);
-			_delay_ms(2000);
-			/* If two password are not matched get another password from user	*/
-			changePassword();
-		}
-	}
-}
-
-
-
+/*******************************************************************************
+ * Human_Machne_Interface.c
+ *
+ *	File Name: Human_Machne_Interface.c
+ *
+ *	Description: the source file for HMI_ECU application
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+
+
+/*******************************************************************************
+ *                      	Header Files	                                   *
+ *******************************************************************************/
+
+
+#include"mcu_hal.h"		/* For I-bit*/
+#include"std_types.h"	/* For uint8*/
+#include"lcd.h"			/* For LCD */
+#include"keypad.h"		/* For Keypad */
+#include"util/delay.h"	/* For delay function */
+#include"uart.h"		/* For UART protocol */
+#include"timer1.h"		/* For Timer 1 */
+#include"profiler.h"	/* For the hot path profiler */
+#include"trace.h"		/* For the event trace */
+#include"stack_monitor.h"	/* For the stack high-water mark */
+#include"idle.h"		/* For the idle sleep */
+#include"multidrop.h"	/* For the panels on the link */
+#include"link.h"		/* For the acknowledged transport */
+
+
+/*******************************************************************************
+ * 																			   *
+ *                      Global Variables              						   *
+ *                      									                   *
+ *******************************************************************************/
+
+/*	Flag to count number of seconds	*/
+static volatile uint8 g_secondsCount=0;
+/*	Flag to determine if user entered the password wrong,
+ * in 3 consective times
+ */
+static volatile uint8 g_consectiveWrongPasswords=0;
+/*	Flag to determine if user entered old pass correctly,
+ * and wanted to change the password
+ */
+static volatile uint8 g_changepassFlag=0;
+
+
+
+/*******************************************************************************
+ *                      	  Defines                                          *
+ *******************************************************************************/
+
+#define KEYPAD_ENTER_CHARACTER '='
+/* ON/C key of the keypad, displays the statistics at the menu */
+#define KEYPAD_STATS_KEY 13
+#define PASSWORD_SIZE 5
+#define ECU_READY 0xFF
+#define MATCHED_PASSWORD 0xFE
+#define UNMATCHED_PASSWORD 0xFD
+/*	Answer of the Control_ECU to a password sent during its lockout, it is not checked	*/
+#define LOCKED_OUT 0xFC
+#define SEND_PASSWORD 0x01
+#define CONFIRM_SEND_PASSWORD 0x02
+#define OPEN_DOOR 0x03
+#define CHANGE_PASS 0x04
+#define DOOR_UNLOCKED 0x05
+#define DOOR_LOCKING 0x06
+#define DOOR_LOCKED 0x07
+
+/* Door position sent by Control_ECU from its limit switches */
+#define DOOR_POSITION_UNKNOWN 0x00
+#define DOOR_POSITION_OPENED 0x01
+#define DOOR_POSITION_CLOSED 0x02
+
+/* Statistics query, answered by STATS_REQUEST then the values of Control_ECU
+ * (2 bytes each, low byte first) : unlocks, wrong passwords, lockouts,
+ * EEPROM errors, UART frame errors, UART overruns, max response time in ms,
+ * max stack usage in bytes
+ */
+#define STATS_REQUEST 0x12
+#define STATS_NUM_VALUES 8
+
+/* Latency histograms of Control_ECU, sent as text lines on its UART line
+ * for a serial capture, and their reset
+ */
+#define HISTOGRAM_REQUEST 0x13
+#define HISTOGRAM_RESET 0x14
+
+/* Link baud rate negotiation : HMI_ECU sends BAUD_REQUEST with the index of its
+ * highest rate in g_linkBaudRates, Control_ECU answers BAUD_REQUEST with the
+ * index both of them support, then both switch to it. The handshake with
+ * ECU_READY is done again at the new rate.
+ */
+#define BAUD_REQUEST 0x16
+/* Highest link baud rate of the build, make BAUD=n gives -DLINK_MAX_BAUD=n */
+#ifndef LINK_MAX_BAUD
+#define LINK_MAX_BAUD (F_CPU/2)
+#endif
+#ifdef MULTIDROP_ENABLE
+/* The panels share the link at 9600 */
+#undef LINK_MAX_BAUD
+#define LINK_MAX_BAUD 9600
+#endif
+#define LINK_NUM_BAUD_RATES (sizeof(g_linkBaudRates)/sizeof(g_linkBaudRates[0]))
+/* The acknowledged transport (-DLINK_ENABLE, make LINK=1) starts at the highest
+ * rate of the build and does not switch : a frame lost at the switch could not
+ * be sent again
+ */
+#ifdef LINK_ENABLE
+#define LINK_START_BAUD_INDEX getMaxBaudIndex()
+#else
+#define LINK_START_BAUD_INDEX 0
+#endif
+
+/* Synchronous link with -DUART_SYNC_ENABLE (make SYNC=1) : XCK on PB0 of both
+ * ECUs, Control_ECU is the master that clocks both directions
+ */
+#ifdef UART_SYNC_ENABLE
+#if defined(MULTIDROP_ENABLE) || defined(RS485_ENABLE)
+#error "The synchronous link is point-to-point, without RS-485 transceivers"
+#endif
+#define LINK_UART_MODE Synchronous_Mode
+#else
+#define LINK_UART_MODE Asynchronous_Double_Speed_Mode
+#endif
+#define LINK_XCK_ROLE UART_XCK_SLAVE
+
+
+
+/*******************************************************************************
+ * 																			   *
+ *                      Link Baud Rates              						   *
+ *                      									                   *
+ *******************************************************************************/
+
+/*	Link baud rates of both ECUs by their index, the first one is the rate at
+ * reset. 57600 and 115200 are not there, their error is above 2 % at 8 MHz.
+ * The synchronous slave needs XCK below F_CPU/4, F_CPU/6 is the fastest rate
+ * between two ECUs at the same clock.
+ */
+static const UART_BaudRate g_linkBaudRates[]={
+		UART_BAUD(LINK_UART_MODE,9600),
+		UART_BAUD(LINK_UART_MODE,19200),
+		UART_BAUD(LINK_UART_MODE,38400),
+		UART_BAUD(LINK_UART_MODE,76800),
+		UART_BAUD(LINK_UART_MODE,250000),
+		UART_BAUD(LINK_UART_MODE,500000),
+		UART_BAUD(LINK_UART_MODE,1000000)
+#ifdef UART_SYNC_ENABLE
+		,UART_BAUD(LINK_UART_MODE,F_CPU/6)
+#endif
+};
+
+
+/*******************************************************************************
+ * 																			   *
+ *                     Function Prototypes                                	   *
+ *                     													       *
+ *******************************************************************************/
+
+
+
+/*	This function is called every 1 second passed in timer1*/
+void timer1HMICallback(void);
+/*	Function to get password from user and
+ * send it to the Contol_ECU*/
+void getAndSendPassword(void);
+/*	Function to Open the Door	*/
+void openDoor(void);
+/*	Function to change the password if user
+ *  wanted to change the password and entered
+ *  the old password correct.
+ */
+void changePassword();
+/*	Function to receive the real door position from the Contol_ECU,
+ *  it displays the position and returns FALSE if the door did not reach
+ *  the expected position.
+ */
+uint8 checkDoorPosition(uint8 expectedPosition);
+/*	Function to tell the user that the Control_ECU did not check the password,
+ *  it is locked out after 3 wrong passwords
+ */
+void displayLockedOut(void);
+/*	Function to display the expected door travel time in seconds
+ *  on the second line of the LCD.
+ */
+void displayDoorTravelTime(uint8 seconds);
+/*	Function to query the statistics of the Control_ECU and display them,
+ *  two values on each screen.
+ */
+void displayStatistics(void);
+/*	Function to send the wake counts of both ECUs and the latency histograms,
+ *  the user can then reset the histograms.
+ */
+void exportHistograms(void);
+/* Function to return the index of the highest link baud rate of this build */
+uint8 getMaxBaudIndex(void);
+/*	Function to agree on the highest link baud rate with the Control_ECU
+ *  and switch to it.
+ */
+void negotiateBaudRate(void);
+
+
+
+
+/*******************************************************************************
+ *                         main() Function                                     *
+ *******************************************************************************/
+
+
+int main(void)
+{
+	// Enable I-bit
+	HAL_SET_BITS(SREG, (1<<7));
+	/*	Sleep in the Idle mode while waiting for an interrupt	*/
+	Idle_init();
+	/*	Initialize the LCD*/
+	LCD_init();
+
+	/*	Initialize UART with :
+	 * Asynchronous with double speed
+	 * 8- bit Mode, 9-bit on the multi-drop link
+	 * Parity is disabled
+	 * 1-stop bit
+	 * baud rate =9600, till the rate of both ECUs is agreed
+	 * (the highest one from the start under the transport)
+	 *
+	 */
+	UART_ConfigType UART_Config={LINK_UART_MODE,MULTIDROP_UART_BITS,PARITY_DISABLED,ONE_STOP_BIT,g_linkBaudRates[LINK_START_BAUD_INDEX],LINK_XCK_ROLE};
+	UART_init(&UART_Config);
+	/*	Wait for the polls of the Control_ECU, only with MULTIDROP_ENABLE	*/
+	MULTIDROP_INIT();
+
+	/*	Timer1 configurations to calculate 1 second*/
+	Timer1_ConfigType TIMER1_Config = {0,CTC_MODE, F_CPU_256, 31250};
+	Timer1_init(&TIMER1_Config);
+
+	/*	Set the callback function of timer1*/
+	Timer1_setCallBack(timer1HMICallback);
+	/*	Time the hot paths with Timer1, only with PROFILER_ENABLE	*/
+	PROFILER_INIT();
+	/*	Record the events with their time, only with TRACE_ENABLE	*/
+	TRACE_INIT();
+	/*	Frames acknowledged and sent again on the link, only with LINK_ENABLE	*/
+	LINK_INIT();
+	/*	Throttle the peer with XON/XOFF or RTS/CTS, only with UART_FLOW_XONXOFF/RTSCTS	*/
+	UART_FLOW_INIT();
+
+	/* sending to CONTROL_ECU ECU_READY signal */
+	MULTIDROP_WAIT_TURN();
+	UART_sendByte(ECU_READY);
+	/* looping until CONTROL_ECU send ECU_READY signal */
+	while ( UART_recieveByte() != ECU_READY);
+	/* switching to the highest baud rate of both ECUs */
+	negotiateBaudRate();
+
+	/* variable to know if password match or not match*/
+	uint8 passStatus;
+
+	while(1)
+	{
+		/*	Clear LCD screen*/
+		LCD_clearScreen();
+		LCD_displayString("Plz Enter Pass:");
+		/*	Move LCD cursor to second line*/
+		LCD_moveCursor(1, 0);
+		/* Get password from user */
+		getAndSendPassword();
+		/*	Clear LCD screen*/
+		LCD_clearScreen();
+		/*	Move LCD cursor to First line*/
+		LCD_moveCursor(0, 0);
+		LCD_displayString("Plz Re-Enter the:");
+		/*	Move LCD cursor to second line*/
+		LCD_moveCursor(1, 0);
+		LCD_displayString("same pass:");
+		/* Get password from user */
+		getAndSendPassword();
+
+
+
+		/* looping until CONTROL_ECU is ready to receive the password */
+		while (UART_recieveByte() != SEND_PASSWORD);
+		/* sending to CONTROL_ECU  signal to let it know that HMI_ECU will send the password*/
+		UART_sendByte(CONFIRM_SEND_PASSWORD);
+
+		/*	Get the password status from CONTROL_ECU to identify if the
+		 * two passwords are matched or not	*/
+		passStatus = UART_recieveByte();
+
+		LCD_clearScreen();
+
+		/* if passwords were matched*/
+		if(passStatus==MATCHED_PASSWORD)
+		{
+
+			while(1)
+			{
+				/* if user entered password wrong 3 consecutive times */
+				if(g_consectiveWrongPasswords==3)
+				{
+					/* clear the counter of consecutive wrong passwords*/
+					g_consectiveWrongPasswords=0;
+					/* clear second count	*/
+					g_secondsCount=0;
+					LCD_clearScreen();
+					LCD_displayString("ERROR !!!");
+					/* loop till there are 60 seconds passed */
+					/*	Nothing to do till the Timer1 interrupt	*/
+					IDLE_WAIT_UNTIL(g_secondsCount>=60);
+
+				}
+				/* if passwords match and not wrong in 3 consecutive times , display :
+				 * '+' : Open Door
+				 * '-' : change Pass
+				 */
+				LCD_clearScreen();
+				LCD_displayString("+ : Open Door");
+				LCD_moveCursor(1, 0);
+				LCD_displayString("- : Change Pass");
+
+				/* if user wanted to open the door '+' */
+				if(KEYPAD_getPressedKey()=='+')
+				{
+					TRACE(TRACE_EVENT_MENU, '+');
+					_delay_ms(200);
+					/* Open the door	*/
+					openDoor();
+				}
+				/* if user wanted to change the pass '-' */
+				else if(KEYPAD_getPressedKey()=='-')
+				{
+					TRACE(TRACE_EVENT_MENU, '-');
+					_delay_ms(200);
+					/* Change the password	*/
+					changePassword();
+				}
+				/* if user wanted to see the statistics 'ON/C' */
+				else if(KEYPAD_getPressedKey()==KEYPAD_STATS_KEY)
+				{
+					displayStatistics();
+				}
+				/* if user wanted to export the latency histograms '=' */
+				else if(KEYPAD_getPressedKey()==KEYPAD_ENTER_CHARACTER)
+				{
+					_delay_ms(200);
+					exportHistograms();
+				}
+#ifdef PROFILER_ENABLE
+				/* '%' : dump the profiler of the two ECUs over the UART */
+				else if(KEYPAD_getPressedKey()=='%')
+				{
+					MULTIDROP_WAIT_TURN();
+					UART_sendByte(PROFILER_DUMP_REQUEST);
+					LINK_SET_TX_CHANNEL(LINK_CHANNEL_TRACE);
+					PROFILER_DUMP();
+					LINK_SET_TX_CHANNEL(LINK_CHANNEL_CONTROL);
+				}
+#endif
+#ifdef TRACE_ENABLE
+				/* '*' : dump the trace of the two ECUs over the UART */
+				else if(KEYPAD_getPressedKey()=='*')
+				{
+					MULTIDROP_WAIT_TURN();
+					UART_sendByte(TRACE_DUMP_REQUEST);
+					LINK_SET_TX_CHANNEL(LINK_CHANNEL_TRACE);
+					TRACE_DUMP();
+					LINK_SET_TX_CHANNEL(LINK_CHANNEL_CONTROL);
+				}
+#endif
+
+				/* If user wanted to change the password and entered the old
+				 * password correctly */
+				if(g_changepassFlag==1)
+				{
+					/*	Clear the change pass flag 	*/
+					g_changepassFlag=0;
+					/* break and go to outer menu to get new	*/
+					break;
+				}
+
+
+			} /* End of inner while(1) */
+
+		}/*	End of if(passStatus==MATCHED_PASSWORD) */
+
+
+		/* if the 2 entered passwords were not matched	*/
+		else if(passStatus==UNMATCHED_PASSWORD)
+		{
+			LCD_displayString("NOT MATCHED ");
+			_delay_ms(2000);
+		}
+		/* if the Control_ECU is locked out, the new password is not saved	*/
+		else if(passStatus==LOCKED_OUT)
+		{
+			displayLockedOut();
+		}
+
+	} /* End Of While(1)*/
+
+
+	return 1;
+} /* End of main() function */
+
+
+
+
+/*******************************************************************************
+ * 																			   *
+ *                     Function Definitions									   *
+ *                     					                                       *
+ *******************************************************************************/
+
+
+
+
+
+/*	This function is called every 1 second passed in timer1*/
+void timer1HMICallback(void)
+{
+	/* increments the seconds counter*/
+	g_secondsCount++;
+	/* Count the second of the trace timestamps */
+	TRACE_TICK();
+}
+
+
+
+/*	Function to get password from user and
+ * send it to the Contol_ECU*/
+void getAndSendPassword(void)
+{
+	/*	variable to loop over password 	*/
+	uint8 passwordSize=0;
+	/* 5-digit Password + null +'#' when we send using UART */
+	uint8 password[PASSWORD_SIZE+2];
+	/* Loop to get password from user via keypad*/
+	for(passwordSize=0;passwordSize< PASSWORD_SIZE;passwordSize++)
+	{
+		/* Store password	*/
+		password[passwordSize] = KEYPAD_getPressedKey();
+		LCD_displayCharacter('*');
+		/* Only the number of digits, not the digit itself */
+		TRACE(TRACE_EVENT_KEY, passwordSize+1);
+		//LCD_intgerToString(password[passwordSize]);
+		_delay_ms(500);
+	}
+	/*	Put null after filling the string */
+	//password[++passwordSize]='\0';
+	password[passwordSize]='#';
+	password[++passwordSize]='\0';
+
+
+	/* As long as '=' is not pressed we wait */
+	while(KEYPAD_getPressedKey() != KEYPAD_ENTER_CHARACTER);
+	_delay_ms(100);
+
+	/* Send signal to Control_ECU to let him know that HMI_ECU will send password */
+	MULTIDROP_WAIT_TURN();
+	UART_sendByte(SEND_PASSWORD);
+	while ( UART_recieveByte() != CONFIRM_SEND_PASSWORD);
+	/*Send Each digit password to Control_ECU, not kept in the trace*/
+	TRACE_MASK(TRUE);
+	UART_sendString(password);
+	TRACE_MASK(FALSE);
+}
+
+/*	Function to Open the Door	*/
+void openDoor(void)
+{
+	/*	Variable to determine status of entered password,
+	 * whether it is matched or not matched
+	 */
+	uint8 passwordStatus;
+
+	LCD_clearScreen();
+	LCD_displayString("Plz Enter Pass:");
+	LCD_moveCursor(1, 0);
+	/* Calling function getAndSendPassword() ,
+	 * that get the pass from user and send it to Control_ECU
+	 */
+	getAndSendPassword();
+
+
+	/*	Wait till the Control_ECU send a signal to let HMI_ECU know that it will
+	 * receive status of password from Control_ECU
+	 */
+	while ( UART_recieveByte() != SEND_PASSWORD);
+	UART_sendByte(CONFIRM_SEND_PASSWORD);
+	/*	Receive the password status, whether entered pass in matched or not*/
+	passwordStatus=UART_recieveByte();
+
+	/*	If the Two password matched */
+	if(passwordStatus==MATCHED_PASSWORD)
+	{
+		/* Send a signal to Control_ECU to let him know that we are in open Door function,
+		 * it only waits for it after a matched password
+		 */
+		UART_sendByte(OPEN_DOOR);
+		/*	Clear the consecutive wrong password counter */
+		g_consectiveWrongPasswords=0;
+		LCD_clearScreen();
+		/*	Display Door Unlocking */
+		LCD_displayString("Door Unlocking");
+		/*	Display the travel time learned by the Control_ECU */
+		displayDoorTravelTime(UART_recieveByte());
+		/*	Wait till the Control_ECU stops the motor at the end of travel */
+		while(UART_recieveByte() != DOOR_UNLOCKED);
+		if(checkDoorPosition(DOOR_POSITION_OPENED))
+		{
+			LCD_clearScreen();
+			/*	Display Door Opened */
+			LCD_displayString("Door Opened");
+		}
+		/*	Wait till the Control_ECU starts locking the door */
+		while(UART_recieveByte() != DOOR_LOCKING);
+		LCD_clearScreen();
+		/*	Display Door Locking */
+		LCD_displayString("Door Locking");
+		/*	Display the travel time learned by the Control_ECU */
+		displayDoorTravelTime(UART_recieveByte());
+		/*	Wait till the Control_ECU stops the motor at the end of travel */
+		while(UART_recieveByte() != DOOR_LOCKED);
+		if(!checkDoorPosition(DOOR_POSITION_CLOSED))
+		{
+			/*	Keep the real door position on the screen */
+			_delay_ms(2000);
+		}
+	}
+
+	/*	If the Two passwords are NOT matched */
+	else if(passwordStatus==UNMATCHED_PASSWORD)
+	{
+		/*	Increment the consecutive wrong password counter */
+		g_consectiveWrongPasswords++;
+		/* if user entered consecutive wrong pass less than 3 times*/
+		if(g_consectiveWrongPasswords<3)
+		{
+			LCD_clearScreen();
+			/* Display "Wrong Pass:" and display the number of wrong password times*/
+			LCD_displayString("Wrong Pass: ");
+			LCD_intgerToString(g_consectiveWrongPasswords);
+			_delay_ms(2000);
+			/* If two password are not matched get another password from user	*/
+			openDoor();
+		}
+	}
+	/*	If the Control_ECU is locked out, the password is not counted */
+	else if(passwordStatus==LOCKED_OUT)
+	{
+		displayLockedOut();
+	}
+}
+
+/*	Function to change the password if user
+ *  wanted to change the password and entered
+ *  the old password correct.
+ */
+void changePassword()
+{
+	/*	Variable to determine status of entered password,
+	 * whether it is matched or not matched
+	 */
+	uint8 passwordStatus;
+
+	LCD_clearScreen();
+	LCD_displayString("Plz Enter Pass: ");
+	LCD_moveCursor(1, 0);
+	/* Calling function getAndSendPassword() ,
+	 * that get the pass from user and send it to Control_ECU
+	 */
+	getAndSendPassword();
+
+
+	/*	Wait till the Control_ECU send a signal to let HMI_ECU know that it will
+	 * receive status of password from Control_ECU
+	 */
+	while ( UART_recieveByte() != SEND_PASSWORD);
+	UART_sendByte(CONFIRM_SEND_PASSWORD);
+	/*	Receive the password status, whether entered pass in matched or not*/
+	passwordStatus=UART_recieveByte();
+
+	/*	If the Two passwords matched */
+	if(passwordStatus==MATCHED_PASSWORD)
+	{
+		/* Send a signal to Control_ECU to let him know that we are in Change pass function,
+		 * it only waits for it after a matched password
+		 */
+		UART_sendByte(CHANGE_PASS);
+		/*	Clear the consecutive wrong password counter */
+		g_consectiveWrongPasswords=0;
+		/* Set the change password flag */
+		g_changepassFlag=1;
+		LCD_clearScreen();
+		LCD_displayString("Change Password");
+		LCD_moveCursor(1, 0);
+		LCD_displayString("Confirmed");
+		_delay_ms(2000);
+	}
+	/*	If the Two passwords are NOT matched */
+	else if(passwordStatus==UNMATCHED_PASSWORD)
+	{
+		/* Clear the change password flag */
+		g_changepassFlag=0;
+		/*	Increment the consecutive wrong password counter */
+		g_consectiveWrongPasswords++;
+		/* if user entered consecutive wrong pass less than 3 times*/
+		if(g_consectiveWrongPasswords<3)
+		{
+			LCD_clearScreen();
+			/* Display "Wrong Pass:" and display the number of wrong password times*/
+			LCD_displayString("Wrong Pass: ");
+			LCD_intgerToString(g_consectiveWrongPasswords);
+			_delay_ms(2000);
+			/* If two password are not matched get another password from user	*/
+			changePassword();
+		}
+	}
+	/*	If the Control_ECU is locked out, the password is not counted */
+	else if(passwordStatus==LOCKED_OUT)
+	{
+		/* Clear the change password flag */
+		g_changepassFlag=0;
+		displayLockedOut();
+	}
+}
+
+/*	Function to receive the real door position from the Contol_ECU,
+ *  it displays the position and returns FALSE if the door did not reach
+ *  the expected position.
+ */
+uint8 checkDoorPosition(uint8 expectedPosition)
+{
+	/*	Door position read by Control_ECU from its limit switches */
+	uint8 doorPosition = UART_recieveByte();
+
+	if(doorPosition == expectedPosition)
+	{
+		return TRUE;
+	}
+
+	LCD_clearScreen();
+	/*	The motor stopped on stall or timeout before reaching the limit */
+	if(doorPosition == DOOR_POSITION_OPENED)
+	{
+		LCD_displayString("Door Still Open");
+	}
+	else if(doorPosition == DOOR_POSITION_CLOSED)
+	{
+		LCD_displayString("Door Still Closed");
+	}
+	else
+	{
+		LCD_displayString("Door Half Open");
+	}
+	return FALSE;
+}
+
+/*	Function to tell the user that the Control_ECU did not check the password,
+ *  it is locked out after 3 wrong passwords
+ */
+void displayLockedOut(void)
+{
+	LCD_clearScreen();
+	LCD_displayString("Locked Out");
+	LCD_moveCursor(1, 0);
+	LCD_displayString("Try Again Later");
+	_delay_ms(2000);
+}
+
+/*	Function to display the expected door travel time in seconds
+ *  on the second line of the LCD.
+ */
+void displayDoorTravelTime(uint8 seconds)
+{
+	LCD_moveCursor(1, 0);
+	LCD_displayString("Wait: ");
+	LCD_intgerToString(seconds);
+	LCD_displayString(" sec");
+}
+
+/*	Function to query the statistics of the Control_ECU and display them,
+ *  two values on each screen.
+ */
+void displayStatistics(void)
+{
+	/*	Labels of the values, in the order they are sent	*/
+	static const char * const labels[STATS_NUM_VALUES+1] = {
+			"Unlocks:", "Wrong pass:", "Lockouts:", "EEPROM err:",
+			"Frame err:", "Overruns:", "Latency ms:", "Ctrl stack:",
+			"HMI stack:"
+	};
+	/*	The last one is the stack usage of this ECU	*/
+	uint16 values[STATS_NUM_VALUES+1];
+	uint8 i;
+
+	/*	Control_ECU answers while it waits for the next password	*/
+	MULTIDROP_WAIT_TURN();
+	UART_sendByte(STATS_REQUEST);
+	while(UART_recieveByte() != STATS_REQUEST);
+	for(i=0;i<STATS_NUM_VALUES;i++)
+	{
+		values[i]=UART_recieveByte();
+		values[i]|=(uint16)UART_recieveByte()<<8;
+	}
+	values[STATS_NUM_VALUES]=StackMonitor_getMaxUsage();
+
+	for(i=0;i<=STATS_NUM_VALUES;i++)
+	{
+		/*	New screen every two values	*/
+		if((i%2)==0)
+		{
+			if(i!=0)
+			{
+				_delay_ms(2000);
+			}
+			LCD_clearScreen();
+		}
+		LCD_displayStringRowColumn(i%2, 0, labels[i]);
+		LCD_intgerToString(values[i]);
+	}
+	_delay_ms(2000);
+}
+
+/*	Function to send the wake counts of both ECUs and the latency histograms,
+ *  the user can then reset the histograms.
+ */
+void exportHistograms(void)
+{
+	/*	The wake counts of the HMI_ECU first, Control_ECU skips the text	*/
+	MULTIDROP_WAIT_TURN();
+	LINK_SET_TX_CHANNEL(LINK_CHANNEL_TELEMETRY);
+	Idle_send();
+	LINK_SEND();
+	UART_FLOW_SEND();
+	LINK_SET_TX_CHANNEL(LINK_CHANNEL_CONTROL);
+	/*	Control_ECU answers while it waits for the next password	*/
+	UART_sendByte(HISTOGRAM_REQUEST);
+
+	LCD_clearScreen();
+	LCD_displayString("Histograms sent");
+	LCD_moveCursor(1, 0);
+	LCD_displayString("+ : Reset");
+	/*	Any other key keeps them	*/
+	if(KEYPAD_getPressedKey()=='+')
+	{
+		MULTIDROP_WAIT_TURN();
+		UART_sendByte(HISTOGRAM_RESET);
+		LCD_clearScreen();
+		LCD_displayString("Histograms reset");
+		_delay_ms(1000);
+	}
+	_delay_ms(200);
+}
+
+/* Function to return the index of the highest link baud rate of this build */
+uint8 getMaxBaudIndex(void)
+{
+	uint8 index=0;
+	while(((index+1) < LINK_NUM_BAUD_RATES) && (g_linkBaudRates[index+1] <= LINK_MAX_BAUD))
+	{
+		index++;
+	}
+	return index;
+}
+
+/*	Function to agree on the highest link baud rate with the Control_ECU
+ *  and switch to it.
+ */
+void negotiateBaudRate(void)
+{
+	uint8 index=getMaxBaudIndex();
+
+	/*	Nothing to agree on, the link stays at its first rate	*/
+	if(index == LINK_START_BAUD_INDEX)
+	{
+		return;
+	}
+	UART_sendByte(BAUD_REQUEST);
+	UART_sendByte(index);
+	/*	Control_ECU answers the index both of them support	*/
+	while ( UART_recieveByte() != BAUD_REQUEST);
+	index=UART_recieveByte();
+	if((index == 0) || (index >= LINK_NUM_BAUD_RATES))
+	{
+		return;
+	}
+	UART_setBaudRate(g_linkBaudRates[index]);
+	/*	Control_ECU switches at the end of the stop bit of its answer	*/
+	_delay_ms(1);
+	/*	Start again at the new rate	*/
+	UART_sendByte(ECU_READY);
+	while ( UART_recieveByte() != ECU_READY);
+}
@@ -0,0 +1,162 @@
+ /******************************************************************************
+ *
+ * Module: Idle
+ *
+ * File Name: idle.c
+ *
+ * Description: Source file for the idle sleep of the ECU
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include "idle.h"
+#include <avr/pgmspace.h>	/* For the names in flash */
+#include "uart.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define IDLE_ECU_NAME				"HMI"
+#define IDLE_NAME_SIZE				10
+
+/* No ISR since the sleep started */
+#define IDLE_WAKE_NONE				0xFF
+
+/*******************************************************************************
+ *                      Names in Flash                                         *
+ *******************************************************************************/
+
+/* Indexed by Idle_WakeReason */
+static const char g_names[IDLE_NUM_WAKE_REASONS][IDLE_NAME_SIZE] PROGMEM = {
+		"TIMER1", "UART_RX", "UART_TX", "KEYPAD", "OTHER"
+};
+
+/*******************************************************************************
+ *                      Global Variables                                  *
+ *******************************************************************************/
+
+static volatile uint8 g_wakeReason = IDLE_WAKE_NONE;
+/* Changed with the interrupts disabled, in Idle_sleep() */
+static uint32 g_wakeCounts[IDLE_NUM_WAKE_REASONS];
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Send the number in decimal
+ */
+static void Idle_sendNumber(uint32 number);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Select the Idle sleep mode and enable the sleep instruction.
+ */
+void Idle_init(void)
+{
+	/* SM2:0 = 000 Idle, SE = 1 */
+	HAL_CLEAR_BITS(MCUCR, (1<<SM2) | (1<<SM1) | (1<<SM0));
+	HAL_SET_BIT(MCUCR, SE);
+}
+
+/*
+ * Description :
+ * Sleep till the next interrupt and count its wake reason.
+ * It must be called with the interrupts disabled, after checking the
+ * condition of the wait. It returns with the interrupts disabled.
+ */
+void Idle_sleep(void)
+{
+	uint8 reason;
+
+	g_wakeReason = IDLE_WAKE_NONE;
+	HAL_SLEEP();
+
+	reason = g_wakeReason;
+	if(reason == IDLE_WAKE_NONE)
+	{
+		reason = IDLE_WAKE_OTHER;
+	}
+	g_wakeCounts[reason]++;
+}
+
+/*
+ * Description :
+ * Called by the ISRs, the first one after a sleep is the wake reason.
+ */
+void Idle_noteWake(Idle_WakeReason reason)
+{
+	if(g_wakeReason == IDLE_WAKE_NONE)
+	{
+		g_wakeReason = reason;
+	}
+}
+
+/*
+ * Description :
+ * Return the number of sleeps ended by the reason.
+ */
+uint32 Idle_getWakeCount(Idle_WakeReason reason)
+{
+	uint32 count;
+	uint8 sreg = HAL_READ_REG(SREG);
+
+	cli();
+	count = g_wakeCounts[reason];
+	HAL_WRITE_REG(SREG, sreg);
+	return count;
+}
+
+/*
+ * Description :
+ * Send the wake counts over the UART as one text line :
+ * IDLE <ECU> <reason> <count> ... <reason> <count>
+ */
+void Idle_send(void)
+{
+	const char * name;
+	char c;
+	uint8 i;
+
+	UART_sendString((const uint8 *)"IDLE " IDLE_ECU_NAME);
+	for(i=0;i<IDLE_NUM_WAKE_REASONS;i++)
+	{
+		UART_sendByte(' ');
+		name = g_names[i];
+		while((c = pgm_read_byte(name++)) != '\0')
+		{
+			UART_sendByte(c);
+		}
+		UART_sendByte(' ');
+		Idle_sendNumber(Idle_getWakeCount(i));
+	}
+	UART_sendString((const uint8 *)"\r\n");
+}
+
+
+/*******************************************************************************
+ *                      Private Functions                                      *
+ *******************************************************************************/
+
+static void Idle_sendNumber(uint32 number)
+{
+	uint8 digits[10];
+	uint8 i = 0;
+
+	do
+	{
+		digits[i++] = '0' + (number % 10);
+		number /= 10;
+	}while(number != 0);
+
+	while(i > 0)
+	{
+		UART_sendByte(digits[--i]);
+	}
+}
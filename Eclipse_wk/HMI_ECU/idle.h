@@ -0,0 +1,95 @@
+ /******************************************************************************
+ *
+ * Module: Idle
+ *
+ * File Name: idle.h
+ *
+ * Description: Header file for the idle sleep of the ECU
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef IDLE_H_
+#define IDLE_H_
+
+#include "std_types.h"
+#include <avr/interrupt.h>		/* For cli() */
+#include "mcu_hal.h"			/* For SREG access */
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * The waits for an interrupt put the CPU in the Idle sleep mode : the
+ * timers and the UART keep running and wake it up. Each ISR tells which one it is with Idle_noteWake(), the
+ * first one after a sleep is counted as its wake reason.
+ */
+
+/*
+ * Sleep till the condition is true, it is checked with the interrupts
+ * disabled so the interrupt that makes it true can not be missed.
+ */
+#define IDLE_WAIT_UNTIL(CONDITION)						\
+	do{													\
+		uint8 idleSreg = HAL_READ_REG(SREG);			\
+		cli();											\
+		while(!(CONDITION))								\
+		{												\
+			Idle_sleep();								\
+		}												\
+		HAL_WRITE_REG(SREG, idleSreg);					\
+	}while(0)
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef enum{
+	IDLE_WAKE_TIMER1,
+	IDLE_WAKE_UART_RX,
+	IDLE_WAKE_UART_TX,			/* transmit ring */
+	IDLE_WAKE_KEYPAD,			/* Timer0 scan tick */
+	IDLE_WAKE_OTHER,			/* an ISR that does not call Idle_noteWake() */
+	IDLE_NUM_WAKE_REASONS
+}Idle_WakeReason;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Select the Idle sleep mode and enable the sleep instruction.
+ */
+void Idle_init(void);
+
+/*
+ * Description :
+ * Sleep till the next interrupt and count its wake reason.
+ * It must be called with the interrupts disabled, after checking the
+ * condition of the wait. It returns with the interrupts disabled.
+ */
+void Idle_sleep(void);
+
+/*
+ * Description :
+ * Called by the ISRs, the first one after a sleep is the wake reason.
+ */
+void Idle_noteWake(Idle_WakeReason reason);
+
+/*
+ * Description :
+ * Return the number of sleeps ended by the reason.
+ */
+uint32 Idle_getWakeCount(Idle_WakeReason reason);
+
+/*
+ * Description :
+ * Send the wake counts over the UART as one text line :
+ * IDLE <ECU> <reason> <count> ... <reason> <count>
+ */
+void Idle_send(void);
+
+#endif /* IDLE_H_ */
@@ -0,0 +1,188 @@
+ /******************************************************************************
+ *
+ * Module: Link
+ *
+ * File Name: link.h
+ *
+ * Description: Header file for the acknowledged transport over the UART link
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef LINK_H_
+#define LINK_H_
+
+#include "std_types.h"
+#include "queue.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * The transport is only built with LINK_ENABLE defined (-DLINK_ENABLE), then
+ * UART_sendByte() and UART_recieveByte() go through it and the bytes are sent
+ * in frames :
+ *
+ *   LINK_SOF, control, length, payload (0 --> LINK_MAX_PAYLOAD bytes), CRC-8
+ *
+ * length is the channel of the frame in the high nibble and the number of bytes
+ * of the payload in the low one. control is the sequence number of the frame in
+ * the high nibble and the acknowledge number of its channel in the low one :
+ * the next sequence number expected from the peer, all the frames before it are
+ * received (cumulative acknowledge). A frame without payload only acknowledges,
+ * it has no sequence number. The CRC-8 (polynomial 0x07) covers control, length
+ * and the payload.
+ *
+ * Each channel has its own sequence numbers : up to LINK_WINDOW_SIZE frames
+ * of a channel are sent without waiting for their acknowledge. The receiver
+ * only takes the next frame of the channel in order, a frame with a bad CRC or
+ * out of order is dropped and the sender sends the frames again from the oldest
+ * one when it is not acknowledged within LINK_RETRANSMIT_TIMEOUT (go-back-N).
+ * The receiver acknowledges each frame from the RX Complete ISR, so the
+ * acknowledges do not wait for the application.
+ *
+ * The frames go one at a time in the transmit ring of the UART, the next one
+ * is taken when it is empty, from the channel with the lowest number that has
+ * a frame to send (strict priority) : a command waits for one frame at most
+ * behind a dump. The control channel is read by UART_recieveByte(), a frame
+ * that does not fit in LINK_RX_BUFFER_SIZE is not acknowledged and sent again.
+ * The other channels are given to their call back, without one they are only
+ * acknowledged : their text is for the serial capture.
+ *
+ * The bytes sent while frames of the channel wait for their acknowledge are
+ * gathered in the next frame, it is sent with the acknowledge, once it is full
+ * or when the application waits for a byte.
+ *
+ * Timer1 must be initialized (1 second CTC cycle) and UART_init() called
+ * before Link_init(), the Timer1 alarm belongs to the transport.
+ */
+
+/* Start of a frame, the receiver looks for it after a bad frame */
+#define LINK_SOF						0x7E
+
+/* Less than 16, the length has 4 bits */
+#define LINK_MAX_PAYLOAD				8
+/* Less than 16, the sequence numbers have 4 bits */
+#define LINK_WINDOW_SIZE				4
+
+/* Bytes of the control channel received in order and not read yet, a power of 2 */
+#define LINK_RX_BUFFER_SIZE				32
+
+/* Time in Timer1 ticks of 32 us, a full window is 50 ms at 9600 baud */
+#define LINK_RETRANSMIT_TIMEOUT			3125	/* 100 ms */
+
+#ifdef LINK_ENABLE
+
+/* The acknowledges are sent from the ISR, the peer must not hold the line */
+#if defined(MULTIDROP_ENABLE) || defined(RS485_ENABLE)
+#error "The transport is point-to-point, without RS-485 transceivers"
+#endif
+#define LINK_INIT()						Link_init()
+#define LINK_SEND()						Link_send()
+#define LINK_SET_TX_CHANNEL(CHANNEL)	Link_setTxChannel(CHANNEL)
+
+#else
+
+#define LINK_INIT()
+#define LINK_SEND()
+#define LINK_SET_TX_CHANNEL(CHANNEL)
+
+#endif
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+/* By priority, the lowest number first */
+typedef enum{
+	LINK_CHANNEL_CONTROL,			/* passwords and commands, read by UART_recieveByte() */
+	LINK_CHANNEL_TELEMETRY,			/* statistics and histograms */
+	LINK_CHANNEL_TRACE,				/* trace and profiler dumps */
+	LINK_CHANNEL_CONSOLE,			/* maintenance console */
+	LINK_NUM_CHANNELS
+}Link_Channel;
+
+typedef enum{
+	LINK_STAT_FRAMES_SENT,			/* frames with a payload, the first time */
+	LINK_STAT_RETRANSMISSIONS,		/* frames sent again */
+	LINK_STAT_TIMEOUTS,				/* acknowledges not received in time */
+	LINK_STAT_BAD_FRAMES,			/* bad CRC or length, or a byte with errors */
+	LINK_STAT_DROPPED_FRAMES,		/* good frames out of order or without room */
+	LINK_NUM_STATS
+}Link_Stat;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Start with the sequence numbers at 0 and take the bytes received by the UART.
+ */
+void Link_init(void);
+
+/*
+ * Description :
+ * Add the byte to the next frame of the transmit channel, sleeping while the
+ * window of the channel is full.
+ */
+void Link_sendByte(uint8 data);
+
+/*
+ * Description :
+ * Set the channel of the bytes given to Link_sendByte(), the control channel
+ * after Link_init(). The bytes gathered for the previous one are still sent.
+ */
+void Link_setTxChannel(Link_Channel channel);
+
+/*
+ * Description :
+ * Set the function called from the RX Complete ISR with each byte received in
+ * order on the channel, not the control channel read by Link_receiveByte().
+ */
+void Link_setReceiveCallBack(Link_Channel channel,void(*a_ptr)(uint8));
+
+/*
+ * Description :
+ * Send the bytes gathered so far on the control channel, then sleep till a byte
+ * of the control channel is received in order.
+ */
+uint8 Link_receiveByte(void);
+
+/*
+ * Description :
+ * Keep the bytes read by Link_receiveByte() in the receive ring from now on,
+ * they stay at the front of Link_getReceiveQueue() till Link_releaseBytes().
+ */
+void Link_holdBytes(void);
+
+/*
+ * Description :
+ * Drop the bytes read since Link_holdBytes() from the receive ring, the next
+ * ones are dropped as they are read.
+ */
+void Link_releaseBytes(void);
+
+/*
+ * Description :
+ * Return the ring of the control channel, the bytes held by Link_holdBytes()
+ * are at its front. Only to read them in place.
+ */
+const Queue * Link_getReceiveQueue(void);
+
+/*
+ * Description :
+ * Return the counter of the transport since Link_init().
+ */
+uint16 Link_getStat(Link_Stat stat);
+
+/*
+ * Description :
+ * Send the counters over the UART as one text line :
+ * LINK <ECU> <counter> <value> ... <counter> <value>
+ */
+void Link_send(void);
+
+#endif /* LINK_H_ */
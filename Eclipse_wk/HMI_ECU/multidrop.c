@@ -0,0 +1,126 @@
+ /******************************************************************************
+ *
+ * Module: Multi-drop
+ *
+ * File Name: multidrop.c
+ *
+ * Description: Source file for the panel side of the multi-drop link
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifdef MULTIDROP_ENABLE
+
+#include "multidrop.h"
+#include "idle.h"			/* For the sleep till the poll */
+
+/*******************************************************************************
+ *                      Global Variables                                       *
+ *******************************************************************************/
+
+static uint8 g_address = 1;
+/* A request waits for the next poll of this panel */
+static volatile uint8 g_waitingFlag = FALSE;
+/* Polled with a request, the panel has the turn */
+static volatile uint8 g_selectedFlag = FALSE;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Called from the RX Complete ISR with each address frame
+ */
+static void Multidrop_addressCallBack(uint8 address);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Read the address of the panel from its jumpers and wait for the polls
+ * in the multi-processor mode, the UART must be initialized in MODE_9_BITS.
+ */
+void Multidrop_init(void)
+{
+	uint8 i;
+
+	g_address = 1;
+	for(i=0;i<MULTIDROP_NUM_JUMPERS;i++)
+	{
+		/* Input with the pull-up, a fitted jumper reads 0 */
+		GPIO_setupPinDirection(MULTIDROP_JUMPERS_PORT_ID, MULTIDROP_FIRST_JUMPER_PIN_ID+i, PIN_INPUT);
+		GPIO_writePin(MULTIDROP_JUMPERS_PORT_ID, MULTIDROP_FIRST_JUMPER_PIN_ID+i, LOGIC_HIGH);
+	}
+	for(i=0;i<MULTIDROP_NUM_JUMPERS;i++)
+	{
+		if(GPIO_readPin(MULTIDROP_JUMPERS_PORT_ID, MULTIDROP_FIRST_JUMPER_PIN_ID+i) == LOGIC_LOW)
+		{
+			g_address += (1<<i);
+		}
+	}
+
+	g_waitingFlag = FALSE;
+	g_selectedFlag = FALSE;
+	UART_setMultiProcessorMode(TRUE);
+	UART_setAddressCallBack(Multidrop_addressCallBack);
+}
+
+/*
+ * Description :
+ * Sleep till the Control_ECU polls this panel, the request is then sent
+ * as the answer to the poll and the panel keeps the turn till the
+ * Control_ECU addresses another one.
+ */
+void Multidrop_waitTurn(void)
+{
+	uint8 sreg = HAL_READ_REG(SREG);
+
+	/* Each request waits for a new poll, the turn of the previous one may be over */
+	cli();
+	g_selectedFlag = FALSE;
+	g_waitingFlag = TRUE;
+	UART_setMultiProcessorMode(TRUE);
+	HAL_WRITE_REG(SREG, sreg);
+
+	IDLE_WAIT_UNTIL(g_selectedFlag);
+}
+
+/*
+ * Description :
+ * Return the address of the panel, 1 --> 8.
+ */
+uint8 Multidrop_getAddress(void)
+{
+	return g_address;
+}
+
+
+/*******************************************************************************
+ *                      Private Functions                                      *
+ *******************************************************************************/
+
+static void Multidrop_addressCallBack(uint8 address)
+{
+	if(address != g_address)
+	{
+		/* Another panel has the turn, its data frames are ignored */
+		g_selectedFlag = FALSE;
+		UART_setMultiProcessorMode(TRUE);
+	}
+	else if(g_waitingFlag)
+	{
+		/* The request is the answer, the replies of the Control_ECU are received */
+		g_waitingFlag = FALSE;
+		g_selectedFlag = TRUE;
+		UART_setMultiProcessorMode(FALSE);
+	}
+	else
+	{
+		UART_sendByte(MULTIDROP_NO_REQUEST);
+	}
+}
+
+#endif /* MULTIDROP_ENABLE */
@@ -0,0 +1,84 @@
+ /******************************************************************************
+ *
+ * Module: Multi-drop
+ *
+ * File Name: multidrop.h
+ *
+ * Description: Header file for the panel side of the multi-drop link
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef MULTIDROP_H_
+#define MULTIDROP_H_
+
+#include "std_types.h"
+#include "uart.h"
+#include "gpio.h"			/* For the jumper pins */
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * The multi-drop link is only built with MULTIDROP_ENABLE defined
+ * (-DMULTIDROP_ENABLE), without it the link is point-to-point and the
+ * macros below are empty.
+ *
+ * Up to 8 panels share the link of the Control_ECU, each one answers the
+ * address 1 + the jumpers fitted on PB0..PB2 (a fitted jumper ties the pin
+ * to ground, the internal pull-up reads 1 without it). Till it is polled
+ * the panel stays in the multi-processor mode and ignores the data frames
+ * sent to the others. A poll is answered from the RX Complete ISR :
+ * MULTIDROP_NO_REQUEST, or the first byte of the request waiting in
+ * MULTIDROP_WAIT_TURN(), which must come before each request to the Control_ECU.
+ */
+
+#define MULTIDROP_JUMPERS_PORT_ID		PORTB_ID
+#define MULTIDROP_FIRST_JUMPER_PIN_ID	PIN0_ID
+#define MULTIDROP_NUM_JUMPERS			3
+
+/* Answer of a polled panel with nothing to send */
+#define MULTIDROP_NO_REQUEST			0x15
+
+#ifdef MULTIDROP_ENABLE
+
+#define MULTIDROP_UART_BITS				MODE_9_BITS
+#define MULTIDROP_INIT()				Multidrop_init()
+#define MULTIDROP_WAIT_TURN()			Multidrop_waitTurn()
+
+#else
+
+#define MULTIDROP_UART_BITS				MODE_8_BITS
+#define MULTIDROP_INIT()
+#define MULTIDROP_WAIT_TURN()
+
+#endif
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Read the address of the panel from its jumpers and wait for the polls
+ * in the multi-processor mode, the UART must be initialized in MODE_9_BITS.
+ */
+void Multidrop_init(void);
+
+/*
+ * Description :
+ * Sleep till the Control_ECU polls this panel, the request is then sent
+ * as the answer to the poll and the panel keeps the turn till the
+ * Control_ECU addresses another one.
+ */
+void Multidrop_waitTurn(void);
+
+/*
+ * Description :
+ * Return the address of the panel, 1 --> 8.
+ */
+uint8 Multidrop_getAddress(void);
+
+#endif /* MULTIDROP_H_ */
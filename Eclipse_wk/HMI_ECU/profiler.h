@@ -0,0 +1,116 @@
+ /******************************************************************************
+ *
+ * Module: Profiler
+ *
+ * File Name: profiler.h
+ *
+ * Description: Header file for the Timer1 based profiler of the code regions
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * The profiler is only built with PROFILER_ENABLE defined (-DPROFILER_ENABLE),
+ * without it the macros below are empty and the regions cost nothing.
+ *
+ * The regions are timed with TCNT1, Timer1 must be initialized before
+ * PROFILER_INIT(). One tick is the Timer1 prescaler in CPU cycles (256 with
+ * the 1 second CTC configuration), a region must last less than one Timer1
+ * cycle and must not be entered again before its exit.
+ */
+
+/* Enter/exit records kept in RAM, the oldest one is overwritten */
+#define PROFILER_RING_SIZE			32
+
+/* Byte sent to the CONTROL_ECU to request its dump, while the password is awaited */
+#define PROFILER_DUMP_REQUEST		0x10
+
+#ifdef PROFILER_ENABLE
+
+#define PROFILER_INIT()				Profiler_init()
+#define PROFILER_ENTER(REGION)		Profiler_enter(REGION)
+#define PROFILER_EXIT(REGION)		Profiler_exit(REGION)
+#define PROFILER_DUMP()				Profiler_dump()
+
+#else
+
+#define PROFILER_INIT()
+#define PROFILER_ENTER(REGION)
+#define PROFILER_EXIT(REGION)
+#define PROFILER_DUMP()
+
+#endif
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef enum{
+	PROFILER_UART_RECEIVE_FRAME,
+	PROFILER_LCD_SEND_COMMAND,
+	PROFILER_LCD_DISPLAY_CHARACTER,
+	PROFILER_NUM_REGIONS
+}Profiler_RegionId;
+
+typedef struct{
+	uint16 count;
+	uint32 totalTicks;
+	uint16 maxTicks;
+}Profiler_RegionStats;
+
+/* The bit 7 of region is set for an exit */
+typedef struct{
+	uint8 region;
+	uint16 timestamp;
+}Profiler_Record;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+#ifdef PROFILER_ENABLE
+
+/*
+ * Description :
+ * Clear the regions and the records, and read the Timer1 cycle length.
+ */
+void Profiler_init(void);
+
+/*
+ * Description :
+ * Record the entry of the region with the current TCNT1.
+ */
+void Profiler_enter(Profiler_RegionId region);
+
+/*
+ * Description :
+ * Record the exit of the region and add its time to the region statistics.
+ */
+void Profiler_exit(Profiler_RegionId region);
+
+/*
+ * Description :
+ * Copy the statistics of the region.
+ */
+void Profiler_getRegion(Profiler_RegionId region,Profiler_RegionStats * stats);
+
+/*
+ * Description :
+ * Send the statistics of the regions then the records, oldest first,
+ * as text lines over the UART.
+ */
+void Profiler_dump(void);
+
+#endif /* PROFILER_ENABLE */
+
+#endif /* PROFILER_H_ */
@@ -0,0 +1,187 @@
+ /******************************************************************************
+ *
+ * Module: Queue
+ *
+ * File Name: queue.c
+ *
+ * Description: Source file for the single producer single consumer queue
+ *              between an ISR and the main loop
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include "queue.h"
+#include "mcu_hal.h"		/* For the acquire/release accesses of the counters */
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Copy size bytes from source to destination
+ */
+static void Queue_copy(uint8 * destination,const uint8 * source,uint8 size);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Empty the queue and give it its buffer of QUEUE_BUFFER_SIZE(element_size, capacity)
+ * bytes. It is called while neither side uses the queue.
+ */
+void Queue_init(Queue * queue,void * buffer,uint8 element_size,uint8 capacity)
+{
+	queue->buffer = (uint8 *)buffer;
+	queue->elementSize = element_size;
+	queue->mask = capacity - 1;
+	queue->head = 0;
+	queue->tail = 0;
+}
+
+/*
+ * Description :
+ * Copy the element at the head and return TRUE, or return FALSE if the queue
+ * is full (producer side).
+ */
+uint8 Queue_put(Queue * queue,const void * element)
+{
+	uint8 head = queue->head;
+
+	/* The consumer has read the places it gave back before they are written */
+	if((uint8)(head - HAL_LOAD_ACQUIRE(queue->tail)) > queue->mask)
+	{
+		return FALSE;
+	}
+	Queue_copy(&queue->buffer[(head & queue->mask) * queue->elementSize],
+			(const uint8 *)element, queue->elementSize);
+	/* The element is written before the consumer can see it */
+	HAL_STORE_RELEASE(queue->head, head + 1);
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Copy the element at the tail out and take it, or return FALSE if the queue
+ * is empty (consumer side).
+ */
+uint8 Queue_get(Queue * queue,void * element)
+{
+	if(!Queue_peek(queue, element))
+	{
+		return FALSE;
+	}
+	Queue_drop(queue);
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Copy the element at the tail out and leave it in the queue, or return FALSE
+ * if the queue is empty (consumer side).
+ */
+uint8 Queue_peek(const Queue * queue,void * element)
+{
+	uint8 tail = queue->tail;
+
+	/* The head is read before the element it covers */
+	if(HAL_LOAD_ACQUIRE(queue->head) == tail)
+	{
+		return FALSE;
+	}
+	Queue_copy((uint8 *)element,
+			&queue->buffer[(tail & queue->mask) * queue->elementSize], queue->elementSize);
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Take the element at the tail without a copy, the queue must not be empty
+ * (consumer side).
+ */
+void Queue_drop(Queue * queue)
+{
+	Queue_dropCount(queue, 1);
+}
+
+/*
+ * Description :
+ * Take count elements at the tail without a copy, the queue must hold them
+ * (consumer side).
+ */
+void Queue_dropCount(Queue * queue,uint8 count)
+{
+	/* The elements are read before the producer can write over them */
+	HAL_STORE_RELEASE(queue->tail, queue->tail + count);
+}
+
+/*
+ * Description :
+ * Return the address of the element index places after the tail, it stays in
+ * the queue, or NULL_PTR if the queue holds index elements or less (consumer side).
+ */
+const void * Queue_at(const Queue * queue,uint8 index)
+{
+	uint8 tail = queue->tail;
+
+	/* The head is read before the element it covers */
+	if((uint8)(HAL_LOAD_ACQUIRE(queue->head) - tail) <= index)
+	{
+		return NULL_PTR;
+	}
+	return &queue->buffer[((uint8)(tail + index) & queue->mask) * queue->elementSize];
+}
+
+/*
+ * Description :
+ * Return the number of places from the tail to the end of the buffer, the
+ * elements after them are at its start (consumer side).
+ */
+uint8 Queue_contiguous(const Queue * queue)
+{
+	return (uint8)(queue->mask + 1 - (queue->tail & queue->mask));
+}
+
+/*
+ * Description :
+ * Return the number of elements in the queue, the other side can change it
+ * right after.
+ */
+uint8 Queue_count(const Queue * queue)
+{
+	return (uint8)(HAL_LOAD_ACQUIRE(queue->head) - HAL_LOAD_ACQUIRE(queue->tail));
+}
+
+/*
+ * Description :
+ * Return the number of elements that can still be put (producer side).
+ */
+uint8 Queue_room(const Queue * queue)
+{
+	return (uint8)(queue->mask + 1 - Queue_count(queue));
+}
+
+/*
+ * Description :
+ * Return TRUE if the queue holds no element.
+ */
+uint8 Queue_isEmpty(const Queue * queue)
+{
+	return (HAL_LOAD_ACQUIRE(queue->head) == HAL_LOAD_ACQUIRE(queue->tail));
+}
+
+/*******************************************************************************
+ *                      Private Functions                                      *
+ *******************************************************************************/
+
+static void Queue_copy(uint8 * destination,const uint8 * source,uint8 size)
+{
+	uint8 i;
+
+	for(i=0;i<size;i++)
+	{
+		destination[i] = source[i];
+	}
+}
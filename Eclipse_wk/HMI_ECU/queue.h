@@ -0,0 +1,130 @@
+ /******************************************************************************
+ *
+ * Module: Queue
+ *
+ * File Name: queue.h
+ *
+ * Description: Header file for the single producer single consumer queue
+ *              between an ISR and the main loop
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef QUEUE_H_
+#define QUEUE_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Fixed size ring of elements of any size, one side puts and the other side
+ * takes, an ISR on one of them and the main loop on the other. head counts the
+ * elements put and is only written by the producer, tail counts the elements
+ * taken and is only written by the consumer : both are 8-bit, read and written
+ * in one instruction, so neither side disables the interrupts. The capacity is
+ * a power of 2 up to 128, the counters wrap around and all the places are used.
+ */
+
+/* Bytes of the buffer given to Queue_init() */
+#define QUEUE_BUFFER_SIZE(ELEMENT_SIZE,CAPACITY)	((ELEMENT_SIZE) * (CAPACITY))
+
+/* For #if checks of the capacities */
+#define QUEUE_IS_CAPACITY(CAPACITY)		(((CAPACITY) >= 1) && ((CAPACITY) <= 128) && \
+										(((CAPACITY) & ((CAPACITY) - 1)) == 0))
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef struct{
+	uint8 * buffer;
+	uint8 elementSize;
+	uint8 mask;					/* capacity - 1 */
+	volatile uint8 head;		/* elements put, written by the producer */
+	volatile uint8 tail;		/* elements taken, written by the consumer */
+}Queue;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Empty the queue and give it its buffer of QUEUE_BUFFER_SIZE(element_size, capacity)
+ * bytes. It is called while neither side uses the queue.
+ */
+void Queue_init(Queue * queue,void * buffer,uint8 element_size,uint8 capacity);
+
+/*
+ * Description :
+ * Copy the element at the head and return TRUE, or return FALSE if the queue
+ * is full (producer side).
+ */
+uint8 Queue_put(Queue * queue,const void * element);
+
+/*
+ * Description :
+ * Copy the element at the tail out and take it, or return FALSE if the queue
+ * is empty (consumer side).
+ */
+uint8 Queue_get(Queue * queue,void * element);
+
+/*
+ * Description :
+ * Copy the element at the tail out and leave it in the queue, or return FALSE
+ * if the queue is empty (consumer side).
+ */
+uint8 Queue_peek(const Queue * queue,void * element);
+
+/*
+ * Description :
+ * Take the element at the tail without a copy, the queue must not be empty
+ * (consumer side).
+ */
+void Queue_drop(Queue * queue);
+
+/*
+ * Description :
+ * Take count elements at the tail without a copy, the queue must hold them
+ * (consumer side).
+ */
+void Queue_dropCount(Queue * queue,uint8 count);
+
+/*
+ * Description :
+ * Return the address of the element index places after the tail, it stays in
+ * the queue, or NULL_PTR if the queue holds index elements or less (consumer side).
+ */
+const void * Queue_at(const Queue * queue,uint8 index);
+
+/*
+ * Description :
+ * Return the number of places from the tail to the end of the buffer, the
+ * elements after them are at its start (consumer side).
+ */
+uint8 Queue_contiguous(const Queue * queue);
+
+/*
+ * Description :
+ * Return the number of elements in the queue, the other side can change it
+ * right after.
+ */
+uint8 Queue_count(const Queue * queue);
+
+/*
+ * Description :
+ * Return the number of elements that can still be put (producer side).
+ */
+uint8 Queue_room(const Queue * queue);
+
+/*
+ * Description :
+ * Return TRUE if the queue holds no element.
+ */
+uint8 Queue_isEmpty(const Queue * queue);
+
+#endif /* QUEUE_H_ */
@@ -0,0 +1,130 @@
+ /******************************************************************************
+ *
+ * Module: Stack Monitor
+ *
+ * File Name: stack_monitor.c
+ *
+ * Description: Source file for the stack high-water mark of the ECU
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include "stack_monitor.h"
+#include "mcu_hal.h"			/* For HOST_BUILD and the simulator */
+
+/*******************************************************************************
+ *                      Linker Symbols                                         *
+ *******************************************************************************/
+
+#ifndef HOST_BUILD
+/* Set by the avr-gcc linker script */
+extern uint8 _end;				/* End of .bss and .noinit */
+extern uint8 __stack;			/* RAMEND, first byte of the stack */
+#endif
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Return the bottom and the top of the painted area
+ */
+static void StackMonitor_getArea(const uint8 ** bottom,const uint8 ** top);
+
+/*
+ * Return the deepest byte of stack used
+ */
+static const uint8 * StackMonitor_getDeepest(void);
+
+#ifndef HOST_BUILD
+/*
+ * Paint the free SRAM, before the stack is used : no prologue, no locals
+ */
+void StackMonitor_paint(void) __attribute__ ((naked, used, section (".init1")));
+#endif
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Return the most bytes of stack used since power on.
+ */
+uint16 StackMonitor_getMaxUsage(void)
+{
+	const uint8 * bottom;
+	const uint8 * top;
+	uint32 used;
+
+	StackMonitor_getArea(&bottom, &top);
+	used = (uint32)(top - StackMonitor_getDeepest()) + 1;
+	/* The host stack may be larger */
+	return (used > 0xFFFF) ? 0xFFFF : (uint16)used;
+}
+
+/*
+ * Description :
+ * Return the bytes between the end of the static variables and the deepest
+ * stack since power on, the margin left before the stack overwrites them.
+ */
+uint16 StackMonitor_getFree(void)
+{
+	const uint8 * bottom;
+	const uint8 * top;
+	uint32 free;
+
+	StackMonitor_getArea(&bottom, &top);
+	free = (uint32)(StackMonitor_getDeepest() - bottom);
+	return (free > 0xFFFF) ? 0xFFFF : (uint16)free;
+}
+
+
+/*******************************************************************************
+ *                      Private Functions                                      *
+ *******************************************************************************/
+
+static void StackMonitor_getArea(const uint8 ** bottom,const uint8 ** top)
+{
+#ifndef HOST_BUILD
+	*bottom = &_end;
+	*top = &__stack;
+#else
+	Sim_getStack(bottom, top);
+#endif
+}
+
+static const uint8 * StackMonitor_getDeepest(void)
+{
+	const uint8 * bottom;
+	const uint8 * top;
+
+	StackMonitor_getArea(&bottom, &top);
+	while((bottom < top) && (*bottom == STACK_MONITOR_CANARY))
+	{
+		bottom++;
+	}
+	return bottom;
+}
+
+#ifndef HOST_BUILD
+void StackMonitor_paint(void)
+{
+	/* Z runs from _end to __stack, both included */
+	__asm__ volatile (
+			"	ldi r30, lo8(_end)		\n"
+			"	ldi r31, hi8(_end)		\n"
+			"	ldi r24, %0				\n"
+			"	ldi r25, hi8(__stack)	\n"
+			"	rjmp 2f					\n"
+			"1:	st Z+, r24				\n"
+			"2:	cpi r30, lo8(__stack)	\n"
+			"	cpc r31, r25			\n"
+			"	brlo 1b					\n"
+			"	breq 1b					\n"
+			:
+			: "i" (STACK_MONITOR_CANARY)
+	);
+}
+#endif
@@ -0,0 +1,49 @@
+ /******************************************************************************
+ *
+ * Module: Stack Monitor
+ *
+ * File Name: stack_monitor.h
+ *
+ * Description: Header file for the stack high-water mark of the ECU
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef STACK_MONITOR_H_
+#define STACK_MONITOR_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * The free SRAM, from the end of .bss/.noinit to RAMEND, is painted with
+ * STACK_MONITOR_CANARY before main(), in the .init1 section of the startup
+ * code. The deepest stack is the first byte from the bottom that is not
+ * the canary any more. A stack byte equal to the canary hides itself,
+ * the high-water mark may be a few bytes short.
+ * In the host build the simulator paints the stack of the ECU coroutine.
+ */
+#define STACK_MONITOR_CANARY		0xC5
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Return the most bytes of stack used since power on.
+ */
+uint16 StackMonitor_getMaxUsage(void);
+
+/*
+ * Description :
+ * Return the bytes between the end of the static variables and the deepest
+ * stack since power on, the margin left before the stack overwrites them.
+ */
+uint16 StackMonitor_getFree(void);
+
+#endif /* STACK_MONITOR_H_ */
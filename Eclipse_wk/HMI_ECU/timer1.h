@@ -1,58 +1,110 @@
-/*
- * timer.h
- *
- *  Created on: Oct 27, 2022
- *      Author: Omar Elsherif
- */
-
-#ifndef TIMER1_H_
-#define TIMER1_H_
-
-#include"std_types.h"
-
-
-/*******************************************************************************
- *                      Configuration                                          *
- *******************************************************************************/
-
-typedef enum{
-	NO_CLK,F_CPU_1, F_CPU_8,F_CPU_64, F_CPU_256, F_CPU_1024, EXTERNAL_CLK_T1_FALLING,EXTERNAL_CLK_T1_RISING
-}Timer1_Prescaler;
-
-typedef enum{
-	NORMAL_MODE, CTC_MODE=0x04
-}Timer1_Mode;
-
-
-typedef struct {
- uint16 initial_value;
- Timer1_Mode mode;
- Timer1_Prescaler prescaler;
- uint16 compare_value; // it will be used in compare mode only.
-}Timer1_ConfigType;
-
-
-
-/*******************************************************************************
- *                      Functions Prototypes                                   *
- *******************************************************************************/
-
-/*
- * Description :
- * Function to initialize the Timer driver.
- */
-void Timer1_init(const Timer1_ConfigType * TIMER1_Config);
-
-/*
- * Description :
- * Function to disable the Timer1
- */
-void Timer1_deInit(void);
-
-/*
- * Description :
- * Function to set the Call Back function address.
- */
-void Timer1_setCallBack(void(*a_ptr)(void));
-
-#endif /* TIMER1_H_ */
+/*
+ * timer.h
+ *
+ *  Created on: Oct 27, 2022
+ *      Author: Omar Elsherif
+ */
+
+#ifndef TIMER1_H_
+#define TIMER1_H_
+
+#include"std_types.h"
+
+
+/*******************************************************************************
+ *                      Configuration                                          *
+ *******************************************************************************/
+
+typedef enum{
+	NO_CLK,F_CPU_1, F_CPU_8,F_CPU_64, F_CPU_256, F_CPU_1024, EXTERNAL_CLK_T1_FALLING,EXTERNAL_CLK_T1_RISING
+}Timer1_Prescaler;
+
+typedef enum{
+	NORMAL_MODE, CTC_MODE=0x04
+}Timer1_Mode;
+
+
+typedef enum{
+	CAPTURE_FALLING_EDGE,CAPTURE_RISING_EDGE
+}Timer1_CaptureEdge;
+
+typedef struct {
+ uint16 initial_value;
+ Timer1_Mode mode;
+ Timer1_Prescaler prescaler;
+ uint16 compare_value; // it will be used in compare mode only.
+}Timer1_ConfigType;
+
+
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Function to initialize the Timer driver.
+ */
+void Timer1_init(const Timer1_ConfigType * TIMER1_Config);
+
+/*
+ * Description :
+ * Function to disable the Timer1
+ */
+void Timer1_deInit(void);
+
+/*
+ * Description :
+ * Function to set the Call Back function address.
+ */
+void Timer1_setCallBack(void(*a_ptr)(void));
+
+/*
+ * Description :
+ * Function to return the current value of the timer counter.
+ */
+uint16 Timer1_getCount(void);
+
+/*
+ * Description :
+ * Function to start capturing the timer on the required edge of ICP1 (PD6).
+ * The capture works in CTC mode too, so the timer can keep its compare interrupt.
+ */
+void Timer1_enableInputCapture(Timer1_CaptureEdge edge);
+
+/*
+ * Description :
+ * Function to stop the input capture.
+ */
+void Timer1_disableInputCapture(void);
+
+/*
+ * Description :
+ * Function to set the Call Back function address of the input capture.
+ * It is called from the ISR with the timer ticks passed since the previous capture,
+ * the period is only valid if it is less than one timer cycle.
+ */
+void Timer1_setCaptureCallBack(void(*a_ptr)(uint16));
+
+/*
+ * Description :
+ * Function to start a one shot alarm on the compare B match, the ticks from now
+ * must be less than one timer cycle. It works in CTC mode too, next to the
+ * compare A interrupt, starting it again moves the alarm.
+ */
+void Timer1_startAlarm(uint16 ticks);
+
+/*
+ * Description :
+ * Function to cancel the alarm if it did not ring yet.
+ */
+void Timer1_stopAlarm(void);
+
+/*
+ * Description :
+ * Function to set the Call Back function address of the alarm.
+ * It is called from the ISR, once for each Timer1_startAlarm().
+ */
+void Timer1_setAlarmCallBack(void(*a_ptr)(void));
+
+#endif /* TIMER1_H_ */
@@ -0,0 +1,25 @@
+ /******************************************************************************
+ *
+ * Module: Host Simulator
+ *
+ * File Name: interrupt.h
+ *
+ * Description: <avr/interrupt.h> of the host build. An ISR is a plain
+ *              function named as its vector, the simulator finds it in the
+ *              ECU library and calls it when the interrupt is served.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef SIM_AVR_INTERRUPT_H_
+#define SIM_AVR_INTERRUPT_H_
+
+#include "sim_registers.h"
+
+#define ISR(VECTOR)		void VECTOR(void); void VECTOR(void)
+
+#define sei()			Sim_setInterruptEnable(1)
+#define cli()			Sim_setInterruptEnable(0)
+
+#endif /* SIM_AVR_INTERRUPT_H_ */
@@ -0,0 +1,260 @@
+ /******************************************************************************
+ *
+ * Module: Host Simulator
+ *
+ * File Name: io.h
+ *
+ * Description: <avr/io.h> of the host build, the register names of the
+ *              ATmega32 are mapped on the simulated registers and the bit
+ *              names keep their ATmega32 positions.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef SIM_AVR_IO_H_
+#define SIM_AVR_IO_H_
+
+#include "sim_registers.h"
+
+/*******************************************************************************
+ *                                Registers                                    *
+ *******************************************************************************/
+
+#define SREG    SIM_REGISTER(SREG)
+#define PORTA   SIM_REGISTER(PORTA)
+#define DDRA    SIM_REGISTER(DDRA)
+#define PINA    SIM_REGISTER(PINA)
+#define PORTB   SIM_REGISTER(PORTB)
+#define DDRB    SIM_REGISTER(DDRB)
+#define PINB    SIM_REGISTER(PINB)
+#define PORTC   SIM_REGISTER(PORTC)
+#define DDRC    SIM_REGISTER(DDRC)
+#define PINC    SIM_REGISTER(PINC)
+#define PORTD   SIM_REGISTER(PORTD)
+#define DDRD    SIM_REGISTER(DDRD)
+#define PIND    SIM_REGISTER(PIND)
+#define UCSRA   SIM_REGISTER(UCSRA)
+#define UCSRB   SIM_REGISTER(UCSRB)
+#define UCSRC   SIM_REGISTER(UCSRC)
+#define UBRRH   SIM_REGISTER(UBRRH)
+#define UBRRL   SIM_REGISTER(UBRRL)
+#define UDR     SIM_REGISTER(UDR)
+#define TWBR    SIM_REGISTER(TWBR)
+#define TWSR    SIM_REGISTER(TWSR)
+#define TWAR    SIM_REGISTER(TWAR)
+#define TWDR    SIM_REGISTER(TWDR)
+#define TWCR    SIM_REGISTER(TWCR)
+#define TCCR0   SIM_REGISTER(TCCR0)
+#define TCNT0   SIM_REGISTER(TCNT0)
+#define OCR0    SIM_REGISTER(OCR0)
+#define TCCR2   SIM_REGISTER(TCCR2)
+#define TCNT2   SIM_REGISTER(TCNT2)
+#define OCR2    SIM_REGISTER(OCR2)
+#define ASSR    SIM_REGISTER(ASSR)
+#define TCCR1A  SIM_REGISTER(TCCR1A)
+#define TCCR1B  SIM_REGISTER(TCCR1B)
+#define TCNT1   SIM_REGISTER(TCNT1)
+#define OCR1A   SIM_REGISTER(OCR1A)
+#define OCR1B   SIM_REGISTER(OCR1B)
+#define ICR1    SIM_REGISTER(ICR1)
+#define TIMSK   SIM_REGISTER(TIMSK)
+#define TIFR    SIM_REGISTER(TIFR)
+#define GICR    SIM_REGISTER(GICR)
+#define GIFR    SIM_REGISTER(GIFR)
+#define MCUCR   SIM_REGISTER(MCUCR)
+#define MCUCSR  SIM_REGISTER(MCUCSR)
+#define ADMUX   SIM_REGISTER(ADMUX)
+#define ADCSRA  SIM_REGISTER(ADCSRA)
+#define ADC     SIM_REGISTER(ADC)
+#define SFIOR   SIM_REGISTER(SFIOR)
+
+/*******************************************************************************
+ *                                Bits                                         *
+ *******************************************************************************/
+
+/* UCSRA */
+#define RXC     7
+#define TXC     6
+#define UDRE    5
+#define FE      4
+#define DOR     3
+#define PE      2
+#define U2X     1
+#define MPCM    0
+
+/* UCSRB */
+#define RXCIE   7
+#define TXCIE   6
+#define UDRIE   5
+#define RXEN    4
+#define TXEN    3
+#define UCSZ2   2
+#define RXB8    1
+#define TXB8    0
+
+/* UCSRC */
+#define URSEL   7
+#define UMSEL   6
+#define UPM1    5
+#define UPM0    4
+#define USBS    3
+#define UCSZ1   2
+#define UCSZ0   1
+#define UCPOL   0
+
+/* TWCR */
+#define TWINT   7
+#define TWEA    6
+#define TWSTA   5
+#define TWSTO   4
+#define TWWC    3
+#define TWEN    2
+#define TWIE    0
+
+/* TWSR */
+#define TWPS1   1
+#define TWPS0   0
+
+/* TCCR0 */
+#define FOC0    7
+#define WGM00   6
+#define COM01   5
+#define COM00   4
+#define WGM01   3
+#define CS02    2
+#define CS01    1
+#define CS00    0
+
+/* TCCR2 */
+#define FOC2    7
+#define WGM20   6
+#define COM21   5
+#define COM20   4
+#define WGM21   3
+#define CS22    2
+#define CS21    1
+#define CS20    0
+
+/* TCCR1A */
+#define COM1A1  7
+#define COM1A0  6
+#define COM1B1  5
+#define COM1B0  4
+#define FOC1A   3
+#define FOC1B   2
+#define WGM11   1
+#define WGM10   0
+
+/* TCCR1B */
+#define ICNC1   7
+#define ICES1   6
+#define WGM13   4
+#define WGM12   3
+#define CS12    2
+#define CS11    1
+#define CS10    0
+
+/* TIMSK */
+#define OCIE2   7
+#define TOIE2   6
+#define TICIE1  5
+#define OCIE1A  4
+#define OCIE1B  3
+#define TOIE1   2
+#define OCIE0   1
+#define TOIE0   0
+
+/* TIFR */
+#define OCF2    7
+#define TOV2    6
+#define ICF1    5
+#define OCF1A   4
+#define OCF1B   3
+#define TOV1    2
+#define OCF0    1
+#define TOV0    0
+
+/* GICR */
+#define INT1    7
+#define INT0    6
+#define INT2    5
+
+/* GIFR */
+#define INTF1   7
+#define INTF0   6
+#define INTF2   5
+
+/* MCUCR */
+#define SE      7
+#define SM2     6
+#define SM1     5
+#define SM0     4
+#define ISC11   3
+#define ISC10   2
+#define ISC01   1
+#define ISC00   0
+
+/* MCUCSR */
+#define ISC2    6
+
+/* ADMUX */
+#define REFS1   7
+#define REFS0   6
+#define ADLAR   5
+#define MUX4    4
+#define MUX3    3
+#define MUX2    2
+#define MUX1    1
+#define MUX0    0
+
+/* ADCSRA */
+#define ADEN    7
+#define ADSC    6
+#define ADATE   5
+#define ADIF    4
+#define ADIE    3
+#define ADPS2   2
+#define ADPS1   1
+#define ADPS0   0
+
+/* SFIOR */
+#define ADTS2   7
+#define ADTS1   6
+#define ADTS0   5
+
+/* Port pins */
+#define PA0     0
+#define PA1     1
+#define PA2     2
+#define PA3     3
+#define PA4     4
+#define PA5     5
+#define PA6     6
+#define PA7     7
+#define PB0     0
+#define PB1     1
+#define PB2     2
+#define PB3     3
+#define PB4     4
+#define PB5     5
+#define PB6     6
+#define PB7     7
+#define PC0     0
+#define PC1     1
+#define PC2     2
+#define PC3     3
+#define PC4     4
+#define PC5     5
+#define PC6     6
+#define PC7     7
+#define PD0     0
+#define PD1     1
+#define PD2     2
+#define PD3     3
+#define PD4     4
+#define PD5     5
+#define PD6     6
+#define PD7     7
+
+#endif /* SIM_AVR_IO_H_ */
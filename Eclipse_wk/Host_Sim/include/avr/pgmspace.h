@@ -0,0 +1,23 @@
+ /******************************************************************************
+ *
+ * Module: Host Simulator
+ *
+ * File Name: pgmspace.h
+ *
+ * Description: <avr/pgmspace.h> of the host build, flash data is plain memory.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef SIM_AVR_PGMSPACE_H_
+#define SIM_AVR_PGMSPACE_H_
+
+#include <stdint.h>
+
+#define PROGMEM
+
+#define pgm_read_byte(ADDRESS)		(*(const uint8_t *)(ADDRESS))
+#define pgm_read_word(ADDRESS)		(*(const uint16_t *)(ADDRESS))
+
+#endif /* SIM_AVR_PGMSPACE_H_ */
@@ -0,0 +1,98 @@
+ /******************************************************************************
+ *
+ * Module: Host Simulator
+ *
+ * File Name: sim_registers.h
+ *
+ * Description: Registers of the simulated ATmega32, as seen by the ECU code
+ *              built with HOST_BUILD. mcu_hal.h maps the register accesses of
+ *              the drivers on the functions declared here.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef SIM_REGISTERS_H_
+#define SIM_REGISTERS_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* All the simulated registers, X(name) is expanded for each one */
+#define SIM_REGISTERS(X) \
+	X(SREG)   X(PORTA)  X(DDRA)   X(PINA)   X(PORTB)  X(DDRB)   X(PINB)   \
+	X(PORTC)  X(DDRC)   X(PINC)   X(PORTD)  X(DDRD)   X(PIND)   \
+	X(UCSRA)  X(UCSRB)  X(UCSRC)  X(UBRRH)  X(UBRRL)  X(UDR)    \
+	X(TWBR)   X(TWSR)   X(TWAR)   X(TWDR)   X(TWCR)   \
+	X(TCCR0)  X(TCNT0)  X(OCR0)   X(TCCR2)  X(TCNT2)  X(OCR2)   X(ASSR)   \
+	X(TCCR1A) X(TCCR1B) X(TCNT1)  X(OCR1A)  X(OCR1B)  X(ICR1)   \
+	X(TIMSK)  X(TIFR)   X(GICR)   X(GIFR)   X(MCUCR)  X(MCUCSR) \
+	X(ADMUX)  X(ADCSRA) X(ADC)    X(SFIOR)
+
+#define SIM_REGISTER_ID(NAME)	SIM_##NAME,
+
+/* A register is a small struct, so the ECU code can not read or write it
+ * directly by mistake, it has to go through the HAL macros */
+#define SIM_REGISTER(NAME)		((Sim_Register){SIM_##NAME})
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef enum{
+	SIM_REGISTERS(SIM_REGISTER_ID)
+	SIM_NUM_REGISTERS
+}Sim_RegisterId;
+
+typedef struct{
+	uint8_t id;		/* Sim_RegisterId */
+}Sim_Register;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Access a register of the ECU running now, the simulated time advances
+ * by the access time and the pending interrupts are served.
+ */
+uint8_t Sim_readRegister(Sim_Register reg);
+void Sim_writeRegister(Sim_Register reg,uint8_t value);
+
+/*
+ * Description :
+ * Access a 16-bit register (TCNT1, OCR1A, OCR1B, ICR1, ADC).
+ */
+uint16_t Sim_readRegister16(Sim_Register reg);
+void Sim_writeRegister16(Sim_Register reg,uint16_t value);
+
+/*
+ * Description :
+ * Set/Clear the global interrupt enable (I-bit), used by sei()/cli().
+ */
+void Sim_setInterruptEnable(uint8_t enable);
+
+/*
+ * Description :
+ * Busy wait of the ECU code (_delay_us/_delay_ms), interrupts are still served.
+ */
+void Sim_delayUs(double us);
+
+/*
+ * Description :
+ * sei then sleep then cli : with SE of MCUCR set the ECU sleeps till an
+ * interrupt is served, without it the sleep does nothing.
+ */
+void Sim_sleep(void);
+
+/*
+ * Description :
+ * Return the bottom and the top of the stack of the ECU, for stack_monitor.c.
+ */
+void Sim_getStack(const uint8_t ** bottom,const uint8_t ** top);
+
+#endif /* SIM_REGISTERS_H_ */
@@ -0,0 +1,21 @@
+ /******************************************************************************
+ *
+ * Module: Host Simulator
+ *
+ * File Name: stdlib.h
+ *
+ * Description: <stdlib.h> of the host build, adds the avr-libc functions
+ *              the ECU code uses and glibc does not have.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef SIM_STDLIB_H_
+#define SIM_STDLIB_H_
+
+#include_next <stdlib.h>
+
+char * itoa(int value,char * string,int radix);
+
+#endif /* SIM_STDLIB_H_ */
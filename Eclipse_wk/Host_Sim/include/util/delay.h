@@ -0,0 +1,22 @@
+ /******************************************************************************
+ *
+ * Module: Host Simulator
+ *
+ * File Name: delay.h
+ *
+ * Description: <util/delay.h> of the host build, the busy waits advance
+ *              the simulated time of the ECU.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef SIM_UTIL_DELAY_H_
+#define SIM_UTIL_DELAY_H_
+
+#include "sim_registers.h"
+
+#define _delay_us(US)		Sim_delayUs((double)(US))
+#define _delay_ms(MS)		Sim_delayUs((double)(MS) * 1000.0)
+
+#endif /* SIM_UTIL_DELAY_H_ */
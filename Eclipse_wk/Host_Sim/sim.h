@@ -0,0 +1,335 @@
+ /******************************************************************************
+ *
+ * Module: Host Simulator
+ *
+ * File Name: sim.h
+ *
+ * Description: Internal header of the host simulator of the two ECUs.
+ *              Each ECU is a shared library built from its Eclipse sources
+ *              with HOST_BUILD, running in its own coroutine on top of the
+ *              simulated ATmega32 peripherals and the devices of its board.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef SIM_H_
+#define SIM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <ucontext.h>
+#include "sim_registers.h"
+#include "sim_eeprom.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define SIM_F_CPU					8000000UL
+#define SIM_CYCLES_PER_US			(SIM_F_CPU / 1000000UL)
+#define SIM_CYCLES_PER_MS			(SIM_F_CPU / 1000UL)
+
+/* Time of one register access, with the code around it */
+#define SIM_ACCESS_CYCLES			2
+/*
+ * Idle loops : the last register accesses of the ECU are kept, once the same
+ * accesses with the same values have repeated SIM_IDLE_ACCESSES times without
+ * any delay the ECU is polling something that can only change at the next
+ * event, and the time jumps to it.
+ */
+#define SIM_IDLE_HISTORY			64
+#define SIM_IDLE_ACCESSES			256
+/* Lookahead between the ECUs before the UART is configured */
+#define SIM_DEFAULT_LOOKAHEAD		800
+
+#define SIM_TIME_NEVER				UINT64_MAX
+
+#define SIM_NUM_PORTS				4
+#define SIM_PORT_A					0
+#define SIM_PORT_B					1
+#define SIM_PORT_C					2
+#define SIM_PORT_D					3
+
+/* ATmega32 interrupt vectors, the number is the priority (lower first) */
+#define SIM_INT0_VECT				1
+#define SIM_INT1_VECT				2
+#define SIM_INT2_VECT				3
+#define SIM_TIMER2_COMP_VECT		4
+#define SIM_TIMER2_OVF_VECT			5
+#define SIM_TIMER1_CAPT_VECT		6
+#define SIM_TIMER1_COMPA_VECT		7
+#define SIM_TIMER1_COMPB_VECT		8
+#define SIM_TIMER1_OVF_VECT			9
+#define SIM_TIMER0_COMP_VECT		10
+#define SIM_TIMER0_OVF_VECT			11
+#define SIM_SPI_STC_VECT			12
+#define SIM_USART_RXC_VECT			13
+#define SIM_USART_UDRE_VECT			14
+#define SIM_USART_TXC_VECT			15
+#define SIM_ADC_VECT				16
+#define SIM_EE_RDY_VECT				17
+#define SIM_ANA_COMP_VECT			18
+#define SIM_TWI_VECT				19
+#define SIM_SPM_RDY_VECT			20
+#define SIM_NUM_VECTORS				21
+
+/* HMI panels on the multi-drop link of the Control ECU */
+#define SIM_MAX_PANELS				8
+
+/* UART frames on the line, not received yet */
+#define SIM_UART_LINE_SIZE			64
+/* Receive FIFO : 2 bytes UDR buffer + the receive shift register */
+#define SIM_UART_FIFO_SIZE			3
+
+/* DE and /RE of the RS-485 transceiver of each board, high to drive the bus */
+#define SIM_RS485_DE_PORT			SIM_PORT_B
+#define SIM_RS485_DE_PIN			4
+/* A driver enabled longer than this after the peer released the bus is not a turnaround */
+#define SIM_RS485_TURNAROUND_CYCLES	(2 * SIM_CYCLES_PER_MS)
+
+/* RTS of each board wired to CTS of the peer on the point-to-point link, low : ready to receive */
+#define SIM_RTS_CTS_PORT			SIM_PORT_B
+#define SIM_RTS_PIN					4
+#define SIM_CTS_PIN					5
+
+/* XCK of the synchronous mode : the output of the master clocks both directions */
+#define SIM_XCK_PORT				SIM_PORT_B
+#define SIM_XCK_PIN					0
+/* The slave samples XCK with its own clock, XCK must be below F_CPU/4 */
+#define SIM_XCK_SLAVE_MIN_CYCLES	5
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+/* Simulated time in CPU cycles since power on */
+typedef uint64_t Sim_Time;
+
+typedef struct Sim_Ecu Sim_Ecu;
+
+/* Timer0 / Timer2 */
+typedef struct{
+	uint8_t id;						/* 0 or 2 */
+	uint16_t prescaler;				/* 0 when the timer is stopped */
+	Sim_Time baseTime;				/* the counter was baseCount at baseTime */
+	uint8_t baseCount;
+	uint8_t ocrBuffer;				/* OCR as written, loaded at BOTTOM in PWM modes */
+	Sim_Time nextOverflow;
+	Sim_Time nextCompare;
+}Sim_Timer8;
+
+/* Timer1 */
+typedef struct{
+	uint16_t prescaler;
+	Sim_Time baseTime;
+	uint16_t baseCount;
+	uint16_t ocr1a;
+	uint16_t ocr1b;
+	uint16_t icr1;
+	Sim_Time nextCompareA;
+	Sim_Time nextCompareB;
+	Sim_Time nextOverflow;
+}Sim_Timer1;
+
+typedef struct{
+	Sim_Time start;					/* falling edge of the start bit */
+	uint32_t waveform;				/* line levels, bit 0 is the start bit */
+	uint8_t length;					/* bits in the waveform */
+	uint8_t synchronous;			/* sent in synchronous mode (XCK clock) */
+	uint32_t bitCycles;				/* bit time of the sender */
+	const Sim_Ecu * sender;
+	uint8_t collision;				/* another sender was on the line at the same time */
+}Sim_UartFrame;
+
+typedef struct{
+	/* Transmitter */
+	uint8_t shifting;
+	Sim_Time shiftEnd;
+	uint8_t bufferFull;
+	uint16_t buffer;
+	/* Receiver : frames sent by the peers in the order of their start, then the receive FIFO */
+	Sim_UartFrame line[SIM_UART_LINE_SIZE];
+	uint8_t lineHead;
+	uint8_t lineCount;
+	Sim_UartFrame lastFrame;		/* last frame taken from the line, for the collisions */
+	uint16_t fifo[SIM_UART_FIFO_SIZE];
+	uint8_t fifoErrors[SIM_UART_FIFO_SIZE];	/* FE/DOR/PE bits of each byte */
+	const Sim_Ecu * fifoSenders[SIM_UART_FIFO_SIZE];
+	uint8_t fifoCount;
+	uint16_t lastData;
+	const Sim_Ecu * lastSender;		/* sender of the last byte read from UDR */
+	/* UCSRC and UBRRH share the same I/O address */
+	uint8_t ucsrc;
+	uint8_t ubrrh;
+	uint64_t ubrrhReadAccess;		/* a read right after this one gives UCSRC */
+	/* RS-485 transceiver, the receiver is off while the driver is on */
+	uint8_t rs485;
+	uint8_t driving;
+	Sim_Time driveStart;
+	Sim_Time driveEnd;
+	uint8_t driveConflict;			/* the conflict of this drive is counted */
+	/* Noise : one frame out of noise is sent with a bit flipped, 0 for none */
+	uint32_t noise;
+	/* Statistics */
+	uint32_t bytesSent;
+	uint32_t bytesReceived;
+	uint32_t errors;
+	uint32_t collisions;
+	uint32_t undriven;				/* frames sent with the RS-485 driver off */
+	uint32_t conflicts;				/* two RS-485 drivers on the bus at the same time */
+	uint32_t bitErrors;				/* frames sent with a bit flipped by the noise */
+	/* The bytes sent are written to this file, NULL if not */
+	FILE * linkLog;
+}Sim_Uart;
+
+typedef struct{
+	uint8_t state;
+	uint8_t twcr;
+	uint8_t twsr;
+	uint8_t twdr;
+	Sim_Time doneTime;				/* end of the current bus operation */
+	uint8_t pending;				/* TWINT is set at doneTime */
+}Sim_Twi;
+
+typedef struct{
+	Sim_Time conversionEnd;
+	uint8_t converting;
+	uint8_t firstConversion;
+	uint16_t result;
+}Sim_Adc;
+
+/* Events of the devices reported to the benchmark */
+typedef enum{
+	SIM_EVENT_KEY_PRESS, SIM_EVENT_LCD_WRITE, SIM_EVENT_UART_WRITE, SIM_EVENT_UART_READ,
+	SIM_EVENT_TWI_START, SIM_EVENT_TWI_STOP, SIM_EVENT_MOTOR,
+	SIM_EVENT_RS485_RELEASE, SIM_EVENT_RS485_TURNAROUND, SIM_EVENT_STALL	/* the value is the time in cycles */
+}Sim_BenchEvent;
+
+/* Devices connected to the pins of an ECU */
+typedef struct{
+	/* Advance the devices to ecu->now */
+	void (*update)(Sim_Ecu * ecu);
+	/* Time of the next change of the devices seen by the ECU */
+	Sim_Time (*nextEvent)(Sim_Ecu * ecu);
+	/* Levels on the pins of the port (1 if nothing pulls them low) */
+	uint8_t (*readPins)(Sim_Ecu * ecu,uint8_t port);
+	/* The ECU has written PORTx or DDRx */
+	void (*portWritten)(Sim_Ecu * ecu,uint8_t port);
+	/* Voltage of the ADC input as 0 --> 1023 of AVCC */
+	uint16_t (*readAdc)(Sim_Ecu * ecu,uint8_t channel);
+}Sim_Board;
+
+struct Sim_Ecu{
+	const char * name;
+	void * library;
+	int (*main)(void);
+	void (*vectors[SIM_NUM_VECTORS])(void);
+	ucontext_t context;
+	void * stack;
+	uint8_t finished;
+
+	Sim_Time now;
+	uint8_t interruptEnable;		/* I-bit of SREG */
+	uint8_t inInterrupt;
+	uint8_t io[SIM_NUM_REGISTERS];	/* registers without side effects */
+	uint8_t pins[SIM_NUM_PORTS];	/* pin levels at the last update, for INT0/INT1 */
+	Sim_Time nextEvent;				/* 0 when it must be computed again */
+	uint8_t idle;					/* waiting for the next event */
+	uint8_t sleeping;				/* in a sleep instruction, till an interrupt */
+
+	/* Idle loop detection */
+	uint32_t history[SIM_IDLE_HISTORY];
+	uint8_t historyIndex;
+	uint8_t loopPeriod;				/* accesses in the loop, 0 if none */
+	uint32_t loopAccesses;			/* accesses repeated with this period */
+
+	Sim_Timer8 timer0;
+	Sim_Timer1 timer1;
+	Sim_Timer8 timer2;
+	Sim_Uart uart;
+	Sim_Twi twi;
+	Sim_Adc adc;
+
+	/* ECUs that receive the frames sent : the HMI panels for the Control ECU */
+	Sim_Ecu * peers[SIM_MAX_PANELS];
+	uint8_t peerCount;
+	const Sim_Board * board;
+	void * boardState;
+	Sim_Eeprom * eeprom;			/* 24C16 on the TWI bus, NULL if none */
+
+	/* Statistics */
+	uint64_t accesses;
+	uint64_t interrupts[SIM_NUM_VECTORS];
+	uint64_t events;				/* times the peripherals were updated */
+	Sim_Time idleCycles;			/* time skipped in idle loops and waits */
+	Sim_Time sleepCycles;			/* time in sleep instructions */
+	uint64_t wakes[SIM_NUM_VECTORS];	/* interrupts that ended a sleep */
+};
+
+/*******************************************************************************
+ *                      Global Variables                                       *
+ *******************************************************************************/
+
+/* ECU running now */
+extern Sim_Ecu * g_simEcu;
+/* Print the trace of the devices and the link */
+extern uint8_t g_simTrace;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/* sim_core.c */
+void Sim_loadEcu(Sim_Ecu * ecu,const char * name,const char * library);
+void Sim_connect(Sim_Ecu * ecu1,Sim_Ecu * ecu2);
+void Sim_run(Sim_Ecu * const * ecus,uint8_t count,Sim_Time until,uint8_t (*done)(void));
+void Sim_advance(Sim_Time cycles);
+void Sim_update(Sim_Ecu * ecu);
+Sim_Time Sim_nextEvent(Sim_Ecu * ecu);
+void Sim_reschedule(Sim_Ecu * ecu);
+void Sim_wakePeer(Sim_Ecu * ecu,const Sim_Ecu * peer,Sim_Time time);
+uint8_t Sim_readPort(Sim_Ecu * ecu,uint8_t port);
+uint8_t Sim_outputPins(Sim_Ecu * ecu,uint8_t port);
+void Sim_trace(const Sim_Ecu * ecu,const char * format,...);
+void Sim_fatal(const Sim_Ecu * ecu,const char * format,...);
+double Sim_timeMs(Sim_Time time);
+const char * Sim_vectorName(uint8_t vector);
+
+/* sim_timers.c */
+void SimTimer_reset(Sim_Ecu * ecu);
+void SimTimer_update(Sim_Ecu * ecu);
+Sim_Time SimTimer_nextEvent(Sim_Ecu * ecu);
+uint8_t SimTimer_read(Sim_Ecu * ecu,Sim_RegisterId id);
+void SimTimer_write(Sim_Ecu * ecu,Sim_RegisterId id,uint8_t value);
+uint16_t SimTimer_read16(Sim_Ecu * ecu,Sim_RegisterId id);
+void SimTimer_write16(Sim_Ecu * ecu,Sim_RegisterId id,uint16_t value);
+void SimTimer_inputCapture(Sim_Ecu * ecu,Sim_Time time,uint8_t rising);
+uint8_t SimTimer_pwmOutput(Sim_Ecu * ecu,uint8_t timer,double * duty,double * frequency);
+
+/* sim_uart.c */
+void SimUart_update(Sim_Ecu * ecu);
+Sim_Time SimUart_nextEvent(Sim_Ecu * ecu);
+uint8_t SimUart_read(Sim_Ecu * ecu,Sim_RegisterId id);
+void SimUart_write(Sim_Ecu * ecu,Sim_RegisterId id,uint8_t value);
+Sim_Time SimUart_frameCycles(const Sim_Ecu * ecu);
+void SimUart_portWritten(Sim_Ecu * ecu,uint8_t port);
+uint8_t SimUart_readPins(Sim_Ecu * ecu,uint8_t port);
+
+/* sim_twi.c */
+void SimTwi_update(Sim_Ecu * ecu);
+Sim_Time SimTwi_nextEvent(Sim_Ecu * ecu);
+uint8_t SimTwi_read(Sim_Ecu * ecu,Sim_RegisterId id);
+void SimTwi_write(Sim_Ecu * ecu,Sim_RegisterId id,uint8_t value);
+
+/* sim_adc.c */
+void SimAdc_update(Sim_Ecu * ecu);
+Sim_Time SimAdc_nextEvent(Sim_Ecu * ecu);
+void SimAdc_write(Sim_Ecu * ecu,Sim_RegisterId id,uint8_t value);
+uint16_t SimAdc_read16(Sim_Ecu * ecu);
+
+/* sim_bench.c */
+void SimBench_event(const Sim_Ecu * ecu,Sim_BenchEvent event,uint32_t value);
+
+#endif /* SIM_H_ */
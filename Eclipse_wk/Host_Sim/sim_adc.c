@@ -0,0 +1,134 @@
+ /******************************************************************************
+ *
+ * Module: Host Simulator
+ *
+ * File Name: sim_adc.c
+ *
+ * Description: Simulated ADC of the ATmega32, single conversion and free
+ *              running modes. The input voltage comes from the board.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include <avr/io.h>
+#include "sim.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* ADC clock cycles of a conversion */
+#define SIM_ADC_FIRST_CONVERSION	25
+#define SIM_ADC_CONVERSION			13
+
+/*******************************************************************************
+ *                      Global Variables                                       *
+ *******************************************************************************/
+
+/* ADPS2:0 --> division factor */
+static const uint8_t g_adcPrescalers[8] = {2, 2, 4, 8, 16, 32, 64, 128};
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static Sim_Time SimAdc_conversionCycles(const Sim_Ecu * ecu);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Complete the conversions ended by now, free running starts the next one.
+ */
+void SimAdc_update(Sim_Ecu * ecu)
+{
+	Sim_Adc * adc = &ecu->adc;
+	uint8_t channel;
+
+	while(adc->converting && (adc->conversionEnd <= ecu->now))
+	{
+		channel = ecu->io[SIM_ADMUX] & 0x07;
+		adc->result = 0;
+		if((ecu->board != NULL) && (ecu->board->readAdc != NULL))
+		{
+			adc->result = ecu->board->readAdc(ecu, channel) & 0x3FF;
+		}
+		ecu->io[SIM_ADCSRA] |= (1<<ADIF);
+
+		/* ADTS2:0 = 0 free running */
+		if((ecu->io[SIM_ADCSRA] & (1<<ADATE)) && ((ecu->io[SIM_SFIOR] >> 5) == 0))
+		{
+			adc->conversionEnd += SimAdc_conversionCycles(ecu);
+		}
+		else
+		{
+			adc->converting = 0;
+			ecu->io[SIM_ADCSRA] &= ~(1<<ADSC);
+		}
+	}
+}
+
+/*
+ * Description :
+ * Return the time of the end of the current conversion.
+ */
+Sim_Time SimAdc_nextEvent(Sim_Ecu * ecu)
+{
+	return ecu->adc.converting ? ecu->adc.conversionEnd : SIM_TIME_NEVER;
+}
+
+void SimAdc_write(Sim_Ecu * ecu,Sim_RegisterId id,uint8_t value)
+{
+	Sim_Adc * adc = &ecu->adc;
+	uint8_t adcsra;
+
+	if(id != SIM_ADCSRA)
+	{
+		ecu->io[id] = value;
+		return;
+	}
+
+	/* ADIF is cleared by writing one, ADSC can not be cleared by writing zero */
+	adcsra = ecu->io[SIM_ADCSRA];
+	ecu->io[SIM_ADCSRA] = (value & (~(1<<ADIF))) | (adcsra & (1<<ADIF) & (~value)) | (adcsra & (1<<ADSC));
+
+	if(!(value & (1<<ADEN)))
+	{
+		/* Disabling the ADC aborts the conversion */
+		adc->converting = 0;
+		adc->firstConversion = 1;
+		ecu->io[SIM_ADCSRA] &= ~(1<<ADSC);
+	}
+	else if((value & (1<<ADSC)) && (!adc->converting))
+	{
+		/* The first conversion after ADEN takes longer to set up the analog circuit */
+		adc->converting = 1;
+		adc->conversionEnd = ecu->now + (adc->firstConversion ?
+				(Sim_Time)SIM_ADC_FIRST_CONVERSION * g_adcPrescalers[value & 0x07] :
+				SimAdc_conversionCycles(ecu));
+		adc->firstConversion = 0;
+	}
+}
+
+uint16_t SimAdc_read16(Sim_Ecu * ecu)
+{
+	/* ADLAR = 1 left adjusts the result */
+	if(ecu->io[SIM_ADMUX] & (1<<ADLAR))
+	{
+		return ecu->adc.result << 6;
+	}
+	return ecu->adc.result;
+}
+
+
+/*******************************************************************************
+ *                      Private Functions                                      *
+ *******************************************************************************/
+
+static Sim_Time SimAdc_conversionCycles(const Sim_Ecu * ecu)
+{
+	return (Sim_Time)SIM_ADC_CONVERSION * g_adcPrescalers[ecu->io[SIM_ADCSRA] & 0x07];
+}
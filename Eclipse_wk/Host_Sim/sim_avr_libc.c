@@ -0,0 +1,56 @@
+ /******************************************************************************
+ *
+ * Module: Host Simulator
+ *
+ * File Name: sim_avr_libc.c
+ *
+ * Description: avr-libc functions used by the ECUs that the host C library
+ *              does not have. The ECU libraries take them from door_sim.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include <stdlib.h>
+
+/*
+ * Description :
+ * Convert the integer to a string in the given radix (2 --> 36),
+ * only radix 10 gives a sign.
+ */
+char * itoa(int value,char * string,int radix)
+{
+	char digits[sizeof(int) * 8 + 1];
+	unsigned int magnitude;
+	unsigned char i = 0;
+	unsigned char j = 0;
+
+	if((radix < 2) || (radix > 36))
+	{
+		string[0] = '\0';
+		return string;
+	}
+
+	if((radix == 10) && (value < 0))
+	{
+		string[j++] = '-';
+		magnitude = -(unsigned int)value;
+	}
+	else
+	{
+		magnitude = (unsigned int)value;
+	}
+
+	do
+	{
+		digits[i++] = "0123456789abcdefghijklmnopqrstuvwxyz"[magnitude % radix];
+		magnitude /= radix;
+	}while(magnitude != 0);
+
+	while(i > 0)
+	{
+		string[j++] = digits[--i];
+	}
+	string[j] = '\0';
+	return string;
+}
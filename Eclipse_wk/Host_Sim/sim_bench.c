@@ -0,0 +1,516 @@
+ /******************************************************************************
+ *
+ * Module: Host Simulator
+ *
+ * File Name: sim_bench.c
+ *
+ * Description: Time to unlock benchmark. The standard flows are played on
+ *              the keypad : password setup, then for each iteration open
+ *              door, change password and three wrong passwords. The devices
+ *              report their events here and the latency of each phase is
+ *              measured in simulated time :
+ *              keypad          key press --> first LCD write or UART byte of the HMI,
+ *                              with the delay of the HMI after the previous key
+ *              link_byte       UDR written by an ECU --> UDR read by its peer,
+ *                              the data frames between the Control ECU and the
+ *                              panel with the keys on the multi-drop link
+ *              link_stream     UDR read --> next UDR read of the same direction,
+ *                              when the next byte was written before : the time
+ *                              of one byte on a busy link, 1/throughput
+ *              eeprom_transfer TWI START --> STOP of one EEPROM access
+ *              eeprom_burst    EEPROM accesses less than 20 ms apart
+ *              lcd_redraw      LCD writes less than 10 ms apart, not the single
+ *                              '*' of a password digit
+ *              rs485_release   stop bit of the last frame --> RS-485 driver released
+ *              rs485_turnaround driver released --> driver of the peer enabled
+ *                              (door_sim --rs485 only)
+ *              stall_stop      motor stalled --> motor stopped, from the end of the
+ *                              inrush blanking time of the Control ECU
+ *                              (door_sim --no-limit-switches or --block-door only)
+ *              setup           first key --> main menu, first power on
+ *              time_to_unlock  '=' of the password --> motor started to open
+ *              open_door       '+' --> main menu, door opened and closed
+ *              change_password '-' --> main menu with the new password
+ *              wrong_attempt   '=' of a wrong password --> first LCD write
+ *              lockout         '=' of the third wrong password --> main menu
+ *              On the multi-drop link the keys are pressed on the first
+ *              panel, the other ones are polled too and the phases include
+ *              the wait for the poll of the first panel.
+ *              The results are written to PREFIX.csv and PREFIX.json.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_boards.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Events closer than this belong to the same burst */
+#define SIM_BENCH_LCD_GAP_CYCLES	(10 * SIM_CYCLES_PER_MS)
+#define SIM_BENCH_EEPROM_GAP_CYCLES	(20 * SIM_CYCLES_PER_MS)
+/* Simulated time allowed for one flow, the lockout takes 60 seconds */
+#define SIM_BENCH_FLOW_SECONDS		120
+/* UART bytes sent and not read yet in each direction */
+#define SIM_BENCH_LINK_QUEUE_SIZE	64
+#define SIM_BENCH_KEYS_SIZE			32
+#define SIM_BENCH_MAX_PATH			512
+
+/* The keys are pressed on the panel at this address */
+#define SIM_BENCH_PANEL_ADDRESS		1
+
+#define SIM_MENU_LINE0				"+ : Open Door"
+#define SIM_MENU_LINE1				"- : Change Pass"
+
+typedef enum{
+	SIM_BENCH_KEYPAD, SIM_BENCH_LINK_BYTE, SIM_BENCH_LINK_STREAM, SIM_BENCH_EEPROM_TRANSFER, SIM_BENCH_EEPROM_BURST,
+	SIM_BENCH_LCD_REDRAW, SIM_BENCH_RS485_RELEASE, SIM_BENCH_RS485_TURNAROUND, SIM_BENCH_STALL_STOP, SIM_BENCH_SETUP, SIM_BENCH_TIME_TO_UNLOCK, SIM_BENCH_OPEN_DOOR,
+	SIM_BENCH_CHANGE_PASSWORD, SIM_BENCH_WRONG_ATTEMPT, SIM_BENCH_LOCKOUT, SIM_BENCH_NUM_PHASES
+}SimBench_Phase;
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef struct{
+	double * samples;				/* milliseconds */
+	uint32_t count;
+	uint32_t size;
+}SimBench_Samples;
+
+typedef struct{
+	double min;
+	double median;
+	double p99;
+	double max;
+	double mean;
+}SimBench_Stats;
+
+/* A group of events closer than the gap */
+typedef struct{
+	uint8_t open;
+	uint32_t events;
+	Sim_Time start;
+	Sim_Time last;
+}SimBench_Burst;
+
+typedef struct{
+	uint8_t active;
+	Sim_Ecu * const * ecus;
+	uint8_t count;
+	Sim_Ecu * control;
+	Sim_Ecu * hmi;
+	SimBench_Phase flow;
+	SimBench_Samples phases[SIM_BENCH_NUM_PHASES];
+	/* Keypad */
+	uint8_t keyPending;
+	Sim_Time keyTime;
+	Sim_Time enterTime;				/* last '=' */
+	uint8_t unlockPending;
+	uint8_t responsePending;
+	/* Link, one queue for each direction, 0 : Control --> HMI */
+	Sim_Time linkQueue[2][SIM_BENCH_LINK_QUEUE_SIZE];
+	uint8_t linkHead[2];
+	uint8_t linkCount[2];
+	Sim_Time linkRead[2];			/* last byte read */
+	uint8_t linkStreaming[2];		/* the next byte was written before it was read */
+	uint8_t address;				/* panel addressed by the Control ECU, 0 point-to-point */
+	/* EEPROM */
+	Sim_Time twiStart;
+	uint8_t twiStarted;
+	SimBench_Burst eepromBurst;
+	SimBench_Burst lcdBurst;
+}SimBench_State;
+
+/*******************************************************************************
+ *                      Global Variables                                       *
+ *******************************************************************************/
+
+static const char * const g_benchPhaseNames[SIM_BENCH_NUM_PHASES] = {
+		"keypad", "link_byte", "link_stream", "eeprom_transfer", "eeprom_burst", "lcd_redraw", "rs485_release",
+		"rs485_turnaround", "stall_stop", "setup",
+		"time_to_unlock", "open_door", "change_password", "wrong_attempt", "lockout"
+};
+
+static SimBench_State g_bench;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static uint8_t SimBench_flow(SimBench_Phase flow,const char * keys);
+static uint8_t SimBench_flowDone(void);
+static void SimBench_sample(SimBench_Phase phase,Sim_Time cycles);
+static void SimBench_burst(SimBench_Burst * burst,SimBench_Phase phase,Sim_Time time,Sim_Time gap);
+static void SimBench_closeBurst(SimBench_Burst * burst,SimBench_Phase phase);
+static int SimBench_compare(const void * a,const void * b);
+static void SimBench_stats(SimBench_Samples * samples,SimBench_Stats * stats);
+static uint8_t SimBench_write(const char * prefix,unsigned long iterations);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Run the benchmark on the ECUs attached to their boards, with an erased
+ * EEPROM : the Control ECU first, then the panel that gets the keys and the
+ * other panels. Return TRUE if all the flows ended at the main menu in time
+ * and the results are written.
+ */
+uint8_t SimBench_run(Sim_Ecu * const * ecus,uint8_t count,unsigned long iterations,const char * password,const char * prefix)
+{
+	char current[6];
+	char next[6];
+	char wrong[6];
+	char keys[SIM_BENCH_KEYS_SIZE];
+	unsigned long i;
+	uint8_t done;
+	uint8_t p;
+
+	memset(&g_bench, 0, sizeof(SimBench_State));
+	g_bench.ecus = ecus;
+	g_bench.count = count;
+	g_bench.control = ecus[0];
+	g_bench.hmi = ecus[1];
+	g_bench.active = 1;
+
+	strcpy(current, password);
+	snprintf(keys, sizeof(keys), "%s=%s=", current, current);
+	done = SimBench_flow(SIM_BENCH_SETUP, keys);
+
+	for(i=0;done && (i<iterations);i++)
+	{
+		snprintf(keys, sizeof(keys), "+%s=", current);
+		done = SimBench_flow(SIM_BENCH_OPEN_DOOR, keys);
+
+		/* The new password is the old one reversed. The main menu reads the held '-'
+		 * twice (there is no wait for the release), one press changes the password */
+		for(p=0;p<5;p++)
+		{
+			next[p] = current[4 - p];
+		}
+		next[5] = '\0';
+		if(strcmp(next, current) == 0)
+		{
+			next[0] = (char)('0' + ((next[0] - '0' + 1) % 10));
+		}
+		snprintf(keys, sizeof(keys), "-%s=%s=%s=", current, next, next);
+		done = done && SimBench_flow(SIM_BENCH_CHANGE_PASSWORD, keys);
+		strcpy(current, next);
+
+		strcpy(wrong, current);
+		wrong[0] = (char)('0' + ((wrong[0] - '0' + 1) % 10));
+		snprintf(keys, sizeof(keys), "+%s=%s=%s=", wrong, wrong, wrong);
+		done = done && SimBench_flow(SIM_BENCH_LOCKOUT, keys);
+	}
+	g_bench.active = 0;
+
+	if(!done)
+	{
+		fprintf(stderr, "benchmark: the %s flow did not end at the main menu\n", g_benchPhaseNames[g_bench.flow]);
+	}
+	done = done && SimBench_write(prefix, iterations);
+
+	for(p=0;p<SIM_BENCH_NUM_PHASES;p++)
+	{
+		free(g_bench.phases[p].samples);
+	}
+	return done;
+}
+
+/*
+ * Description :
+ * Event of the devices of an ECU at ecu->now, nothing is done out of the benchmark.
+ */
+void SimBench_event(const Sim_Ecu * ecu,Sim_BenchEvent event,uint32_t value)
+{
+	SimBench_State * bench = &g_bench;
+	uint8_t direction = (ecu == bench->control) ? 0 : 1;
+	uint8_t index;
+
+	/* Only the panel with the keys is timed */
+	if((!bench->active) || ((ecu != bench->control) && (ecu != bench->hmi)))
+	{
+		return;
+	}
+
+	switch(event)
+	{
+	case SIM_EVENT_KEY_PRESS:
+		bench->keyPending = 1;
+		bench->keyTime = ecu->now;
+		if(value == '=')
+		{
+			bench->enterTime = ecu->now;
+			bench->unlockPending = (bench->flow == SIM_BENCH_OPEN_DOOR);
+			bench->responsePending = (bench->flow == SIM_BENCH_LOCKOUT);
+		}
+		break;
+	case SIM_EVENT_LCD_WRITE:
+		if(bench->keyPending)
+		{
+			bench->keyPending = 0;
+			SimBench_sample(SIM_BENCH_KEYPAD, ecu->now - bench->keyTime);
+		}
+		if(bench->responsePending)
+		{
+			bench->responsePending = 0;
+			SimBench_sample(SIM_BENCH_WRONG_ATTEMPT, ecu->now - bench->enterTime);
+		}
+		SimBench_burst(&bench->lcdBurst, SIM_BENCH_LCD_REDRAW, ecu->now, SIM_BENCH_LCD_GAP_CYCLES);
+		break;
+	case SIM_EVENT_UART_WRITE:
+		if(value & 0x100)
+		{
+			/* Address frame of the multi-drop link, not timed */
+			bench->address = (uint8_t)value;
+			break;
+		}
+		if((ecu == bench->control) && (bench->address != 0) && (bench->address != SIM_BENCH_PANEL_ADDRESS))
+		{
+			/* Sent to another panel */
+			break;
+		}
+		if((ecu == bench->hmi) && bench->keyPending)
+		{
+			bench->keyPending = 0;
+			SimBench_sample(SIM_BENCH_KEYPAD, ecu->now - bench->keyTime);
+		}
+		if(bench->linkCount[direction] < SIM_BENCH_LINK_QUEUE_SIZE)
+		{
+			index = (bench->linkHead[direction] + bench->linkCount[direction]) % SIM_BENCH_LINK_QUEUE_SIZE;
+			bench->linkQueue[direction][index] = ecu->now;
+			bench->linkCount[direction]++;
+		}
+		break;
+	case SIM_EVENT_UART_READ:
+		if((value & 0x100) || (ecu->uart.lastSender != ((ecu == bench->control) ? bench->hmi : bench->control)))
+		{
+			/* Address frame, or a byte of another panel */
+			break;
+		}
+		/* The byte was sent by the peer */
+		direction ^= 1;
+		if(bench->linkCount[direction] > 0)
+		{
+			SimBench_sample(SIM_BENCH_LINK_BYTE, ecu->now - bench->linkQueue[direction][bench->linkHead[direction]]);
+			bench->linkHead[direction] = (bench->linkHead[direction] + 1) % SIM_BENCH_LINK_QUEUE_SIZE;
+			bench->linkCount[direction]--;
+			if(bench->linkStreaming[direction])
+			{
+				SimBench_sample(SIM_BENCH_LINK_STREAM, ecu->now - bench->linkRead[direction]);
+			}
+			bench->linkRead[direction] = ecu->now;
+			bench->linkStreaming[direction] = (bench->linkCount[direction] > 0);
+		}
+		break;
+	case SIM_EVENT_TWI_START:
+		bench->twiStarted = 1;
+		bench->twiStart = ecu->now;
+		SimBench_burst(&bench->eepromBurst, SIM_BENCH_EEPROM_BURST, ecu->now, SIM_BENCH_EEPROM_GAP_CYCLES);
+		break;
+	case SIM_EVENT_TWI_STOP:
+		if(bench->twiStarted)
+		{
+			bench->twiStarted = 0;
+			SimBench_sample(SIM_BENCH_EEPROM_TRANSFER, ecu->now - bench->twiStart);
+			SimBench_burst(&bench->eepromBurst, SIM_BENCH_EEPROM_BURST, ecu->now, SIM_BENCH_EEPROM_GAP_CYCLES);
+		}
+		break;
+	case SIM_EVENT_MOTOR:
+		/* value is the direction, 1 to open */
+		if(bench->unlockPending && (value == 1))
+		{
+			bench->unlockPending = 0;
+			SimBench_sample(SIM_BENCH_TIME_TO_UNLOCK, ecu->now - bench->enterTime);
+		}
+		break;
+	case SIM_EVENT_RS485_RELEASE:
+		SimBench_sample(SIM_BENCH_RS485_RELEASE, value);
+		break;
+	case SIM_EVENT_RS485_TURNAROUND:
+		SimBench_sample(SIM_BENCH_RS485_TURNAROUND, value);
+		break;
+	case SIM_EVENT_STALL:
+		SimBench_sample(SIM_BENCH_STALL_STOP, value);
+		break;
+	}
+}
+
+
+/*******************************************************************************
+ *                      Private Functions                                      *
+ *******************************************************************************/
+
+/* Press the keys of the flow and run till the main menu is back */
+static uint8_t SimBench_flow(SimBench_Phase flow,const char * keys)
+{
+	static char flowKeys[SIM_BENCH_KEYS_SIZE];
+	SimBench_State * bench = &g_bench;
+	Sim_Time start = bench->hmi->now;
+
+	/* The board keeps a pointer to the keys */
+	strcpy(flowKeys, keys);
+	bench->flow = flow;
+	SimHmiBoard_pressKeys(bench->hmi, flowKeys);
+	Sim_run(bench->ecus, bench->count, start + (Sim_Time)SIM_BENCH_FLOW_SECONDS * SIM_F_CPU, SimBench_flowDone);
+	if(!SimBench_flowDone())
+	{
+		return 0;
+	}
+
+	/* The flow ends with the last write of the main menu, the lockout is timed from its third password */
+	SimBench_closeBurst(&bench->lcdBurst, SIM_BENCH_LCD_REDRAW);
+	SimBench_closeBurst(&bench->eepromBurst, SIM_BENCH_EEPROM_BURST);
+	SimBench_sample(flow, bench->lcdBurst.last - ((flow == SIM_BENCH_LOCKOUT) ? bench->enterTime : start));
+	return 1;
+}
+
+/* All the keys are pressed and released and the main menu is on the LCD */
+static uint8_t SimBench_flowDone(void)
+{
+	char line[SIM_LCD_COLUMNS + 1];
+
+	if(!SimHmiBoard_keysDone(g_bench.hmi))
+	{
+		return 0;
+	}
+	SimHmiBoard_getLine(g_bench.hmi, 0, line);
+	if(strncmp(line, SIM_MENU_LINE0, strlen(SIM_MENU_LINE0)) != 0)
+	{
+		return 0;
+	}
+	SimHmiBoard_getLine(g_bench.hmi, 1, line);
+	return strncmp(line, SIM_MENU_LINE1, strlen(SIM_MENU_LINE1)) == 0;
+}
+
+static void SimBench_sample(SimBench_Phase phase,Sim_Time cycles)
+{
+	SimBench_Samples * samples = &g_bench.phases[phase];
+
+	if(samples->count == samples->size)
+	{
+		samples->size = (samples->size == 0) ? 64 : (2 * samples->size);
+		samples->samples = realloc(samples->samples, samples->size * sizeof(double));
+		if(samples->samples == NULL)
+		{
+			fprintf(stderr, "no memory for the benchmark samples\n");
+			exit(2);
+		}
+	}
+	samples->samples[samples->count++] = Sim_timeMs(cycles);
+}
+
+/* An event at time, it starts a new burst after the gap */
+static void SimBench_burst(SimBench_Burst * burst,SimBench_Phase phase,Sim_Time time,Sim_Time gap)
+{
+	if(burst->open && (time > burst->last + gap))
+	{
+		SimBench_closeBurst(burst, phase);
+	}
+	if(!burst->open)
+	{
+		burst->open = 1;
+		burst->events = 0;
+		burst->start = time;
+	}
+	burst->events++;
+	burst->last = time;
+}
+
+static void SimBench_closeBurst(SimBench_Burst * burst,SimBench_Phase phase)
+{
+	if(burst->open)
+	{
+		burst->open = 0;
+		if(burst->events > 1)
+		{
+			SimBench_sample(phase, burst->last - burst->start);
+		}
+	}
+}
+
+static int SimBench_compare(const void * a,const void * b)
+{
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+/* Sort the samples, nearest rank percentiles */
+static void SimBench_stats(SimBench_Samples * samples,SimBench_Stats * stats)
+{
+	uint32_t i;
+
+	memset(stats, 0, sizeof(SimBench_Stats));
+	if(samples->count == 0)
+	{
+		return;
+	}
+	qsort(samples->samples, samples->count, sizeof(double), SimBench_compare);
+	for(i=0;i<samples->count;i++)
+	{
+		stats->mean += samples->samples[i];
+	}
+	stats->mean /= samples->count;
+	stats->min = samples->samples[0];
+	stats->median = samples->samples[(samples->count - 1) / 2];
+	stats->p99 = samples->samples[((samples->count * 99) + 99) / 100 - 1];
+	stats->max = samples->samples[samples->count - 1];
+}
+
+/* Write the statistics of each phase to the files and to stdout */
+static uint8_t SimBench_write(const char * prefix,unsigned long iterations)
+{
+	char path[SIM_BENCH_MAX_PATH];
+	FILE * csv;
+	FILE * json;
+	SimBench_Stats stats;
+	uint32_t count;
+	uint8_t p;
+
+	snprintf(path, sizeof(path), "%s.csv", prefix);
+	csv = fopen(path, "w");
+	snprintf(path, sizeof(path), "%s.json", prefix);
+	json = fopen(path, "w");
+	if((csv == NULL) || (json == NULL))
+	{
+		fprintf(stderr, "benchmark: can not write %s.csv and %s.json\n", prefix, prefix);
+		if(csv != NULL)
+		{
+			fclose(csv);
+		}
+		if(json != NULL)
+		{
+			fclose(json);
+		}
+		return 0;
+	}
+
+	fprintf(csv, "phase,count,min_ms,median_ms,p99_ms,max_ms,mean_ms\n");
+	fprintf(json, "{\n  \"iterations\": %lu,\n  \"phases\": {", iterations);
+	printf("%-16s %6s %10s %10s %10s %10s %10s\n", "Phase", "count", "min ms", "median ms", "p99 ms", "max ms", "mean ms");
+	for(p=0;p<SIM_BENCH_NUM_PHASES;p++)
+	{
+		count = g_bench.phases[p].count;
+		SimBench_stats(&g_bench.phases[p], &stats);
+		fprintf(csv, "%s,%u,%.3f,%.3f,%.3f,%.3f,%.3f\n", g_benchPhaseNames[p], count,
+				stats.min, stats.median, stats.p99, stats.max, stats.mean);
+		fprintf(json, "%s\n    \"%s\": {\"count\": %u, \"min_ms\": %.3f, \"median_ms\": %.3f, "
+				"\"p99_ms\": %.3f, \"max_ms\": %.3f, \"mean_ms\": %.3f}", (p == 0) ? "" : ",", g_benchPhaseNames[p], count,
+				stats.min, stats.median, stats.p99, stats.max, stats.mean);
+		printf("%-16s %6u %10.3f %10.3f %10.3f %10.3f %10.3f\n", g_benchPhaseNames[p], count,
+				stats.min, stats.median, stats.p99, stats.max, stats.mean);
+	}
+	fprintf(json, "\n  }\n}\n");
+	fclose(csv);
+	fclose(json);
+	return 1;
+}
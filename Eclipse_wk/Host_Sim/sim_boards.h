@@ -0,0 +1,73 @@
+ /******************************************************************************
+ *
+ * Module: Host Simulator
+ *
+ * File Name: sim_boards.h
+ *
+ * Description: Devices connected to the pins of each ECU :
+ *              Control ECU : door motor with its encoder and shunt, door
+ *                            limit switches and buzzer.
+ *              HMI ECU     : HD44780 LCD in 8-bit mode and 4x4 keypad.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef SIM_BOARDS_H_
+#define SIM_BOARDS_H_
+
+#include "sim.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define SIM_LCD_COLUMNS				16
+#define SIM_LCD_ROWS				2
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef struct{
+	uint32_t opens;					/* door reached the opened limit switch */
+	uint32_t closes;				/* door reached the closed limit switch */
+	uint32_t stalls;				/* motor driven against the end of travel or the obstacle */
+	double maxStallMs;				/* longest stall before the motor was stopped, less
+									   the inrush blanking time of the Control ECU */
+	double buzzerOnMs;
+	double doorPosition;			/* 0 closed --> 1 opened */
+}SimControlBoard_Stats;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/* sim_control_board.c */
+void SimControlBoard_attach(Sim_Ecu * ecu);
+void SimControlBoard_getStats(const Sim_Ecu * ecu,SimControlBoard_Stats * stats);
+/*
+ * Faults of the door : limitSwitches 0 leaves the limit switches unconnected,
+ * the door then stalls at each end of its travel. blockAt 0 --> 1 is the
+ * position of an obstacle that stops the door while it opens, < 0 for none.
+ */
+void SimControlBoard_setFaults(Sim_Ecu * ecu,uint8_t limitSwitches,double blockAt);
+
+/*
+ * sim_hmi_board.c
+ * The keys are pressed one after the other, each one is held till the
+ * HMI ECU reads it. Keys are 0-9 + - * % = and C, a space waits 1 second.
+ */
+void SimHmiBoard_attach(Sim_Ecu * ecu,const char * keys,uint8_t address);
+void SimHmiBoard_pressKeys(Sim_Ecu * ecu,const char * keys);
+uint8_t SimHmiBoard_keysDone(const Sim_Ecu * ecu);
+void SimHmiBoard_getLine(const Sim_Ecu * ecu,uint8_t row,char * line);
+
+/*
+ * sim_bench.c
+ * Time to unlock benchmark, the results are written to PREFIX.csv and PREFIX.json.
+ * ecus : the Control ECU, the panel that gets the keys, then the other panels.
+ */
+uint8_t SimBench_run(Sim_Ecu * const * ecus,uint8_t count,unsigned long iterations,const char * password,const char * prefix);
+
+#endif /* SIM_BOARDS_H_ */
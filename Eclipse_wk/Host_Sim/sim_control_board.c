@@ -0,0 +1,403 @@
+ /******************************************************************************
+ *
+ * Module: Host Simulator
+ *
+ * File Name: sim_control_board.c
+ *
+ * Description: Devices of the Control ECU board :
+ *              Door motor, direction on PB0/PB1 and enable on PB3/OC0, with
+ *              its 0.5 ohm shunt on ADC0 and its encoder on ICP1.
+ *              Door limit switches, opened on PD2/INT0 and closed on PD3/INT1,
+ *              active low.
+ *              Buzzer on PD7/OC2.
+ *              door_sim can leave the limit switches unconnected or block
+ *              the door with an obstacle, the motor then stalls.
+ *
+ *              The motor is a first order model : the speed goes to the speed
+ *              of the applied voltage less the door friction, the current is
+ *              the voltage not balanced by the back EMF over the winding.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include <math.h>
+#include <string.h>
+#include <avr/io.h>
+#include "sim_boards.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define SIM_MOTOR_IN1_PIN			PB0
+/* PB0 is XCK once the Control ECU is in the synchronous mode, IN1 is wired to PB2 */
+#define SIM_MOTOR_SYNC_IN1_PIN		PB2
+#define SIM_MOTOR_IN2_PIN			PB1
+#define SIM_MOTOR_ENABLE_PIN		PB3
+#define SIM_LIMIT_OPENED_PIN		PD2
+#define SIM_LIMIT_CLOSED_PIN		PD3
+#define SIM_SHUNT_ADC_CHANNEL		0
+
+/* Motor and door */
+#define SIM_MOTOR_NO_LOAD_RPM		330.0
+#define SIM_MOTOR_TIME_CONSTANT		0.05		/* seconds */
+#define SIM_MOTOR_STALL_CURRENT		2.5			/* amperes at 100% */
+#define SIM_DOOR_FRICTION_CURRENT	0.3			/* amperes */
+#define SIM_ENCODER_PULSES_PER_REV	20
+#define SIM_DOOR_TRAVEL_PULSES		400.0
+/* The limit switches are pressed in the last pulses of the travel */
+#define SIM_LIMIT_SWITCH_PULSES		2.0
+/* Encoder pulses per second below which the coasting door is at rest */
+#define SIM_DOOR_REST_SPEED			0.01
+#define SIM_SHUNT_OHMS				0.5
+#define SIM_ADC_REFERENCE			5.0
+/* The Control ECU ignores the shunt current for this time after the motor starts */
+#define SIM_INRUSH_BLANKING_CYCLES	(250 * SIM_CYCLES_PER_MS)
+
+/* The motor is integrated in steps of 100 us */
+#define SIM_MOTOR_STEP_CYCLES		(100 * SIM_CYCLES_PER_US)
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef struct{
+	double position;				/* encoder pulses from closed */
+	double speed;					/* pulses per second, positive to open */
+	double current;					/* amperes */
+	Sim_Time lastUpdate;
+	int8_t direction;				/* from PB0/PB1, PB2/PB1 on the synchronous link */
+	uint8_t opened;					/* limit switches pressed */
+	uint8_t closed;
+	uint8_t stalled;
+	Sim_Time motorStart;			/* last start of the motor */
+	Sim_Time stallStart;
+	uint8_t limitSwitches;			/* the limit switches are connected */
+	double blockPosition;			/* encoder pulses of the obstacle, < 0 for none */
+	uint8_t buzzerOn;
+	double buzzerFrequency;
+	SimControlBoard_Stats stats;
+}SimControlBoard_State;
+
+/*******************************************************************************
+ *                      Global Variables                                       *
+ *******************************************************************************/
+
+static SimControlBoard_State g_controlBoard;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void SimControlBoard_update(Sim_Ecu * ecu);
+static Sim_Time SimControlBoard_nextEvent(Sim_Ecu * ecu);
+static uint8_t SimControlBoard_readPins(Sim_Ecu * ecu,uint8_t port);
+static void SimControlBoard_portWritten(Sim_Ecu * ecu,uint8_t port);
+static uint16_t SimControlBoard_readAdc(Sim_Ecu * ecu,uint8_t channel);
+static double SimControlBoard_drive(Sim_Ecu * ecu,const SimControlBoard_State * state);
+static void SimControlBoard_step(Sim_Ecu * ecu,SimControlBoard_State * state,Sim_Time cycles);
+static void SimControlBoard_updateBuzzer(Sim_Ecu * ecu,SimControlBoard_State * state,Sim_Time cycles);
+
+static const Sim_Board g_controlBoardDevices = {
+		SimControlBoard_update, SimControlBoard_nextEvent, SimControlBoard_readPins,
+		SimControlBoard_portWritten, SimControlBoard_readAdc
+};
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Connect the devices to the ECU, the door starts closed.
+ */
+void SimControlBoard_attach(Sim_Ecu * ecu)
+{
+	SimControlBoard_State * state = &g_controlBoard;
+
+	memset(state, 0, sizeof(SimControlBoard_State));
+	state->closed = 1;
+	state->limitSwitches = 1;
+	state->blockPosition = -1;
+
+	ecu->board = &g_controlBoardDevices;
+	ecu->boardState = state;
+}
+
+/*
+ * Description :
+ * Return the statistics of the devices.
+ */
+void SimControlBoard_getStats(const Sim_Ecu * ecu,SimControlBoard_Stats * stats)
+{
+	const SimControlBoard_State * state = ecu->boardState;
+
+	*stats = state->stats;
+	stats->doorPosition = state->position / SIM_DOOR_TRAVEL_PULSES;
+}
+
+/*
+ * Description :
+ * Faults of the door : limitSwitches 0 leaves the limit switches unconnected,
+ * the door then stalls at each end of its travel. blockAt 0 --> 1 is the
+ * position of an obstacle that stops the door while it opens, < 0 for none.
+ */
+void SimControlBoard_setFaults(Sim_Ecu * ecu,uint8_t limitSwitches,double blockAt)
+{
+	SimControlBoard_State * state = ecu->boardState;
+
+	state->limitSwitches = limitSwitches;
+	state->blockPosition = (blockAt < 0) ? -1 : blockAt * SIM_DOOR_TRAVEL_PULSES;
+}
+
+
+/*******************************************************************************
+ *                      Private Functions                                      *
+ *******************************************************************************/
+
+static void SimControlBoard_update(Sim_Ecu * ecu)
+{
+	SimControlBoard_State * state = ecu->boardState;
+
+	while(ecu->now >= state->lastUpdate + SIM_MOTOR_STEP_CYCLES)
+	{
+		SimControlBoard_step(ecu, state, SIM_MOTOR_STEP_CYCLES);
+	}
+}
+
+static Sim_Time SimControlBoard_nextEvent(Sim_Ecu * ecu)
+{
+	SimControlBoard_State * state = ecu->boardState;
+
+	/* Nothing changes while the motor is stopped and the buzzer is off */
+	if((state->direction != 0) || (state->speed != 0) || state->buzzerOn)
+	{
+		return state->lastUpdate + SIM_MOTOR_STEP_CYCLES;
+	}
+	return SIM_TIME_NEVER;
+}
+
+static uint8_t SimControlBoard_readPins(Sim_Ecu * ecu,uint8_t port)
+{
+	SimControlBoard_State * state = ecu->boardState;
+	uint8_t pins = 0xFF;
+
+	if((port == SIM_PORT_D) && state->limitSwitches)
+	{
+		if(state->opened)
+		{
+			pins &= ~(1<<SIM_LIMIT_OPENED_PIN);
+		}
+		if(state->closed)
+		{
+			pins &= ~(1<<SIM_LIMIT_CLOSED_PIN);
+		}
+	}
+	return pins;
+}
+
+static void SimControlBoard_portWritten(Sim_Ecu * ecu,uint8_t port)
+{
+	SimControlBoard_State * state = ecu->boardState;
+	uint8_t pins;
+	uint8_t in1;
+	int8_t direction;
+
+	if(port != SIM_PORT_B)
+	{
+		return;
+	}
+
+	pins = Sim_outputPins(ecu, SIM_PORT_B);
+	in1 = (ecu->uart.ucsrc & (1<<UMSEL)) ? SIM_MOTOR_SYNC_IN1_PIN : SIM_MOTOR_IN1_PIN;
+	direction = 0;
+	if((pins & (1<<in1)) && (!(pins & (1<<SIM_MOTOR_IN2_PIN))))
+	{
+		direction = 1;
+	}
+	else if((!(pins & (1<<in1))) && (pins & (1<<SIM_MOTOR_IN2_PIN)))
+	{
+		direction = -1;
+	}
+
+	if(direction != state->direction)
+	{
+		/* Catch up with the old direction before the change */
+		SimControlBoard_update(ecu);
+		state->direction = direction;
+		if(direction != 0)
+		{
+			state->motorStart = ecu->now;
+		}
+		SimBench_event(ecu, SIM_EVENT_MOTOR, (uint32_t)(int32_t)direction);
+		Sim_trace(ecu, "Motor %s, door at %.0f%%", (direction > 0) ? "opening" : ((direction < 0) ? "closing" : "stopped"),
+				100.0 * state->position / SIM_DOOR_TRAVEL_PULSES);
+	}
+}
+
+static uint16_t SimControlBoard_readAdc(Sim_Ecu * ecu,uint8_t channel)
+{
+	SimControlBoard_State * state = ecu->boardState;
+	double adc;
+
+	if(channel != SIM_SHUNT_ADC_CHANNEL)
+	{
+		return 0;
+	}
+	adc = (state->current * SIM_SHUNT_OHMS / SIM_ADC_REFERENCE) * 1023.0;
+	return (adc > 1023.0) ? 1023 : (uint16_t)adc;
+}
+
+/* Average voltage on the motor as a part of the supply, signed by the direction */
+static double SimControlBoard_drive(Sim_Ecu * ecu,const SimControlBoard_State * state)
+{
+	double duty;
+	double frequency;
+
+	if(!SimTimer_pwmOutput(ecu, 0, &duty, &frequency))
+	{
+		duty = (Sim_outputPins(ecu, SIM_PORT_B) & (1<<SIM_MOTOR_ENABLE_PIN)) ? 1.0 : 0.0;
+	}
+	return state->direction * duty;
+}
+
+static void SimControlBoard_step(Sim_Ecu * ecu,SimControlBoard_State * state,Sim_Time cycles)
+{
+	const double noLoadSpeed = SIM_MOTOR_NO_LOAD_RPM * SIM_ENCODER_PULSES_PER_REV / 60.0;
+	const double frictionSpeed = noLoadSpeed * SIM_DOOR_FRICTION_CURRENT / SIM_MOTOR_STALL_CURRENT;
+	double dt = (double)cycles / SIM_F_CPU;
+	double drive = SimControlBoard_drive(ecu, state);
+	double target = drive * noLoadSpeed;
+	double oldPosition = state->position;
+	double speed;
+	double pulse;
+	uint8_t atEnd;
+	uint8_t opened;
+	uint8_t closed;
+	uint8_t stalled;
+	Sim_Time detectable;
+
+	/* The friction holds the door below its torque */
+	if(fabs(target) <= frictionSpeed)
+	{
+		target = 0;
+	}
+	else
+	{
+		target -= (target > 0) ? frictionSpeed : -frictionSpeed;
+	}
+	speed = target + (state->speed - target) * exp(-dt / SIM_MOTOR_TIME_CONSTANT);
+	if((target == 0) && (fabs(speed) < SIM_DOOR_REST_SPEED))
+	{
+		speed = 0;
+	}
+	state->position += 0.5 * (state->speed + speed) * dt;
+	state->speed = speed;
+
+	/* Mechanical ends of the travel */
+	atEnd = 0;
+	if(state->position >= SIM_DOOR_TRAVEL_PULSES)
+	{
+		state->position = SIM_DOOR_TRAVEL_PULSES;
+		state->speed = 0;
+		atEnd = (drive > 0);
+	}
+	else if(state->position <= 0)
+	{
+		state->position = 0;
+		state->speed = 0;
+		atEnd = (drive < 0);
+	}
+	/* The obstacle stops the opening door, it can still close */
+	if((state->blockPosition >= 0) && (oldPosition <= state->blockPosition) && (state->position > state->blockPosition))
+	{
+		state->position = state->blockPosition;
+		state->speed = 0;
+		atEnd = (drive > 0);
+	}
+	state->current = fabs(SIM_MOTOR_STALL_CURRENT * (drive - state->speed / noLoadSpeed));
+
+	/* One encoder pulse (rising edge on ICP1) at each whole pulse position */
+	if(state->position > oldPosition)
+	{
+		for(pulse=floor(oldPosition) + 1;pulse<=state->position;pulse++)
+		{
+			SimTimer_inputCapture(ecu, state->lastUpdate +
+					(Sim_Time)(cycles * (pulse - oldPosition) / (state->position - oldPosition)), 1);
+		}
+	}
+	else if(state->position < oldPosition)
+	{
+		for(pulse=ceil(oldPosition) - 1;pulse>=state->position;pulse--)
+		{
+			SimTimer_inputCapture(ecu, state->lastUpdate +
+					(Sim_Time)(cycles * (oldPosition - pulse) / (oldPosition - state->position)), 1);
+		}
+	}
+	state->lastUpdate += cycles;
+
+	opened = (state->position >= (SIM_DOOR_TRAVEL_PULSES - SIM_LIMIT_SWITCH_PULSES));
+	closed = (state->position <= SIM_LIMIT_SWITCH_PULSES);
+	if(opened && (!state->opened))
+	{
+		state->stats.opens++;
+		Sim_trace(ecu, "Door opened limit switch pressed");
+	}
+	if(closed && (!state->closed))
+	{
+		state->stats.closes++;
+		Sim_trace(ecu, "Door closed limit switch pressed");
+	}
+	state->opened = opened;
+	state->closed = closed;
+
+	stalled = atEnd && (state->current > SIM_DOOR_FRICTION_CURRENT);
+	if(stalled && (!state->stalled))
+	{
+		state->stats.stalls++;
+		state->stallStart = state->lastUpdate;
+		Sim_trace(ecu, "Motor stalled at %.0f%%, %.2f A", 100.0 * state->position / SIM_DOOR_TRAVEL_PULSES, state->current);
+	}
+	else if((!stalled) && state->stalled)
+	{
+		/* The Control ECU can only see the stall after its inrush blanking time */
+		detectable = state->motorStart + SIM_INRUSH_BLANKING_CYCLES;
+		if(detectable < state->stallStart)
+		{
+			detectable = state->stallStart;
+		}
+		detectable = (state->lastUpdate > detectable) ? (state->lastUpdate - detectable) : 0;
+		if((double)detectable / SIM_CYCLES_PER_MS > state->stats.maxStallMs)
+		{
+			state->stats.maxStallMs = (double)detectable / SIM_CYCLES_PER_MS;
+		}
+		SimBench_event(ecu, SIM_EVENT_STALL, (uint32_t)detectable);
+		Sim_trace(ecu, "Motor stall ended after %.1f ms", (double)(state->lastUpdate - state->stallStart) / SIM_CYCLES_PER_MS);
+	}
+	state->stalled = stalled;
+
+	SimControlBoard_updateBuzzer(ecu, state, cycles);
+}
+
+static void SimControlBoard_updateBuzzer(Sim_Ecu * ecu,SimControlBoard_State * state,Sim_Time cycles)
+{
+	double duty;
+	double frequency;
+	uint8_t on = SimTimer_pwmOutput(ecu, 2, &duty, &frequency) && (duty > 0) && (duty < 1) && (frequency > 0);
+
+	if(on)
+	{
+		state->stats.buzzerOnMs += (double)cycles / SIM_CYCLES_PER_MS;
+		if((!state->buzzerOn) || (frequency != state->buzzerFrequency))
+		{
+			Sim_trace(ecu, "Buzzer %.0f Hz", frequency);
+		}
+		state->buzzerFrequency = frequency;
+	}
+	else if(state->buzzerOn)
+	{
+		Sim_trace(ecu, "Buzzer off");
+	}
+	state->buzzerOn = on;
+}
@@ -0,0 +1,856 @@
+ /******************************************************************************
+ *
+ * Module: Host Simulator
+ *
+ * File Name: sim_core.c
+ *
+ * Description: Loading of the ECU libraries, scheduling of the ECUs,
+ *              simulated time, interrupts and the register accesses.
+ *
+ *              Each ECU runs its main() in a coroutine. The ECU running now
+ *              goes back to the scheduler once it is ahead of another ECU
+ *              by more than one UART frame time, the shortest time any of
+ *              its actions can be seen by the other ECUs, so the bytes on the
+ *              link always arrive in the simulated time order.
+ *
+ *              The time is discrete event : it jumps from one event of the
+ *              peripherals and the devices to the next one. An ECU waiting
+ *              for an interrupt or polling in an idle loop skips the whole
+ *              wait, and while it is idle the other ECUs may run till its
+ *              next event, so the idle hours of a soak test cost nothing.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include <dlfcn.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <avr/io.h>
+#include "sim.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define SIM_STACK_SIZE		(1024 * 1024)
+/* STACK_MONITOR_CANARY of stack_monitor.h, the ECU code finds its deepest stack */
+#define SIM_STACK_CANARY	0xC5
+
+#define SIM_REGISTER_NAME(NAME)		#NAME,
+
+/*******************************************************************************
+ *                      Global Variables                                       *
+ *******************************************************************************/
+
+Sim_Ecu * g_simEcu = NULL;
+uint8_t g_simTrace = 0;
+
+static ucontext_t g_schedulerContext;
+/* The running ECU goes back to the scheduler once its time passes this limit */
+static Sim_Time g_runLimit = 0;
+
+static const char * const g_registerNames[SIM_NUM_REGISTERS] = {
+		SIM_REGISTERS(SIM_REGISTER_NAME)
+};
+
+static const char * const g_vectorNames[SIM_NUM_VECTORS] = {
+		NULL, "INT0_vect", "INT1_vect", "INT2_vect", "TIMER2_COMP_vect", "TIMER2_OVF_vect",
+		"TIMER1_CAPT_vect", "TIMER1_COMPA_vect", "TIMER1_COMPB_vect", "TIMER1_OVF_vect",
+		"TIMER0_COMP_vect", "TIMER0_OVF_vect", "SPI_STC_vect", "USART_RXC_vect",
+		"USART_UDRE_vect", "USART_TXC_vect", "ADC_vect", "EE_RDY_vect", "ANA_COMP_vect",
+		"TWI_vect", "SPM_RDY_vect"
+};
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void Sim_ecuEntry(void);
+static void Sim_yield(Sim_Ecu * ecu);
+static void Sim_advanceTo(Sim_Ecu * ecu,Sim_Time target,uint8_t idle);
+static void Sim_recordAccess(Sim_Ecu * ecu,Sim_RegisterId id,uint8_t write,uint16_t value);
+static Sim_Time Sim_lookahead(Sim_Ecu * sender);
+static Sim_Time Sim_frameLookahead(const Sim_Ecu * sender);
+static void Sim_checkPinInterrupts(Sim_Ecu * ecu);
+static uint8_t Sim_pendingVector(Sim_Ecu * ecu);
+static void Sim_serviceInterrupts(Sim_Ecu * ecu);
+static uint8_t Sim_portOf(Sim_RegisterId id,Sim_RegisterId first);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Load the ECU library and prepare the coroutine of its main(),
+ * the registers start with their reset values.
+ */
+void Sim_loadEcu(Sim_Ecu * ecu,const char * name,const char * library)
+{
+	uint8_t i;
+
+	memset(ecu, 0, sizeof(Sim_Ecu));
+	ecu->name = name;
+
+	/* Each ECU keeps its own copy of the drivers and their globals */
+	ecu->library = dlopen(library, RTLD_NOW | RTLD_LOCAL);
+	if(ecu->library == NULL)
+	{
+		Sim_fatal(ecu, "can not load %s", dlerror());
+	}
+	*(void **)(&ecu->main) = dlsym(ecu->library, "main");
+	if(ecu->main == NULL)
+	{
+		Sim_fatal(ecu, "no main() in %s", library);
+	}
+	for(i=1;i<SIM_NUM_VECTORS;i++)
+	{
+		*(void **)(&ecu->vectors[i]) = dlsym(ecu->library, g_vectorNames[i]);
+	}
+
+	/* Reset values */
+	ecu->uart.ucsrc = (1<<UCSZ1) | (1<<UCSZ0);
+	ecu->twi.twsr = 0xF8;
+	ecu->adc.firstConversion = 1;
+	SimTimer_reset(ecu);
+
+	ecu->stack = malloc(SIM_STACK_SIZE);
+	if(ecu->stack == NULL)
+	{
+		Sim_fatal(ecu, "no memory for the stack");
+	}
+	memset(ecu->stack, SIM_STACK_CANARY, SIM_STACK_SIZE);
+	getcontext(&ecu->context);
+	ecu->context.uc_stack.ss_sp = ecu->stack;
+	ecu->context.uc_stack.ss_size = SIM_STACK_SIZE;
+	ecu->context.uc_link = &g_schedulerContext;
+	makecontext(&ecu->context, Sim_ecuEntry, 0);
+}
+
+/*
+ * Description :
+ * Connect the UARTs of the two ECUs with a crossed TX/RX link. The Control ECU
+ * may be connected to several panels : its TX goes to the RX of all of them,
+ * their TX are wired together to its RX.
+ */
+void Sim_connect(Sim_Ecu * ecu1,Sim_Ecu * ecu2)
+{
+	if((ecu1->peerCount == SIM_MAX_PANELS) || (ecu2->peerCount == SIM_MAX_PANELS))
+	{
+		Sim_fatal(ecu1, "too many ECUs on the link");
+	}
+	ecu1->peers[ecu1->peerCount++] = ecu2;
+	ecu2->peers[ecu2->peerCount++] = ecu1;
+}
+
+/*
+ * Description :
+ * Run the ECUs till the simulated time reaches until, or till done() returns TRUE.
+ * The ECU that is behind in time always runs first.
+ */
+void Sim_run(Sim_Ecu * const * ecus,uint8_t count,Sim_Time until,uint8_t (*done)(void))
+{
+	Sim_Ecu * next;
+	Sim_Ecu * other;
+	Sim_Time lookahead;
+	uint8_t i;
+
+	while((done == NULL) || (!done()))
+	{
+		next = NULL;
+		for(i=0;i<count;i++)
+		{
+			if((!ecus[i]->finished) && ((next == NULL) || (ecus[i]->now < next->now)))
+			{
+				next = ecus[i];
+			}
+		}
+
+		if((next == NULL) || (next->now >= until))
+		{
+			break;
+		}
+
+		/* Stay within the lookahead of the other ECUs */
+		g_runLimit = until;
+		for(i=0;i<count;i++)
+		{
+			other = ecus[i];
+			if((other != next) && (!other->finished) && (other->now < g_runLimit))
+			{
+				lookahead = Sim_lookahead(other);
+				if(lookahead < g_runLimit - other->now)
+				{
+					g_runLimit = other->now + lookahead;
+				}
+			}
+		}
+
+		g_simEcu = next;
+		swapcontext(&g_schedulerContext, &next->context);
+		g_simEcu = NULL;
+	}
+}
+
+/*
+ * Description :
+ * Advance the time of the running ECU, the peripherals and the devices are
+ * updated and the pending interrupts are served at each event on the way.
+ * In an idle loop the time goes on till the next event.
+ */
+void Sim_advance(Sim_Time cycles)
+{
+	Sim_Ecu * ecu = g_simEcu;
+
+	Sim_advanceTo(ecu, ecu->now + cycles, ecu->loopAccesses >= SIM_IDLE_ACCESSES);
+}
+
+/*
+ * Description :
+ * Bring the peripherals and the devices of the ECU to its current time.
+ */
+void Sim_update(Sim_Ecu * ecu)
+{
+	SimTimer_update(ecu);
+	SimUart_update(ecu);
+	SimTwi_update(ecu);
+	SimAdc_update(ecu);
+	if((ecu->board != NULL) && (ecu->board->update != NULL))
+	{
+		ecu->board->update(ecu);
+	}
+	Sim_checkPinInterrupts(ecu);
+	ecu->events++;
+}
+
+/*
+ * Description :
+ * Return the time of the next event of the peripherals and the devices.
+ */
+Sim_Time Sim_nextEvent(Sim_Ecu * ecu)
+{
+	Sim_Time next = SimTimer_nextEvent(ecu);
+	Sim_Time event;
+
+	event = SimUart_nextEvent(ecu);
+	if(event < next)
+	{
+		next = event;
+	}
+	event = SimTwi_nextEvent(ecu);
+	if(event < next)
+	{
+		next = event;
+	}
+	event = SimAdc_nextEvent(ecu);
+	if(event < next)
+	{
+		next = event;
+	}
+	if((ecu->board != NULL) && (ecu->board->nextEvent != NULL))
+	{
+		event = ecu->board->nextEvent(ecu);
+		if(event < next)
+		{
+			next = event;
+		}
+	}
+	return next;
+}
+
+/*
+ * Description :
+ * Update the ECU at its current time and compute its next event again,
+ * for the changes outside of the register writes, like a key seen pressed.
+ */
+void Sim_reschedule(Sim_Ecu * ecu)
+{
+	ecu->nextEvent = 0;
+}
+
+/*
+ * Description :
+ * The running ECU has sent something that reaches the peer at time :
+ * the peer may answer from then on, even if it was idle.
+ */
+void Sim_wakePeer(Sim_Ecu * ecu,const Sim_Ecu * peer,Sim_Time time)
+{
+	Sim_Time limit = time + Sim_frameLookahead(peer);
+
+	if((ecu == g_simEcu) && (limit < g_runLimit))
+	{
+		g_runLimit = limit;
+	}
+}
+
+/*
+ * Description :
+ * Return the levels of the port pins as read from PINx :
+ * the output pins give PORTx, the input pins give the devices levels.
+ */
+uint8_t Sim_readPort(Sim_Ecu * ecu,uint8_t port)
+{
+	uint8_t ddr = ecu->io[SIM_DDRA + (3 * port)];
+	uint8_t external = 0xFF;
+
+	if((ecu->board != NULL) && (ecu->board->readPins != NULL))
+	{
+		external = ecu->board->readPins(ecu, port);
+	}
+	external &= SimUart_readPins(ecu, port);
+	return (Sim_outputPins(ecu, port) & ddr) | (external & (~ddr));
+}
+
+/*
+ * Description :
+ * Return the levels the ECU drives on the output pins of the port.
+ */
+uint8_t Sim_outputPins(Sim_Ecu * ecu,uint8_t port)
+{
+	return ecu->io[SIM_PORTA + (3 * port)] & ecu->io[SIM_DDRA + (3 * port)];
+}
+
+/*
+ * Description :
+ * Print a trace line with the simulated time, only when tracing is enabled.
+ */
+void Sim_trace(const Sim_Ecu * ecu,const char * format,...)
+{
+	va_list args;
+
+	if(!g_simTrace)
+	{
+		return;
+	}
+	printf("%12.3f ms  %-8s ", Sim_timeMs(ecu->now), ecu->name);
+	va_start(args, format);
+	vprintf(format, args);
+	va_end(args);
+	printf("\n");
+}
+
+/*
+ * Description :
+ * Report an error of the ECU code or of the simulator and stop.
+ */
+void Sim_fatal(const Sim_Ecu * ecu,const char * format,...)
+{
+	va_list args;
+
+	fflush(stdout);
+	fprintf(stderr, "%12.3f ms  %-8s error: ", Sim_timeMs(ecu->now), (ecu->name != NULL) ? ecu->name : "");
+	va_start(args, format);
+	vfprintf(stderr, format, args);
+	va_end(args);
+	fprintf(stderr, "\n");
+	exit(2);
+}
+
+/*
+ * Description :
+ * Convert the simulated time to milliseconds.
+ */
+double Sim_timeMs(Sim_Time time)
+{
+	return (double)time / SIM_CYCLES_PER_MS;
+}
+
+/*
+ * Description :
+ * Return the avr-libc name of the interrupt vector.
+ */
+const char * Sim_vectorName(uint8_t vector)
+{
+	return ((vector > 0) && (vector < SIM_NUM_VECTORS)) ? g_vectorNames[vector] : "?";
+}
+
+
+/*******************************************************************************
+ *                      Register access of the ECU code                        *
+ *******************************************************************************/
+
+uint8_t Sim_readRegister(Sim_Register reg)
+{
+	Sim_Ecu * ecu = g_simEcu;
+	Sim_RegisterId id = (Sim_RegisterId)reg.id;
+	uint8_t value;
+
+	switch(id)
+	{
+	case SIM_SREG:
+		value = ecu->interruptEnable ? 0x80 : 0x00;
+		break;
+	case SIM_PINA: case SIM_PINB: case SIM_PINC: case SIM_PIND:
+		value = Sim_readPort(ecu, Sim_portOf(id, SIM_PINA));
+		break;
+	case SIM_UCSRA: case SIM_UCSRB: case SIM_UCSRC: case SIM_UBRRH: case SIM_UBRRL: case SIM_UDR:
+		value = SimUart_read(ecu, id);
+		break;
+	case SIM_TWBR: case SIM_TWSR: case SIM_TWAR: case SIM_TWDR: case SIM_TWCR:
+		value = SimTwi_read(ecu, id);
+		break;
+	case SIM_TCCR0: case SIM_TCNT0: case SIM_OCR0: case SIM_TCCR2: case SIM_TCNT2: case SIM_OCR2:
+	case SIM_TCCR1A: case SIM_TCCR1B: case SIM_TIFR:
+		value = SimTimer_read(ecu, id);
+		break;
+	case SIM_TCNT1: case SIM_OCR1A: case SIM_OCR1B: case SIM_ICR1: case SIM_ADC:
+		Sim_fatal(ecu, "8-bit read of the 16-bit register %s", g_registerNames[id]);
+		value = 0;
+		break;
+	default:
+		value = ecu->io[id];
+		break;
+	}
+
+	/* Reading UDR takes the byte out of the receive FIFO */
+	if(id == SIM_UDR)
+	{
+		Sim_reschedule(ecu);
+	}
+	Sim_recordAccess(ecu, id, 0, value);
+	ecu->accesses++;
+	Sim_advance(SIM_ACCESS_CYCLES);
+	return value;
+}
+
+void Sim_writeRegister(Sim_Register reg,uint8_t value)
+{
+	Sim_Ecu * ecu = g_simEcu;
+	Sim_RegisterId id = (Sim_RegisterId)reg.id;
+
+	switch(id)
+	{
+	case SIM_SREG:
+		ecu->interruptEnable = (value >> 7) & 0x01;
+		break;
+	case SIM_PORTA: case SIM_PORTB: case SIM_PORTC: case SIM_PORTD:
+	case SIM_DDRA: case SIM_DDRB: case SIM_DDRC: case SIM_DDRD:
+		ecu->io[id] = value;
+		SimUart_portWritten(ecu, (id - SIM_PORTA) / 3);
+		if((ecu->board != NULL) && (ecu->board->portWritten != NULL))
+		{
+			ecu->board->portWritten(ecu, (id - SIM_PORTA) / 3);
+		}
+		break;
+	case SIM_PINA: case SIM_PINB: case SIM_PINC: case SIM_PIND:
+		/* Read only on the ATmega32 */
+		break;
+	case SIM_UCSRA: case SIM_UCSRB: case SIM_UCSRC: case SIM_UBRRH: case SIM_UBRRL: case SIM_UDR:
+		SimUart_write(ecu, id, value);
+		break;
+	case SIM_TWBR: case SIM_TWSR: case SIM_TWAR: case SIM_TWDR: case SIM_TWCR:
+		SimTwi_write(ecu, id, value);
+		break;
+	case SIM_TCCR0: case SIM_TCNT0: case SIM_OCR0: case SIM_TCCR2: case SIM_TCNT2: case SIM_OCR2:
+	case SIM_TCCR1A: case SIM_TCCR1B: case SIM_TIFR:
+		SimTimer_write(ecu, id, value);
+		break;
+	case SIM_GIFR:
+		/* Flags are cleared by writing one */
+		ecu->io[id] &= ~value;
+		break;
+	case SIM_ADMUX: case SIM_ADCSRA: case SIM_SFIOR:
+		SimAdc_write(ecu, id, value);
+		break;
+	case SIM_TCNT1: case SIM_OCR1A: case SIM_OCR1B: case SIM_ICR1: case SIM_ADC:
+		Sim_fatal(ecu, "8-bit write of the 16-bit register %s", g_registerNames[id]);
+		break;
+	default:
+		ecu->io[id] = value;
+		break;
+	}
+
+	/* Any write may start something or enable an interrupt */
+	Sim_reschedule(ecu);
+	Sim_recordAccess(ecu, id, 1, value);
+	ecu->accesses++;
+	Sim_advance(SIM_ACCESS_CYCLES);
+}
+
+uint16_t Sim_readRegister16(Sim_Register reg)
+{
+	Sim_Ecu * ecu = g_simEcu;
+	Sim_RegisterId id = (Sim_RegisterId)reg.id;
+	uint16_t value = 0;
+
+	switch(id)
+	{
+	case SIM_TCNT1: case SIM_OCR1A: case SIM_OCR1B: case SIM_ICR1:
+		value = SimTimer_read16(ecu, id);
+		break;
+	case SIM_ADC:
+		value = SimAdc_read16(ecu);
+		break;
+	default:
+		Sim_fatal(ecu, "16-bit read of the 8-bit register %s", g_registerNames[id]);
+		break;
+	}
+
+	/* Two I/O accesses */
+	Sim_recordAccess(ecu, id, 0, value);
+	ecu->accesses += 2;
+	Sim_advance(2 * SIM_ACCESS_CYCLES);
+	return value;
+}
+
+void Sim_writeRegister16(Sim_Register reg,uint16_t value)
+{
+	Sim_Ecu * ecu = g_simEcu;
+	Sim_RegisterId id = (Sim_RegisterId)reg.id;
+
+	switch(id)
+	{
+	case SIM_TCNT1: case SIM_OCR1A: case SIM_OCR1B: case SIM_ICR1:
+		SimTimer_write16(ecu, id, value);
+		break;
+	default:
+		Sim_fatal(ecu, "16-bit write of the register %s", g_registerNames[id]);
+		break;
+	}
+
+	Sim_reschedule(ecu);
+	Sim_recordAccess(ecu, id, 1, value);
+	ecu->accesses += 2;
+	Sim_advance(2 * SIM_ACCESS_CYCLES);
+}
+
+void Sim_setInterruptEnable(uint8_t enable)
+{
+	g_simEcu->interruptEnable = enable;
+	Sim_reschedule(g_simEcu);
+	Sim_advance(1);
+}
+
+void Sim_delayUs(double us)
+{
+	Sim_Ecu * ecu = g_simEcu;
+	double cycles = us * SIM_CYCLES_PER_US;
+
+	/* A loop with a delay is doing something, not polling */
+	ecu->loopPeriod = 0;
+	ecu->loopAccesses = 0;
+	Sim_advanceTo(ecu, ecu->now + ((cycles > 0) ? (Sim_Time)(cycles + 0.5) : 0), 0);
+}
+
+void Sim_sleep(void)
+{
+	Sim_Ecu * ecu = g_simEcu;
+	Sim_Time start = ecu->now;
+
+	/* The sleep runs before the interrupts pending at the sei */
+	ecu->interruptEnable = 1;
+	Sim_reschedule(ecu);
+	if(ecu->io[SIM_MCUCR] & (1<<SE))
+	{
+		/* A loop that sleeps is not polling, its accesses run in time */
+		ecu->loopPeriod = 0;
+		ecu->loopAccesses = 0;
+		ecu->sleeping = 1;
+		/* The events on the way may have no interrupt */
+		while(ecu->sleeping)
+		{
+			Sim_advanceTo(ecu, ecu->now + 1, 1);
+		}
+		ecu->sleepCycles += ecu->now - start;
+	}
+	else
+	{
+		Sim_advance(1);
+	}
+	ecu->interruptEnable = 0;
+}
+
+void Sim_getStack(const uint8_t ** bottom,const uint8_t ** top)
+{
+	Sim_Ecu * ecu = g_simEcu;
+
+	*bottom = (const uint8_t *)ecu->stack;
+	*top = (const uint8_t *)ecu->stack + SIM_STACK_SIZE - 1;
+}
+
+
+/*******************************************************************************
+ *                      Private Functions                                      *
+ *******************************************************************************/
+
+static void Sim_ecuEntry(void)
+{
+	Sim_Ecu * ecu = g_simEcu;
+
+	ecu->main();
+	ecu->finished = 1;
+	Sim_trace(ecu, "main() returned");
+	/* uc_link goes back to the scheduler */
+}
+
+static void Sim_yield(Sim_Ecu * ecu)
+{
+	swapcontext(&ecu->context, &g_schedulerContext);
+	/* The scheduler runs this ECU again, the other ECU may have sent frames meanwhile */
+	g_simEcu = ecu;
+	Sim_reschedule(ecu);
+}
+
+/*
+ * Advance the ECU to target, and to its next event too when it is idle.
+ * The time jumps to the next event, or to the run limit of the ECU, and
+ * the peripherals are only updated at the events and after register writes.
+ */
+static void Sim_advanceTo(Sim_Ecu * ecu,Sim_Time target,uint8_t idle)
+{
+	Sim_Time start = ecu->now;
+	Sim_Time next;
+	uint8_t eventReached = 0;
+
+	for(;;)
+	{
+		if(ecu->now >= ecu->nextEvent)
+		{
+			eventReached |= (ecu->nextEvent != 0);
+			Sim_update(ecu);
+			Sim_serviceInterrupts(ecu);
+			ecu->nextEvent = Sim_nextEvent(ecu);
+			if(ecu->nextEvent <= ecu->now)
+			{
+				/* Something is already due, go on cycle by cycle */
+				ecu->nextEvent = ecu->now + 1;
+			}
+		}
+
+		if(ecu->now > g_runLimit)
+		{
+			ecu->idle = idle;
+			Sim_yield(ecu);
+			/* The other ECU may have sent something meanwhile, let the code see it */
+			eventReached = 1;
+			continue;
+		}
+		if((ecu->now >= target) && ((!idle) || eventReached || (ecu->nextEvent == SIM_TIME_NEVER)))
+		{
+			break;
+		}
+
+		next = idle ? ecu->nextEvent : target;
+		if(next > ecu->nextEvent)
+		{
+			next = ecu->nextEvent;
+		}
+		if(next > g_runLimit)
+		{
+			next = g_runLimit + 1;
+		}
+		if(next > ecu->now)
+		{
+			ecu->now = next;
+		}
+	}
+
+	ecu->idle = 0;
+	if(idle)
+	{
+		ecu->idleCycles += ecu->now - start;
+	}
+}
+
+/*
+ * Keep the last accesses of the ECU and find the shortest loop they repeat.
+ * The loop is an idle one when it goes on long enough.
+ */
+static void Sim_recordAccess(Sim_Ecu * ecu,Sim_RegisterId id,uint8_t write,uint16_t value)
+{
+	uint32_t access = ((uint32_t)id << 17) | ((uint32_t)write << 16) | value;
+	uint8_t period;
+
+	if((ecu->loopPeriod != 0) &&
+	   (access == ecu->history[(uint8_t)(ecu->historyIndex - ecu->loopPeriod) % SIM_IDLE_HISTORY]))
+	{
+		ecu->loopAccesses++;
+	}
+	else
+	{
+		ecu->loopPeriod = 0;
+		ecu->loopAccesses = 0;
+		for(period=1;period<SIM_IDLE_HISTORY;period++)
+		{
+			if(access == ecu->history[(uint8_t)(ecu->historyIndex - period) % SIM_IDLE_HISTORY])
+			{
+				ecu->loopPeriod = period;
+				ecu->loopAccesses = 1;
+				break;
+			}
+		}
+	}
+
+	ecu->history[ecu->historyIndex % SIM_IDLE_HISTORY] = access;
+	ecu->historyIndex++;
+}
+
+static Sim_Time Sim_lookahead(Sim_Ecu * sender)
+{
+	Sim_Time next;
+
+	/* An idle ECU does nothing before its next event, unless it receives a frame */
+	if(sender->idle)
+	{
+		next = Sim_nextEvent(sender);
+		if(next == SIM_TIME_NEVER)
+		{
+			return SIM_TIME_NEVER;
+		}
+		if(next > sender->now)
+		{
+			return (next - sender->now) + Sim_frameLookahead(sender);
+		}
+	}
+	return Sim_frameLookahead(sender);
+}
+
+static Sim_Time Sim_frameLookahead(const Sim_Ecu * sender)
+{
+	/* A byte sent now arrives after a whole frame */
+	if(sender->io[SIM_UCSRB] & (1<<TXEN))
+	{
+		return SimUart_frameCycles(sender);
+	}
+	return SIM_DEFAULT_LOOKAHEAD;
+}
+
+static void Sim_checkPinInterrupts(Sim_Ecu * ecu)
+{
+	uint8_t pins = Sim_readPort(ecu, SIM_PORT_D);
+	uint8_t changed = pins ^ ecu->pins[SIM_PORT_D];
+	uint8_t sense;
+	uint8_t i;
+
+	ecu->pins[SIM_PORT_D] = pins;
+	if(!changed)
+	{
+		return;
+	}
+
+	/* INT0 on PD2 with ISC01:0, INT1 on PD3 with ISC11:10 */
+	for(i=0;i<2;i++)
+	{
+		if(!(changed & (1<<(PD2 + i))))
+		{
+			continue;
+		}
+		sense = (ecu->io[SIM_MCUCR] >> (2 * i)) & 0x03;
+		if((sense == 1) ||
+		   ((sense == 2) && (!(pins & (1<<(PD2 + i))))) ||
+		   ((sense == 3) && (pins & (1<<(PD2 + i)))))
+		{
+			ecu->io[SIM_GIFR] |= (1<<(INTF0 + i));
+		}
+	}
+}
+
+/*
+ * Return the pending enabled vector with the highest priority, 0 if none.
+ * The flags cleared by the hardware when the vector is executed are cleared here.
+ */
+static uint8_t Sim_pendingVector(Sim_Ecu * ecu)
+{
+	uint8_t timsk = ecu->io[SIM_TIMSK];
+	uint8_t * tifr = &ecu->io[SIM_TIFR];
+	uint8_t * gifr = &ecu->io[SIM_GIFR];
+	uint8_t gicr = ecu->io[SIM_GICR];
+	uint8_t ucsrb = ecu->io[SIM_UCSRB];
+	uint8_t i;
+
+	for(i=0;i<2;i++)
+	{
+		if(gicr & (1<<(INT0 + i)))
+		{
+			/* Low level sense : pending while the pin is low */
+			if((((ecu->io[SIM_MCUCR] >> (2 * i)) & 0x03) == 0) && (!(ecu->pins[SIM_PORT_D] & (1<<(PD2 + i)))))
+			{
+				return SIM_INT0_VECT + i;
+			}
+			if(*gifr & (1<<(INTF0 + i)))
+			{
+				*gifr &= ~(1<<(INTF0 + i));
+				return SIM_INT0_VECT + i;
+			}
+		}
+	}
+
+	if((timsk & (1<<OCIE2)) && (*tifr & (1<<OCF2)))   { *tifr &= ~(1<<OCF2);  return SIM_TIMER2_COMP_VECT; }
+	if((timsk & (1<<TOIE2)) && (*tifr & (1<<TOV2)))   { *tifr &= ~(1<<TOV2);  return SIM_TIMER2_OVF_VECT; }
+	if((timsk & (1<<TICIE1)) && (*tifr & (1<<ICF1)))  { *tifr &= ~(1<<ICF1);  return SIM_TIMER1_CAPT_VECT; }
+	if((timsk & (1<<OCIE1A)) && (*tifr & (1<<OCF1A))) { *tifr &= ~(1<<OCF1A); return SIM_TIMER1_COMPA_VECT; }
+	if((timsk & (1<<OCIE1B)) && (*tifr & (1<<OCF1B))) { *tifr &= ~(1<<OCF1B); return SIM_TIMER1_COMPB_VECT; }
+	if((timsk & (1<<TOIE1)) && (*tifr & (1<<TOV1)))   { *tifr &= ~(1<<TOV1);  return SIM_TIMER1_OVF_VECT; }
+	if((timsk & (1<<OCIE0)) && (*tifr & (1<<OCF0)))   { *tifr &= ~(1<<OCF0);  return SIM_TIMER0_COMP_VECT; }
+	if((timsk & (1<<TOIE0)) && (*tifr & (1<<TOV0)))   { *tifr &= ~(1<<TOV0);  return SIM_TIMER0_OVF_VECT; }
+
+	/* RXC and UDRE are cleared by the ISR itself, TXC by the hardware */
+	if((ucsrb & (1<<RXCIE)) && (ecu->uart.fifoCount > 0))
+	{
+		return SIM_USART_RXC_VECT;
+	}
+	if((ucsrb & (1<<UDRIE)) && (!ecu->uart.bufferFull))
+	{
+		return SIM_USART_UDRE_VECT;
+	}
+	if((ucsrb & (1<<TXCIE)) && (ecu->io[SIM_UCSRA] & (1<<TXC)))
+	{
+		ecu->io[SIM_UCSRA] &= ~(1<<TXC);
+		return SIM_USART_TXC_VECT;
+	}
+
+	if((ecu->io[SIM_ADCSRA] & (1<<ADIE)) && (ecu->io[SIM_ADCSRA] & (1<<ADIF)))
+	{
+		ecu->io[SIM_ADCSRA] &= ~(1<<ADIF);
+		return SIM_ADC_VECT;
+	}
+
+	if((ecu->twi.twcr & (1<<TWIE)) && (ecu->twi.twcr & (1<<TWINT)))
+	{
+		return SIM_TWI_VECT;
+	}
+
+	return 0;
+}
+
+static void Sim_serviceInterrupts(Sim_Ecu * ecu)
+{
+	uint8_t vector;
+
+	/* An ISR runs with the I-bit cleared, unless it sets it again */
+	while(ecu->interruptEnable)
+	{
+		vector = Sim_pendingVector(ecu);
+		if(vector == 0)
+		{
+			break;
+		}
+		if(ecu->vectors[vector] == NULL)
+		{
+			/* avr-libc jumps to __bad_interrupt and resets the MCU */
+			Sim_fatal(ecu, "%s is enabled without an ISR", g_vectorNames[vector]);
+		}
+
+		ecu->interrupts[vector]++;
+		if(ecu->sleeping)
+		{
+			/* The first interrupt wakes the ECU up */
+			ecu->sleeping = 0;
+			ecu->wakes[vector]++;
+		}
+		ecu->interruptEnable = 0;
+		ecu->inInterrupt++;
+		ecu->vectors[vector]();
+		ecu->inInterrupt--;
+		/* RETI */
+		ecu->interruptEnable = 1;
+	}
+}
+
+static uint8_t Sim_portOf(Sim_RegisterId id,Sim_RegisterId first)
+{
+	return (uint8_t)((id - first) / 3);
+}
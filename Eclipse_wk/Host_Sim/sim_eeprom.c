@@ -0,0 +1,196 @@
+ /******************************************************************************
+ *
+ * Module: Host Simulator
+ *
+ * File Name: sim_eeprom.c
+ *
+ * Description: Simulated 24C16 EEPROM (2 KB, 8 blocks of 256 bytes).
+ *              The block is selected by the bits 3:1 of the slave address,
+ *              a write takes the 16-byte page of the word address and the
+ *              device does not answer during the write cycle after STOP.
+ *              The memory can be kept in a file between runs.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_eeprom.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define SIM_EEPROM_SIZE				2048
+#define SIM_EEPROM_PAGE_SIZE		16
+#define SIM_EEPROM_DEVICE_CODE		0xA0
+/* Self timed write cycle, 5 ms maximum in the datasheet, at 8 MHz */
+#define SIM_EEPROM_WRITE_CYCLES		(5 * 8000UL)
+
+/* Transfer states */
+#define SIM_EEPROM_IDLE				0
+#define SIM_EEPROM_WORD_ADDRESS		1
+#define SIM_EEPROM_WRITING			2
+#define SIM_EEPROM_READING			3
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+struct Sim_Eeprom{
+	uint8_t memory[SIM_EEPROM_SIZE];
+	uint16_t address;
+	uint8_t block;
+	uint8_t state;
+	uint8_t written;				/* bytes written in this transfer */
+	uint64_t busyUntil;				/* end of the write cycle */
+	const char * file;
+	uint32_t writes;				/* completed write cycles */
+};
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Create the EEPROM, erased (0xFF) or with the content of the file if it exists.
+ */
+Sim_Eeprom * SimEeprom_create(const char * file)
+{
+	Sim_Eeprom * eeprom = calloc(1, sizeof(Sim_Eeprom));
+	FILE * stream;
+
+	if(eeprom == NULL)
+	{
+		return NULL;
+	}
+	memset(eeprom->memory, 0xFF, SIM_EEPROM_SIZE);
+	eeprom->file = file;
+
+	if(file != NULL)
+	{
+		stream = fopen(file, "rb");
+		if(stream != NULL)
+		{
+			if(fread(eeprom->memory, 1, SIM_EEPROM_SIZE, stream) != SIM_EEPROM_SIZE)
+			{
+				fprintf(stderr, "%s: short EEPROM image, the rest is erased\n", file);
+			}
+			fclose(stream);
+		}
+	}
+	return eeprom;
+}
+
+/*
+ * Description :
+ * Write the memory back to its file, if any.
+ */
+void SimEeprom_save(const Sim_Eeprom * eeprom)
+{
+	FILE * stream;
+
+	if(eeprom->file == NULL)
+	{
+		return;
+	}
+	stream = fopen(eeprom->file, "wb");
+	if((stream == NULL) || (fwrite(eeprom->memory, 1, SIM_EEPROM_SIZE, stream) != SIM_EEPROM_SIZE))
+	{
+		fprintf(stderr, "%s: can not save the EEPROM image\n", eeprom->file);
+	}
+	if(stream != NULL)
+	{
+		fclose(stream);
+	}
+}
+
+/*
+ * Description :
+ * SLA+R/W after a START, return TRUE for ACK.
+ */
+uint8_t SimEeprom_address(Sim_Eeprom * eeprom,uint64_t now,uint8_t sla)
+{
+	if(((sla & 0xF0) != SIM_EEPROM_DEVICE_CODE) || (now < eeprom->busyUntil))
+	{
+		eeprom->state = SIM_EEPROM_IDLE;
+		return 0;
+	}
+
+	eeprom->block = (sla >> 1) & 0x07;
+	if(sla & 0x01)
+	{
+		/* Read from the current address */
+		eeprom->state = SIM_EEPROM_READING;
+	}
+	else
+	{
+		eeprom->state = SIM_EEPROM_WORD_ADDRESS;
+		eeprom->written = 0;
+	}
+	return 1;
+}
+
+/*
+ * Description :
+ * Byte from the master, return TRUE for ACK.
+ */
+uint8_t SimEeprom_write(Sim_Eeprom * eeprom,uint8_t data)
+{
+	uint16_t page;
+
+	switch(eeprom->state)
+	{
+	case SIM_EEPROM_WORD_ADDRESS:
+		eeprom->address = ((uint16_t)eeprom->block << 8) | data;
+		eeprom->state = SIM_EEPROM_WRITING;
+		return 1;
+	case SIM_EEPROM_WRITING:
+		/* The address rolls over inside the page */
+		page = eeprom->address & ~(SIM_EEPROM_PAGE_SIZE - 1);
+		eeprom->memory[eeprom->address] = data;
+		eeprom->address = page | ((eeprom->address + 1) & (SIM_EEPROM_PAGE_SIZE - 1));
+		eeprom->written++;
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/*
+ * Description :
+ * Byte to the master from the current address.
+ */
+uint8_t SimEeprom_read(Sim_Eeprom * eeprom)
+{
+	uint8_t data = eeprom->memory[eeprom->address];
+
+	eeprom->address = (eeprom->address + 1) % SIM_EEPROM_SIZE;
+	return data;
+}
+
+/*
+ * Description :
+ * STOP on the bus, a write transfer starts the write cycle.
+ */
+void SimEeprom_stop(Sim_Eeprom * eeprom,uint64_t now)
+{
+	if((eeprom->state == SIM_EEPROM_WRITING) && (eeprom->written > 0))
+	{
+		eeprom->busyUntil = now + SIM_EEPROM_WRITE_CYCLES;
+		eeprom->writes++;
+	}
+	eeprom->state = SIM_EEPROM_IDLE;
+}
+
+/*
+ * Description :
+ * Return the number of write cycles since the start.
+ */
+uint32_t SimEeprom_writes(const Sim_Eeprom * eeprom)
+{
+	return eeprom->writes;
+}
@@ -0,0 +1,39 @@
+ /******************************************************************************
+ *
+ * Module: Host Simulator
+ *
+ * File Name: sim_eeprom.h
+ *
+ * Description: Model of the 24C16 EEPROM on the TWI bus of the Control ECU.
+ *              It only needs the bus events and the time in CPU cycles, so
+ *              the simavr co-simulation uses it too.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef SIM_EEPROM_H_
+#define SIM_EEPROM_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef struct Sim_Eeprom Sim_Eeprom;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/* now is the time in CPU cycles at 8 MHz */
+Sim_Eeprom * SimEeprom_create(const char * file);
+void SimEeprom_save(const Sim_Eeprom * eeprom);
+uint8_t SimEeprom_address(Sim_Eeprom * eeprom,uint64_t now,uint8_t sla);
+uint8_t SimEeprom_write(Sim_Eeprom * eeprom,uint8_t data);
+uint8_t SimEeprom_read(Sim_Eeprom * eeprom);
+void SimEeprom_stop(Sim_Eeprom * eeprom,uint64_t now);
+uint32_t SimEeprom_writes(const Sim_Eeprom * eeprom);
+
+#endif /* SIM_EEPROM_H_ */
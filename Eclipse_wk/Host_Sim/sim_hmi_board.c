@@ -0,0 +1,333 @@
+ /******************************************************************************
+ *
+ * Module: Host Simulator
+ *
+ * File Name: sim_hmi_board.c
+ *
+ * Description: Devices of the HMI ECU board :
+ *              HD44780 LCD, 8-bit data on PORTC, RS on PD4 and E on PD5.
+ *              4x4 keypad, rows on PA0-PA3 and columns on PA4-PA7, a pressed
+ *              key pulls its column low while its row is driven low.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <avr/io.h>
+#include "sim_boards.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define SIM_LCD_RS_PIN				PD4
+#define SIM_LCD_E_PIN				PD5
+#define SIM_LCD_DDRAM_SIZE			0x80
+#define SIM_LCD_LINE1_ADDRESS		0x40
+#define SIM_LCD_LINE_LENGTH			0x28
+/* The screen is traced once it has not changed for this time */
+#define SIM_LCD_SETTLE_CYCLES		(20 * SIM_CYCLES_PER_MS)
+
+/* Address jumpers of the multi-drop link on PB0..PB2, a fitted one ties the pin to ground */
+#define SIM_JUMPERS_MASK			0x07
+
+#define SIM_KEYPAD_FIRST_COL_PIN	PA4
+/* The user releases the key after the ECU reads it, then waits for the next one */
+#define SIM_KEYPAD_HOLD_CYCLES		(40 * SIM_CYCLES_PER_MS)
+#define SIM_KEYPAD_GAP_CYCLES		(60 * SIM_CYCLES_PER_MS)
+#define SIM_KEYPAD_PAUSE_CYCLES		(1000 * SIM_CYCLES_PER_MS)
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef struct{
+	/* LCD */
+	char ddram[SIM_LCD_DDRAM_SIZE];
+	uint8_t address;
+	uint8_t enable;					/* E level at the last port write */
+	uint8_t dirty;
+	Sim_Time lastChange;
+	/* Keypad */
+	const char * keys;
+	int8_t row;						/* pressed key, -1 for none */
+	int8_t col;
+	uint8_t detected;
+	Sim_Time releaseTime;
+	Sim_Time nextPress;
+	/* Jumpers fitted for the panel address */
+	uint8_t jumpers;
+}SimHmiBoard_State;
+
+/*******************************************************************************
+ *                      Global Variables                                       *
+ *******************************************************************************/
+
+/* Keys in the order of the buttons, see KEYPAD_4x4_adjustKeyNumber() */
+static const char g_keypadLayout[] = "789%456*123-C0=+";
+
+/* One board for each panel on the link */
+static SimHmiBoard_State g_hmiBoards[SIM_MAX_PANELS];
+static uint8_t g_hmiBoardCount = 0;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void SimHmiBoard_update(Sim_Ecu * ecu);
+static Sim_Time SimHmiBoard_nextEvent(Sim_Ecu * ecu);
+static uint8_t SimHmiBoard_readPins(Sim_Ecu * ecu,uint8_t port);
+static void SimHmiBoard_portWritten(Sim_Ecu * ecu,uint8_t port);
+static void SimHmiBoard_lcdExecute(Sim_Ecu * ecu,SimHmiBoard_State * state,uint8_t rs,uint8_t data);
+static void SimHmiBoard_pressNextKey(Sim_Ecu * ecu,SimHmiBoard_State * state);
+
+static const Sim_Board g_hmiBoardDevices = {
+		SimHmiBoard_update, SimHmiBoard_nextEvent, SimHmiBoard_readPins, SimHmiBoard_portWritten, NULL
+};
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Connect the LCD and the keypad to the ECU, the keys are pressed in order.
+ * The jumpers give the panel address 1 --> SIM_MAX_PANELS on the multi-drop link.
+ */
+void SimHmiBoard_attach(Sim_Ecu * ecu,const char * keys,uint8_t address)
+{
+	SimHmiBoard_State * state;
+
+	if(g_hmiBoardCount == SIM_MAX_PANELS)
+	{
+		Sim_fatal(ecu, "too many HMI boards");
+	}
+	state = &g_hmiBoards[g_hmiBoardCount++];
+	memset(state, 0, sizeof(SimHmiBoard_State));
+	state->jumpers = (uint8_t)((address - 1) & SIM_JUMPERS_MASK);
+	memset(state->ddram, ' ', SIM_LCD_DDRAM_SIZE);
+	state->keys = keys;
+	state->row = -1;
+	state->col = -1;
+
+	ecu->board = &g_hmiBoardDevices;
+	ecu->boardState = state;
+}
+
+/*
+ * Description :
+ * Press these keys once the previous ones are done, the keys are not copied.
+ */
+void SimHmiBoard_pressKeys(Sim_Ecu * ecu,const char * keys)
+{
+	SimHmiBoard_State * state = ecu->boardState;
+
+	state->keys = keys;
+	if(state->nextPress < ecu->now)
+	{
+		state->nextPress = ecu->now;
+	}
+	Sim_reschedule(ecu);
+}
+
+/*
+ * Description :
+ * Return TRUE once all the keys are pressed and released.
+ */
+uint8_t SimHmiBoard_keysDone(const Sim_Ecu * ecu)
+{
+	const SimHmiBoard_State * state = ecu->boardState;
+
+	return (*state->keys == '\0') && (state->row < 0);
+}
+
+/*
+ * Description :
+ * Copy the visible characters of the LCD row (0 or 1) to line,
+ * it needs SIM_LCD_COLUMNS + 1 characters.
+ */
+void SimHmiBoard_getLine(const Sim_Ecu * ecu,uint8_t row,char * line)
+{
+	const SimHmiBoard_State * state = ecu->boardState;
+	uint8_t first = (row == 0) ? 0 : SIM_LCD_LINE1_ADDRESS;
+	uint8_t i;
+	char c;
+
+	for(i=0;i<SIM_LCD_COLUMNS;i++)
+	{
+		c = state->ddram[first + i];
+		line[i] = ((c >= ' ') && (c <= '~')) ? c : '?';
+	}
+	line[SIM_LCD_COLUMNS] = '\0';
+}
+
+
+/*******************************************************************************
+ *                      Private Functions                                      *
+ *******************************************************************************/
+
+static void SimHmiBoard_update(Sim_Ecu * ecu)
+{
+	SimHmiBoard_State * state = ecu->boardState;
+	char line0[SIM_LCD_COLUMNS + 1];
+	char line1[SIM_LCD_COLUMNS + 1];
+
+	if(state->dirty && (ecu->now >= state->lastChange + SIM_LCD_SETTLE_CYCLES))
+	{
+		state->dirty = 0;
+		SimHmiBoard_getLine(ecu, 0, line0);
+		SimHmiBoard_getLine(ecu, 1, line1);
+		Sim_trace(ecu, "LCD |%s|%s|", line0, line1);
+	}
+
+	if((state->row >= 0) && state->detected && (ecu->now >= state->releaseTime))
+	{
+		state->row = -1;
+		state->col = -1;
+		state->nextPress = ecu->now + SIM_KEYPAD_GAP_CYCLES;
+	}
+	if((state->row < 0) && (*state->keys != '\0') && (ecu->now >= state->nextPress))
+	{
+		SimHmiBoard_pressNextKey(ecu, state);
+	}
+}
+
+static Sim_Time SimHmiBoard_nextEvent(Sim_Ecu * ecu)
+{
+	SimHmiBoard_State * state = ecu->boardState;
+	Sim_Time next = SIM_TIME_NEVER;
+
+	if(state->dirty)
+	{
+		next = state->lastChange + SIM_LCD_SETTLE_CYCLES;
+	}
+	if((state->row >= 0) && state->detected && (state->releaseTime < next))
+	{
+		next = state->releaseTime;
+	}
+	if((state->row < 0) && (*state->keys != '\0') && (state->nextPress < next))
+	{
+		next = state->nextPress;
+	}
+	return next;
+}
+
+static uint8_t SimHmiBoard_readPins(Sim_Ecu * ecu,uint8_t port)
+{
+	SimHmiBoard_State * state = ecu->boardState;
+	uint8_t rows;
+
+	if(port == SIM_PORT_B)
+	{
+		return (uint8_t)(~state->jumpers);
+	}
+	if((port != SIM_PORT_A) || (state->row < 0))
+	{
+		/* External pull-ups */
+		return 0xFF;
+	}
+
+	/* Rows driven low by the ECU */
+	rows = (~ecu->io[SIM_PORTA]) & ecu->io[SIM_DDRA];
+	if(!(rows & (1<<state->row)))
+	{
+		return 0xFF;
+	}
+
+	if(!state->detected)
+	{
+		state->detected = 1;
+		state->releaseTime = ecu->now + SIM_KEYPAD_HOLD_CYCLES;
+		Sim_reschedule(ecu);
+	}
+	return (uint8_t)(~(1<<(SIM_KEYPAD_FIRST_COL_PIN + state->col)));
+}
+
+static void SimHmiBoard_portWritten(Sim_Ecu * ecu,uint8_t port)
+{
+	SimHmiBoard_State * state = ecu->boardState;
+	uint8_t control;
+	uint8_t enable;
+
+	if((port != SIM_PORT_C) && (port != SIM_PORT_D))
+	{
+		return;
+	}
+
+	/* The HD44780 latches RS and the data on the falling edge of E */
+	control = Sim_outputPins(ecu, SIM_PORT_D);
+	enable = (control >> SIM_LCD_E_PIN) & 0x01;
+	if(state->enable && (!enable))
+	{
+		SimHmiBoard_lcdExecute(ecu, state, (control >> SIM_LCD_RS_PIN) & 0x01, Sim_outputPins(ecu, SIM_PORT_C));
+	}
+	state->enable = enable;
+}
+
+static void SimHmiBoard_lcdExecute(Sim_Ecu * ecu,SimHmiBoard_State * state,uint8_t rs,uint8_t data)
+{
+	if(rs)
+	{
+		state->ddram[state->address] = (char)data;
+		/* Two lines mode : 0x00-0x27 then 0x40-0x67 */
+		state->address++;
+		if(state->address == SIM_LCD_LINE_LENGTH)
+		{
+			state->address = SIM_LCD_LINE1_ADDRESS;
+		}
+		else if(state->address == (SIM_LCD_LINE1_ADDRESS + SIM_LCD_LINE_LENGTH))
+		{
+			state->address = 0;
+		}
+	}
+	else if(data & 0x80)
+	{
+		/* Set DDRAM address */
+		state->address = data & 0x7F;
+	}
+	else if(data == 0x01)
+	{
+		/* Clear display */
+		memset(state->ddram, ' ', SIM_LCD_DDRAM_SIZE);
+		state->address = 0;
+	}
+	else if((data & 0xFE) == 0x02)
+	{
+		/* Return home */
+		state->address = 0;
+	}
+	else
+	{
+		/* Function set, display control, entry mode, CGRAM : no effect on the text */
+		return;
+	}
+
+	state->dirty = 1;
+	state->lastChange = ecu->now;
+	SimBench_event(ecu, SIM_EVENT_LCD_WRITE, data);
+}
+
+static void SimHmiBoard_pressNextKey(Sim_Ecu * ecu,SimHmiBoard_State * state)
+{
+	char key = *state->keys++;
+	const char * button;
+
+	if(key == ' ')
+	{
+		state->nextPress = ecu->now + SIM_KEYPAD_PAUSE_CYCLES;
+		return;
+	}
+
+	button = (key != '\0') ? strchr(g_keypadLayout, key) : NULL;
+	if(button == NULL)
+	{
+		Sim_fatal(ecu, "no key '%c' on the keypad", key);
+	}
+	state->row = (int8_t)((button - g_keypadLayout) / 4);
+	state->col = (int8_t)((button - g_keypadLayout) % 4);
+	state->detected = 0;
+	Sim_trace(ecu, "Key '%c' pressed", key);
+	SimBench_event(ecu, SIM_EVENT_KEY_PRESS, (uint8_t)key);
+}
@@ -0,0 +1,465 @@
+ /******************************************************************************
+ *
+ * Module: Host Simulator
+ *
+ * File Name: sim_main.c
+ *
+ * Description: door_sim, runs the Control ECU and the HMI ECU together on
+ *              the host : the password is set on the first power on, then
+ *              the door is opened with it the required number of times.
+ *              With --bench the standard flows are timed instead, see sim_bench.c.
+ *              With --panels the Control ECU polls several HMI panels on a
+ *              multi-drop link, the keys are pressed on the first one.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include <dlfcn.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "sim_boards.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define SIM_DEFAULT_PASSWORD		"12345"
+#define SIM_MAX_PATH				512
+/* Simulated seconds allowed for the password setup and for each transaction */
+#define SIM_SETUP_SECONDS			30
+#define SIM_TRANSACTION_SECONDS		40
+/* Longest stall after the inrush blanking : the 20 ms the Control ECU confirms
+ * it in and the settling of its current filter */
+#define SIM_STALL_STOP_MS			30
+
+#define SIM_MENU_LINE				"+ : Open Door"
+
+/*******************************************************************************
+ *                      Global Variables                                       *
+ *******************************************************************************/
+
+static Sim_Ecu g_controlEcu;
+/* The keys are pressed on the first panel */
+static Sim_Ecu g_hmiEcus[SIM_MAX_PANELS];
+static uint8_t g_panels = 1;
+/* The Control ECU, then the panels */
+static Sim_Ecu * g_ecus[1 + SIM_MAX_PANELS];
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void usage(const char * program);
+static char * defaultLibrary(const char * program,const char * name);
+static void loadPanel(Sim_Ecu * ecu,uint8_t panel,const char * library);
+static void checkBuild(const Sim_Ecu * ecu,const char * symbol,const char * feature);
+static FILE * openLinkLog(const char * prefix,const char * name);
+static char * transactionKeys(const char * password,unsigned long transactions,unsigned long interval);
+static uint8_t scenarioDone(void);
+static void printSummary(uint8_t done,unsigned long transactions,double hostSeconds);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+int main(int argc,char * argv[])
+{
+	static const struct option options[] = {
+			{"control", required_argument, NULL, 'c'},
+			{"hmi", required_argument, NULL, 'm'},
+			{"transactions", required_argument, NULL, 'n'},
+			{"interval", required_argument, NULL, 'i'},
+			{"password", required_argument, NULL, 'p'},
+			{"keys", required_argument, NULL, 'k'},
+			{"eeprom", required_argument, NULL, 'e'},
+			{"bench", required_argument, NULL, 'b'},
+			{"link-log", required_argument, NULL, 'l'},
+			{"time", required_argument, NULL, 't'},
+			{"panels", required_argument, NULL, 'P'},
+			{"rs485", no_argument, NULL, 'r'},
+			{"bit-errors", required_argument, NULL, 'E'},
+			{"no-limit-switches", no_argument, NULL, 'S'},
+			{"block-door", required_argument, NULL, 'B'},
+			{"verbose", no_argument, NULL, 'v'},
+			{"help", no_argument, NULL, 'h'},
+			{NULL, 0, NULL, 0}
+	};
+	const char * controlLibrary = NULL;
+	const char * hmiLibrary = NULL;
+	const char * password = SIM_DEFAULT_PASSWORD;
+	const char * keys = NULL;
+	const char * eepromFile = NULL;
+	const char * benchPrefix = NULL;
+	const char * linkLogPrefix = NULL;
+	uint8_t rs485 = 0;
+	unsigned long noise = 0;
+	uint8_t limitSwitches = 1;
+	double blockAt = -1;
+	unsigned long transactions = 1;
+	unsigned long interval = 0;
+	double seconds = 0;
+	struct timespec start;
+	struct timespec end;
+	char name[SIM_MAX_PATH];
+	SimControlBoard_Stats stats;
+	uint8_t done;
+	uint8_t p;
+	int option;
+
+	while((option = getopt_long(argc, argv, "c:m:n:i:p:k:e:b:l:t:P:rE:SB:vh", options, NULL)) != -1)
+	{
+		switch(option)
+		{
+		case 'c': controlLibrary = optarg; break;
+		case 'm': hmiLibrary = optarg; break;
+		case 'n': transactions = strtoul(optarg, NULL, 10); break;
+		case 'i': interval = strtoul(optarg, NULL, 10); break;
+		case 'p': password = optarg; break;
+		case 'k': keys = optarg; break;
+		case 'e': eepromFile = optarg; break;
+		case 'b': benchPrefix = optarg; break;
+		case 'l': linkLogPrefix = optarg; break;
+		case 't': seconds = strtod(optarg, NULL); break;
+		case 'P': g_panels = (uint8_t)strtoul(optarg, NULL, 10); break;
+		case 'r': rs485 = 1; break;
+		case 'E': noise = strtoul(optarg, NULL, 10); break;
+		case 'S': limitSwitches = 0; break;
+		case 'B': blockAt = strtod(optarg, NULL) / 100.0; break;
+		case 'v': g_simTrace = 1; break;
+		default:
+			usage(argv[0]);
+			return (option == 'h') ? 0 : 2;
+		}
+	}
+	if((strlen(password) != 5) || (strspn(password, "0123456789") != 5))
+	{
+		fprintf(stderr, "%s: the password is 5 digits\n", argv[0]);
+		return 2;
+	}
+	if((g_panels < 1) || (g_panels > SIM_MAX_PANELS))
+	{
+		fprintf(stderr, "%s: 1 to %u panels\n", argv[0], SIM_MAX_PANELS);
+		return 2;
+	}
+
+	if(benchPrefix != NULL)
+	{
+		/* The flows press their own keys, the benchmark starts from an erased EEPROM */
+		keys = "";
+		eepromFile = NULL;
+	}
+	else if(keys == NULL)
+	{
+		keys = transactionKeys(password, transactions, interval);
+	}
+	if(seconds <= 0)
+	{
+		seconds = SIM_SETUP_SECONDS + ((SIM_TRANSACTION_SECONDS + (double)interval) * transactions);
+	}
+
+	Sim_loadEcu(&g_controlEcu, "Control", (controlLibrary != NULL) ? controlLibrary : defaultLibrary(argv[0], "control_ecu.so"));
+	SimControlBoard_attach(&g_controlEcu);
+	SimControlBoard_setFaults(&g_controlEcu, limitSwitches, blockAt);
+	g_controlEcu.eeprom = SimEeprom_create(eepromFile);
+	g_ecus[0] = &g_controlEcu;
+	for(p=0;p<g_panels;p++)
+	{
+		loadPanel(&g_hmiEcus[p], p, (hmiLibrary != NULL) ? hmiLibrary : defaultLibrary(argv[0], "hmi_ecu.so"));
+		Sim_connect(&g_controlEcu, &g_hmiEcus[p]);
+		/* The jumpers give the address p + 1 */
+		SimHmiBoard_attach(&g_hmiEcus[p], (p == 0) ? keys : "", p + 1);
+		g_ecus[1 + p] = &g_hmiEcus[p];
+	}
+	if(g_panels > 1)
+	{
+		checkBuild(&g_controlEcu, "Multidrop_init", "the multi-drop link, make MULTIDROP=1");
+		checkBuild(&g_hmiEcus[0], "Multidrop_init", "the multi-drop link, make MULTIDROP=1");
+	}
+	if(rs485)
+	{
+		for(p=0;p<=g_panels;p++)
+		{
+			checkBuild(g_ecus[p], "USART_TXC_vect", "the RS-485 link, make RS485=1");
+			g_ecus[p]->uart.rs485 = 1;
+		}
+	}
+	for(p=0;p<=g_panels;p++)
+	{
+		g_ecus[p]->uart.noise = noise;
+	}
+	if(linkLogPrefix != NULL)
+	{
+		g_controlEcu.uart.linkLog = openLinkLog(linkLogPrefix, "control");
+		for(p=0;p<g_panels;p++)
+		{
+			snprintf(name, sizeof(name), (p == 0) ? "hmi" : "hmi%u", p + 1);
+			g_hmiEcus[p].uart.linkLog = openLinkLog(linkLogPrefix, name);
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if(benchPrefix != NULL)
+	{
+		done = SimBench_run(g_ecus, 1 + g_panels, transactions, password, benchPrefix);
+	}
+	else
+	{
+		Sim_run(g_ecus, 1 + g_panels, (Sim_Time)(seconds * SIM_F_CPU), scenarioDone);
+		done = scenarioDone();
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	SimEeprom_save(g_controlEcu.eeprom);
+	if(linkLogPrefix != NULL)
+	{
+		for(p=0;p<=g_panels;p++)
+		{
+			fclose(g_ecus[p]->uart.linkLog);
+		}
+	}
+	printSummary(done, transactions, (end.tv_sec - start.tv_sec) + ((end.tv_nsec - start.tv_nsec) / 1e9));
+
+	SimControlBoard_getStats(&g_controlEcu, &stats);
+	if(stats.maxStallMs > SIM_STALL_STOP_MS)
+	{
+		fprintf(stderr, "%s: the motor stayed stalled for %.1f ms, more than %u ms\n",
+				argv[0], stats.maxStallMs, SIM_STALL_STOP_MS);
+		done = 0;
+	}
+
+	return done ? 0 : 1;
+}
+
+
+/*******************************************************************************
+ *                      Private Functions                                      *
+ *******************************************************************************/
+
+static void usage(const char * program)
+{
+	printf("Usage: %s [options]\n"
+			"  -n, --transactions N  open the door N times after setting the password (1)\n"
+			"  -i, --interval S      wait S seconds at the main menu before each transaction,\n"
+			"                        -n 288 -i 300 is a day of traffic\n"
+			"  -p, --password DIGITS the 5 digits password (" SIM_DEFAULT_PASSWORD ")\n"
+			"  -k, --keys KEYS       press these keys instead, ' ' waits 1 second,\n"
+			"                        a '-' at the HMI menu changes the password\n"
+			"  -e, --eeprom FILE     keep the 24C16 content in FILE\n"
+			"  -b, --bench PREFIX    time the setup, then N times open door, change password\n"
+			"                        and three wrong passwords, write PREFIX.csv and PREFIX.json\n"
+			"  -l, --link-log PREFIX write the bytes sent by each ECU to PREFIX.control\n"
+			"                        and PREFIX.hmi, for Tools/trace_decode.py\n"
+			"  -t, --time SECONDS    simulated time limit\n"
+			"  -P, --panels N        N HMI panels polled on a multi-drop link (1), the keys\n"
+			"                        go to the first one, N > 1 needs make MULTIDROP=1\n"
+			"  -r, --rs485           RS-485 transceivers on the link, DE/RE on PB4 of each\n"
+			"                        board, needs make RS485=1\n"
+			"  -E, --bit-errors N    flip a bit in one frame out of N sent on the link, only\n"
+			"                        the transport of make LINK=1 recovers from them\n"
+			"  -S, --no-limit-switches  leave the door limit switches unconnected, the\n"
+			"                        motor stalls at each end of the travel\n"
+			"  -B, --block-door PERCENT  an obstacle stops the opening door at PERCENT\n"
+			"                        of its travel, the motor stalls there\n"
+			"  -c, --control LIB     Control ECU library (control_ecu.so beside %s)\n"
+			"  -m, --hmi LIB         HMI ECU library (hmi_ecu.so beside %s)\n"
+			"  -v, --verbose         trace the devices and the UART link\n",
+			program, program, program);
+}
+
+static char * defaultLibrary(const char * program,const char * name)
+{
+	static char paths[2][SIM_MAX_PATH];
+	static uint8_t next = 0;
+	char * path = paths[next++ % 2];
+	const char * slash = strrchr(program, '/');
+	int directory = (slash != NULL) ? (int)(slash - program) : 1;
+
+	snprintf(path, SIM_MAX_PATH, "%.*s/%s", directory, (slash != NULL) ? program : ".", name);
+	return path;
+}
+
+/*
+ * Each panel has its own copy of the HMI library : dlopen() gives the one
+ * already loaded for the same file, with the same globals
+ */
+static void loadPanel(Sim_Ecu * ecu,uint8_t panel,const char * library)
+{
+	static char names[SIM_MAX_PANELS][8];
+	char copy[] = "/tmp/door_sim_hmiXXXXXX";
+	char buffer[4096];
+	FILE * source;
+	FILE * destination;
+	size_t size;
+	int file;
+
+	if(panel == 0)
+	{
+		Sim_loadEcu(ecu, "HMI", library);
+		return;
+	}
+
+	file = mkstemp(copy);
+	source = fopen(library, "rb");
+	destination = (file >= 0) ? fdopen(file, "wb") : NULL;
+	if((source == NULL) || (destination == NULL))
+	{
+		fprintf(stderr, "can not copy %s for the panel %u\n", library, panel + 1);
+		exit(2);
+	}
+	while((size = fread(buffer, 1, sizeof(buffer), source)) > 0)
+	{
+		fwrite(buffer, 1, size, destination);
+	}
+	fclose(source);
+	fclose(destination);
+
+	snprintf(names[panel], sizeof(names[panel]), "HMI%u", panel + 1);
+	Sim_loadEcu(ecu, names[panel], copy);
+	/* The loaded library stays mapped */
+	unlink(copy);
+}
+
+/* The ECU must be built with the feature that defines the symbol */
+static void checkBuild(const Sim_Ecu * ecu,const char * symbol,const char * feature)
+{
+	if(dlsym(ecu->library, symbol) == NULL)
+	{
+		Sim_fatal(ecu, "built without %s", feature);
+	}
+}
+
+/* Raw bytes sent by the ECU on the link */
+static FILE * openLinkLog(const char * prefix,const char * name)
+{
+	char path[SIM_MAX_PATH];
+	FILE * file;
+
+	snprintf(path, sizeof(path), "%s.%s", prefix, name);
+	file = fopen(path, "wb");
+	if(file == NULL)
+	{
+		perror(path);
+		exit(2);
+	}
+	return file;
+}
+
+/* Set the password twice, then wait and press '+' and the password for each transaction */
+static char * transactionKeys(const char * password,unsigned long transactions,unsigned long interval)
+{
+	char * keys = malloc((2 * 6) + (transactions * (7 + interval)) + 1);
+	char * next = keys;
+	unsigned long i;
+
+	if(keys == NULL)
+	{
+		fprintf(stderr, "no memory for the keys\n");
+		exit(2);
+	}
+	next += sprintf(next, "%s=%s=", password, password);
+	for(i=0;i<transactions;i++)
+	{
+		/* ' ' waits 1 second */
+		memset(next, ' ', interval);
+		next += interval;
+		next += sprintf(next, "+%s=", password);
+	}
+	return keys;
+}
+
+/* All the keys are pressed and the HMI is back to its main menu */
+static uint8_t scenarioDone(void)
+{
+	char line[SIM_LCD_COLUMNS + 1];
+
+	if(!SimHmiBoard_keysDone(&g_hmiEcus[0]))
+	{
+		return 0;
+	}
+	SimHmiBoard_getLine(&g_hmiEcus[0], 0, line);
+	return strncmp(line, SIM_MENU_LINE, strlen(SIM_MENU_LINE)) == 0;
+}
+
+static void printSummary(uint8_t done,unsigned long transactions,double hostSeconds)
+{
+	SimControlBoard_Stats stats;
+	char line0[SIM_LCD_COLUMNS + 1];
+	char line1[SIM_LCD_COLUMNS + 1];
+	Sim_Time simTime = 0;
+	double simSeconds;
+	Sim_Ecu * const * ecus = g_ecus;
+	uint8_t i;
+	uint8_t v;
+
+	for(i=0;i<=g_panels;i++)
+	{
+		if(ecus[i]->now > simTime)
+		{
+			simTime = ecus[i]->now;
+		}
+	}
+	simSeconds = simTime / (double)SIM_F_CPU;
+	SimControlBoard_getStats(&g_controlEcu, &stats);
+	SimHmiBoard_getLine(&g_hmiEcus[0], 0, line0);
+	SimHmiBoard_getLine(&g_hmiEcus[0], 1, line1);
+
+	printf("Result            : %s\n", done ? "done" : "time limit reached");
+	printf("Transactions      : %lu\n", transactions);
+	printf("Simulated time    : %.3f s\n", simSeconds);
+	printf("Host time         : %.3f s (%.1f x real time)\n", hostSeconds, (hostSeconds > 0) ? simSeconds / hostSeconds : 0);
+	printf("Door              : opened %u, closed %u, stalls %u, at %.0f%%\n",
+			stats.opens, stats.closes, stats.stalls, 100 * stats.doorPosition);
+	if(stats.stalls)
+	{
+		printf("Stall stop        : %.1f ms at most after the inrush blanking\n", stats.maxStallMs);
+	}
+	printf("Buzzer on         : %.0f ms\n", stats.buzzerOnMs);
+	printf("EEPROM writes     : %u\n", SimEeprom_writes(g_controlEcu.eeprom));
+	printf("LCD               : |%s|%s|\n", line0, line1);
+	for(i=0;i<=g_panels;i++)
+	{
+		printf("%-8s UART      : sent %u, received %u, errors %u", ecus[i]->name,
+				ecus[i]->uart.bytesSent, ecus[i]->uart.bytesReceived, ecus[i]->uart.errors);
+		if(ecus[i]->uart.collisions)
+		{
+			printf(", collisions %u", ecus[i]->uart.collisions);
+		}
+		if(ecus[i]->uart.bitErrors)
+		{
+			printf(", bit errors sent %u", ecus[i]->uart.bitErrors);
+		}
+		if(ecus[i]->uart.rs485)
+		{
+			printf(", RS-485 undriven %u, conflicts %u", ecus[i]->uart.undriven, ecus[i]->uart.conflicts);
+		}
+		printf("\n");
+		printf("%-8s registers : %llu accesses, %llu events, idle %.1f%%\n", ecus[i]->name,
+				(unsigned long long)ecus[i]->accesses, (unsigned long long)ecus[i]->events,
+				(ecus[i]->now > 0) ? (100.0 * ecus[i]->idleCycles) / ecus[i]->now : 0);
+		printf("%-8s interrupts:", ecus[i]->name);
+		for(v=1;v<SIM_NUM_VECTORS;v++)
+		{
+			if(ecus[i]->interrupts[v])
+			{
+				printf(" %s %llu", Sim_vectorName(v), (unsigned long long)ecus[i]->interrupts[v]);
+			}
+		}
+		printf("\n");
+		/* Duty cycle : the rest of the time the CPU runs, idle loops included */
+		printf("%-8s sleep     : %.1f%%, woken by", ecus[i]->name,
+				(ecus[i]->now > 0) ? (100.0 * ecus[i]->sleepCycles) / ecus[i]->now : 0);
+		for(v=1;v<SIM_NUM_VECTORS;v++)
+		{
+			if(ecus[i]->wakes[v])
+			{
+				printf(" %s %llu", Sim_vectorName(v), (unsigned long long)ecus[i]->wakes[v]);
+			}
+		}
+		printf("\n");
+	}
+}
@@ -0,0 +1,637 @@
+ /******************************************************************************
+ *
+ * Module: Host Simulator
+ *
+ * File Name: sim_timers.c
+ *
+ * Description: Simulated Timer0, Timer1 and Timer2 of the ATmega32.
+ *              The counters are not stepped, each one is computed from the
+ *              time it was last written (base) and its prescaler, and the
+ *              flags are set at the computed times of the next events.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include <avr/io.h>
+#include "sim.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define SIM_TIMER8_MAX			0xFFUL
+#define SIM_TIMER16_MAX			0xFFFFUL
+
+/* WGM values of Timer0/Timer2 : WGMx1 is bit 3, WGMx0 is bit 6 of TCCRx */
+#define SIM_WGM8_NORMAL			0
+#define SIM_WGM8_PHASE_CORRECT	1
+#define SIM_WGM8_CTC			2
+#define SIM_WGM8_FAST_PWM		3
+
+/*******************************************************************************
+ *                      Global Variables                                       *
+ *******************************************************************************/
+
+/* CSx2:0 --> prescaler, 0 for stopped or external clock */
+static const uint16_t g_timer0Prescalers[8] = {0, 1, 8, 64, 256, 1024, 0, 0};
+static const uint16_t g_timer2Prescalers[8] = {0, 1, 8, 32, 64, 128, 256, 1024};
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static uint32_t SimTimer_count(uint32_t baseCount,uint64_t ticks,uint32_t top,uint32_t max);
+static uint64_t SimTimer_ticksTo(uint32_t baseCount,uint32_t top,uint32_t max,uint32_t value);
+static Sim_Time SimTimer_eventTime(Sim_Time baseTime,uint16_t prescaler,uint64_t ticks);
+static void SimTimer_catchUp(Sim_Time * event,Sim_Time period,Sim_Time now);
+
+static uint8_t SimTimer8_tccr(const Sim_Ecu * ecu,const Sim_Timer8 * timer);
+static uint8_t SimTimer8_mode(const Sim_Ecu * ecu,const Sim_Timer8 * timer);
+static uint8_t SimTimer8_ocr(const Sim_Ecu * ecu,const Sim_Timer8 * timer);
+static uint32_t SimTimer8_top(const Sim_Ecu * ecu,const Sim_Timer8 * timer);
+static uint8_t SimTimer8_count(const Sim_Ecu * ecu,const Sim_Timer8 * timer,Sim_Time time);
+static void SimTimer8_rebase(Sim_Ecu * ecu,Sim_Timer8 * timer,Sim_Time time);
+static void SimTimer8_schedule(Sim_Ecu * ecu,Sim_Timer8 * timer);
+static void SimTimer8_update(Sim_Ecu * ecu,Sim_Timer8 * timer);
+static Sim_Time SimTimer8_nextEvent(const Sim_Ecu * ecu,const Sim_Timer8 * timer);
+
+static uint8_t SimTimer1_mode(const Sim_Ecu * ecu);
+static uint32_t SimTimer1_top(const Sim_Ecu * ecu);
+static uint16_t SimTimer1_count(const Sim_Ecu * ecu,Sim_Time time);
+static void SimTimer1_rebase(Sim_Ecu * ecu,Sim_Time time);
+static void SimTimer1_schedule(Sim_Ecu * ecu);
+static void SimTimer1_update(Sim_Ecu * ecu);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Stop the three timers, as after a reset.
+ */
+void SimTimer_reset(Sim_Ecu * ecu)
+{
+	ecu->timer0.id = 0;
+	ecu->timer2.id = 2;
+	SimTimer8_schedule(ecu, &ecu->timer0);
+	SimTimer8_schedule(ecu, &ecu->timer2);
+	SimTimer1_schedule(ecu);
+}
+
+/*
+ * Description :
+ * Set the timer flags of all the events up to the current time.
+ */
+void SimTimer_update(Sim_Ecu * ecu)
+{
+	SimTimer8_update(ecu, &ecu->timer0);
+	SimTimer1_update(ecu);
+	SimTimer8_update(ecu, &ecu->timer2);
+}
+
+/*
+ * Description :
+ * Return the time of the next timer event that changes something.
+ * Setting a flag that is already set changes nothing, those events are
+ * skipped and the next update catches up with them.
+ */
+Sim_Time SimTimer_nextEvent(Sim_Ecu * ecu)
+{
+	uint8_t tifr = ecu->io[SIM_TIFR];
+	const Sim_Time times[] = {
+			SimTimer8_nextEvent(ecu, &ecu->timer0),
+			SimTimer8_nextEvent(ecu, &ecu->timer2),
+			(tifr & (1<<OCF1A)) ? SIM_TIME_NEVER : ecu->timer1.nextCompareA,
+			(tifr & (1<<OCF1B)) ? SIM_TIME_NEVER : ecu->timer1.nextCompareB,
+			(tifr & (1<<TOV1)) ? SIM_TIME_NEVER : ecu->timer1.nextOverflow
+	};
+	Sim_Time next = SIM_TIME_NEVER;
+	uint8_t i;
+
+	for(i=0;i<sizeof(times)/sizeof(times[0]);i++)
+	{
+		if(times[i] < next)
+		{
+			next = times[i];
+		}
+	}
+	return next;
+}
+
+uint8_t SimTimer_read(Sim_Ecu * ecu,Sim_RegisterId id)
+{
+	switch(id)
+	{
+	case SIM_TCNT0:
+		return SimTimer8_count(ecu, &ecu->timer0, ecu->now);
+	case SIM_TCNT2:
+		return SimTimer8_count(ecu, &ecu->timer2, ecu->now);
+	case SIM_OCR0:
+		/* The CPU accesses the OCR buffer */
+		return ecu->timer0.ocrBuffer;
+	case SIM_OCR2:
+		return ecu->timer2.ocrBuffer;
+	case SIM_TCCR0: case SIM_TCCR2:
+		/* FOCx always reads zero */
+		return ecu->io[id] & 0x7F;
+	case SIM_TCCR1A:
+		/* FOC1A/FOC1B always read zero */
+		return ecu->io[id] & 0xF3;
+	default:
+		return ecu->io[id];
+	}
+}
+
+void SimTimer_write(Sim_Ecu * ecu,Sim_RegisterId id,uint8_t value)
+{
+	Sim_Timer8 * timer = ((id == SIM_TCCR0) || (id == SIM_TCNT0) || (id == SIM_OCR0)) ? &ecu->timer0 : &ecu->timer2;
+	Sim_RegisterId ocr = (timer->id == 0) ? SIM_OCR0 : SIM_OCR2;
+
+	SimTimer_update(ecu);
+
+	switch(id)
+	{
+	case SIM_TCCR0: case SIM_TCCR2:
+		SimTimer8_rebase(ecu, timer, ecu->now);
+		ecu->io[id] = value & 0x7F;
+		timer->prescaler = (timer->id == 0) ? g_timer0Prescalers[value & 0x07] : g_timer2Prescalers[value & 0x07];
+		if((SimTimer8_mode(ecu, timer) == SIM_WGM8_NORMAL) || (SimTimer8_mode(ecu, timer) == SIM_WGM8_CTC))
+		{
+			/* No double buffering out of the PWM modes */
+			ecu->io[ocr] = timer->ocrBuffer;
+		}
+		SimTimer8_schedule(ecu, timer);
+		break;
+	case SIM_TCNT0: case SIM_TCNT2:
+		timer->baseTime = ecu->now;
+		timer->baseCount = value;
+		SimTimer8_schedule(ecu, timer);
+		break;
+	case SIM_OCR0: case SIM_OCR2:
+		timer->ocrBuffer = value;
+		if((SimTimer8_mode(ecu, timer) == SIM_WGM8_NORMAL) || (SimTimer8_mode(ecu, timer) == SIM_WGM8_CTC))
+		{
+			SimTimer8_rebase(ecu, timer, ecu->now);
+			ecu->io[ocr] = value;
+			SimTimer8_schedule(ecu, timer);
+		}
+		break;
+	case SIM_TCCR1A: case SIM_TCCR1B:
+		SimTimer1_rebase(ecu, ecu->now);
+		ecu->io[id] = (id == SIM_TCCR1A) ? (value & 0xF3) : value;
+		ecu->timer1.prescaler = g_timer0Prescalers[ecu->io[SIM_TCCR1B] & 0x07];
+		SimTimer1_schedule(ecu);
+		break;
+	case SIM_TIFR:
+		/* Flags are cleared by writing one */
+		ecu->io[SIM_TIFR] &= ~value;
+		break;
+	default:
+		ecu->io[id] = value;
+		break;
+	}
+}
+
+uint16_t SimTimer_read16(Sim_Ecu * ecu,Sim_RegisterId id)
+{
+	switch(id)
+	{
+	case SIM_TCNT1:
+		return SimTimer1_count(ecu, ecu->now);
+	case SIM_OCR1A:
+		return ecu->timer1.ocr1a;
+	case SIM_OCR1B:
+		return ecu->timer1.ocr1b;
+	default:
+		return ecu->timer1.icr1;
+	}
+}
+
+void SimTimer_write16(Sim_Ecu * ecu,Sim_RegisterId id,uint16_t value)
+{
+	SimTimer_update(ecu);
+	SimTimer1_rebase(ecu, ecu->now);
+
+	/* OCR1A/OCR1B take the new value at once in all the modes used by the ECUs */
+	switch(id)
+	{
+	case SIM_TCNT1:
+		ecu->timer1.baseCount = value;
+		break;
+	case SIM_OCR1A:
+		ecu->timer1.ocr1a = value;
+		break;
+	case SIM_OCR1B:
+		ecu->timer1.ocr1b = value;
+		break;
+	default:
+		ecu->timer1.icr1 = value;
+		break;
+	}
+	SimTimer1_schedule(ecu);
+}
+
+/*
+ * Description :
+ * Edge on the ICP1 pin at the given time (not after the current time),
+ * ICR1 takes the counter value if the edge matches ICES1.
+ */
+void SimTimer_inputCapture(Sim_Ecu * ecu,Sim_Time time,uint8_t rising)
+{
+	uint8_t tccr1b = ecu->io[SIM_TCCR1B];
+	uint8_t mode = SimTimer1_mode(ecu);
+
+	if(((tccr1b >> ICES1) & 0x01) != (rising ? 1 : 0))
+	{
+		return;
+	}
+	/* ICR1 is the TOP value in these modes, no capture */
+	if((mode == 8) || (mode == 10) || (mode == 12) || (mode == 14))
+	{
+		return;
+	}
+
+	if(tccr1b & (1<<ICNC1))
+	{
+		/* Four equal samples of the pin */
+		time += 4;
+	}
+	if(time < ecu->timer1.baseTime)
+	{
+		time = ecu->timer1.baseTime;
+	}
+	if(time > ecu->now)
+	{
+		time = ecu->now;
+	}
+
+	ecu->timer1.icr1 = SimTimer1_count(ecu, time);
+	ecu->io[SIM_TIFR] |= (1<<ICF1);
+}
+
+/*
+ * Description :
+ * Return TRUE if the OCx pin of Timer0 (timer = 0) or Timer2 (timer = 2) is
+ * driven by the timer, with the duty cycle (0 --> 1) and the frequency in Hz
+ * of its waveform. FALSE if the pin is a normal port pin.
+ */
+uint8_t SimTimer_pwmOutput(Sim_Ecu * ecu,uint8_t timer,double * duty,double * frequency)
+{
+	Sim_Timer8 * t = (timer == 0) ? &ecu->timer0 : &ecu->timer2;
+	uint8_t tccr = SimTimer8_tccr(ecu, t);
+	uint8_t com = (tccr >> 4) & 0x03;
+	uint8_t ocr = SimTimer8_ocr(ecu, t);
+
+	if(com == 0)
+	{
+		return 0;
+	}
+
+	*duty = 0;
+	*frequency = 0;
+	if(t->prescaler == 0)
+	{
+		/* The pin keeps its level, take it as low */
+		return 1;
+	}
+
+	switch(SimTimer8_mode(ecu, t))
+	{
+	case SIM_WGM8_FAST_PWM:
+		*frequency = (double)SIM_F_CPU / (t->prescaler * (SIM_TIMER8_MAX + 1));
+		*duty = (ocr + 1) / (double)(SIM_TIMER8_MAX + 1);
+		if(com == 3)
+		{
+			*duty = 1 - *duty;
+		}
+		break;
+	case SIM_WGM8_PHASE_CORRECT:
+		*frequency = (double)SIM_F_CPU / (t->prescaler * 2 * SIM_TIMER8_MAX);
+		*duty = ocr / (double)SIM_TIMER8_MAX;
+		if(com == 3)
+		{
+			*duty = 1 - *duty;
+		}
+		break;
+	default:
+		if(com == 1)
+		{
+			/* Toggle on compare match : square wave */
+			*frequency = (double)SIM_F_CPU / (2.0 * t->prescaler * (SimTimer8_top(ecu, t) + 1));
+			*duty = 0.5;
+		}
+		else
+		{
+			/* Set/Clear on compare match : static level */
+			*duty = (com == 3) ? 1 : 0;
+		}
+		break;
+	}
+	return 1;
+}
+
+
+/*******************************************************************************
+ *                      Private Functions                                      *
+ *******************************************************************************/
+
+/* Counter value after the given ticks, it counts up to top then restarts from 0.
+ * A counter above top first counts up to max. */
+static uint32_t SimTimer_count(uint32_t baseCount,uint64_t ticks,uint32_t top,uint32_t max)
+{
+	uint64_t first;
+
+	if(baseCount > top)
+	{
+		first = max - baseCount + 1;
+		if(ticks < first)
+		{
+			return baseCount + (uint32_t)ticks;
+		}
+		ticks -= first;
+		baseCount = 0;
+	}
+	return (uint32_t)((baseCount + ticks) % (top + 1));
+}
+
+/* Ticks (at least one) till the counter becomes value, UINT64_MAX if never */
+static uint64_t SimTimer_ticksTo(uint32_t baseCount,uint32_t top,uint32_t max,uint32_t value)
+{
+	uint64_t offset = 0;
+
+	if(baseCount > top)
+	{
+		if((value > baseCount) && (value <= max))
+		{
+			return value - baseCount;
+		}
+		offset = max - baseCount + 1;
+		if(value == 0)
+		{
+			return offset;
+		}
+		baseCount = 0;
+	}
+	if(value > top)
+	{
+		return UINT64_MAX;
+	}
+	if(value > baseCount)
+	{
+		return offset + (value - baseCount);
+	}
+	return offset + (top + 1 - baseCount) + value;
+}
+
+static Sim_Time SimTimer_eventTime(Sim_Time baseTime,uint16_t prescaler,uint64_t ticks)
+{
+	if((prescaler == 0) || (ticks == UINT64_MAX))
+	{
+		return SIM_TIME_NEVER;
+	}
+	return baseTime + (ticks * prescaler);
+}
+
+/* Move a periodic event after now, by whole periods */
+static void SimTimer_catchUp(Sim_Time * event,Sim_Time period,Sim_Time now)
+{
+	if((*event != SIM_TIME_NEVER) && (*event <= now))
+	{
+		*event += (((now - *event) / period) + 1) * period;
+	}
+}
+
+static uint8_t SimTimer8_tccr(const Sim_Ecu * ecu,const Sim_Timer8 * timer)
+{
+	return ecu->io[(timer->id == 0) ? SIM_TCCR0 : SIM_TCCR2];
+}
+
+static uint8_t SimTimer8_mode(const Sim_Ecu * ecu,const Sim_Timer8 * timer)
+{
+	uint8_t tccr = SimTimer8_tccr(ecu, timer);
+
+	return (((tccr >> 3) & 0x01) << 1) | ((tccr >> 6) & 0x01);
+}
+
+/* Active compare value, behind the buffer in the PWM modes */
+static uint8_t SimTimer8_ocr(const Sim_Ecu * ecu,const Sim_Timer8 * timer)
+{
+	return ecu->io[(timer->id == 0) ? SIM_OCR0 : SIM_OCR2];
+}
+
+static uint32_t SimTimer8_top(const Sim_Ecu * ecu,const Sim_Timer8 * timer)
+{
+	return (SimTimer8_mode(ecu, timer) == SIM_WGM8_CTC) ? SimTimer8_ocr(ecu, timer) : SIM_TIMER8_MAX;
+}
+
+static uint8_t SimTimer8_count(const Sim_Ecu * ecu,const Sim_Timer8 * timer,Sim_Time time)
+{
+	if(timer->prescaler == 0)
+	{
+		return timer->baseCount;
+	}
+	return (uint8_t)SimTimer_count(timer->baseCount, (time - timer->baseTime) / timer->prescaler,
+			SimTimer8_top(ecu, timer), SIM_TIMER8_MAX);
+}
+
+/* Move the base to the last tick at or before time, keeping the counter value */
+static void SimTimer8_rebase(Sim_Ecu * ecu,Sim_Timer8 * timer,Sim_Time time)
+{
+	uint64_t ticks;
+
+	if(timer->prescaler == 0)
+	{
+		timer->baseTime = time;
+		return;
+	}
+	ticks = (time - timer->baseTime) / timer->prescaler;
+	timer->baseCount = SimTimer8_count(ecu, timer, time);
+	timer->baseTime += ticks * timer->prescaler;
+}
+
+static void SimTimer8_schedule(Sim_Ecu * ecu,Sim_Timer8 * timer)
+{
+	uint32_t top = SimTimer8_top(ecu, timer);
+
+	timer->nextCompare = SimTimer_eventTime(timer->baseTime, timer->prescaler,
+			SimTimer_ticksTo(timer->baseCount, top, SIM_TIMER8_MAX, SimTimer8_ocr(ecu, timer)));
+
+	/* TOVx when the counter wraps from MAX, at BOTTOM */
+	if(top == SIM_TIMER8_MAX)
+	{
+		timer->nextOverflow = SimTimer_eventTime(timer->baseTime, timer->prescaler,
+				SimTimer_ticksTo(timer->baseCount, top, SIM_TIMER8_MAX, 0));
+	}
+	else
+	{
+		timer->nextOverflow = SIM_TIME_NEVER;
+	}
+}
+
+static void SimTimer8_update(Sim_Ecu * ecu,Sim_Timer8 * timer)
+{
+	uint8_t tov = (timer->id == 0) ? (1<<TOV0) : (1<<TOV2);
+	uint8_t ocf = (timer->id == 0) ? (1<<OCF0) : (1<<OCF2);
+	Sim_RegisterId ocr = (timer->id == 0) ? SIM_OCR0 : SIM_OCR2;
+	Sim_Time period;
+	Sim_Time next;
+	uint8_t mode;
+
+	for(;;)
+	{
+		next = (timer->nextCompare < timer->nextOverflow) ? timer->nextCompare : timer->nextOverflow;
+		if(next > ecu->now)
+		{
+			break;
+		}
+		period = (Sim_Time)(SimTimer8_top(ecu, timer) + 1) * timer->prescaler;
+
+		if(next == timer->nextCompare)
+		{
+			ecu->io[SIM_TIFR] |= ocf;
+			SimTimer_catchUp(&timer->nextCompare, period, ecu->now);
+		}
+		if(next == timer->nextOverflow)
+		{
+			ecu->io[SIM_TIFR] |= tov;
+
+			/* The PWM modes load OCRx from its buffer at BOTTOM */
+			mode = SimTimer8_mode(ecu, timer);
+			if(((mode == SIM_WGM8_FAST_PWM) || (mode == SIM_WGM8_PHASE_CORRECT)) && (ecu->io[ocr] != timer->ocrBuffer))
+			{
+				ecu->io[ocr] = timer->ocrBuffer;
+				timer->baseTime = next;
+				timer->baseCount = 0;
+				SimTimer8_schedule(ecu, timer);
+			}
+			SimTimer_catchUp(&timer->nextOverflow, period, ecu->now);
+		}
+	}
+}
+
+/* Next event of the timer that sets a flag or loads OCRx */
+static Sim_Time SimTimer8_nextEvent(const Sim_Ecu * ecu,const Sim_Timer8 * timer)
+{
+	uint8_t tov = (timer->id == 0) ? (1<<TOV0) : (1<<TOV2);
+	uint8_t ocf = (timer->id == 0) ? (1<<OCF0) : (1<<OCF2);
+	uint8_t mode = SimTimer8_mode(ecu, timer);
+	Sim_Time next = SIM_TIME_NEVER;
+
+	if(!(ecu->io[SIM_TIFR] & ocf))
+	{
+		next = timer->nextCompare;
+	}
+	if(((!(ecu->io[SIM_TIFR] & tov)) ||
+	    (((mode == SIM_WGM8_FAST_PWM) || (mode == SIM_WGM8_PHASE_CORRECT)) && (SimTimer8_ocr(ecu, timer) != timer->ocrBuffer))) &&
+	   (timer->nextOverflow < next))
+	{
+		next = timer->nextOverflow;
+	}
+	return next;
+}
+
+static uint8_t SimTimer1_mode(const Sim_Ecu * ecu)
+{
+	return (((ecu->io[SIM_TCCR1B] >> WGM12) & 0x03) << 2) | (ecu->io[SIM_TCCR1A] & 0x03);
+}
+
+static uint32_t SimTimer1_top(const Sim_Ecu * ecu)
+{
+	switch(SimTimer1_mode(ecu))
+	{
+	case 1: case 5:
+		return 0x00FF;
+	case 2: case 6:
+		return 0x01FF;
+	case 3: case 7:
+		return 0x03FF;
+	case 4: case 9: case 11: case 15:
+		return ecu->timer1.ocr1a;
+	case 8: case 10: case 12: case 14:
+		return ecu->timer1.icr1;
+	default:
+		return SIM_TIMER16_MAX;
+	}
+}
+
+static uint16_t SimTimer1_count(const Sim_Ecu * ecu,Sim_Time time)
+{
+	const Sim_Timer1 * timer = &ecu->timer1;
+
+	if(timer->prescaler == 0)
+	{
+		return timer->baseCount;
+	}
+	return (uint16_t)SimTimer_count(timer->baseCount, (time - timer->baseTime) / timer->prescaler,
+			SimTimer1_top(ecu), SIM_TIMER16_MAX);
+}
+
+static void SimTimer1_rebase(Sim_Ecu * ecu,Sim_Time time)
+{
+	Sim_Timer1 * timer = &ecu->timer1;
+	uint64_t ticks;
+
+	if(timer->prescaler == 0)
+	{
+		timer->baseTime = time;
+		return;
+	}
+	ticks = (time - timer->baseTime) / timer->prescaler;
+	timer->baseCount = SimTimer1_count(ecu, time);
+	timer->baseTime += ticks * timer->prescaler;
+}
+
+static void SimTimer1_schedule(Sim_Ecu * ecu)
+{
+	Sim_Timer1 * timer = &ecu->timer1;
+	uint32_t top = SimTimer1_top(ecu);
+	uint8_t mode = SimTimer1_mode(ecu);
+
+	timer->nextCompareA = SimTimer_eventTime(timer->baseTime, timer->prescaler,
+			SimTimer_ticksTo(timer->baseCount, top, SIM_TIMER16_MAX, timer->ocr1a));
+	timer->nextCompareB = SimTimer_eventTime(timer->baseTime, timer->prescaler,
+			SimTimer_ticksTo(timer->baseCount, top, SIM_TIMER16_MAX, timer->ocr1b));
+
+	if((mode == 4) || (mode == 12))
+	{
+		/* CTC : TOV1 only when the counter passes MAX */
+		timer->nextOverflow = (top == SIM_TIMER16_MAX) ?
+				SimTimer_eventTime(timer->baseTime, timer->prescaler, SimTimer_ticksTo(timer->baseCount, top, SIM_TIMER16_MAX, 0)) :
+				SIM_TIME_NEVER;
+	}
+	else if(mode == 0)
+	{
+		timer->nextOverflow = SimTimer_eventTime(timer->baseTime, timer->prescaler,
+				SimTimer_ticksTo(timer->baseCount, top, SIM_TIMER16_MAX, 0));
+	}
+	else
+	{
+		/* PWM modes : TOV1 at TOP */
+		timer->nextOverflow = SimTimer_eventTime(timer->baseTime, timer->prescaler,
+				SimTimer_ticksTo(timer->baseCount, top, SIM_TIMER16_MAX, top));
+	}
+}
+
+static void SimTimer1_update(Sim_Ecu * ecu)
+{
+	Sim_Timer1 * timer = &ecu->timer1;
+	Sim_Time period = (Sim_Time)(SimTimer1_top(ecu) + 1) * timer->prescaler;
+
+	if(timer->nextCompareA <= ecu->now)
+	{
+		ecu->io[SIM_TIFR] |= (1<<OCF1A);
+		SimTimer_catchUp(&timer->nextCompareA, period, ecu->now);
+	}
+	if(timer->nextCompareB <= ecu->now)
+	{
+		ecu->io[SIM_TIFR] |= (1<<OCF1B);
+		SimTimer_catchUp(&timer->nextCompareB, period, ecu->now);
+	}
+	if(timer->nextOverflow <= ecu->now)
+	{
+		ecu->io[SIM_TIFR] |= (1<<TOV1);
+		SimTimer_catchUp(&timer->nextOverflow, period, ecu->now);
+	}
+}
@@ -0,0 +1,206 @@
+ /******************************************************************************
+ *
+ * Module: Host Simulator
+ *
+ * File Name: sim_twi.c
+ *
+ * Description: Simulated TWI of the ATmega32 in master mode, with the
+ *              24C16 EEPROM of the Control ECU as the only slave on the bus.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include <avr/io.h>
+#include "sim.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Bus states of the master */
+#define SIM_TWI_IDLE			0
+#define SIM_TWI_STARTED			1	/* START sent, SLA+R/W is next */
+#define SIM_TWI_TRANSMITTER		2
+#define SIM_TWI_RECEIVER		3
+#define SIM_TWI_NOT_ADDRESSED	4	/* SLA got no ACK, waiting for STOP or START */
+
+/* TWSR status codes of the master */
+#define SIM_TWI_START			0x08
+#define SIM_TWI_REP_START		0x10
+#define SIM_TWI_MT_SLA_ACK		0x18
+#define SIM_TWI_MT_SLA_NACK		0x20
+#define SIM_TWI_MT_DATA_ACK		0x28
+#define SIM_TWI_MT_DATA_NACK	0x30
+#define SIM_TWI_MR_SLA_ACK		0x40
+#define SIM_TWI_MR_SLA_NACK		0x48
+#define SIM_TWI_MR_DATA_ACK		0x50
+#define SIM_TWI_MR_DATA_NACK	0x58
+#define SIM_TWI_NO_STATE		0xF8
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static Sim_Time SimTwi_sclCycles(const Sim_Ecu * ecu);
+static void SimTwi_execute(Sim_Ecu * ecu,uint8_t twcr);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Set TWINT once the current bus operation is done.
+ */
+void SimTwi_update(Sim_Ecu * ecu)
+{
+	Sim_Twi * twi = &ecu->twi;
+
+	if(twi->pending && (twi->doneTime <= ecu->now))
+	{
+		twi->pending = 0;
+		twi->twcr |= (1<<TWINT);
+	}
+}
+
+/*
+ * Description :
+ * Return the time of the next TWI event.
+ */
+Sim_Time SimTwi_nextEvent(Sim_Ecu * ecu)
+{
+	return ecu->twi.pending ? ecu->twi.doneTime : SIM_TIME_NEVER;
+}
+
+uint8_t SimTwi_read(Sim_Ecu * ecu,Sim_RegisterId id)
+{
+	Sim_Twi * twi = &ecu->twi;
+
+	switch(id)
+	{
+	case SIM_TWCR:
+		return twi->twcr;
+	case SIM_TWSR:
+		return twi->twsr;
+	case SIM_TWDR:
+		return twi->twdr;
+	default:
+		return ecu->io[id];
+	}
+}
+
+void SimTwi_write(Sim_Ecu * ecu,Sim_RegisterId id,uint8_t value)
+{
+	Sim_Twi * twi = &ecu->twi;
+
+	switch(id)
+	{
+	case SIM_TWCR:
+		if(value & (1<<TWINT))
+		{
+			/* Writing one clears TWINT and starts the next operation */
+			twi->twcr = value & (~(1<<TWINT));
+			if(value & (1<<TWEN))
+			{
+				SimTwi_execute(ecu, value);
+			}
+		}
+		else
+		{
+			twi->twcr = (value & (~(1<<TWINT))) | (twi->twcr & (1<<TWINT));
+		}
+		break;
+	case SIM_TWSR:
+		/* Only the prescaler bits are writable */
+		twi->twsr = (twi->twsr & 0xF8) | (value & 0x03);
+		break;
+	case SIM_TWDR:
+		twi->twdr = value;
+		break;
+	default:
+		ecu->io[id] = value;
+		break;
+	}
+}
+
+
+/*******************************************************************************
+ *                      Private Functions                                      *
+ *******************************************************************************/
+
+static Sim_Time SimTwi_sclCycles(const Sim_Ecu * ecu)
+{
+	/* SCL frequency = F_CPU / (16 + 2 * TWBR * 4^TWPS) */
+	return 16 + (2 * (Sim_Time)ecu->io[SIM_TWBR] * (1UL << (2 * (ecu->twi.twsr & 0x03))));
+}
+
+static void SimTwi_execute(Sim_Ecu * ecu,uint8_t twcr)
+{
+	Sim_Twi * twi = &ecu->twi;
+	Sim_Time scl = SimTwi_sclCycles(ecu);
+	uint8_t ack;
+	uint8_t status;
+
+	if(twcr & (1<<TWSTA))
+	{
+		status = (twi->state == SIM_TWI_IDLE) ? SIM_TWI_START : SIM_TWI_REP_START;
+		if(status == SIM_TWI_START)
+		{
+			SimBench_event(ecu, SIM_EVENT_TWI_START, 0);
+		}
+		twi->state = SIM_TWI_STARTED;
+		twi->twsr = (twi->twsr & 0x03) | status;
+		twi->doneTime = ecu->now + scl;
+		twi->pending = 1;
+		return;
+	}
+
+	if(twcr & (1<<TWSTO))
+	{
+		/* STOP does not set TWINT, TWSTO is cleared once it is sent */
+		if(ecu->eeprom != NULL)
+		{
+			SimEeprom_stop(ecu->eeprom, ecu->now + scl);
+		}
+		twi->state = SIM_TWI_IDLE;
+		twi->twcr &= ~(1<<TWSTO);
+		SimBench_event(ecu, SIM_EVENT_TWI_STOP, 0);
+		twi->twsr = (twi->twsr & 0x03) | SIM_TWI_NO_STATE;
+		return;
+	}
+
+	/* A byte and the ACK bit */
+	switch(twi->state)
+	{
+	case SIM_TWI_STARTED:
+		ack = (ecu->eeprom != NULL) && SimEeprom_address(ecu->eeprom, ecu->now, twi->twdr);
+		if(twi->twdr & 0x01)
+		{
+			status = ack ? SIM_TWI_MR_SLA_ACK : SIM_TWI_MR_SLA_NACK;
+			twi->state = ack ? SIM_TWI_RECEIVER : SIM_TWI_NOT_ADDRESSED;
+		}
+		else
+		{
+			status = ack ? SIM_TWI_MT_SLA_ACK : SIM_TWI_MT_SLA_NACK;
+			twi->state = ack ? SIM_TWI_TRANSMITTER : SIM_TWI_NOT_ADDRESSED;
+		}
+		break;
+	case SIM_TWI_TRANSMITTER:
+		ack = SimEeprom_write(ecu->eeprom, twi->twdr);
+		status = ack ? SIM_TWI_MT_DATA_ACK : SIM_TWI_MT_DATA_NACK;
+		break;
+	case SIM_TWI_RECEIVER:
+		twi->twdr = SimEeprom_read(ecu->eeprom);
+		status = (twcr & (1<<TWEA)) ? SIM_TWI_MR_DATA_ACK : SIM_TWI_MR_DATA_NACK;
+		break;
+	default:
+		/* Nothing on the bus, the driver waits for TWINT forever as on the target */
+		Sim_trace(ecu, "TWI operation without START");
+		return;
+	}
+
+	twi->twsr = (twi->twsr & 0x03) | status;
+	twi->doneTime = ecu->now + (9 * scl);
+	twi->pending = 1;
+}
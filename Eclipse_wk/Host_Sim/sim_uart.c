@@ -0,0 +1,691 @@
+ /******************************************************************************
+ *
+ * Module: Host Simulator
+ *
+ * File Name: sim_uart.c
+ *
+ * Description: Simulated USART of the ATmega32, the TX of each ECU is
+ *              connected to the RX of the other one. On the multi-drop link
+ *              the Control ECU sends to all the panels, and the frames of
+ *              two panels on the line at the same time collide.
+ *
+ *              The sender puts the line levels of each frame on the link with
+ *              its own bit time, the receiver samples them in the middle of
+ *              its own bits, so a baud rate or a frame format mismatch gives
+ *              the same wrong bytes and FE/PE errors as on the real link.
+ *
+ *              In the synchronous mode the master puts its UBRR clock on
+ *              XCK and the slave sends and samples with it, a slave clocked
+ *              at F_CPU/4 or faster receives and sends FE errors.
+ *
+ *              With noise on the link one frame out of N is sent with one
+ *              bit flipped, the same ones from run to run.
+ *
+ *              On the RS-485 link a frame only gets on the bus while the
+ *              driver of the sender is enabled, and the receiver is off while
+ *              it is. The time from the stop bit of the last frame to the
+ *              release of the driver, and from the release to the driver of
+ *              the peer, are reported to the benchmark.
+ *
+ *              On the point-to-point link RTS of each ECU is wired to CTS
+ *              of the other one, for the RTS/CTS flow control.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include <avr/io.h>
+#include "sim.h"
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static uint8_t SimUart_dataBits(const Sim_Ecu * ecu);
+static uint8_t SimUart_frameBits(const Sim_Ecu * ecu);
+static uint32_t SimUart_bitCycles(const Sim_Ecu * ecu);
+static uint32_t SimUart_ubrr(const Sim_Ecu * ecu);
+static uint8_t SimUart_isXckMaster(const Sim_Ecu * ecu);
+static const Sim_Ecu * SimUart_xckMaster(const Sim_Ecu * ecu);
+static uint8_t SimUart_parity(uint16_t data,uint8_t bits,uint8_t odd);
+static uint32_t SimUart_random(void);
+static void SimUart_send(Sim_Ecu * ecu,uint16_t data,Sim_Time start);
+static void SimUart_putFrame(Sim_Ecu * ecu,Sim_Ecu * peer,const Sim_UartFrame * frame);
+static uint8_t SimUart_overlap(const Sim_UartFrame * frame1,const Sim_UartFrame * frame2);
+static Sim_Time SimUart_receiveTime(const Sim_Ecu * ecu,const Sim_UartFrame * frame);
+static void SimUart_receive(Sim_Ecu * ecu,const Sim_UartFrame * frame);
+static void SimUart_drive(Sim_Ecu * ecu);
+static void SimUart_release(Sim_Ecu * ecu);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Advance the transmitter and receive the frames of the peer completed by now.
+ */
+void SimUart_update(Sim_Ecu * ecu)
+{
+	Sim_Uart * uart = &ecu->uart;
+
+	while(uart->shifting && (uart->shiftEnd <= ecu->now))
+	{
+		if(uart->bufferFull)
+		{
+			/* The next byte goes from UDR to the shift register */
+			uart->bufferFull = 0;
+			SimUart_send(ecu, uart->buffer, uart->shiftEnd);
+			uart->shiftEnd += SimUart_frameCycles(ecu);
+		}
+		else
+		{
+			uart->shifting = 0;
+			ecu->io[SIM_UCSRA] |= (1<<TXC);
+		}
+	}
+
+	while((uart->lineCount > 0) && (SimUart_receiveTime(ecu, &uart->line[uart->lineHead]) <= ecu->now))
+	{
+		SimUart_receive(ecu, &uart->line[uart->lineHead]);
+		uart->lastFrame = uart->line[uart->lineHead];
+		uart->lineHead = (uart->lineHead + 1) % SIM_UART_LINE_SIZE;
+		uart->lineCount--;
+	}
+}
+
+/*
+ * Description :
+ * Return the time of the next UART event.
+ */
+Sim_Time SimUart_nextEvent(Sim_Ecu * ecu)
+{
+	Sim_Uart * uart = &ecu->uart;
+	Sim_Time next = SIM_TIME_NEVER;
+	Sim_Time receive;
+
+	if(uart->shifting)
+	{
+		next = uart->shiftEnd;
+	}
+	if(uart->lineCount > 0)
+	{
+		receive = SimUart_receiveTime(ecu, &uart->line[uart->lineHead]);
+		if(receive < next)
+		{
+			next = receive;
+		}
+	}
+	return next;
+}
+
+uint8_t SimUart_read(Sim_Ecu * ecu,Sim_RegisterId id)
+{
+	Sim_Uart * uart = &ecu->uart;
+	uint8_t value;
+	uint8_t i;
+
+	switch(id)
+	{
+	case SIM_UCSRA:
+		value = ecu->io[SIM_UCSRA] & ((1<<TXC) | (1<<U2X) | (1<<MPCM));
+		if(uart->fifoCount > 0)
+		{
+			/* FE, DOR and PE belong to the byte at the head of the FIFO */
+			value |= (1<<RXC) | uart->fifoErrors[0];
+		}
+		if(!uart->bufferFull)
+		{
+			value |= (1<<UDRE);
+		}
+		return value;
+	case SIM_UCSRB:
+		value = ecu->io[SIM_UCSRB] & (~(1<<RXB8));
+		if((uart->fifoCount > 0) && (uart->fifo[0] & 0x100))
+		{
+			value |= (1<<RXB8);
+		}
+		return value;
+	case SIM_UCSRC: case SIM_UBRRH:
+		/* Same address : a read gives UBRRH, a read in the next cycle gives UCSRC */
+		if(uart->ubrrhReadAccess == ecu->accesses)
+		{
+			uart->ubrrhReadAccess = 0;
+			return uart->ucsrc | (1<<URSEL);
+		}
+		uart->ubrrhReadAccess = ecu->accesses + 1;
+		return uart->ubrrh;
+	case SIM_UDR:
+		if(uart->fifoCount > 0)
+		{
+			uart->lastData = uart->fifo[0];
+			uart->lastSender = uart->fifoSenders[0];
+			for(i=1;i<uart->fifoCount;i++)
+			{
+				uart->fifo[i - 1] = uart->fifo[i];
+				uart->fifoErrors[i - 1] = uart->fifoErrors[i];
+				uart->fifoSenders[i - 1] = uart->fifoSenders[i];
+			}
+			uart->fifoCount--;
+			SimBench_event(ecu, SIM_EVENT_UART_READ, uart->lastData);
+		}
+		return (uint8_t)uart->lastData;
+	default:
+		return ecu->io[id];
+	}
+}
+
+void SimUart_write(Sim_Ecu * ecu,Sim_RegisterId id,uint8_t value)
+{
+	Sim_Uart * uart = &ecu->uart;
+	uint16_t data;
+
+	switch(id)
+	{
+	case SIM_UCSRA:
+		/* TXC is cleared by writing one, the other flags are read only */
+		ecu->io[SIM_UCSRA] = (value & ((1<<U2X) | (1<<MPCM))) |
+				(ecu->io[SIM_UCSRA] & (1<<TXC) & (~value));
+		break;
+	case SIM_UCSRB:
+		ecu->io[SIM_UCSRB] = value & (~(1<<RXB8));
+		if(!(value & (1<<RXEN)))
+		{
+			/* Disabling the receiver flushes the receive buffer */
+			uart->fifoCount = 0;
+		}
+		break;
+	case SIM_UCSRC: case SIM_UBRRH:
+		if(value & (1<<URSEL))
+		{
+			uart->ucsrc = value & (~(1<<URSEL));
+		}
+		else
+		{
+			uart->ubrrh = value & 0x0F;
+		}
+		break;
+	case SIM_UDR:
+		if(!(ecu->io[SIM_UCSRB] & (1<<TXEN)))
+		{
+			break;
+		}
+		data = value;
+		if(ecu->io[SIM_UCSRB] & (1<<TXB8))
+		{
+			data |= 0x100;
+		}
+		SimBench_event(ecu, SIM_EVENT_UART_WRITE, data);
+		if(!uart->shifting)
+		{
+			uart->shifting = 1;
+			uart->shiftEnd = ecu->now + SimUart_frameCycles(ecu);
+			SimUart_send(ecu, data, ecu->now);
+		}
+		else
+		{
+			/* A write while UDRE is cleared overwrites the buffer */
+			uart->buffer = data;
+			uart->bufferFull = 1;
+		}
+		break;
+	default:
+		ecu->io[id] = value;
+		break;
+	}
+}
+
+/*
+ * Description :
+ * The ECU has written PORTx or DDRx : the RS-485 driver follows its DE pin.
+ */
+void SimUart_portWritten(Sim_Ecu * ecu,uint8_t port)
+{
+	Sim_Uart * uart = &ecu->uart;
+	uint8_t driving;
+
+	if((!uart->rs485) || (port != SIM_RS485_DE_PORT))
+	{
+		return;
+	}
+	driving = (Sim_outputPins(ecu, port) >> SIM_RS485_DE_PIN) & 0x01;
+	if(driving == uart->driving)
+	{
+		return;
+	}
+
+	/* The transmitter must be up to date to know if the last frame is over */
+	SimUart_update(ecu);
+	uart->driving = driving;
+	if(driving)
+	{
+		SimUart_drive(ecu);
+	}
+	else
+	{
+		SimUart_release(ecu);
+	}
+}
+
+/*
+ * Description :
+ * Return the levels the UART wires give to the input pins of the port : CTS
+ * follows RTS of the peer, high with the pull-up while it is not an output.
+ */
+uint8_t SimUart_readPins(Sim_Ecu * ecu,uint8_t port)
+{
+	uint8_t rts;
+
+	if((port != SIM_RTS_CTS_PORT) || (ecu->peerCount != 1))
+	{
+		return 0xFF;
+	}
+	rts = 1;
+	if(ecu->peers[0]->io[SIM_DDRA + (3 * port)] & (1<<SIM_RTS_PIN))
+	{
+		rts = (Sim_outputPins(ecu->peers[0], port) >> SIM_RTS_PIN) & 0x01;
+	}
+	return rts ? 0xFF : (uint8_t)(~(1<<SIM_CTS_PIN));
+}
+
+/*
+ * Description :
+ * Return the time of one frame with the current settings of the ECU.
+ */
+Sim_Time SimUart_frameCycles(const Sim_Ecu * ecu)
+{
+	return (Sim_Time)SimUart_frameBits(ecu) * SimUart_bitCycles(ecu);
+}
+
+
+/*******************************************************************************
+ *                      Private Functions                                      *
+ *******************************************************************************/
+
+static uint8_t SimUart_dataBits(const Sim_Ecu * ecu)
+{
+	uint8_t ucsz = ((ecu->io[SIM_UCSRB] >> UCSZ2) & 0x01) << 2 | ((ecu->uart.ucsrc >> UCSZ0) & 0x03);
+
+	return (ucsz == 7) ? 9 : (5 + (ucsz & 0x03));
+}
+
+static uint8_t SimUart_frameBits(const Sim_Ecu * ecu)
+{
+	uint8_t ucsrc = ecu->uart.ucsrc;
+
+	/* Start + data + parity + stop bits */
+	return 1 + SimUart_dataBits(ecu) + ((ucsrc & (1<<UPM1)) ? 1 : 0) + ((ucsrc & (1<<USBS)) ? 2 : 1);
+}
+
+static uint32_t SimUart_bitCycles(const Sim_Ecu * ecu)
+{
+	const Sim_Ecu * master;
+
+	if(ecu->uart.ucsrc & (1<<UMSEL))
+	{
+		if(SimUart_isXckMaster(ecu))
+		{
+			return 2 * (SimUart_ubrr(ecu) + 1);
+		}
+		/* The slave runs with XCK of the master, no frame can arrive sooner than the fastest one */
+		master = SimUart_xckMaster(ecu);
+		return (master != NULL) ? (2 * (SimUart_ubrr(master) + 1)) : 2;
+	}
+	return ((ecu->io[SIM_UCSRA] & (1<<U2X)) ? 8 : 16) * (SimUart_ubrr(ecu) + 1);
+}
+
+static uint32_t SimUart_ubrr(const Sim_Ecu * ecu)
+{
+	return ((uint32_t)ecu->uart.ubrrh << 8) | ecu->io[SIM_UBRRL];
+}
+
+/* XCK is an output on the master of the synchronous mode */
+static uint8_t SimUart_isXckMaster(const Sim_Ecu * ecu)
+{
+	return (ecu->io[SIM_DDRA + (3 * SIM_XCK_PORT)] >> SIM_XCK_PIN) & 0x01;
+}
+
+/* Peer that clocks the synchronous slave, NULL if there is none */
+static const Sim_Ecu * SimUart_xckMaster(const Sim_Ecu * ecu)
+{
+	uint8_t i;
+
+	for(i=0;i<ecu->peerCount;i++)
+	{
+		if((ecu->peers[i]->uart.ucsrc & (1<<UMSEL)) && SimUart_isXckMaster(ecu->peers[i]))
+		{
+			return ecu->peers[i];
+		}
+	}
+	return NULL;
+}
+
+static uint8_t SimUart_parity(uint16_t data,uint8_t bits,uint8_t odd)
+{
+	uint8_t parity = odd;
+	uint8_t i;
+
+	for(i=0;i<bits;i++)
+	{
+		parity ^= (data >> i) & 0x01;
+	}
+	return parity;
+}
+
+/* Xorshift, the same noise from run to run */
+static uint32_t SimUart_random(void)
+{
+	static uint32_t state = 0x2545F491UL;
+
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+/* Put the frame on the line to the peers */
+static void SimUart_send(Sim_Ecu * ecu,uint16_t data,Sim_Time start)
+{
+	Sim_UartFrame frame;
+	uint8_t ucsrc = ecu->uart.ucsrc;
+	uint8_t bits = SimUart_dataBits(ecu);
+	uint8_t length = 1 + bits;
+	uint32_t waveform;
+	uint8_t i;
+
+	ecu->uart.bytesSent++;
+	Sim_trace(ecu, "UART TX 0x%02X", data);
+	if(ecu->uart.linkLog != NULL)
+	{
+		fputc((uint8_t)data, ecu->uart.linkLog);
+	}
+	if(ecu->uart.rs485 && (!ecu->uart.driving))
+	{
+		/* The transceiver does not put it on the bus */
+		ecu->uart.undriven++;
+		Sim_trace(ecu, "RS-485 frame sent with the driver off");
+		return;
+	}
+	if(ecu->peerCount == 0)
+	{
+		return;
+	}
+	if((ucsrc & (1<<UMSEL)) && (!SimUart_isXckMaster(ecu)) && (SimUart_xckMaster(ecu) == NULL))
+	{
+		/* No clock on XCK, the frame does not leave the slave */
+		ecu->uart.errors++;
+		Sim_trace(ecu, "UART synchronous slave without an XCK clock");
+		return;
+	}
+
+	/* Start bit = 0, data LSB first, parity, stop bits = 1 */
+	waveform = ((uint32_t)data & ((1UL<<bits) - 1)) << 1;
+	if(ucsrc & (1<<UPM1))
+	{
+		waveform |= (uint32_t)SimUart_parity(data, bits, (ucsrc >> UPM0) & 0x01) << length;
+		length++;
+	}
+	waveform |= 0x3UL << length;
+	length += (ucsrc & (1<<USBS)) ? 2 : 1;
+	if((ecu->uart.noise != 0) && ((SimUart_random() % ecu->uart.noise) == 0))
+	{
+		/* A data, parity or stop bit : a wrong byte, a PE or a FE for the receiver */
+		waveform ^= 1UL << (1 + (SimUart_random() % (length - 1)));
+		ecu->uart.bitErrors++;
+		Sim_trace(ecu, "UART bit error on the line");
+	}
+
+	frame.start = start;
+	frame.waveform = waveform;
+	frame.length = length;
+	frame.synchronous = (ucsrc & (1<<UMSEL)) ? 1 : 0;
+	frame.bitCycles = SimUart_bitCycles(ecu);
+	frame.sender = ecu;
+	frame.collision = 0;
+	for(i=0;i<ecu->peerCount;i++)
+	{
+		SimUart_putFrame(ecu, ecu->peers[i], &frame);
+	}
+}
+
+/*
+ * Insert the frame in the line of the peer in the order of the start times,
+ * the senders of the frames may not run in the same order
+ */
+static void SimUart_putFrame(Sim_Ecu * ecu,Sim_Ecu * peer,const Sim_UartFrame * frame)
+{
+	Sim_Uart * peerUart = &peer->uart;
+	Sim_UartFrame * other;
+	uint8_t position;
+	uint8_t collision = 0;
+	uint8_t i;
+
+	if(peerUart->lineCount == SIM_UART_LINE_SIZE)
+	{
+		Sim_fatal(ecu, "too many frames on the line");
+	}
+
+	/* The frames of another sender on the line at the same time are all lost */
+	if((peerUart->lastFrame.sender != NULL) && SimUart_overlap(frame, &peerUart->lastFrame))
+	{
+		collision = 1;
+	}
+	position = peerUart->lineCount;
+	for(i=0;i<peerUart->lineCount;i++)
+	{
+		other = &peerUart->line[(peerUart->lineHead + i) % SIM_UART_LINE_SIZE];
+		if(SimUart_overlap(frame, other))
+		{
+			other->collision = 1;
+			collision = 1;
+		}
+		if((position == peerUart->lineCount) && (frame->start < other->start))
+		{
+			position = i;
+		}
+	}
+	if(collision)
+	{
+		peerUart->collisions++;
+		Sim_trace(peer, "UART collision");
+	}
+
+	for(i=peerUart->lineCount;i>position;i--)
+	{
+		peerUart->line[(peerUart->lineHead + i) % SIM_UART_LINE_SIZE] =
+				peerUart->line[(peerUart->lineHead + i - 1) % SIM_UART_LINE_SIZE];
+	}
+	other = &peerUart->line[(peerUart->lineHead + position) % SIM_UART_LINE_SIZE];
+	*other = *frame;
+	other->collision = collision;
+	peerUart->lineCount++;
+	Sim_wakePeer(ecu, peer, SimUart_receiveTime(peer, other));
+}
+
+/* Two frames of different senders on the line at the same time */
+static uint8_t SimUart_overlap(const Sim_UartFrame * frame1,const Sim_UartFrame * frame2)
+{
+	Sim_Time end1 = frame1->start + ((Sim_Time)frame1->length * frame1->bitCycles);
+	Sim_Time end2 = frame2->start + ((Sim_Time)frame2->length * frame2->bitCycles);
+
+	return (frame1->sender != frame2->sender) && (frame1->start < end2) && (frame2->start < end1);
+}
+
+/* The receiver has the frame once it samples the middle of its first stop bit */
+static Sim_Time SimUart_receiveTime(const Sim_Ecu * ecu,const Sim_UartFrame * frame)
+{
+	uint32_t bitCycles = frame->synchronous ? frame->bitCycles : SimUart_bitCycles(ecu);
+	uint8_t stopBit = 1 + SimUart_dataBits(ecu) + ((ecu->uart.ucsrc & (1<<UPM1)) ? 1 : 0);
+
+	return frame->start + (Sim_Time)stopBit * bitCycles + (bitCycles / 2);
+}
+
+static void SimUart_receive(Sim_Ecu * ecu,const Sim_UartFrame * frame)
+{
+	Sim_Uart * uart = &ecu->uart;
+	uint8_t ucsrc = uart->ucsrc;
+	uint8_t bits = SimUart_dataBits(ecu);
+	/* The receiver samples with its own clock, with XCK in synchronous mode */
+	uint32_t bitCycles = frame->synchronous ? frame->bitCycles : SimUart_bitCycles(ecu);
+	uint16_t data = 0;
+	uint8_t errors = 0;
+	uint8_t sample;
+	uint8_t level;
+	uint8_t index;
+	uint8_t addressBit;
+
+	if(!(ecu->io[SIM_UCSRB] & (1<<RXEN)))
+	{
+		return;
+	}
+	if(uart->rs485 && uart->driving)
+	{
+		/* /RE is tied to DE, the receiver does not see the bus while driving it */
+		Sim_trace(ecu, "RS-485 frame lost, the driver is on");
+		return;
+	}
+
+	/* Sample n is taken in the middle of the receiver bit n */
+	for(sample=0;sample<(bits + 2 + ((ucsrc & (1<<UPM1)) ? 1 : 0));sample++)
+	{
+		index = (uint8_t)((((uint64_t)sample * bitCycles) + (bitCycles / 2)) / frame->bitCycles);
+		level = (index < frame->length) ? ((frame->waveform >> index) & 0x01) : 1;
+
+		if(sample == 0)
+		{
+			if(level)
+			{
+				/* False start bit, nothing is received */
+				return;
+			}
+		}
+		else if(sample <= bits)
+		{
+			data |= (uint16_t)level << (sample - 1);
+		}
+		else if((ucsrc & (1<<UPM1)) && (sample == (bits + 1)))
+		{
+			if(level != SimUart_parity(data, bits, (ucsrc >> UPM0) & 0x01))
+			{
+				errors |= (1<<PE);
+			}
+		}
+		else if(!level)
+		{
+			errors |= (1<<FE);
+		}
+	}
+	if(frame->collision)
+	{
+		/* The two drivers fight on the line, the receiver can not sample a valid frame */
+		errors |= (1<<FE);
+	}
+	if(frame->synchronous && (frame->bitCycles < SIM_XCK_SLAVE_MIN_CYCLES) &&
+			((!SimUart_isXckMaster(ecu)) || (!SimUart_isXckMaster(frame->sender))))
+	{
+		/* The slave misses XCK edges */
+		errors |= (1<<FE);
+	}
+
+	/* Multi-processor mode : only the address frames are received */
+	if(ecu->io[SIM_UCSRA] & (1<<MPCM))
+	{
+		addressBit = (bits == 9) ? ((data >> 8) & 0x01) : (!(errors & (1<<FE)));
+		if(!addressBit)
+		{
+			return;
+		}
+	}
+
+	if(uart->fifoCount == SIM_UART_FIFO_SIZE)
+	{
+		/* The frame is lost, DOR is seen with the last byte of the FIFO */
+		uart->fifoErrors[SIM_UART_FIFO_SIZE - 1] |= (1<<DOR);
+		uart->errors++;
+		Sim_trace(ecu, "UART RX overrun");
+		return;
+	}
+
+	if(errors)
+	{
+		uart->errors++;
+	}
+	uart->fifo[uart->fifoCount] = data;
+	uart->fifoErrors[uart->fifoCount] = errors;
+	uart->fifoSenders[uart->fifoCount] = frame->sender;
+	uart->fifoCount++;
+	uart->bytesReceived++;
+	Sim_trace(ecu, "UART RX 0x%02X%s%s", data, (errors & (1<<FE)) ? " FE" : "", (errors & (1<<PE)) ? " PE" : "");
+}
+
+/*
+ * The driver is enabled : the turnaround is timed from the last release of
+ * a peer, a peer still driving the bus is a conflict
+ */
+static void SimUart_drive(Sim_Ecu * ecu)
+{
+	Sim_Uart * uart = &ecu->uart;
+	const Sim_Uart * peerUart;
+	Sim_Time released = 0;
+	uint8_t i;
+
+	uart->driveStart = ecu->now;
+	uart->driveConflict = 0;
+	for(i=0;i<ecu->peerCount;i++)
+	{
+		peerUart = &ecu->peers[i]->uart;
+		if(peerUart->driving)
+		{
+			/* A peer behind in time may still release it before now, it checks when it does */
+			if((ecu->peers[i]->now >= ecu->now) && (!uart->driveConflict))
+			{
+				uart->driveConflict = 1;
+				uart->conflicts++;
+				Sim_trace(ecu, "RS-485 conflict with %s", ecu->peers[i]->name);
+			}
+		}
+		else if((peerUart->driveEnd <= ecu->now) && (peerUart->driveEnd > released))
+		{
+			released = peerUart->driveEnd;
+		}
+	}
+	if((!uart->driveConflict) && (released != 0) && (ecu->now - released <= SIM_RS485_TURNAROUND_CYCLES))
+	{
+		SimBench_event(ecu, SIM_EVENT_RS485_TURNAROUND, (uint32_t)(ecu->now - released));
+	}
+}
+
+/*
+ * The driver is released : timed from the stop bit of the last frame, a peer
+ * that enabled its driver before now is a conflict
+ */
+static void SimUart_release(Sim_Ecu * ecu)
+{
+	Sim_Uart * uart = &ecu->uart;
+	Sim_Uart * peerUart;
+	uint8_t i;
+
+	uart->driveEnd = ecu->now;
+	if(uart->shifting)
+	{
+		/* The rest of the frame is not driven, the receivers see the idle bus */
+		uart->undriven++;
+		Sim_trace(ecu, "RS-485 driver released during a frame");
+	}
+	else if(uart->bytesSent > 0)
+	{
+		SimBench_event(ecu, SIM_EVENT_RS485_RELEASE, (uint32_t)(ecu->now - uart->shiftEnd));
+	}
+
+	for(i=0;i<ecu->peerCount;i++)
+	{
+		peerUart = &ecu->peers[i]->uart;
+		if((peerUart->driveStart > uart->driveStart) && (peerUart->driveStart < ecu->now) &&
+				(!peerUart->driveConflict))
+		{
+			peerUart->driveConflict = 1;
+			peerUart->conflicts++;
+			Sim_trace(ecu->peers[i], "RS-485 conflict with %s", ecu->name);
+		}
+	}
+}
@@ -0,0 +1,217 @@
+ /******************************************************************************
+ *
+ * Module: Queue test
+ *
+ * File Name: queue_test.c
+ *
+ * Description: Stress test of the ECU single producer single consumer queue
+ *              (Control_ECU/queue.c) on the host : a producer thread puts
+ *              numbered elements and a consumer thread takes them, the
+ *              consumer checks that every element comes once and in order.
+ *              The two threads run at the same time on two cores, the way
+ *              the ISR and the main loop can never do on the AVR, so a
+ *              missing barrier shows up here as a lost or repeated element.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "queue.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define QUEUE_TEST_DEFAULT_ITEMS	4000000UL
+#define QUEUE_TEST_MAX_CAPACITY		128
+
+/* Element of the wide queues : the sequence number and its complement */
+typedef struct{
+	unsigned long sequence;
+	unsigned long check;
+}QueueTest_Element;
+
+typedef struct{
+	const char * name;
+	uint8 elementSize;		/* 1 : byte queue like the UART rings */
+	uint8 capacity;
+	uint8 peekDrop;			/* consumer takes with Queue_peek() + Queue_drop() */
+}QueueTest_Case;
+
+typedef struct{
+	Queue queue;
+	const QueueTest_Case * testCase;
+	unsigned long items;
+	unsigned long received;
+	unsigned long errors;
+	unsigned long fullSpins;
+	unsigned long emptySpins;
+}QueueTest_Run;
+
+/*******************************************************************************
+ *                      Global Variables                                  *
+ *******************************************************************************/
+
+static const QueueTest_Case g_cases[] = {
+	{"byte queue, capacity 1",              1, 1,   FALSE},
+	{"byte queue, capacity 32",             1, 32,  FALSE},
+	{"byte queue, capacity 128",            1, 128, FALSE},
+	{"byte queue, capacity 128, peek/drop", 1, 128, TRUE},
+	{"16-byte elements, capacity 8",        sizeof(QueueTest_Element), 8, FALSE},
+	{"16-byte elements, capacity 8, peek/drop", sizeof(QueueTest_Element), 8, TRUE},
+};
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+static void QueueTest_fill(const QueueTest_Run * run,unsigned long sequence,void * element)
+{
+	if(run->testCase->elementSize == 1)
+	{
+		*(uint8 *)element = (uint8)sequence;
+	}
+	else
+	{
+		QueueTest_Element * wide = (QueueTest_Element *)element;
+		wide->sequence = sequence;
+		wide->check = ~sequence;
+	}
+}
+
+static uint8 QueueTest_matches(const QueueTest_Run * run,unsigned long sequence,const void * element)
+{
+	if(run->testCase->elementSize == 1)
+	{
+		return (*(const uint8 *)element == (uint8)sequence);
+	}
+	else
+	{
+		const QueueTest_Element * wide = (const QueueTest_Element *)element;
+		return (wide->sequence == sequence) && (wide->check == ~sequence);
+	}
+}
+
+static void * QueueTest_producer(void * argument)
+{
+	QueueTest_Run * run = (QueueTest_Run *)argument;
+	QueueTest_Element element;
+	unsigned long sequence;
+
+	for(sequence = 0; sequence < run->items; sequence++)
+	{
+		QueueTest_fill(run, sequence, &element);
+		while(!Queue_put(&run->queue, &element))
+		{
+			run->fullSpins++;
+			sched_yield();
+		}
+	}
+	return NULL;
+}
+
+static void * QueueTest_consumer(void * argument)
+{
+	QueueTest_Run * run = (QueueTest_Run *)argument;
+	QueueTest_Element element;
+	uint8 count;
+	uint8 taken;
+
+	while(run->received < run->items)
+	{
+		count = Queue_count(&run->queue);
+		if(count > run->testCase->capacity)
+		{
+			/* More elements than places : the counters are torn */
+			run->errors++;
+		}
+
+		if(run->testCase->peekDrop)
+		{
+			taken = Queue_peek(&run->queue, &element);
+			if(taken)
+			{
+				Queue_drop(&run->queue);
+			}
+		}
+		else
+		{
+			taken = Queue_get(&run->queue, &element);
+		}
+
+		if(!taken)
+		{
+			run->emptySpins++;
+			sched_yield();
+			continue;
+		}
+
+		if(!QueueTest_matches(run, run->received, &element))
+		{
+			if(run->errors < 10)
+			{
+				fprintf(stderr, "  element %lu out of order\n", run->received);
+			}
+			run->errors++;
+		}
+		run->received++;
+	}
+	return NULL;
+}
+
+static unsigned long QueueTest_runCase(const QueueTest_Case * test_case,unsigned long items)
+{
+	static uint8 buffer[QUEUE_BUFFER_SIZE(sizeof(QueueTest_Element), QUEUE_TEST_MAX_CAPACITY)];
+	QueueTest_Run run;
+	pthread_t producer;
+	pthread_t consumer;
+
+	memset(&run, 0, sizeof(run));
+	run.testCase = test_case;
+	run.items = items;
+	Queue_init(&run.queue, buffer, test_case->elementSize, test_case->capacity);
+
+	if(pthread_create(&consumer, NULL, QueueTest_consumer, &run) != 0 ||
+			pthread_create(&producer, NULL, QueueTest_producer, &run) != 0)
+	{
+		perror("pthread_create");
+		exit(2);
+	}
+	pthread_join(producer, NULL);
+	pthread_join(consumer, NULL);
+
+	if(!Queue_isEmpty(&run.queue))
+	{
+		/* The consumer stopped at the count, an extra element is a repeated one */
+		run.errors++;
+	}
+
+	printf("%-42s %lu items, %lu errors, %lu full waits, %lu empty waits\n",
+			test_case->name, run.received, run.errors, run.fullSpins, run.emptySpins);
+	return run.errors;
+}
+
+int main(int argc,char * argv[])
+{
+	unsigned long items = QUEUE_TEST_DEFAULT_ITEMS;
+	unsigned long errors = 0;
+	unsigned int i;
+
+	if(argc > 1)
+	{
+		items = strtoul(argv[1], NULL, 0);
+	}
+
+	for(i = 0; i < sizeof(g_cases)/sizeof(g_cases[0]); i++)
+	{
+		errors += QueueTest_runCase(&g_cases[i], items);
+	}
+
+	printf("%s\n", errors ? "FAIL" : "PASS");
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,88 @@
+ /******************************************************************************
+ *
+ * Module: simavr Co-simulation
+ *
+ * File Name: cosim.h
+ *
+ * Description: Internal header of door_simavr. The real AVR images of the
+ *              Control ECU and of the HMI ECU run on two simavr ATmega32
+ *              cores, their UARTs are cross-wired and the devices of each
+ *              board are modelled on the pins and the peripherals :
+ *              Control ECU : 24C16 on the TWI bus, door motor with its
+ *                            encoder, shunt and limit switches.
+ *              HMI ECU     : HD44780 LCD in 8-bit mode and 4x4 keypad.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#ifndef COSIM_H_
+#define COSIM_H_
+
+#include <stdint.h>
+#include "sim_avr.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Same clock as the -DF_CPU=8000000UL builds */
+#define COSIM_F_CPU					8000000UL
+#define COSIM_CYCLES_PER_MS			(COSIM_F_CPU / 1000UL)
+
+#define COSIM_LCD_COLUMNS			16
+#define COSIM_LCD_ROWS				2
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef enum{
+	COSIM_MOTOR_STOP, COSIM_MOTOR_OPEN, COSIM_MOTOR_CLOSE
+}Cosim_MotorState;
+
+typedef struct{
+	const char * name;
+	avr_t * avr;
+	/* Statistics */
+	uint32_t bytesSent;
+	uint32_t bytesReceived;
+}Cosim_Ecu;
+
+/*******************************************************************************
+ *                      Global Variables                                       *
+ *******************************************************************************/
+
+extern Cosim_Ecu g_cosimControl;
+extern Cosim_Ecu g_cosimHmi;
+/* Print the trace of the devices and the link */
+extern uint8_t g_cosimTrace;
+/* Counts the changes of the LCD, the motor and the keypad, the waits of
+ * the script only check their condition after a change */
+extern uint32_t g_cosimChanges;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/* cosim_main.c */
+uint8_t Cosim_run(double ms,uint8_t (*condition)(const void * arg),const void * arg);
+double Cosim_timeMs(void);
+void Cosim_trace(const Cosim_Ecu * ecu,const char * format,...);
+
+/* cosim_control_board.c */
+void CosimControlBoard_attach(Cosim_Ecu * ecu,const char * eepromFile);
+Cosim_MotorState CosimControlBoard_getMotor(void);
+const char * CosimControlBoard_motorName(Cosim_MotorState state);
+void CosimControlBoard_finish(void);
+
+/* cosim_hmi_board.c */
+void CosimHmiBoard_attach(Cosim_Ecu * ecu);
+void CosimHmiBoard_pressKeys(const char * keys);
+uint8_t CosimHmiBoard_keysDone(void);
+void CosimHmiBoard_getLine(uint8_t row,char * line);
+
+/* cosim_script.c */
+int CosimScript_run(const char * file);
+
+#endif /* COSIM_H_ */
@@ -0,0 +1,343 @@
+ /******************************************************************************
+ *
+ * Module: simavr Co-simulation
+ *
+ * File Name: cosim_control_board.c
+ *
+ * Description: Devices of the Control ECU board on the simavr core :
+ *              24C16 EEPROM on the TWI bus (the model of the host simulator).
+ *              Door motor, direction on PB0/PB1 and enable on PB3/OC0, with
+ *              its 0.5 ohm shunt on ADC0 and its encoder on ICP1.
+ *              Door limit switches, opened on PD2/INT0 and closed on PD3/INT1,
+ *              active low.
+ *
+ *              The motor is the first order model of the host simulator,
+ *              integrated in steps of 100 us by a cycle timer of the core.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "sim_avr.h"
+#include "sim_cycle_timers.h"
+#include "avr_ioport.h"
+#include "avr_timer.h"
+#include "avr_adc.h"
+#include "avr_twi.h"
+#include "sim_eeprom.h"
+#include "cosim.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define COSIM_MOTOR_IN1_PIN			0			/* PB0 */
+#define COSIM_MOTOR_IN2_PIN			1			/* PB1 */
+#define COSIM_MOTOR_ENABLE_PIN		3			/* PB3 */
+#define COSIM_LIMIT_OPENED_PIN		2			/* PD2 */
+#define COSIM_LIMIT_CLOSED_PIN		3			/* PD3 */
+
+/* Data space addresses of the ATmega32 registers read by the board */
+#define COSIM_PORTB_ADDRESS			0x38
+#define COSIM_TCCR0_ADDRESS			0x53
+#define COSIM_OCR0_ADDRESS			0x5C
+#define COSIM_TCCR0_WGM00			6
+#define COSIM_TCCR0_COM01			5
+#define COSIM_TCCR0_WGM01			3
+
+/* Motor and door, same as the host simulator */
+#define COSIM_MOTOR_NO_LOAD_RPM		330.0
+#define COSIM_MOTOR_TIME_CONSTANT	0.05		/* seconds */
+#define COSIM_MOTOR_STALL_CURRENT	2.5			/* amperes at 100% */
+#define COSIM_DOOR_FRICTION_CURRENT	0.3			/* amperes */
+#define COSIM_ENCODER_PULSES_PER_REV	20
+#define COSIM_DOOR_TRAVEL_PULSES	400.0
+#define COSIM_LIMIT_SWITCH_PULSES	2.0
+#define COSIM_DOOR_REST_SPEED		0.01
+#define COSIM_SHUNT_OHMS			0.5
+
+#define COSIM_MOTOR_STEP_US			100
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef struct{
+	Cosim_Ecu * ecu;
+	Sim_Eeprom * eeprom;
+	avr_irq_t * twiIrqs;			/* TWI_IRQ_INPUT/OUTPUT of the bus device */
+	uint8_t twiSelected;			/* slave address of the transfer, 0 if not for us */
+	double position;				/* encoder pulses from closed */
+	double speed;					/* pulses per second, positive to open */
+	double current;					/* amperes */
+	Cosim_MotorState motor;			/* from PB0/PB1 */
+	uint8_t opened;					/* limit switches pressed */
+	uint8_t closed;
+}CosimControlBoard_State;
+
+/*******************************************************************************
+ *                      Global Variables                                       *
+ *******************************************************************************/
+
+static CosimControlBoard_State g_cosimControlBoard;
+
+static const char * g_cosimTwiIrqNames[2] = {"8>cosim.twi.in", "32<cosim.twi.out"};
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void CosimControlBoard_twiHook(struct avr_irq_t * irq,uint32_t value,void * param);
+static void CosimControlBoard_portBHook(struct avr_irq_t * irq,uint32_t value,void * param);
+static avr_cycle_count_t CosimControlBoard_stepTimer(struct avr_t * avr,avr_cycle_count_t when,void * param);
+static double CosimControlBoard_drive(const CosimControlBoard_State * state);
+static void CosimControlBoard_setPin(char port,uint8_t pin,uint8_t level);
+static void CosimControlBoard_encoderPulse(void);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Connect the devices to the core, the door starts closed.
+ * The EEPROM is kept in eepromFile if it is not NULL.
+ */
+void CosimControlBoard_attach(Cosim_Ecu * ecu,const char * eepromFile)
+{
+	CosimControlBoard_State * state = &g_cosimControlBoard;
+	avr_t * avr = ecu->avr;
+
+	memset(state, 0, sizeof(CosimControlBoard_State));
+	state->ecu = ecu;
+	state->closed = 1;
+	state->eeprom = SimEeprom_create(eepromFile);
+
+	/* The EEPROM is a device on the bus : its output goes to the TWI input of the core */
+	state->twiIrqs = avr_alloc_irq(&avr->irq_pool, 0, 2, g_cosimTwiIrqNames);
+	avr_irq_register_notify(state->twiIrqs + TWI_IRQ_OUTPUT, CosimControlBoard_twiHook, state);
+	avr_connect_irq(avr_io_getirq(avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_OUTPUT), state->twiIrqs + TWI_IRQ_OUTPUT);
+	avr_connect_irq(state->twiIrqs + TWI_IRQ_INPUT, avr_io_getirq(avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_INPUT));
+
+	avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), IOPORT_IRQ_PIN_ALL),
+			CosimControlBoard_portBHook, state);
+
+	/* Released (pulled up) opened switch, pressed closed switch, no current */
+	CosimControlBoard_setPin('D', COSIM_LIMIT_OPENED_PIN, 1);
+	CosimControlBoard_setPin('D', COSIM_LIMIT_CLOSED_PIN, 0);
+	avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_ADC_GETIRQ, ADC_IRQ_ADC0), 0);
+
+	avr_cycle_timer_register_usec(avr, COSIM_MOTOR_STEP_US, CosimControlBoard_stepTimer, state);
+}
+
+/*
+ * Description :
+ * Return the state of the motor driven by PB0/PB1.
+ */
+Cosim_MotorState CosimControlBoard_getMotor(void)
+{
+	return g_cosimControlBoard.motor;
+}
+
+const char * CosimControlBoard_motorName(Cosim_MotorState state)
+{
+	static const char * names[3] = {"stop", "open", "close"};
+
+	return names[state];
+}
+
+/*
+ * Description :
+ * Save the EEPROM and print the statistics of the board.
+ */
+void CosimControlBoard_finish(void)
+{
+	CosimControlBoard_State * state = &g_cosimControlBoard;
+
+	SimEeprom_save(state->eeprom);
+	printf("Door              : at %.0f%%\n", 100.0 * state->position / COSIM_DOOR_TRAVEL_PULSES);
+	printf("EEPROM writes     : %u\n", SimEeprom_writes(state->eeprom));
+}
+
+
+/*******************************************************************************
+ *                      Private Functions                                      *
+ *******************************************************************************/
+
+/* Messages of the TWI master of the core, answered as the 24C16 */
+static void CosimControlBoard_twiHook(struct avr_irq_t * irq,uint32_t value,void * param)
+{
+	CosimControlBoard_State * state = param;
+	avr_t * avr = state->ecu->avr;
+	avr_twi_msg_irq_t message;
+
+	message.u.v = value;
+
+	if(message.u.twi.msg & TWI_COND_STOP)
+	{
+		if(state->twiSelected)
+		{
+			SimEeprom_stop(state->eeprom, avr->cycle);
+		}
+		state->twiSelected = 0;
+	}
+	if(message.u.twi.msg & TWI_COND_START)
+	{
+		/* A START or a repeated START with the slave address */
+		state->twiSelected = 0;
+		if(SimEeprom_address(state->eeprom, avr->cycle, message.u.twi.addr))
+		{
+			state->twiSelected = message.u.twi.addr;
+			avr_raise_irq(state->twiIrqs + TWI_IRQ_INPUT, avr_twi_irq_msg(TWI_COND_ACK, state->twiSelected, 1));
+		}
+	}
+	if(!state->twiSelected)
+	{
+		return;
+	}
+	if(message.u.twi.msg & TWI_COND_WRITE)
+	{
+		if(SimEeprom_write(state->eeprom, message.u.twi.data))
+		{
+			avr_raise_irq(state->twiIrqs + TWI_IRQ_INPUT, avr_twi_irq_msg(TWI_COND_ACK, state->twiSelected, 1));
+		}
+	}
+	if(message.u.twi.msg & TWI_COND_READ)
+	{
+		avr_raise_irq(state->twiIrqs + TWI_IRQ_INPUT,
+				avr_twi_irq_msg(TWI_COND_READ, state->twiSelected, SimEeprom_read(state->eeprom)));
+	}
+}
+
+static void CosimControlBoard_portBHook(struct avr_irq_t * irq,uint32_t value,void * param)
+{
+	CosimControlBoard_State * state = param;
+	uint8_t pins = state->ecu->avr->data[COSIM_PORTB_ADDRESS];
+	Cosim_MotorState motor = COSIM_MOTOR_STOP;
+
+	if((pins & (1<<COSIM_MOTOR_IN1_PIN)) && (!(pins & (1<<COSIM_MOTOR_IN2_PIN))))
+	{
+		motor = COSIM_MOTOR_OPEN;
+	}
+	else if((!(pins & (1<<COSIM_MOTOR_IN1_PIN))) && (pins & (1<<COSIM_MOTOR_IN2_PIN)))
+	{
+		motor = COSIM_MOTOR_CLOSE;
+	}
+
+	if(motor != state->motor)
+	{
+		state->motor = motor;
+		g_cosimChanges++;
+		Cosim_trace(state->ecu, "Motor %s, door at %.0f%%", CosimControlBoard_motorName(motor),
+				100.0 * state->position / COSIM_DOOR_TRAVEL_PULSES);
+	}
+}
+
+/* One step of the motor, the timer repeats for the whole run */
+static avr_cycle_count_t CosimControlBoard_stepTimer(struct avr_t * avr,avr_cycle_count_t when,void * param)
+{
+	CosimControlBoard_State * state = param;
+	const double noLoadSpeed = COSIM_MOTOR_NO_LOAD_RPM * COSIM_ENCODER_PULSES_PER_REV / 60.0;
+	const double frictionSpeed = noLoadSpeed * COSIM_DOOR_FRICTION_CURRENT / COSIM_MOTOR_STALL_CURRENT;
+	const double dt = COSIM_MOTOR_STEP_US / 1000000.0;
+	double drive = CosimControlBoard_drive(state);
+	double target = drive * noLoadSpeed;
+	double oldPosition = state->position;
+	double speed;
+	uint8_t opened;
+	uint8_t closed;
+
+	/* The friction holds the door below its torque */
+	if(fabs(target) <= frictionSpeed)
+	{
+		target = 0;
+	}
+	else
+	{
+		target -= (target > 0) ? frictionSpeed : -frictionSpeed;
+	}
+	speed = target + (state->speed - target) * exp(-dt / COSIM_MOTOR_TIME_CONSTANT);
+	if((target == 0) && (fabs(speed) < COSIM_DOOR_REST_SPEED))
+	{
+		speed = 0;
+	}
+	state->position += 0.5 * (state->speed + speed) * dt;
+	state->speed = speed;
+
+	/* Mechanical ends of the travel */
+	if(state->position >= COSIM_DOOR_TRAVEL_PULSES)
+	{
+		state->position = COSIM_DOOR_TRAVEL_PULSES;
+		state->speed = 0;
+	}
+	else if(state->position <= 0)
+	{
+		state->position = 0;
+		state->speed = 0;
+	}
+	state->current = fabs(COSIM_MOTOR_STALL_CURRENT * (drive - state->speed / noLoadSpeed));
+	avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_ADC_GETIRQ, ADC_IRQ_ADC0),
+			(uint32_t)(state->current * COSIM_SHUNT_OHMS * 1000.0));
+
+	/* The door is below 110 pulses per second, at most one pulse in a step */
+	if(floor(state->position) != floor(oldPosition))
+	{
+		CosimControlBoard_encoderPulse();
+	}
+
+	opened = (state->position >= (COSIM_DOOR_TRAVEL_PULSES - COSIM_LIMIT_SWITCH_PULSES));
+	closed = (state->position <= COSIM_LIMIT_SWITCH_PULSES);
+	if(opened != state->opened)
+	{
+		state->opened = opened;
+		CosimControlBoard_setPin('D', COSIM_LIMIT_OPENED_PIN, !opened);
+		Cosim_trace(state->ecu, "Door opened limit switch %s", opened ? "pressed" : "released");
+	}
+	if(closed != state->closed)
+	{
+		state->closed = closed;
+		CosimControlBoard_setPin('D', COSIM_LIMIT_CLOSED_PIN, !closed);
+		Cosim_trace(state->ecu, "Door closed limit switch %s", closed ? "pressed" : "released");
+	}
+	return when + avr_usec_to_cycles(avr, COSIM_MOTOR_STEP_US);
+}
+
+/* Average voltage on the motor as a part of the supply, signed by the direction */
+static double CosimControlBoard_drive(const CosimControlBoard_State * state)
+{
+	const uint8_t * data = state->ecu->avr->data;
+	uint8_t tccr0 = data[COSIM_TCCR0_ADDRESS];
+	double duty;
+
+	if(state->motor == COSIM_MOTOR_STOP)
+	{
+		return 0;
+	}
+	/* Fast PWM, non-inverting on OC0, else the level of PB3 */
+	if((tccr0 & (1<<COSIM_TCCR0_WGM00)) && (tccr0 & (1<<COSIM_TCCR0_WGM01)) && (tccr0 & (1<<COSIM_TCCR0_COM01)))
+	{
+		duty = data[COSIM_OCR0_ADDRESS] / 255.0;
+	}
+	else
+	{
+		duty = (data[COSIM_PORTB_ADDRESS] & (1<<COSIM_MOTOR_ENABLE_PIN)) ? 1.0 : 0.0;
+	}
+	return (state->motor == COSIM_MOTOR_OPEN) ? duty : -duty;
+}
+
+static void CosimControlBoard_setPin(char port,uint8_t pin,uint8_t level)
+{
+	avr_raise_irq(avr_io_getirq(g_cosimControl.avr, AVR_IOCTL_IOPORT_GETIRQ(port), pin), level);
+}
+
+/* A pulse on ICP1, the capture takes the edge selected by ICES1 */
+static void CosimControlBoard_encoderPulse(void)
+{
+	avr_irq_t * icp = avr_io_getirq(g_cosimControl.avr, AVR_IOCTL_TIMER_GETIRQ('1'), TIMER_IRQ_IN_ICP);
+
+	avr_raise_irq(icp, 1);
+	avr_raise_irq(icp, 0);
+}
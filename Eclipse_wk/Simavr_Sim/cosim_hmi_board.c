@@ -0,0 +1,347 @@
+ /******************************************************************************
+ *
+ * Module: simavr Co-simulation
+ *
+ * File Name: cosim_hmi_board.c
+ *
+ * Description: Devices of the HMI ECU board on the simavr core :
+ *              HD44780 LCD, 8-bit data on PORTC, RS on PD4 and E on PD5.
+ *              4x4 keypad, rows on PA0-PA3 and columns on PA4-PA7, a pressed
+ *              key pulls its column low while its row is driven low.
+ *
+ *              The devices follow the writes of the ports and use cycle
+ *              timers of the core for the timing of the user and the screen.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_avr.h"
+#include "sim_cycle_timers.h"
+#include "avr_ioport.h"
+#include "cosim.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define COSIM_LCD_RS_PIN			4			/* PD4 */
+#define COSIM_LCD_E_PIN				5			/* PD5 */
+#define COSIM_LCD_DDRAM_SIZE		0x80
+#define COSIM_LCD_LINE1_ADDRESS		0x40
+#define COSIM_LCD_LINE_LENGTH		0x28
+/* The screen is traced, and checked by the script, once it has not changed for this time */
+#define COSIM_LCD_SETTLE_US			20000
+
+#define COSIM_KEYPAD_FIRST_COL_PIN	4			/* PA4 */
+#define COSIM_KEYPAD_ROWS_MASK		0x0F
+/* The user releases the key after the ECU reads it, then waits for the next one */
+#define COSIM_KEYPAD_HOLD_US		40000
+#define COSIM_KEYPAD_GAP_US			60000
+#define COSIM_KEYPAD_PAUSE_US		1000000
+
+/* Data space addresses of the ATmega32 registers read by the board */
+#define COSIM_PORTA_ADDRESS			0x3B
+#define COSIM_DDRA_ADDRESS			0x3A
+#define COSIM_PORTC_ADDRESS			0x35
+#define COSIM_PORTD_ADDRESS			0x32
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef struct{
+	Cosim_Ecu * ecu;
+	/* LCD */
+	char ddram[COSIM_LCD_DDRAM_SIZE];
+	uint8_t address;
+	uint8_t enable;					/* E level at the last port write */
+	/* Keypad */
+	char * keys;					/* copy of the keys of the script */
+	const char * nextKey;
+	int8_t row;						/* pressed key, -1 for none */
+	int8_t col;
+	uint8_t detected;
+	uint8_t waiting;				/* a timer of the keypad is pending */
+	uint8_t driving;				/* the keypad is driving the column pins */
+}CosimHmiBoard_State;
+
+/*******************************************************************************
+ *                      Global Variables                                       *
+ *******************************************************************************/
+
+/* Keys in the order of the buttons, see KEYPAD_4x4_adjustKeyNumber() */
+static const char g_cosimKeypadLayout[] = "789%456*123-C0=+";
+
+static CosimHmiBoard_State g_cosimHmiBoard;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void CosimHmiBoard_lcdHook(struct avr_irq_t * irq,uint32_t value,void * param);
+static void CosimHmiBoard_lcdExecute(CosimHmiBoard_State * state,uint8_t rs,uint8_t data);
+static avr_cycle_count_t CosimHmiBoard_settleTimer(struct avr_t * avr,avr_cycle_count_t when,void * param);
+static void CosimHmiBoard_keypadHook(struct avr_irq_t * irq,uint32_t value,void * param);
+static void CosimHmiBoard_driveColumns(CosimHmiBoard_State * state);
+static avr_cycle_count_t CosimHmiBoard_releaseTimer(struct avr_t * avr,avr_cycle_count_t when,void * param);
+static avr_cycle_count_t CosimHmiBoard_pressTimer(struct avr_t * avr,avr_cycle_count_t when,void * param);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Connect the LCD and the keypad to the core, no key is pressed.
+ */
+void CosimHmiBoard_attach(Cosim_Ecu * ecu)
+{
+	CosimHmiBoard_State * state = &g_cosimHmiBoard;
+	avr_t * avr = ecu->avr;
+
+	memset(state, 0, sizeof(CosimHmiBoard_State));
+	memset(state->ddram, ' ', COSIM_LCD_DDRAM_SIZE);
+	state->ecu = ecu;
+	state->nextKey = "";
+	state->row = -1;
+	state->col = -1;
+
+	avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('C'), IOPORT_IRQ_PIN_ALL),
+			CosimHmiBoard_lcdHook, state);
+	avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('D'), IOPORT_IRQ_PIN_ALL),
+			CosimHmiBoard_lcdHook, state);
+
+	/* The scan drives a row low by PORTA or by DDRA */
+	avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('A'), IOPORT_IRQ_PIN_ALL),
+			CosimHmiBoard_keypadHook, state);
+	avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('A'), IOPORT_IRQ_DIRECTION_ALL),
+			CosimHmiBoard_keypadHook, state);
+	CosimHmiBoard_driveColumns(state);
+}
+
+/*
+ * Description :
+ * Press the keys in order, a space waits for 1 second. The keys are
+ * added after the ones not pressed yet.
+ */
+void CosimHmiBoard_pressKeys(const char * keys)
+{
+	CosimHmiBoard_State * state = &g_cosimHmiBoard;
+	size_t pending = strlen(state->nextKey);
+	char * buffer = malloc(pending + strlen(keys) + 1);
+
+	if(buffer == NULL)
+	{
+		fprintf(stderr, "out of memory\n");
+		exit(2);
+	}
+	strcpy(buffer, state->nextKey);
+	strcat(buffer, keys);
+	free(state->keys);
+	state->keys = buffer;
+	state->nextKey = buffer;
+
+	if((state->row < 0) && (!state->waiting))
+	{
+		state->waiting = 1;
+		avr_cycle_timer_register(state->ecu->avr, 1, CosimHmiBoard_pressTimer, state);
+	}
+}
+
+/*
+ * Description :
+ * Return TRUE once all the keys are pressed and released.
+ */
+uint8_t CosimHmiBoard_keysDone(void)
+{
+	const CosimHmiBoard_State * state = &g_cosimHmiBoard;
+
+	return (*state->nextKey == '\0') && (state->row < 0) && (!state->waiting);
+}
+
+/*
+ * Description :
+ * Copy the visible characters of the LCD row (0 or 1) to line,
+ * it needs COSIM_LCD_COLUMNS + 1 characters.
+ */
+void CosimHmiBoard_getLine(uint8_t row,char * line)
+{
+	const CosimHmiBoard_State * state = &g_cosimHmiBoard;
+	uint8_t first = (row == 0) ? 0 : COSIM_LCD_LINE1_ADDRESS;
+	uint8_t i;
+	char c;
+
+	for(i=0;i<COSIM_LCD_COLUMNS;i++)
+	{
+		c = state->ddram[first + i];
+		line[i] = ((c >= ' ') && (c <= '~')) ? c : '?';
+	}
+	line[COSIM_LCD_COLUMNS] = '\0';
+}
+
+
+/*******************************************************************************
+ *                      Private Functions                                      *
+ *******************************************************************************/
+
+static void CosimHmiBoard_lcdHook(struct avr_irq_t * irq,uint32_t value,void * param)
+{
+	CosimHmiBoard_State * state = param;
+	const uint8_t * data = state->ecu->avr->data;
+	uint8_t control = data[COSIM_PORTD_ADDRESS];
+	uint8_t enable = (control >> COSIM_LCD_E_PIN) & 0x01;
+
+	/* The HD44780 latches RS and the data on the falling edge of E */
+	if(state->enable && (!enable))
+	{
+		CosimHmiBoard_lcdExecute(state, (control >> COSIM_LCD_RS_PIN) & 0x01, data[COSIM_PORTC_ADDRESS]);
+	}
+	state->enable = enable;
+}
+
+static void CosimHmiBoard_lcdExecute(CosimHmiBoard_State * state,uint8_t rs,uint8_t data)
+{
+	avr_t * avr = state->ecu->avr;
+
+	if(rs)
+	{
+		state->ddram[state->address] = (char)data;
+		/* Two lines mode : 0x00-0x27 then 0x40-0x67 */
+		state->address++;
+		if(state->address == COSIM_LCD_LINE_LENGTH)
+		{
+			state->address = COSIM_LCD_LINE1_ADDRESS;
+		}
+		else if(state->address == (COSIM_LCD_LINE1_ADDRESS + COSIM_LCD_LINE_LENGTH))
+		{
+			state->address = 0;
+		}
+	}
+	else if(data & 0x80)
+	{
+		/* Set DDRAM address */
+		state->address = data & 0x7F;
+	}
+	else if(data == 0x01)
+	{
+		/* Clear display */
+		memset(state->ddram, ' ', COSIM_LCD_DDRAM_SIZE);
+		state->address = 0;
+	}
+	else if((data & 0xFE) == 0x02)
+	{
+		/* Return home */
+		state->address = 0;
+	}
+	else
+	{
+		/* Function set, display control, entry mode, CGRAM : no effect on the text */
+		return;
+	}
+
+	/* Restart the settle time */
+	avr_cycle_timer_cancel(avr, CosimHmiBoard_settleTimer, state);
+	avr_cycle_timer_register_usec(avr, COSIM_LCD_SETTLE_US, CosimHmiBoard_settleTimer, state);
+}
+
+static avr_cycle_count_t CosimHmiBoard_settleTimer(struct avr_t * avr,avr_cycle_count_t when,void * param)
+{
+	CosimHmiBoard_State * state = param;
+	char line0[COSIM_LCD_COLUMNS + 1];
+	char line1[COSIM_LCD_COLUMNS + 1];
+
+	CosimHmiBoard_getLine(0, line0);
+	CosimHmiBoard_getLine(1, line1);
+	Cosim_trace(state->ecu, "LCD |%s|%s|", line0, line1);
+	g_cosimChanges++;
+	return 0;
+}
+
+static void CosimHmiBoard_keypadHook(struct avr_irq_t * irq,uint32_t value,void * param)
+{
+	CosimHmiBoard_State * state = param;
+
+	/* Driving the columns notifies the port too */
+	if(!state->driving)
+	{
+		CosimHmiBoard_driveColumns(state);
+	}
+}
+
+/* The column of the pressed key is low while its row is driven low, the others are pulled up */
+static void CosimHmiBoard_driveColumns(CosimHmiBoard_State * state)
+{
+	avr_t * avr = state->ecu->avr;
+	uint8_t rows = (~avr->data[COSIM_PORTA_ADDRESS]) & avr->data[COSIM_DDRA_ADDRESS] & COSIM_KEYPAD_ROWS_MASK;
+	uint8_t pressed = (state->row >= 0) && (rows & (1<<state->row));
+	uint8_t col;
+
+	state->driving = 1;
+	for(col=0;col<4;col++)
+	{
+		avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('A'), COSIM_KEYPAD_FIRST_COL_PIN + col),
+				!(pressed && (col == state->col)));
+	}
+	state->driving = 0;
+
+	if(pressed && (!state->detected))
+	{
+		state->detected = 1;
+		avr_cycle_timer_register_usec(avr, COSIM_KEYPAD_HOLD_US, CosimHmiBoard_releaseTimer, state);
+	}
+}
+
+static avr_cycle_count_t CosimHmiBoard_releaseTimer(struct avr_t * avr,avr_cycle_count_t when,void * param)
+{
+	CosimHmiBoard_State * state = param;
+
+	state->row = -1;
+	state->col = -1;
+	CosimHmiBoard_driveColumns(state);
+	g_cosimChanges++;
+
+	if(*state->nextKey != '\0')
+	{
+		state->waiting = 1;
+		avr_cycle_timer_register_usec(avr, COSIM_KEYPAD_GAP_US, CosimHmiBoard_pressTimer, state);
+	}
+	return 0;
+}
+
+static avr_cycle_count_t CosimHmiBoard_pressTimer(struct avr_t * avr,avr_cycle_count_t when,void * param)
+{
+	CosimHmiBoard_State * state = param;
+	const char * button;
+	char key;
+
+	state->waiting = 0;
+	if(*state->nextKey == '\0')
+	{
+		g_cosimChanges++;
+		return 0;
+	}
+	key = *state->nextKey++;
+
+	if(key == ' ')
+	{
+		state->waiting = 1;
+		return when + avr_usec_to_cycles(avr, COSIM_KEYPAD_PAUSE_US);
+	}
+
+	button = strchr(g_cosimKeypadLayout, key);
+	if(button == NULL)
+	{
+		fprintf(stderr, "no key '%c' on the keypad\n", key);
+		exit(2);
+	}
+	state->row = (int8_t)((button - g_cosimKeypadLayout) / 4);
+	state->col = (int8_t)((button - g_cosimKeypadLayout) % 4);
+	state->detected = 0;
+	Cosim_trace(state->ecu, "Key '%c' pressed", key);
+	CosimHmiBoard_driveColumns(state);
+	return 0;
+}
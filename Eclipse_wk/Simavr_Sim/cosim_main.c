@@ -0,0 +1,275 @@
+ /******************************************************************************
+ *
+ * Module: simavr Co-simulation
+ *
+ * File Name: cosim_main.c
+ *
+ * Description: door_simavr, loads the AVR images of the two ECUs on two
+ *              simavr cores, wires their UARTs together and runs a script
+ *              of key presses and checks of the LCD and the motor pins.
+ *
+ *              The core that is behind in cycles always executes the next
+ *              instruction, so the two cores never drift apart by more than
+ *              one instruction and the bytes on the link keep their order.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include <getopt.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "avr_uart.h"
+#include "cosim.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define COSIM_MCU					"atmega32"
+#define COSIM_CONTROL_ELF			"../Control_ECU/Debug/Control_ECU.elf"
+#define COSIM_HMI_ELF				"../HMI_ECU/Debug/HMI_ECU.elf"
+
+/*******************************************************************************
+ *                      Global Variables                                       *
+ *******************************************************************************/
+
+Cosim_Ecu g_cosimControl = {"Control", NULL, 0, 0};
+Cosim_Ecu g_cosimHmi = {"HMI", NULL, 0, 0};
+uint8_t g_cosimTrace = 0;
+uint32_t g_cosimChanges = 0;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static void usage(const char * program);
+static void Cosim_load(Cosim_Ecu * ecu,const char * file);
+static void Cosim_connect(Cosim_Ecu * sender,Cosim_Ecu * receiver);
+static void Cosim_uartOutputHook(struct avr_irq_t * irq,uint32_t value,void * param);
+static void Cosim_step(void);
+static void printSummary(int result);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+int main(int argc,char * argv[])
+{
+	static const struct option options[] = {
+			{"control", required_argument, NULL, 'c'},
+			{"hmi", required_argument, NULL, 'm'},
+			{"eeprom", required_argument, NULL, 'e'},
+			{"verbose", no_argument, NULL, 'v'},
+			{"help", no_argument, NULL, 'h'},
+			{NULL, 0, NULL, 0}
+	};
+	const char * controlFile = COSIM_CONTROL_ELF;
+	const char * hmiFile = COSIM_HMI_ELF;
+	const char * eepromFile = NULL;
+	int result;
+	int option;
+
+	while((option = getopt_long(argc, argv, "c:m:e:vh", options, NULL)) != -1)
+	{
+		switch(option)
+		{
+		case 'c': controlFile = optarg; break;
+		case 'm': hmiFile = optarg; break;
+		case 'e': eepromFile = optarg; break;
+		case 'v': g_cosimTrace = 1; break;
+		default:
+			usage(argv[0]);
+			return (option == 'h') ? 0 : 2;
+		}
+	}
+	if(optind != (argc - 1))
+	{
+		usage(argv[0]);
+		return 2;
+	}
+
+	Cosim_load(&g_cosimControl, controlFile);
+	Cosim_load(&g_cosimHmi, hmiFile);
+	Cosim_connect(&g_cosimControl, &g_cosimHmi);
+	Cosim_connect(&g_cosimHmi, &g_cosimControl);
+	CosimControlBoard_attach(&g_cosimControl, eepromFile);
+	CosimHmiBoard_attach(&g_cosimHmi);
+
+	result = CosimScript_run(argv[optind]);
+
+	CosimControlBoard_finish();
+	printSummary(result);
+	return result;
+}
+
+/*
+ * Description :
+ * Run the two cores for the given simulated time, or till condition(arg)
+ * returns TRUE. It is checked at the start and after each change of the
+ * devices. Return TRUE if the condition is met (always TRUE without one).
+ */
+uint8_t Cosim_run(double ms,uint8_t (*condition)(const void * arg),const void * arg)
+{
+	avr_cycle_count_t end = g_cosimControl.avr->cycle + (avr_cycle_count_t)(ms * COSIM_CYCLES_PER_MS);
+	uint32_t changes = g_cosimChanges;
+
+	if((condition != NULL) && condition(arg))
+	{
+		return 1;
+	}
+	while((g_cosimControl.avr->cycle < end) || (g_cosimHmi.avr->cycle < end))
+	{
+		Cosim_step();
+		if((condition != NULL) && (changes != g_cosimChanges))
+		{
+			changes = g_cosimChanges;
+			if(condition(arg))
+			{
+				return 1;
+			}
+		}
+	}
+	return (condition == NULL);
+}
+
+/*
+ * Description :
+ * Return the simulated time in milliseconds, of the core that is behind.
+ */
+double Cosim_timeMs(void)
+{
+	avr_cycle_count_t cycle = g_cosimControl.avr->cycle;
+
+	if(g_cosimHmi.avr->cycle < cycle)
+	{
+		cycle = g_cosimHmi.avr->cycle;
+	}
+	return (double)cycle / COSIM_CYCLES_PER_MS;
+}
+
+/*
+ * Description :
+ * Print a trace line with the simulated time, only when tracing is enabled.
+ */
+void Cosim_trace(const Cosim_Ecu * ecu,const char * format,...)
+{
+	va_list args;
+
+	if(!g_cosimTrace)
+	{
+		return;
+	}
+	printf("%12.3f ms  %-8s ", (double)ecu->avr->cycle / COSIM_CYCLES_PER_MS, ecu->name);
+	va_start(args, format);
+	vprintf(format, args);
+	va_end(args);
+	printf("\n");
+}
+
+
+/*******************************************************************************
+ *                      Private Functions                                      *
+ *******************************************************************************/
+
+static void usage(const char * program)
+{
+	printf("Usage: %s [options] SCRIPT\n"
+			"  -c, --control ELF   Control ECU image (" COSIM_CONTROL_ELF ")\n"
+			"  -m, --hmi ELF       HMI ECU image (" COSIM_HMI_ELF ")\n"
+			"  -e, --eeprom FILE   keep the 24C16 content in FILE\n"
+			"  -v, --verbose       trace the devices and the UART link\n",
+			program);
+}
+
+/* Load the image on a new ATmega32 core at 8 MHz */
+static void Cosim_load(Cosim_Ecu * ecu,const char * file)
+{
+	elf_firmware_t firmware;
+	uint32_t flags = 0;
+
+	memset(&firmware, 0, sizeof(firmware));
+	if(elf_read_firmware(file, &firmware) != 0)
+	{
+		fprintf(stderr, "%s: can not read the image %s\n", ecu->name, file);
+		exit(2);
+	}
+	/* The images have no .mmcu section, the MCU and the clock are the ones of the build */
+	strcpy(firmware.mmcu, COSIM_MCU);
+	firmware.frequency = COSIM_F_CPU;
+
+	ecu->avr = avr_make_mcu_by_name(firmware.mmcu);
+	if(ecu->avr == NULL)
+	{
+		fprintf(stderr, "simavr has no %s core\n", COSIM_MCU);
+		exit(2);
+	}
+	avr_init(ecu->avr);
+	avr_load_firmware(ecu->avr, &firmware);
+	/* AVCC = AREF = 5V for the ADC */
+	ecu->avr->avcc = 5000;
+	ecu->avr->aref = 5000;
+
+	/* The UART goes to the other core : no stdout echo, and no host sleep while polling */
+	avr_ioctl(ecu->avr, AVR_IOCTL_UART_GET_FLAGS('0'), &flags);
+	flags &= ~(AVR_UART_FLAG_STDIO | AVR_UART_FLAG_POOL_SLEEP);
+	avr_ioctl(ecu->avr, AVR_IOCTL_UART_SET_FLAGS('0'), &flags);
+}
+
+/* TXD of the sender to RXD of the receiver */
+static void Cosim_connect(Cosim_Ecu * sender,Cosim_Ecu * receiver)
+{
+	avr_irq_t * output = avr_io_getirq(sender->avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT);
+
+	avr_connect_irq(output, avr_io_getirq(receiver->avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_INPUT));
+	avr_irq_register_notify(output, Cosim_uartOutputHook, sender);
+}
+
+static void Cosim_uartOutputHook(struct avr_irq_t * irq,uint32_t value,void * param)
+{
+	Cosim_Ecu * sender = param;
+	Cosim_Ecu * receiver = (sender == &g_cosimControl) ? &g_cosimHmi : &g_cosimControl;
+
+	sender->bytesSent++;
+	receiver->bytesReceived++;
+	Cosim_trace(sender, "UART TX 0x%02X", value & 0xFF);
+}
+
+/* One instruction (or one sleep) of the core that is behind */
+static void Cosim_step(void)
+{
+	Cosim_Ecu * ecu = (g_cosimControl.avr->cycle <= g_cosimHmi.avr->cycle) ? &g_cosimControl : &g_cosimHmi;
+	int state = avr_run(ecu->avr);
+
+	if((state == cpu_Done) || (state == cpu_Crashed))
+	{
+		fprintf(stderr, "%12.3f ms  %-8s error: the core %s\n", Cosim_timeMs(), ecu->name,
+				(state == cpu_Crashed) ? "crashed" : "stopped");
+		exit(2);
+	}
+}
+
+static void printSummary(int result)
+{
+	const Cosim_Ecu * ecus[2] = {&g_cosimControl, &g_cosimHmi};
+	char line0[COSIM_LCD_COLUMNS + 1];
+	char line1[COSIM_LCD_COLUMNS + 1];
+	uint8_t i;
+
+	CosimHmiBoard_getLine(0, line0);
+	CosimHmiBoard_getLine(1, line1);
+
+	printf("Result            : %s\n", (result == 0) ? "passed" : "failed");
+	printf("Simulated time    : %.3f s\n", Cosim_timeMs() / 1000);
+	printf("Motor             : %s\n", CosimControlBoard_motorName(CosimControlBoard_getMotor()));
+	printf("LCD               : |%s|%s|\n", line0, line1);
+	for(i=0;i<2;i++)
+	{
+		printf("%-8s UART      : sent %u, received %u\n", ecus[i]->name, ecus[i]->bytesSent, ecus[i]->bytesReceived);
+		printf("%-8s cycles    : %llu\n", ecus[i]->name, (unsigned long long)ecus[i]->avr->cycle);
+	}
+}
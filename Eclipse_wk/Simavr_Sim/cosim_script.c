@@ -0,0 +1,235 @@
+ /******************************************************************************
+ *
+ * Module: simavr Co-simulation
+ *
+ * File Name: cosim_script.c
+ *
+ * Description: Scripts of door_simavr, one command per line :
+ *              keys TEXT                      press the keys, ' ' waits 1 s
+ *              wait MS                        run the two cores for MS
+ *              wait-keys TIMEOUT_MS           till all the keys are released
+ *              wait-lcd ROW "TEXT" TIMEOUT_MS till the LCD row starts with TEXT
+ *              expect-lcd ROW "TEXT"          the LCD row starts with TEXT now
+ *              wait-motor STATE TIMEOUT_MS    till the motor is open|close|stop
+ *              expect-motor STATE             the motor is in STATE now
+ *              # comment
+ *              The first failed check stops the script.
+ *
+ * Author: Omar Elsherif
+ *
+ *******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cosim.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+#define COSIM_SCRIPT_LINE_SIZE		256
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+typedef struct{
+	uint8_t row;
+	char text[COSIM_LCD_COLUMNS + 1];
+}CosimScript_LcdCheck;
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+static int CosimScript_execute(char * line,const char * file,unsigned int number);
+static uint8_t CosimScript_parseLcd(char * arguments,CosimScript_LcdCheck * check,char ** rest);
+static uint8_t CosimScript_parseMotor(const char * name,Cosim_MotorState * motor);
+static uint8_t CosimScript_lcdMatches(const void * arg);
+static uint8_t CosimScript_motorMatches(const void * arg);
+static uint8_t CosimScript_keysReleased(const void * arg);
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Run the script, return 0 if all the checks passed, 1 if one failed and
+ * 2 if the script can not be read.
+ */
+int CosimScript_run(const char * file)
+{
+	char line[COSIM_SCRIPT_LINE_SIZE];
+	unsigned int number = 0;
+	FILE * stream = fopen(file, "r");
+	int result = 0;
+
+	if(stream == NULL)
+	{
+		fprintf(stderr, "can not open the script %s\n", file);
+		return 2;
+	}
+	while((result == 0) && (fgets(line, sizeof(line), stream) != NULL))
+	{
+		number++;
+		line[strcspn(line, "\r\n")] = '\0';
+		result = CosimScript_execute(line, file, number);
+	}
+	fclose(stream);
+	return result;
+}
+
+
+/*******************************************************************************
+ *                      Private Functions                                      *
+ *******************************************************************************/
+
+static int CosimScript_execute(char * line,const char * file,unsigned int number)
+{
+	char * command = line + strspn(line, " \t");
+	char * arguments;
+	char * rest;
+	char actual[COSIM_LCD_COLUMNS + 1];
+	CosimScript_LcdCheck lcd;
+	Cosim_MotorState motor;
+	double timeout;
+
+	if((*command == '\0') || (*command == '#'))
+	{
+		return 0;
+	}
+	arguments = command + strcspn(command, " \t");
+	if(*arguments != '\0')
+	{
+		*arguments++ = '\0';
+		arguments += strspn(arguments, " \t");
+	}
+
+	if(strcmp(command, "keys") == 0)
+	{
+		CosimHmiBoard_pressKeys(arguments);
+		return 0;
+	}
+	if(strcmp(command, "wait") == 0)
+	{
+		Cosim_run(atof(arguments), NULL, NULL);
+		return 0;
+	}
+	if(strcmp(command, "wait-keys") == 0)
+	{
+		if(Cosim_run(atof(arguments), CosimScript_keysReleased, NULL))
+		{
+			return 0;
+		}
+		fprintf(stderr, "%s:%u: %.3f ms: the keys are not released\n", file, number, Cosim_timeMs());
+		return 1;
+	}
+	if((strcmp(command, "wait-lcd") == 0) || (strcmp(command, "expect-lcd") == 0))
+	{
+		if(!CosimScript_parseLcd(arguments, &lcd, &rest))
+		{
+			fprintf(stderr, "%s:%u: expected ROW \"TEXT\"\n", file, number);
+			return 2;
+		}
+		timeout = (command[0] == 'w') ? atof(rest) : 0;
+		if(((timeout > 0) && Cosim_run(timeout, CosimScript_lcdMatches, &lcd)) || CosimScript_lcdMatches(&lcd))
+		{
+			return 0;
+		}
+		CosimHmiBoard_getLine(lcd.row, actual);
+		fprintf(stderr, "%s:%u: %.3f ms: LCD row %u is \"%s\", expected \"%s\"\n",
+				file, number, Cosim_timeMs(), lcd.row, actual, lcd.text);
+		return 1;
+	}
+	if((strcmp(command, "wait-motor") == 0) || (strcmp(command, "expect-motor") == 0))
+	{
+		rest = arguments + strcspn(arguments, " \t");
+		if(*rest != '\0')
+		{
+			*rest++ = '\0';
+		}
+		if(!CosimScript_parseMotor(arguments, &motor))
+		{
+			fprintf(stderr, "%s:%u: expected open, close or stop\n", file, number);
+			return 2;
+		}
+		timeout = (command[0] == 'w') ? atof(rest) : 0;
+		if(((timeout > 0) && Cosim_run(timeout, CosimScript_motorMatches, &motor)) || CosimScript_motorMatches(&motor))
+		{
+			return 0;
+		}
+		fprintf(stderr, "%s:%u: %.3f ms: the motor is %s, expected %s\n", file, number, Cosim_timeMs(),
+				CosimControlBoard_motorName(CosimControlBoard_getMotor()), CosimControlBoard_motorName(motor));
+		return 1;
+	}
+
+	fprintf(stderr, "%s:%u: unknown command %s\n", file, number, command);
+	return 2;
+}
+
+/* ROW "TEXT" [rest] */
+static uint8_t CosimScript_parseLcd(char * arguments,CosimScript_LcdCheck * check,char ** rest)
+{
+	char * end;
+	char * text;
+	size_t length;
+	long row = strtol(arguments, &end, 10);
+
+	if((end == arguments) || (row < 0) || (row >= COSIM_LCD_ROWS))
+	{
+		return 0;
+	}
+	text = strchr(end, '"');
+	end = (text != NULL) ? strchr(text + 1, '"') : NULL;
+	if(end == NULL)
+	{
+		return 0;
+	}
+	text++;
+	length = (size_t)(end - text);
+	if(length > COSIM_LCD_COLUMNS)
+	{
+		return 0;
+	}
+	check->row = (uint8_t)row;
+	memcpy(check->text, text, length);
+	check->text[length] = '\0';
+	*rest = end + 1;
+	return 1;
+}
+
+static uint8_t CosimScript_parseMotor(const char * name,Cosim_MotorState * motor)
+{
+	Cosim_MotorState state;
+
+	for(state=COSIM_MOTOR_STOP;state<=COSIM_MOTOR_CLOSE;state++)
+	{
+		if(strcmp(name, CosimControlBoard_motorName(state)) == 0)
+		{
+			*motor = state;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static uint8_t CosimScript_lcdMatches(const void * arg)
+{
+	const CosimScript_LcdCheck * check = arg;
+	char line[COSIM_LCD_COLUMNS + 1];
+
+	CosimHmiBoard_getLine(check->row, line);
+	return strncmp(line, check->text, strlen(check->text)) == 0;
+}
+
+static uint8_t CosimScript_motorMatches(const void * arg)
+{
+	return CosimControlBoard_getMotor() == *(const Cosim_MotorState *)arg;
+}
+
+static uint8_t CosimScript_keysReleased(const void * arg)
+{
+	return CosimHmiBoard_keysDone();
+}
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+################################################################################
+#
+# Module: Memory Summary
+#
+# File Name: mem_summary.py
+#
+# Description: Summary of the static SRAM of an ECU from the map file of its
+#              avr-gcc link (-Wl,-Map): the sizes of .data, .bss and .noinit,
+#              the room left for the stack and the largest variables. It
+#              fails when the static SRAM is over the budget, so the Eclipse
+#              build stops on a memory regression (makefile.targets).
+#
+#              ./mem_summary.py Control_ECU.map --budget 1536
+#
+# Author: Omar Elsherif
+#
+################################################################################
+
+import argparse
+import re
+import sys
+
+################################################################################
+#                                Definitions                                   #
+################################################################################
+
+# ATmega32 : 2 KB of SRAM after the registers, the stack starts at RAMEND
+RAM_START = 0x0060
+RAM_END = 0x085F
+
+# avr-gcc maps the SRAM at 0x800000 in the linker address space
+DATA_SPACE = 0x800000
+
+SECTIONS = (".data", ".bss", ".noinit")
+
+# ".bss            0x0080007a        0x6"
+OUTPUT_SECTION = re.compile(r"^(\.\w+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)")
+# " .bss.g_counts  0x0080007a       0x80 ./histogram.o", the address may be on
+# the next line when the name is long
+INPUT_SECTION = re.compile(r"^ (\.[\w.]+|COMMON)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S+))?\s*$")
+INPUT_CONTINUATION = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S+)\s*$")
+
+################################################################################
+#                                  Parsing                                     #
+################################################################################
+
+def read_map(path):
+    """Sizes of the SRAM output sections and their input sections."""
+    sizes = {}
+    variables = []
+    end = None
+    section = None
+    pending = None
+    with open(path, errors="replace") as map_file:
+        for line in map_file:
+            line = line.rstrip("\r\n")
+            match = OUTPUT_SECTION.match(line)
+            if match:
+                section = match.group(1) if match.group(1) in SECTIONS else None
+                if section is not None:
+                    sizes[section] = int(match.group(3), 16)
+                    end = max(end or 0, int(match.group(2), 16) + int(match.group(3), 16))
+                pending = None
+                continue
+            if section is None:
+                continue
+            match = INPUT_SECTION.match(line)
+            if match:
+                if match.group(2) is None:
+                    pending = match.group(1)
+                else:
+                    add_variable(variables, section, match.group(1), match.group(3), match.group(4))
+                    pending = None
+                continue
+            match = INPUT_CONTINUATION.match(line)
+            if match and pending is not None:
+                add_variable(variables, section, pending, match.group(2), match.group(3))
+            pending = None
+    return sizes, end, variables
+
+
+def add_variable(variables, section, name, size, source):
+    size = int(size, 16)
+    if size == 0:
+        return
+    # ".bss.g_counts" --> "g_counts", the plain sections keep their name
+    for prefix in (".data.", ".bss.", ".noinit.", ".rodata."):
+        if name.startswith(prefix):
+            name = name[len(prefix):]
+    variables.append((size, section, name, source.replace("\\", "/").split("/")[-1]))
+
+################################################################################
+#                                   Output                                     #
+################################################################################
+
+def main(argv):
+    parser = argparse.ArgumentParser(description="Static SRAM of an AVR map file")
+    parser.add_argument("map", help="map file of the link")
+    parser.add_argument("--budget", type=int, default=None,
+                        help="fail if .data + .bss + .noinit is over BUDGET bytes")
+    parser.add_argument("--top", type=int, default=10, help="number of variables listed")
+    args = parser.parse_args(argv[1:])
+
+    sizes, end, variables = read_map(args.map)
+    if not sizes:
+        print("%s: no SRAM section found" % args.map, file=sys.stderr)
+        return 2
+
+    static = sum(sizes.get(section, 0) for section in SECTIONS)
+    ram = RAM_END - RAM_START + 1
+    stack = RAM_END + 1 - ((end - DATA_SPACE) if end is not None else RAM_START + static)
+
+    print("SRAM of %s : %u bytes" % (args.map, ram))
+    for section in SECTIONS:
+        print("  %-8s %5u" % (section, sizes.get(section, 0)))
+    print("  %-8s %5u%s" % ("static", static,
+                            "" if args.budget is None else " (budget %u)" % args.budget))
+    print("  %-8s %5u" % ("stack", stack))
+    if variables:
+        print("Largest:")
+        for size, section, name, source in sorted(variables, reverse=True)[:args.top]:
+            print("  %5u  %-8s %s (%s)" % (size, section, name, source))
+
+    if args.budget is not None and static > args.budget:
+        print("%s: static SRAM %u bytes is over the budget of %u bytes"
+              % (args.map, static, args.budget), file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
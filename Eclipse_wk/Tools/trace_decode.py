@@ -0,0 +1,246 @@
+#!/usr/bin/env python3
+################################################################################
+#
+# Module: Trace
+#
+# File Name: trace_decode.py
+#
+# Description: Decoder of the trace dumps of the two ECUs (trace.c, built with
+#              -DTRACE_ENABLE). It reads the captures of the UART lines, the
+#              bytes sent by each ECU, finds the last dump of each ECU and
+#              prints the records of both on one timeline. The clocks of the
+#              two ECUs are aligned with the bytes sent by one and received
+#              by the other, each link byte is printed with its peer record.
+#
+#              ./trace_decode.py capture.control capture.hmi
+#              door_sim -l capture writes these two files on the host.
+#
+# Author: Omar Elsherif
+#
+################################################################################
+
+import re
+import sys
+
+################################################################################
+#                                Definitions                                   #
+################################################################################
+
+# Trace_EventId of trace.h
+EVENT_INIT = 0x00
+EVENT_UART_TX = 0x01
+EVENT_UART_RX = 0x02
+EVENT_UART_TX_MASKED = 0x03
+EVENT_UART_RX_MASKED = 0x04
+EVENT_KEY = 0x10
+EVENT_MENU = 0x11
+EVENT_PASSWORD_CHECK = 0x20
+EVENT_DOOR = 0x21
+EVENT_LOCKOUT = 0x22
+EVENT_MOTOR = 0x23
+
+EVENT_NAMES = {
+    EVENT_INIT: "INIT",
+    EVENT_UART_TX: "UART_TX",
+    EVENT_UART_RX: "UART_RX",
+    EVENT_UART_TX_MASKED: "UART_TX",
+    EVENT_UART_RX_MASKED: "UART_RX",
+    EVENT_KEY: "KEY",
+    EVENT_MENU: "MENU",
+    EVENT_PASSWORD_CHECK: "PASSWORD_CHECK",
+    EVENT_DOOR: "DOOR",
+    EVENT_LOCKOUT: "LOCKOUT",
+    EVENT_MOTOR: "MOTOR",
+}
+
+# Link protocol bytes of Control_Ecu.c and Human_Machine_Interface.c
+LINK_NAMES = {
+    0x01: "SEND_PASSWORD",
+    0x02: "CONFIRM_SEND_PASSWORD",
+    0x03: "OPEN_DOOR",
+    0x04: "CHANGE_PASS",
+    0x05: "DOOR_UNLOCKED",
+    0x06: "DOOR_LOCKING",
+    0x07: "DOOR_LOCKED",
+    0x10: "PROFILER_DUMP_REQUEST",
+    0x11: "TRACE_DUMP_REQUEST",
+    0xFC: "LOCKED_OUT",
+    0xFD: "UNMATCHED_PASSWORD",
+    0xFE: "MATCHED_PASSWORD",
+    0xFF: "ECU_READY",
+}
+
+# The seconds of the records are 8 bits
+SECONDS_WRAP = 256
+
+# A received byte is matched with one of the next bytes sent by the peer
+MATCH_WINDOW = 8
+
+DUMP_PATTERN = re.compile(rb"TRACE (\w+) (\d+) (\d+)\r\n((?:[0-9A-F]{10}\r\n)*)END\r\n")
+
+################################################################################
+#                                  Decoding                                    #
+################################################################################
+
+class Record:
+    def __init__(self, ecu, index, event, argument, time):
+        self.ecu = ecu
+        self.index = index
+        self.event = event
+        self.argument = argument
+        # Seconds in the ECU clock, then in the merged timeline
+        self.time = time
+        self.peer = None
+
+    def is_sent(self):
+        return self.event in (EVENT_UART_TX, EVENT_UART_TX_MASKED)
+
+    def is_received(self):
+        return self.event in (EVENT_UART_RX, EVENT_UART_RX_MASKED)
+
+    def link_key(self):
+        # A masked byte only matches a masked byte
+        masked = self.event in (EVENT_UART_TX_MASKED, EVENT_UART_RX_MASKED)
+        return (masked, self.argument)
+
+    def describe(self):
+        name = EVENT_NAMES.get(self.event, "EVENT_0x%02X" % self.event)
+        if self.event in (EVENT_UART_TX_MASKED, EVENT_UART_RX_MASKED):
+            return "%s **" % name
+        if self.event in (EVENT_UART_TX, EVENT_UART_RX):
+            link = LINK_NAMES.get(self.argument)
+            return "%s 0x%02X%s" % (name, self.argument, " " + link if link else "")
+        if self.event in (EVENT_PASSWORD_CHECK, EVENT_DOOR):
+            return "%s %s" % (name, LINK_NAMES.get(self.argument, "0x%02X" % self.argument))
+        if self.event == EVENT_MENU:
+            return "%s '%c'" % (name, self.argument)
+        if self.event == EVENT_LOCKOUT:
+            return "%s %s" % (name, "start" if self.argument else "end")
+        if self.event == EVENT_MOTOR:
+            return "%s duty %u%%" % (name, self.argument)
+        if self.event == EVENT_KEY:
+            return "%s %u" % (name, self.argument)
+        return name
+
+
+def read_dumps(paths):
+    """The last dump of each ECU in the captures."""
+    dumps = {}
+    for path in paths:
+        with open(path, "rb") as capture:
+            data = capture.read()
+        for match in DUMP_PATTERN.finditer(data):
+            ecu = match.group(1).decode()
+            ticks_per_second = int(match.group(2))
+            lines = match.group(4).split()
+            if len(lines) != int(match.group(3)):
+                print("%s: the %s dump is cut" % (path, ecu), file=sys.stderr)
+                continue
+            dumps[ecu] = decode_records(ecu, ticks_per_second, lines)
+    return dumps
+
+
+def decode_records(ecu, ticks_per_second, lines):
+    records = []
+    wraps = 0
+    previous = None
+    for index, line in enumerate(lines):
+        raw = bytes.fromhex(line.decode())
+        event, argument, seconds = raw[0], raw[1], raw[2]
+        ticks = (raw[3] << 8) | raw[4]
+        time = (wraps * SECONDS_WRAP) + seconds + (ticks / ticks_per_second)
+        # The records are in time order, the seconds counter wrapped
+        if previous is not None and time < previous:
+            wraps += 1
+            time += SECONDS_WRAP
+        previous = time
+        records.append(Record(ecu, index, event, argument, time))
+    return records
+
+
+def match_link(senders, receivers):
+    """Pair each received byte with the byte sent by the peer, in order."""
+    sent = [record for record in senders if record.is_sent()]
+    pairs = []
+    next_sent = 0
+    for received in (record for record in receivers if record.is_received()):
+        for candidate in range(next_sent, min(next_sent + MATCH_WINDOW, len(sent))):
+            if sent[candidate].link_key() == received.link_key():
+                pairs.append((sent[candidate], received))
+                next_sent = candidate + 1
+                break
+    return pairs
+
+
+def lower_delay(pairs):
+    """Receive time - send time of the quickest pairs, the receiver may read late."""
+    delays = sorted(received.time - sent.time for sent, received in pairs)
+    return delays[len(delays) // 4] if delays else None
+
+
+def merge(reference, other):
+    """Move the other ECU records to the reference clock, return the offset and latency."""
+    forward = match_link(reference, other)
+    backward = match_link(other, reference)
+    # forward delay = offset + latency, backward delay = latency - offset
+    forward_delay = lower_delay(forward)
+    backward_delay = lower_delay(backward)
+    if forward_delay is not None and backward_delay is not None:
+        offset = (forward_delay - backward_delay) / 2
+        latency = (forward_delay + backward_delay) / 2
+    elif forward_delay is not None:
+        offset, latency = forward_delay, 0.0
+    elif backward_delay is not None:
+        offset, latency = -backward_delay, 0.0
+    else:
+        offset, latency = other[0].time - reference[0].time if other and reference else 0.0, None
+    for record in other:
+        record.time -= offset
+    for sent, received in forward + backward:
+        sent.peer = received
+        received.peer = sent
+    return offset, latency, len(forward) + len(backward)
+
+################################################################################
+#                                   Output                                     #
+################################################################################
+
+def print_timeline(records, start):
+    for record in sorted(records, key=lambda record: (record.time, record.ecu, record.index)):
+        line = "%12.6f  %-8s %s" % (record.time - start, record.ecu, record.describe())
+        if record.peer is not None:
+            delay = abs(record.peer.time - record.time) * 1000
+            if record.is_sent():
+                line = "%-52s -> %s %+.3f ms" % (line, record.peer.ecu, delay)
+            else:
+                line = "%-52s <- %s %+.3f ms" % (line, record.peer.ecu, -delay)
+        print(line)
+
+
+def main(argv):
+    if len(argv) < 2:
+        print("Usage: %s CAPTURE [CAPTURE ...]" % argv[0], file=sys.stderr)
+        return 2
+    dumps = read_dumps(argv[1:])
+    if not dumps:
+        print("no trace dump found", file=sys.stderr)
+        return 1
+
+    # The clock of the first ECU found, CONTROL if it is there, is the reference
+    names = sorted(dumps, key=lambda name: name != "CONTROL")
+    reference = dumps[names[0]]
+    for name in names[1:]:
+        offset, latency, pairs = merge(reference, dumps[name])
+        if latency is None:
+            print("# %s: no link byte matched, clocks aligned on the first records" % name)
+        else:
+            print("# %s clock = %s clock %+.6f s, %u link bytes matched, latency %.3f ms"
+                  % (name, names[0], offset, pairs, latency * 1000))
+
+    records = [record for name in names for record in dumps[name]]
+    print_timeline(records, min(record.time for record in records))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))